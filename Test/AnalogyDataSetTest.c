@@ -0,0 +1,98 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <Memory/Memory.h>
+
+#include "../src/AnalogyDataSet.h"
+
+/**
+ * Scores a candidate for a question by a direct scan in double precision.
+ */
+static double direct_score(const Embedding_model* embedding_model, const int* query, int word, Analogy_method method) {
+    double cosines[3];
+    const float* candidate = embedding_model_vector(embedding_model, word);
+    for (int t = 0; t < 3; t++){
+        const float* vector = embedding_model_vector(embedding_model, query[t]);
+        double dot = 0, norm1 = 0, norm2 = 0;
+        for (int j = 0; j < embedding_model->vector_length; j++){
+            dot += vector[j] * candidate[j];
+            norm1 += vector[j] * vector[j];
+            norm2 += candidate[j] * candidate[j];
+        }
+        cosines[t] = dot / sqrt(norm1 * norm2);
+    }
+    if (method == THREE_COS_ADD){
+        return cosines[1] - cosines[0] + cosines[2];
+    }
+    return ((cosines[1] + 1) / 2) * ((cosines[2] + 1) / 2) / ((cosines[0] + 1) / 2 + 0.001);
+}
+
+int main(){
+    start_medium_memory_check();
+    int word_count = 3001, vector_length = 50, question_count = 333;
+    char name[32], name2[32], name3[32], name4[32];
+    unsigned long long next_random = 1;
+    Embedding_model_ptr embedding_model = create_embedding_model3(word_count, vector_length);
+    embedding_model->thread_count = 3;
+    for (int i = 0; i < word_count; i++){
+        sprintf(name, "w%d", i);
+        embedding_model_set_word(embedding_model, i, name);
+        float* vector = embedding_model->vectors + (size_t) i * vector_length;
+        for (int j = 0; j < vector_length; j++){
+            next_random = next_random * 25214903917ULL + 11;
+            vector[j] = (float) (((next_random >> 16) & 0xFFFF) / 65536.0 - 0.5);
+        }
+    }
+    Analogy_data_set_ptr analogy_data_set = create_analogy_data_set2();
+    for (int i = 0; i < question_count; i++){
+        sprintf(name, "w%d", (i * 7) % word_count);
+        sprintf(name2, "w%d", (i * 13 + 1) % word_count);
+        sprintf(name3, "w%d", (i * 29 + 2) % word_count);
+        sprintf(name4, "w%d", i % 2 == 0 ? (i * 31 + 3) % word_count : word_count + i);
+        array_list_add(analogy_data_set->questions, create_analogy_question(name, name2, name3, name4));
+    }
+    array_list_add(analogy_data_set->questions, create_analogy_question("w0", "missing", "w1", "w2"));
+    for (int method = THREE_COS_ADD; method <= THREE_COS_MUL; method++){
+        int* answers = solve_analogies(analogy_data_set, embedding_model, method);
+        for (int i = 0; i < question_count; i++){
+            int query[3] = {(i * 7) % word_count, (i * 13 + 1) % word_count, (i * 29 + 2) % word_count};
+            double best = -INFINITY;
+            for (int word = 0; word < word_count; word++){
+                if (word != query[0] && word != query[1] && word != query[2]){
+                    double score = direct_score(embedding_model, query, word, method);
+                    if (score > best){
+                        best = score;
+                    }
+                }
+            }
+            if (answers[i] == -1 || best - direct_score(embedding_model, query, answers[i], method) > 1e-4){
+                printf("Error 1 %d %d %d\n", method, i, answers[i]);
+            }
+        }
+        if (answers[question_count] != -1){
+            printf("Error 2 %d\n", answers[question_count]);
+        }
+        free_(answers);
+    }
+    for (int i = 0; i < word_count; i++){
+        float* vector = embedding_model->vectors + (size_t) i * vector_length;
+        for (int j = 0; j < vector_length; j++){
+            vector[j] = (j == i % vector_length) ? 1.0f : 0.0f;
+        }
+    }
+    embedding_model->vectors[(size_t) 3 * vector_length] = 1;
+    embedding_model->vectors[(size_t) 3 * vector_length + 2] = 1;
+    embedding_model->vectors[(size_t) 3 * vector_length + 3] = 0;
+    Analogy_data_set_ptr planted = create_analogy_data_set2();
+    array_list_add(planted->questions, create_analogy_question("w1", "w2", "w0", "w3"));
+    if (analogy_accuracy(planted, embedding_model, THREE_COS_ADD) != 1.0 || analogy_accuracy(planted, embedding_model, THREE_COS_MUL) != 1.0){
+        printf("Error 3\n");
+    }
+    free_analogy_data_set(planted);
+    free_analogy_data_set(analogy_data_set);
+    free_embedding_model(embedding_model);
+    end_memory_check();
+}
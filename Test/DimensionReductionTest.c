@@ -0,0 +1,70 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <Corpus.h>
+#include <Memory/Memory.h>
+
+#include "../src/NeuralNetwork.h"
+#include "../src/DimensionReduction.h"
+
+/**
+ * Trains english-xs with 100 dimensional vectors and reduces them to 50 dimensions with every method. The Spearman
+ * correlations on MC, WS353 and MEN are printed before and after the reduction. Since english-xs is too small for
+ * the vectors to correlate with human judgements, the reduced model is checked against the original one instead:
+ * for every dataset, the Spearman correlation of the reduced similarities with the original similarities must be
+ * at least 0.5.
+ */
+int main(){
+    start_large_memory_check();
+    const char* names[3] = {"MC", "WS353", "MEN"};
+    const char* methods[3] = {"Randomized PCA", "Gaussian projection", "Sparse projection"};
+    Semantic_data_set_ptr data_sets[3];
+    data_sets[0] = create_semantic_data_set("MC.txt");
+    data_sets[1] = create_semantic_data_set("WS353.txt");
+    data_sets[2] = create_semantic_data_set("MEN.txt");
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    parameter->cbow = true;
+    parameter->layer_size = 100;
+    Neural_network_ptr neural_network = create_neural_network(english, parameter);
+    train_network(neural_network);
+    Embedding_model_ptr embedding_model = create_embedding_model(neural_network);
+    if (reduce_embedding_model(embedding_model, 100, RANDOMIZED_PCA, 1) != NULL){
+        printf("Error 1\n");
+    }
+    Semantic_data_set_ptr original[3];
+    for (int i = 0; i < 3; i++){
+        original[i] = calculate_similarities2(data_sets[i], embedding_model);
+        printf("%s before: %.6lf\n", names[i], spearman_correlation(data_sets[i], original[i]));
+    }
+    for (int method = RANDOMIZED_PCA; method <= SPARSE_PROJECTION; method++){
+        Embedding_model_ptr reduced = reduce_embedding_model(embedding_model, 50, method, 1);
+        if (reduced == NULL || reduced->vector_length != 50 || reduced->word_count != embedding_model->word_count ||
+            embedding_model_index(reduced, embedding_model->words[7]) != 7){
+            printf("Error 2 %s\n", methods[method]);
+            continue;
+        }
+        for (int i = 0; i < 3; i++){
+            Semantic_data_set_ptr similarities = calculate_similarities2(data_sets[i], reduced);
+            double agreement = spearman_correlation(original[i], similarities);
+            printf("%s %s after: %.6lf, agreement with the original: %.6lf\n", methods[method], names[i],
+                   spearman_correlation(data_sets[i], similarities), agreement);
+            if (agreement < 0.5){
+                printf("Error 3 %s %s\n", methods[method], names[i]);
+            }
+            free_semantic_data_set(similarities);
+        }
+        free_embedding_model(reduced);
+    }
+    for (int i = 0; i < 3; i++){
+        free_semantic_data_set(original[i]);
+        free_semantic_data_set(data_sets[i]);
+    }
+    free_embedding_model(embedding_model);
+    free_neural_network(neural_network);
+    free_word_to_vec_parameter(parameter);
+    free_corpus(english);
+    end_memory_check();
+}
@@ -0,0 +1,76 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+
+#include "../src/KnnGraph.h"
+
+static const char* GRAPH_FILE = "knn-graph-test.bin";
+
+/**
+ * Builds the graph of a random model in two interrupted calls and compares every row with the exact neighbors
+ * found by scanning all pairs one at a time.
+ */
+void test_knn_graph(){
+    int word_count = 5000, vector_length = 50, k = 10;
+    Embedding_model_ptr embedding_model = create_embedding_model3(word_count, vector_length);
+    srand(1);
+    for (long long i = 0; i < (long long) word_count * vector_length; i++){
+        embedding_model->vectors[i] = rand() / (float) RAND_MAX - 0.5f;
+    }
+    embedding_model->vectors[7 * vector_length] = 0;
+    Nearest_neighbors_ptr nearest_neighbors = create_nearest_neighbors(embedding_model);
+    unlink(GRAPH_FILE);
+    if (build_knn_graph2(nearest_neighbors, k, GRAPH_FILE, 1000) != 1000 || build_knn_graph2(nearest_neighbors, k, GRAPH_FILE, 0) != 1000){
+        printf("Error 1\n");
+    }
+    if (create_knn_graph(GRAPH_FILE) != NULL){
+        printf("Error 2\n");
+    }
+    clock_t start = clock();
+    if (build_knn_graph(nearest_neighbors, k, GRAPH_FILE) != word_count){
+        printf("Error 3\n");
+    }
+    printf("Graph of %d words built in %.2f seconds\n", word_count, (clock() - start) / (double) CLOCKS_PER_SEC);
+    Knn_graph_ptr knn_graph = create_knn_graph(GRAPH_FILE);
+    if (knn_graph == NULL || knn_graph->word_count != word_count || knn_graph->k != k){
+        printf("Error 4\n");
+        return;
+    }
+    float best_scores[k];
+    int best_indices[k];
+    for (int row = 0; row < word_count; row++){
+        int size = 0;
+        for (int other = 0; other < word_count; other++){
+            if (other != row){
+                push_neighbor(best_scores, best_indices, &size, k, cosine_similarity_of_rows(nearest_neighbors, row, other), other);
+            }
+        }
+        sort_neighbors(best_scores, best_indices, size, k);
+        const int* neighbors = knn_graph_neighbors(knn_graph, row);
+        const float* scores = knn_graph_scores(knn_graph, row);
+        for (int i = 0; i < k; i++){
+            if (neighbors[i] != best_indices[i] && fabsf(scores[i] - best_scores[i]) > 1e-5){
+                printf("Error 5 %d\n", row);
+                break;
+            }
+            if (i > 0 && scores[i] > scores[i - 1]){
+                printf("Error 6 %d\n", row);
+                break;
+            }
+        }
+    }
+    free_knn_graph(knn_graph);
+    unlink(GRAPH_FILE);
+    free_nearest_neighbors(nearest_neighbors);
+    free_embedding_model(embedding_model);
+}
+
+int main(){
+    test_knn_graph();
+}
@@ -0,0 +1,144 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <math.h>
+#include <Memory/Memory.h>
+
+#include "../src/Iteration.h"
+#include "../src/ValidationMonitor.h"
+
+/**
+ * Compares a learning rate with its expected value.
+ * @param alpha Learning rate.
+ * @param expected Expected learning rate.
+ * @return True if they differ by less than one in a million of the expected value.
+ */
+static bool same_alpha(double alpha, double expected) {
+    return fabs(alpha - expected) <= 1e-6 * expected;
+}
+
+/**
+ * Checks the learning rate of the linear, cosine, warmup and restart schedules at fixed word counts, over two
+ * epochs of a million words with a starting learning rate of 0.025. The learning rate computed by alpha_update must
+ * be the one of the scheduler the iteration constructed for the corpus.
+ */
+void test_schedules(){
+    long long epoch = 1000000;
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    parameter->alpha = 0.025;
+    parameter->number_of_iterations = 2;
+    parameter->schedule = LINEAR_SCHEDULE;
+    parameter->warmup_ratio = 0;
+    parameter->restart_per_epoch = false;
+    Learning_rate_scheduler scheduler = create_learning_rate_scheduler(parameter, epoch);
+    if (!same_alpha(scheduled_alpha(&scheduler, 0), 0.025) || !same_alpha(scheduled_alpha(&scheduler, epoch), 0.025 * (1 - epoch / (2.0 * epoch + 1))) ||
+        !same_alpha(scheduled_alpha(&scheduler, 2 * epoch), 0.025 * 0.0001)){
+        printf("Error 1\n");
+    }
+    parameter->schedule = COSINE_SCHEDULE;
+    scheduler = create_learning_rate_scheduler(parameter, epoch);
+    double middle = 0.025 * 0.0001 + (0.025 - 0.025 * 0.0001) * 0.5 * (1 + cos(M_PI * epoch / (2.0 * epoch + 1)));
+    if (!same_alpha(scheduled_alpha(&scheduler, 0), 0.025) || !same_alpha(scheduled_alpha(&scheduler, epoch), middle) ||
+        scheduled_alpha(&scheduler, epoch / 2) <= 0.025 * (1 - 0.25) || !same_alpha(scheduled_alpha(&scheduler, 2 * epoch), 0.025 * 0.0001)){
+        printf("Error 2\n");
+    }
+    parameter->warmup_ratio = 0.1;
+    scheduler = create_learning_rate_scheduler(parameter, epoch);
+    if (!same_alpha(scheduled_alpha(&scheduler, 0), 0.025 * 0.0001) || !same_alpha(scheduled_alpha(&scheduler, 99999), 0.025 * 0.5) ||
+        !same_alpha(scheduled_alpha(&scheduler, 200000), 0.025) || scheduled_alpha(&scheduler, 300000) >= 0.025){
+        printf("Error 3\n");
+    }
+    parameter->restart_per_epoch = true;
+    scheduler = create_learning_rate_scheduler(parameter, epoch);
+    if (!same_alpha(scheduled_alpha(&scheduler, 49999), 0.025 * 0.5) || !same_alpha(scheduled_alpha(&scheduler, epoch + 100000), 0.025) ||
+        !same_alpha(scheduled_alpha(&scheduler, epoch + 600000), scheduled_alpha(&scheduler, 600000)) ||
+        scheduled_alpha(&scheduler, epoch - 1) >= scheduled_alpha(&scheduler, epoch + 100000)){
+        printf("Error 4\n");
+    }
+    Iteration_ptr iteration = create_iteration2(NULL, parameter, NULL, epoch);
+    iteration->word_count = 250001;
+    alpha_update(iteration, epoch);
+    if (iteration->scheduler.epoch_word_count != epoch || !same_alpha(iteration->alpha, scheduled_alpha(&scheduler, 250001))){
+        printf("Error 5 %.10lf\n", iteration->alpha);
+    }
+    free_iteration(iteration);
+    free_word_to_vec_parameter(parameter);
+}
+
+/**
+ * Places the vectors of words w1 to w4 at the given angles from w0, so that the similarity of (w0, wk) is the cosine
+ * of the k'th angle.
+ * @param word_vectors Word vectors, in the order of the vocabulary.
+ * @param vocabulary Vocabulary of the words.
+ * @param angles Angles of w1 to w4.
+ */
+static void place_vectors(double** word_vectors, Vocabulary_ptr vocabulary, const double* angles) {
+    char name[8];
+    for (int k = 0; k < 5; k++){
+        sprintf(name, "w%d", k);
+        double* row = word_vectors[get_position(vocabulary, name)];
+        row[0] = k == 0 ? 1 : cos(angles[k - 1]);
+        row[1] = k == 0 ? 0 : sin(angles[k - 1]);
+    }
+}
+
+/**
+ * Runs the synchronous checkpoints of a validation monitor with an interval of 100 words and a patience of 2 on a
+ * dataset whose pairs (w0, wk) are less related as k grows. The vectors are placed so that the correlation is -1,
+ * then 0.8, then 1. The monitor must evaluate only when a checkpoint is passed, reset its patience when the
+ * correlation improves, and ask the training to stop after the second evaluation without improvement.
+ */
+void test_validation_monitor(){
+    double reversed[4] = {1.2, 0.9, 0.6, 0.3}, swapped[4] = {0.6, 0.3, 0.9, 1.2}, ordered[4] = {0.3, 0.6, 0.9, 1.2};
+    char name[8], other[8];
+    Vocabulary_ptr vocabulary = create_vocabulary2();
+    for (int k = 0; k < 5; k++){
+        sprintf(name, "w%d", k);
+        array_list_add(vocabulary->vocabulary, create_vocabulary_word(name, 100 - k));
+        vocabulary->total_number_of_words += 100 - k;
+    }
+    prepare_vocabulary(vocabulary);
+    Semantic_data_set_ptr data_set = create_semantic_data_set2();
+    for (int k = 1; k < 5; k++){
+        sprintf(name, "w%d", 0);
+        sprintf(other, "w%d", k);
+        array_list_add(data_set->pairs, create_word_pair(name, other, 5 - k));
+    }
+    double** word_vectors = allocate_2d(5, 2);
+    Validation_monitor_ptr validation_monitor = create_validation_monitor(data_set, 100, 2, 0.01);
+    start_validation_monitor(validation_monitor, vocabulary, 2);
+    double* angles[6] = {reversed, swapped, swapped, ordered, ordered, ordered};
+    bool expected_stop[6] = {false, false, false, false, false, true};
+    for (int i = 0; i < 6; i++){
+        place_vectors(word_vectors, vocabulary, angles[i]);
+        if (i == 4 && validation_checkpoint2(validation_monitor, word_vectors, 450)){
+            printf("Error 6\n");
+        }
+        if (validation_checkpoint2(validation_monitor, word_vectors, 100 * (i + 1)) != expected_stop[i] || validation_monitor->history->size != i + 1){
+            printf("Error 7 %d\n", i);
+        }
+    }
+    double correlations[6] = {-1, 0.8, 0.8, 1, 1, 1};
+    for (int i = 0; i < validation_monitor->history->size; i++){
+        if (fabs(array_list_get_double(validation_monitor->history, i) - correlations[i]) > 1e-9){
+            printf("Error 8 %d %.3lf\n", i, array_list_get_double(validation_monitor->history, i));
+        }
+    }
+    if (validation_monitor->best_correlation != 1 || !validation_should_stop(validation_monitor)){
+        printf("Error 9\n");
+    }
+    finish_validation_monitor(validation_monitor);
+    free_validation_monitor(validation_monitor);
+    free_2d(word_vectors, 5);
+    free_semantic_data_set(data_set);
+    free_vocabulary(vocabulary);
+}
+
+int main(){
+    start_large_memory_check();
+    test_schedules();
+    test_validation_monitor();
+    end_memory_check();
+}
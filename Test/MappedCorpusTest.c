@@ -0,0 +1,89 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <Corpus.h>
+#include <Memory/Memory.h>
+
+#include "../src/MappedCorpus.h"
+
+/**
+ * Concatenates the tokens of all shards into one token stream.
+ * @param shards Corpus shards.
+ * @param shard_count Number of shards.
+ * @param token_count Output, number of tokens in the stream.
+ * @param word_count Output, number of words in the shards.
+ * @return Tokens of the shards one after another.
+ */
+static int* concatenate_shards(Corpus_shard_ptr* shards, int shard_count, long long* token_count, long long* word_count) {
+    *token_count = 0;
+    *word_count = 0;
+    for (int i = 0; i < shard_count; i++){
+        *token_count += shards[i]->token_count;
+        *word_count += shards[i]->word_count;
+    }
+    int* result = malloc_((*token_count + 1) * sizeof(int));
+    long long position = 0;
+    for (int i = 0; i < shard_count; i++){
+        for (long long j = 0; j < shards[i]->token_count; j++){
+            result[position++] = shards[i]->tokens[j];
+        }
+    }
+    return result;
+}
+
+/**
+ * Reads english-xs both sentence by sentence and through the mapped corpus. The vocabulary counted by the threads of
+ * the mapped corpus must have the same words with the same counts, and the shards tokenized from the mapped file
+ * must give the same token stream as the shards read from the sentences, although the two split the corpus into a
+ * different number of shards at different places.
+ */
+int main(){
+    start_large_memory_check();
+    Corpus_ptr corpus = create_corpus2("english-xs.txt");
+    Mapped_corpus_ptr mapped_corpus = create_mapped_corpus("english-xs.txt", 4);
+    if (mapped_corpus == NULL){
+        printf("Error 1\n");
+        return 0;
+    }
+    Vocabulary_ptr vocabulary = create_vocabulary3(corpus, NULL);
+    Vocabulary_ptr mapped_vocabulary = create_vocabulary4(mapped_corpus);
+    if (size_of_vocabulary(mapped_vocabulary) != size_of_vocabulary(vocabulary) ||
+        mapped_vocabulary->total_number_of_words != vocabulary->total_number_of_words){
+        printf("Error 2 %d %d\n", size_of_vocabulary(mapped_vocabulary), size_of_vocabulary(vocabulary));
+    }
+    for (int i = 0; i < size_of_vocabulary(vocabulary); i++){
+        Vocabulary_word_ptr word = vocabulary_get_word(vocabulary, i);
+        int* position = hash_map_get(mapped_vocabulary->word_map, word->name);
+        if (position == NULL || vocabulary_get_word(mapped_vocabulary, *position)->count != word->count){
+            printf("Error 3 %s\n", word->name);
+            break;
+        }
+    }
+    long long token_count, word_count, mapped_token_count, mapped_word_count;
+    Corpus_shard_ptr* shards = create_corpus_shards(corpus, NULL, vocabulary, 3);
+    Corpus_shard_ptr* mapped_shards = create_mapped_corpus_shards(mapped_corpus, vocabulary, 5);
+    int* tokens = concatenate_shards(shards, 3, &token_count, &word_count);
+    int* mapped_tokens = concatenate_shards(mapped_shards, 5, &mapped_token_count, &mapped_word_count);
+    if (mapped_token_count != token_count || mapped_word_count != word_count || word_count != vocabulary->total_number_of_words){
+        printf("Error 4 %lld %lld\n", mapped_token_count, token_count);
+    } else {
+        for (long long i = 0; i < token_count; i++){
+            if (mapped_tokens[i] != tokens[i]){
+                printf("Error 5 %lld\n", i);
+                break;
+            }
+        }
+    }
+    printf("%lld tokens, %d words\n", token_count, size_of_vocabulary(vocabulary));
+    free_(tokens);
+    free_(mapped_tokens);
+    free_corpus_shards(shards, 3);
+    free_corpus_shards(mapped_shards, 5);
+    free_vocabulary(vocabulary);
+    free_vocabulary(mapped_vocabulary);
+    free_mapped_corpus(mapped_corpus);
+    free_corpus(corpus);
+    end_memory_check();
+}
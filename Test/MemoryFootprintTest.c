@@ -0,0 +1,63 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <Corpus.h>
+
+#include "../src/WordToVecParameter.h"
+#include "../src/NeuralNetwork.h"
+
+/**
+ * Returns true if a measured size is within the given relative tolerance of its estimate.
+ * @param estimate Estimated bytes.
+ * @param measured Measured bytes.
+ * @param tolerance Allowed relative difference.
+ * @return True if the measurement is close to the estimate.
+ */
+static bool close_to_estimate(size_t estimate, size_t measured, double tolerance) {
+    double difference = (double) measured - (double) estimate;
+    return difference <= tolerance * estimate && -difference <= tolerance * estimate;
+}
+
+/**
+ * Trains english-xs with three threads and compares the estimated memory footprint of every subsystem with the
+ * bytes the allocator reports for it, and the estimated peak with the growth of the peak resident memory of the
+ * process after the corpus is loaded. The test runs in a process of its own, since the peak resident memory never
+ * decreases.
+ */
+void test_memory_footprint(){
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    size_t resident = current_resident_memory();
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    parameter->cbow = true;
+    parameter->thread_count = 3;
+    Neural_network_ptr neural_network = create_neural_network(english, parameter);
+    Memory_footprint estimate = estimate_memory_footprint(size_of_vocabulary(neural_network->vocabulary),
+                                                          neural_network->vocabulary->total_number_of_words, parameter);
+    Vectorized_dictionary_ptr dictionary = train(neural_network);
+    Memory_footprint measured = neural_network->memory_footprint;
+    const char* names[7] = {"weight matrices", "vocabulary", "tables", "corpus shards", "thread buffers", "dictionary", "peak"};
+    size_t estimates[7] = {estimate.weight_matrices, estimate.vocabulary, estimate.tables, estimate.corpus_shards,
+                           estimate.thread_buffers, estimate.dictionary, estimate.peak};
+    size_t measurements[7] = {measured.weight_matrices, measured.vocabulary, measured.tables, measured.corpus_shards,
+                              measured.thread_buffers, measured.dictionary, measured.peak};
+    for (int i = 0; i < 7; i++){
+        printf("%s: estimated %zu, measured %zu\n", names[i], estimates[i], measurements[i]);
+        if (!close_to_estimate(estimates[i], measurements[i], 0.25)){
+            printf("Error 1 %s\n", names[i]);
+        }
+    }
+    printf("peak resident growth: %zu\n", measured.peak_resident - resident);
+    if (measured.peak_resident < resident || !close_to_estimate(estimate.peak, measured.peak_resident - resident, 0.25)){
+        printf("Error 2\n");
+    }
+    free_vectorized_dictionary(dictionary);
+    free_word_to_vec_parameter(parameter);
+    free_neural_network(neural_network);
+    free_corpus(english);
+}
+
+int main(){
+    test_memory_footprint();
+}
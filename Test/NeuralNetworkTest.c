@@ -2,12 +2,38 @@
 // Created by Olcay Taner YILDIZ on 4.10.2023.
 //
 
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
 #include <Corpus.h>
 #include <Memory/Memory.h>
 
 #include "../src/SemanticDataSet.h"
 #include "../src/WordToVecParameter.h"
 #include "../src/NeuralNetwork.h"
+#include "../src/GloveModel.h"
+#include "../src/ModelSweep.h"
+#include "../src/EmbeddingModel.h"
+#include "../src/MappedCorpus.h"
+
+/**
+ * Overwrites bytes of a file in place and returns the bytes that were there before.
+ * @param file_name Name of the file.
+ * @param offset Offset of the bytes to overwrite.
+ * @param bytes New bytes, replaced with the old bytes on return.
+ * @param size Number of bytes.
+ */
+static void swap_file_bytes(const char* file_name, long offset, void* bytes, size_t size) {
+    char old[64];
+    FILE* file = fopen(file_name, "r+b");
+    fseek(file, offset, SEEK_SET);
+    fread(old, 1, size, file);
+    fseek(file, offset, SEEK_SET);
+    fwrite(bytes, 1, size, file);
+    fclose(file);
+    memcpy(bytes, old, size);
+}
 
 void test_train_english_cbow(){
     Semantic_data_set_ptr mc, rg, ws, men, mturk, rare;
@@ -95,6 +121,358 @@ void test_train_english_skip_gram(){
     free_corpus(english);
 }
 
+void test_train_english_glove(){
+    Semantic_data_set_ptr mc, rg, ws, men, mturk, rare;
+    mc = create_semantic_data_set("MC.txt");
+    rg = create_semantic_data_set("RG.txt");
+    ws = create_semantic_data_set("WS353.txt");
+    men = create_semantic_data_set("MEN.txt");
+    mturk = create_semantic_data_set("MTurk771.txt");
+    rare = create_semantic_data_set("RareWords.txt");
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    parameter->number_of_iterations = 15;
+    Vocabulary_ptr vocabulary = create_vocabulary(english);
+    Cooccurrence_matrix_ptr cooccurrence_matrix = create_cooccurrence_matrix(english, vocabulary, NULL, parameter, "english-xs.cooccur");
+    Glove_model_ptr glove_model = create_glove_model(vocabulary, cooccurrence_matrix, parameter);
+    Vectorized_dictionary_ptr dictionary = train_glove(glove_model);
+    free_word_to_vec_parameter(parameter);
+    Semantic_data_set_ptr mc2 = calculate_similarities(mc, dictionary);
+    printf("%.6lf\n", spearman_correlation(mc, mc2));
+    free_semantic_data_set(mc);
+    free_semantic_data_set(mc2);
+    Semantic_data_set_ptr rg2 = calculate_similarities(rg, dictionary);
+    printf("%.6lf\n", spearman_correlation(rg, rg2));
+    free_semantic_data_set(rg);
+    free_semantic_data_set(rg2);
+    Semantic_data_set_ptr ws2 = calculate_similarities(ws, dictionary);
+    printf("%.6lf\n", spearman_correlation(ws, ws2));
+    free_semantic_data_set(ws);
+    free_semantic_data_set(ws2);
+    Semantic_data_set_ptr men2 = calculate_similarities(men, dictionary);
+    printf("%.6lf\n", spearman_correlation(men, men2));
+    free_semantic_data_set(men);
+    free_semantic_data_set(men2);
+    Semantic_data_set_ptr mturk2 = calculate_similarities(mturk, dictionary);
+    printf("%.6lf\n", spearman_correlation(mturk, mturk2));
+    free_semantic_data_set(mturk);
+    free_semantic_data_set(mturk2);
+    Semantic_data_set_ptr rare2 = calculate_similarities(rare, dictionary);
+    printf("%.6lf\n", spearman_correlation(rare, rare2));
+    free_semantic_data_set(rare);
+    free_semantic_data_set(rare2);
+    free_vectorized_dictionary(dictionary);
+    free_glove_model(glove_model);
+    free_cooccurrence_matrix(cooccurrence_matrix);
+    unlink("english-xs.cooccur");
+    free_vocabulary(vocabulary);
+    free_corpus(english);
+}
+
+void test_cooccurrence_spills(){
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    Vocabulary_ptr vocabulary = create_vocabulary(english);
+    Cooccurrence_matrix_ptr expected = create_cooccurrence_matrix(english, vocabulary, NULL, parameter, "english-xs.cooccur");
+    parameter->cooccurrence_memory_limit = 64 * 1024;
+    Cooccurrence_matrix_ptr spilled = create_cooccurrence_matrix(english, vocabulary, NULL, parameter, "english-xs-spilled.cooccur");
+    if (expected == NULL || spilled == NULL || spilled->spill_count <= COOCCURRENCE_MERGE_FAN_IN){
+        printf("Error 1\n");
+        return;
+    }
+    if (expected->record_count != spilled->record_count){
+        printf("Error 2\n");
+    }
+    for (long long i = 0; i < expected->record_count && i < spilled->record_count; i++){
+        if (compare_cooccurrence_record(&expected->records[i], &spilled->records[i]) != 0 ||
+            fabs(expected->records[i].value - spilled->records[i].value) > 1e-9 * expected->records[i].value){
+            printf("Error 3\n");
+            break;
+        }
+    }
+    if (create_cooccurrence_matrix(english, vocabulary, NULL, parameter, "missing-directory/english-xs.cooccur") != NULL){
+        printf("Error 4\n");
+    }
+    Cooccurrence_matrix_ptr reopened = create_cooccurrence_matrix2("english-xs.cooccur");
+    Vocabulary_ptr other = create_vocabulary2();
+    array_list_add(other->vocabulary, create_vocabulary_word("w0", 2));
+    array_list_add(other->vocabulary, create_vocabulary_word("w1", 1));
+    other->total_number_of_words = 3;
+    prepare_vocabulary(other);
+    if (reopened == NULL || reopened->record_count != expected->record_count || create_glove_model(other, reopened, parameter) != NULL){
+        printf("Error 5\n");
+    }
+    free_vocabulary(other);
+    if (reopened != NULL){
+        free_cooccurrence_matrix(reopened);
+    }
+    long long negative = -1;
+    int outside = size_of_vocabulary(vocabulary);
+    swap_file_bytes("english-xs.cooccur", 8, &negative, sizeof(long long));
+    if (create_cooccurrence_matrix2("english-xs.cooccur") != NULL){
+        printf("Error 6\n");
+    }
+    swap_file_bytes("english-xs.cooccur", 8, &negative, sizeof(long long));
+    swap_file_bytes("english-xs.cooccur", 16, &outside, sizeof(int));
+    if (create_cooccurrence_matrix2("english-xs.cooccur") != NULL){
+        printf("Error 7\n");
+    }
+    free_cooccurrence_matrix(expected);
+    free_cooccurrence_matrix(spilled);
+    unlink("english-xs.cooccur");
+    unlink("english-xs-spilled.cooccur");
+    free_vocabulary(vocabulary);
+    free_word_to_vec_parameter(parameter);
+    free_corpus(english);
+}
+
+void test_train_english_sweep(){
+    Semantic_data_set_ptr mc, ws, men;
+    mc = create_semantic_data_set("MC.txt");
+    ws = create_semantic_data_set("WS353.txt");
+    men = create_semantic_data_set("MEN.txt");
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    Word_to_vec_parameter_ptr parameters[2];
+    parameters[0] = create_word_to_vec_parameter();
+    parameters[0]->cbow = true;
+    parameters[1] = create_word_to_vec_parameter();
+    parameters[1]->cbow = false;
+    Model_sweep_ptr model_sweep = create_model_sweep(english, NULL, parameters, 2);
+    Vectorized_dictionary_ptr* dictionaries = train_model_sweep(model_sweep);
+    for (int i = 0; i < 2; i++){
+        Semantic_data_set_ptr mc2 = calculate_similarities(mc, dictionaries[i]);
+        printf("%.6lf\n", spearman_correlation(mc, mc2));
+        free_semantic_data_set(mc2);
+        Semantic_data_set_ptr ws2 = calculate_similarities(ws, dictionaries[i]);
+        printf("%.6lf\n", spearman_correlation(ws, ws2));
+        free_semantic_data_set(ws2);
+        Semantic_data_set_ptr men2 = calculate_similarities(men, dictionaries[i]);
+        printf("%.6lf\n", spearman_correlation(men, men2));
+        free_semantic_data_set(men2);
+        free_vectorized_dictionary(dictionaries[i]);
+        free_word_to_vec_parameter(parameters[i]);
+    }
+    free_(dictionaries);
+    free_model_sweep(model_sweep);
+    free_semantic_data_set(mc);
+    free_semantic_data_set(ws);
+    free_semantic_data_set(men);
+    free_corpus(english);
+}
+
+void test_embedding_delta(){
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    Neural_network_ptr neural_network = create_neural_network(english, parameter);
+    if (!save_embedding_model2(neural_network, "english-xs.model")){
+        printf("Error 1\n");
+    }
+    for (int i = 0; i < neural_network->vector_length; i++){
+        neural_network->word_vectors[3][i] += 1;
+        neural_network->word_vectors[100][i] -= 1;
+    }
+    neural_network->row_versions[3] = neural_network->snapshot_version;
+    neural_network->row_versions[100] = neural_network->snapshot_version;
+    if (save_embedding_delta(neural_network, "english-xs.delta") != 2){
+        printf("Error 2\n");
+    }
+    Embedding_model_ptr expected = create_embedding_model(neural_network);
+    size_t vectors_size = (size_t) expected->word_count * expected->vector_length * sizeof(float);
+    Embedding_model_ptr embedding_model = create_embedding_model4("english-xs.model", false);
+    if (apply_embedding_delta(embedding_model, "english-xs.delta") != 2 ||
+        memcmp(embedding_model->vectors, expected->vectors, vectors_size) != 0){
+        printf("Error 3\n");
+    }
+    free_embedding_model(embedding_model);
+    FILE* input = fopen("english-xs.delta", "rb");
+    char buffer[4096];
+    size_t size = fread(buffer, 1, sizeof(buffer), input);
+    fclose(input);
+    FILE* output = fopen("english-xs.delta", "wb");
+    fwrite(buffer, 1, size - sizeof(float), output);
+    fclose(output);
+    embedding_model = create_embedding_model4("english-xs.model", false);
+    float* original = malloc_(vectors_size);
+    memcpy(original, embedding_model->vectors, vectors_size);
+    if (apply_embedding_delta(embedding_model, "english-xs.delta") != -1 ||
+        memcmp(embedding_model->vectors, original, vectors_size) != 0 || embedding_model->version != 1){
+        printf("Error 4\n");
+    }
+    free_(original);
+    free_embedding_model(embedding_model);
+    int negative = -1;
+    long long offsets[2] = {-4096, 8};
+    for (int i = 0; i < 2; i++){
+        swap_file_bytes("english-xs.model", i == 0 ? 8 : 12, &negative, sizeof(int));
+        if (create_embedding_model4("english-xs.model", false) != NULL){
+            printf("Error 5 %d\n", i);
+        }
+        swap_file_bytes("english-xs.model", i == 0 ? 8 : 12, &negative, sizeof(int));
+        swap_file_bytes("english-xs.model", 16, &offsets[i], sizeof(long long));
+        if (create_embedding_model4("english-xs.model", false) != NULL){
+            printf("Error 6 %d\n", i);
+        }
+        swap_file_bytes("english-xs.model", 16, &offsets[i], sizeof(long long));
+    }
+    long long vectors_offset;
+    input = fopen("english-xs.model", "rb");
+    fseek(input, 16, SEEK_SET);
+    fread(&vectors_offset, sizeof(long long), 1, input);
+    fclose(input);
+    char letter = 'a';
+    for (long offset = 24; offset < vectors_offset; offset++){
+        swap_file_bytes("english-xs.model", offset, &letter, 1);
+        letter = 'a';
+    }
+    if (create_embedding_model4("english-xs.model", false) != NULL){
+        printf("Error 7\n");
+    }
+    free_embedding_model(expected);
+    unlink("english-xs.model");
+    unlink("english-xs.delta");
+    free_neural_network(neural_network);
+    free_word_to_vec_parameter(parameter);
+    free_corpus(english);
+}
+
+void test_train_english_weight_files(){
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    parameter->cbow = true;
+    Word_to_vec_parameter file_parameter = *parameter;
+    file_parameter.weight_file_prefix = "english-xs-weights";
+    Neural_network_ptr heap_network = create_neural_network(english, parameter);
+    Neural_network_ptr file_network = create_neural_network(english, &file_parameter);
+    if (file_network == NULL || file_network->word_vectors_matrix->placement != FILE_PLACEMENT ||
+        file_network->word_vector_update_matrix->placement != FILE_PLACEMENT){
+        printf("Error 1\n");
+        return;
+    }
+    int word_count = size_of_vocabulary(heap_network->vocabulary);
+    for (int i = 0; i < word_count; i++){
+        memcpy(file_network->word_vectors[i], heap_network->word_vectors[i], heap_network->vector_length * sizeof(double));
+    }
+    train_network(heap_network);
+    train_network(file_network);
+    for (int i = 0; i < word_count; i++){
+        if (memcmp(file_network->word_vectors[i], heap_network->word_vectors[i], heap_network->vector_length * sizeof(double)) != 0){
+            printf("Error 2 %d\n", i);
+            break;
+        }
+    }
+    Embedding_model_ptr embedding_model = create_embedding_model5(file_network, "english-xs-weights.model");
+    if (embedding_model == NULL || embedding_model->word_count != word_count){
+        printf("Error 3\n");
+    } else {
+        for (int i = 0; i < word_count; i++){
+            const float* row = embedding_model_vector(embedding_model, i);
+            if (embedding_model_index(embedding_model, vocabulary_get_word(heap_network->vocabulary, i)->name) != i ||
+                row[0] != (float) heap_network->word_vectors[i][0] ||
+                row[heap_network->vector_length - 1] != (float) heap_network->word_vectors[i][heap_network->vector_length - 1]){
+                printf("Error 4 %d\n", i);
+                break;
+            }
+        }
+        free_embedding_model(embedding_model);
+    }
+    file_parameter.weight_file_prefix = "missing-directory/english-xs-weights";
+    Neural_network_ptr missing_network = create_neural_network(english, &file_parameter);
+    if (missing_network != NULL){
+        printf("Error 5\n");
+        free_neural_network(missing_network);
+    }
+    free_neural_network(file_network);
+    free_neural_network(heap_network);
+    unlink("english-xs-weights.vectors");
+    unlink("english-xs-weights.update");
+    unlink("english-xs-weights.model");
+    free_word_to_vec_parameter(parameter);
+    free_corpus(english);
+}
+
+/**
+ * Trains the same network twice in deterministic mode with four threads. Since the threads exchange their updates
+ * only in rounds of a fixed number of words, both dictionaries must hold exactly the same vectors.
+ */
+void test_train_english_deterministic(){
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    parameter->thread_count = 4;
+    parameter->deterministic = true;
+    Vectorized_dictionary_ptr dictionaries[2];
+    for (int i = 0; i < 2; i++){
+        Neural_network_ptr neural_network = create_neural_network(english, parameter);
+        dictionaries[i] = train(neural_network);
+        free_neural_network(neural_network);
+    }
+    Array_list_ptr words = dictionaries[0]->dictionary.words;
+    if (words->size == 0 || words->size != dictionaries[1]->dictionary.words->size){
+        printf("Error 1\n");
+    }
+    for (int i = 0; i < words->size; i++){
+        Vectorized_word_ptr word1 = array_list_get(words, i);
+        Vectorized_word_ptr word2 = get_word(&dictionaries[1]->dictionary, word1->word.name);
+        bool same = word2 != NULL && word2->vector->size == word1->vector->size;
+        for (int j = 0; same && j < word1->vector->size; j++){
+            same = get_value(word1->vector, j) == get_value(word2->vector, j);
+        }
+        if (!same){
+            printf("Error 2 %s\n", word1->word.name);
+            break;
+        }
+    }
+    free_vectorized_dictionary(dictionaries[0]);
+    free_vectorized_dictionary(dictionaries[1]);
+    free_word_to_vec_parameter(parameter);
+    free_corpus(english);
+}
+
+/**
+ * Trains english-xs with hierarchical softmax through the mapped corpus with a single thread, once with the top
+ * four levels of the Huffman tree cached as private rows and once without. With one thread, a private row only
+ * gathers the updates the shared row would have received and is written back to it before anything else reads
+ * it, so both runs must give the same vectors up to the rounding of these merges.
+ */
+void test_train_english_hs_cached_levels(){
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    parameter->cbow = true;
+    parameter->hierarchical_soft_max = true;
+    Vectorized_dictionary_ptr dictionaries[2];
+    for (int i = 0; i < 2; i++){
+        parameter->hs_cached_levels = 4 * i;
+        Mapped_corpus_ptr mapped_corpus = create_mapped_corpus("english-xs.txt", 1);
+        Neural_network_ptr neural_network = create_neural_network3(mapped_corpus, parameter);
+        dictionaries[i] = train(neural_network);
+        free_neural_network(neural_network);
+        free_mapped_corpus(mapped_corpus);
+    }
+    Array_list_ptr words = dictionaries[0]->dictionary.words;
+    if (words->size == 0 || words->size != dictionaries[1]->dictionary.words->size){
+        printf("Error 1\n");
+    }
+    double max_difference = 0;
+    for (int i = 0; i < words->size; i++){
+        Vectorized_word_ptr word1 = array_list_get(words, i);
+        Vectorized_word_ptr word2 = get_word(&dictionaries[1]->dictionary, word1->word.name);
+        if (word2 == NULL || word2->vector->size != word1->vector->size){
+            printf("Error 2 %s\n", word1->word.name);
+            break;
+        }
+        for (int j = 0; j < word1->vector->size; j++){
+            double difference = fabs(get_value(word1->vector, j) - get_value(word2->vector, j));
+            if (difference > max_difference){
+                max_difference = difference;
+            }
+        }
+    }
+    if (max_difference > 1e-9){
+        printf("Error 3 %g\n", max_difference);
+    }
+    free_vectorized_dictionary(dictionaries[0]);
+    free_vectorized_dictionary(dictionaries[1]);
+    free_word_to_vec_parameter(parameter);
+}
+
 void test_with_word_vectors(){
     Semantic_data_set_ptr mc, rg, ws, men, mturk, rare;
     mc = create_semantic_data_set("MC.txt");
@@ -135,5 +513,12 @@ void test_with_word_vectors(){
 int main(){
     start_large_memory_check();
     test_train_english_cbow();
+    test_embedding_delta();
+    test_train_english_weight_files();
+    test_train_english_deterministic();
+    test_train_english_hs_cached_levels();
+    test_train_english_sweep();
+    test_train_english_glove();
+    test_cooccurrence_spills();
     end_memory_check();
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <Corpus.h>
+#include <Memory/Memory.h>
+
+#include "../src/PhraseDetector.h"
+#include "../src/Vocabulary.h"
+
+static const char* PHRASE_CORPUS_FILE = "phrase-detector-test.txt";
+
+/**
+ * Writes a corpus of 1000 sentences of six words, where every sentence starts with "new york" and the other words
+ * are drawn from 200 filler words, so that no bigram of fillers occurs more than a few times. Since no word
+ * precedes "new", a filler can not be joined with it before "new york" is scored.
+ */
+static void write_phrase_corpus() {
+    FILE* output = fopen(PHRASE_CORPUS_FILE, "w");
+    unsigned long long next_random = 1;
+    for (int i = 0; i < 1000; i++){
+        for (int j = 0; j < 6; j++){
+            if (j == 0){
+                fprintf(output, "new");
+            } else if (j == 1){
+                fprintf(output, " york");
+            } else {
+                next_random = next_random * 25214903917ULL + 11;
+                fprintf(output, " f%llu", (next_random >> 16) % 200);
+            }
+        }
+        fprintf(output, "\n");
+    }
+    fclose(output);
+}
+
+/**
+ * Checks that every sentence read through the detector is rewritten to five words with "new_york" at index 0 if
+ * join is true, and is left as six words otherwise.
+ * @param phrase_detector Phrase detector to read through.
+ * @param corpus Corpus to read.
+ * @param join True if "new york" is expected to be joined.
+ * @return Number of sentences that are not rewritten as expected.
+ */
+static int count_unexpected_sentences(Phrase_detector_ptr phrase_detector, Corpus_ptr corpus, bool join) {
+    int unexpected = 0, sentence_count = 0;
+    corpus_open(corpus);
+    Sentence_ptr sentence = phrase_get_sentence(phrase_detector, corpus);
+    while (sentence != NULL){
+        sentence_count++;
+        if (join){
+            if (sentence_word_count(sentence) != 5 || strcmp(sentence_get_word(sentence, 0), "new_york") != 0){
+                unexpected++;
+            }
+        } else {
+            if (sentence_word_count(sentence) != 6 || strcmp(sentence_get_word(sentence, 0), "new") != 0){
+                unexpected++;
+            }
+        }
+        sentence = phrase_get_sentence(phrase_detector, corpus);
+    }
+    corpus_close(corpus);
+    return unexpected + (sentence_count != 1000);
+}
+
+/**
+ * Detects phrases in a corpus where "new york" is the only frequent bigram. Its score is (1000 - 5) / (1000 * 1000)
+ * * 6000, about 6, so with a threshold of 1 the pair is joined in every sentence and becomes a single word of the
+ * vocabulary, while no bigram with a filler word is joined. With the default threshold of 100 nothing is joined.
+ * A thread count of zero counts on one thread.
+ */
+int main(){
+    start_large_memory_check();
+    write_phrase_corpus();
+    Corpus_ptr corpus = create_corpus2(PHRASE_CORPUS_FILE);
+    Phrase_detector_ptr phrase_detector = create_phrase_detector2(corpus, 2, 5, 1);
+    if (phrase_detector->total_number_of_words != 6000){
+        printf("Error 1 %lld\n", phrase_detector->total_number_of_words);
+    }
+    double score = phrase_score(phrase_detector, "new", "york");
+    if (score < 5.9 || score > 6.0 || phrase_score(phrase_detector, "york", "new") != 0){
+        printf("Error 2 %.3lf\n", score);
+    }
+    int unexpected = count_unexpected_sentences(phrase_detector, corpus, true);
+    if (unexpected != 0){
+        printf("Error 3 %d\n", unexpected);
+    }
+    Vocabulary_ptr vocabulary = create_vocabulary3(corpus, phrase_detector);
+    if (hash_map_get(vocabulary->word_map, "new_york") == NULL || hash_map_get(vocabulary->word_map, "new") != NULL ||
+        vocabulary_get_word(vocabulary, get_position(vocabulary, "new_york"))->count != 1000 || vocabulary->total_number_of_words != 5000){
+        printf("Error 4\n");
+    }
+    free_vocabulary(vocabulary);
+    free_phrase_detector(phrase_detector);
+    phrase_detector = create_phrase_detector(corpus, 2);
+    unexpected = count_unexpected_sentences(phrase_detector, corpus, false);
+    if (unexpected != 0){
+        printf("Error 5 %d\n", unexpected);
+    }
+    free_phrase_detector(phrase_detector);
+    phrase_detector = create_phrase_detector2(corpus, 0, 5, 1);
+    if (phrase_detector->total_number_of_words != 6000 || phrase_score(phrase_detector, "new", "york") != score){
+        printf("Error 6 %lld\n", phrase_detector->total_number_of_words);
+    }
+    free_phrase_detector(phrase_detector);
+    free_corpus(corpus);
+    remove(PHRASE_CORPUS_FILE);
+    end_memory_check();
+}
@@ -0,0 +1,157 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <Memory/Memory.h>
+
+#include "../src/ProductQuantizer.h"
+
+static const char* QUANTIZER_FILE = "product-quantizer-test.bin";
+
+/**
+ * Quantizes a model of 4000 words drawn around 100 cluster centers, and checks the reconstruction error, the recall
+ * of the search against the exact search (words of the same cluster are hardly separated by the codes alone, so only
+ * the reranked search is expected to find nearly all neighbors), and a save and load round trip of a quantizer
+ * holding a word of 2000 characters. A file whose number of centroids does not fit in one byte is rejected.
+ */
+void test_product_quantizer(){
+    int word_count = 4000, vector_length = 32, cluster_count = 100;
+    Embedding_model_ptr embedding_model = create_embedding_model3(word_count, vector_length);
+    float* centers = malloc_((size_t) cluster_count * vector_length * sizeof(float));
+    srand(7);
+    for (int i = 0; i < cluster_count * vector_length; i++){
+        centers[i] = rand() / (float) RAND_MAX - 0.5f;
+    }
+    char word[16], long_word[2001];
+    memset(long_word, 'a', 2000);
+    long_word[2000] = '\0';
+    for (int i = 0; i < word_count; i++){
+        sprintf(word, "w%d", i);
+        embedding_model_set_word(embedding_model, i, i == 5 ? long_word : word);
+        for (int j = 0; j < vector_length; j++){
+            embedding_model->vectors[(size_t) i * vector_length + j] = centers[(i % cluster_count) * vector_length + j] + 0.05f * (rand() / (float) RAND_MAX - 0.5f);
+        }
+    }
+    free_(centers);
+    Product_quantizer_ptr product_quantizer = create_product_quantizer(embedding_model, 8, 1);
+    if (product_quantizer == NULL){
+        printf("Error 1\n");
+        return;
+    }
+    float decoded[vector_length];
+    double error = 0, norm = 0;
+    for (int i = 0; i < word_count; i++){
+        const float* row = embedding_model_vector(embedding_model, i);
+        double row_norm = 0;
+        for (int j = 0; j < vector_length; j++){
+            row_norm += row[j] * row[j];
+        }
+        decode_product_quantizer_row(product_quantizer, i, decoded);
+        for (int j = 0; j < vector_length; j++){
+            double difference = decoded[j] - row[j] / sqrt(row_norm);
+            error += difference * difference;
+        }
+        norm += 1;
+    }
+    if (error / norm > 0.05){
+        printf("Error 2 %.4lf\n", error / norm);
+    }
+    Nearest_neighbors_ptr nearest_neighbors = create_nearest_neighbors(embedding_model);
+    double recall = product_quantizer_recall(product_quantizer, nearest_neighbors, 200, 10, 0);
+    double reranked_recall = product_quantizer_recall(product_quantizer, nearest_neighbors, 200, 10, 100);
+    printf("Recall at 10: %.3lf, reranked: %.3lf\n", recall, reranked_recall);
+    if (recall < 0.1 || reranked_recall < 0.95 || reranked_recall < recall){
+        printf("Error 3\n");
+    }
+    if (!save_product_quantizer(product_quantizer, QUANTIZER_FILE)){
+        printf("Error 4\n");
+    }
+    Product_quantizer_ptr loaded = create_product_quantizer2(QUANTIZER_FILE);
+    if (loaded == NULL || loaded->word_count != word_count || product_quantizer_index(loaded, "w3999") != 3999 ||
+        strlen(loaded->words[5]) != 2000 || product_quantizer_index(loaded, long_word) != 5 ||
+        memcmp(loaded->codes, product_quantizer->codes, (size_t) (word_count + PQ_BLOCK_ROWS - 1) / PQ_BLOCK_ROWS * PQ_BLOCK_ROWS * 8) != 0){
+        printf("Error 5\n");
+    }
+    if (loaded != NULL){
+        free_product_quantizer(loaded);
+    }
+    FILE* file = fopen(QUANTIZER_FILE, "r+b");
+    int centroid_count = PQ_CENTROID_COUNT + 1;
+    fseek(file, 4 * sizeof(int), SEEK_SET);
+    fwrite(&centroid_count, sizeof(int), 1, file);
+    fclose(file);
+    loaded = create_product_quantizer2(QUANTIZER_FILE);
+    if (loaded != NULL){
+        printf("Error 6\n");
+        free_product_quantizer(loaded);
+    }
+    unlink(QUANTIZER_FILE);
+    free_nearest_neighbors(nearest_neighbors);
+    free_product_quantizer(product_quantizer);
+    free_embedding_model(embedding_model);
+}
+
+/**
+ * Writes a byte into the codes at the end of a quantizer file.
+ * @param code_size Number of code bytes at the end of the file.
+ * @param offset Offset of the byte in the codes.
+ * @param value Value of the byte.
+ */
+static void write_code_byte(int code_size, int offset, unsigned char value) {
+    FILE* file = fopen(QUANTIZER_FILE, "r+b");
+    fseek(file, offset - code_size, SEEK_END);
+    fwrite(&value, 1, 1, file);
+    fclose(file);
+}
+
+/**
+ * Quantizes a model of 100 words with 2 subspaces, so that every subspace has 100 centroids and the last block of
+ * 32 rows has 28 padding rows. A padding code changed in the file is loaded as 0, and a file where the code of the
+ * last word selects the centroid 100 is rejected.
+ */
+void test_product_quantizer_codes(){
+    int word_count = 100, vector_length = 8, code_size = 128 * 2;
+    Embedding_model_ptr embedding_model = create_embedding_model3(word_count, vector_length);
+    char word[16];
+    srand(11);
+    for (int i = 0; i < word_count; i++){
+        sprintf(word, "w%d", i);
+        embedding_model_set_word(embedding_model, i, word);
+        for (int j = 0; j < vector_length; j++){
+            embedding_model->vectors[(size_t) i * vector_length + j] = rand() / (float) RAND_MAX - 0.5f;
+        }
+    }
+    Product_quantizer_ptr product_quantizer = create_product_quantizer(embedding_model, 2, 1);
+    if (product_quantizer == NULL || product_quantizer->centroid_count != 100 || !save_product_quantizer(product_quantizer, QUANTIZER_FILE)){
+        printf("Error 7\n");
+        return;
+    }
+    write_code_byte(code_size, 3 * 2 * 32 + 4, 255);
+    Product_quantizer_ptr loaded = create_product_quantizer2(QUANTIZER_FILE);
+    if (loaded == NULL || loaded->codes[3 * 2 * 32 + 4] != 0 ||
+        memcmp(loaded->codes, product_quantizer->codes, code_size) != 0){
+        printf("Error 8\n");
+    }
+    if (loaded != NULL){
+        free_product_quantizer(loaded);
+    }
+    write_code_byte(code_size, 3 * 2 * 32 + 3, 100);
+    loaded = create_product_quantizer2(QUANTIZER_FILE);
+    if (loaded != NULL){
+        printf("Error 9\n");
+        free_product_quantizer(loaded);
+    }
+    unlink(QUANTIZER_FILE);
+    free_product_quantizer(product_quantizer);
+    free_embedding_model(embedding_model);
+}
+
+int main(){
+    test_product_quantizer();
+    test_product_quantizer_codes();
+}
@@ -0,0 +1,120 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "../src/QueryServer.h"
+
+#define CLIENT_COUNT 8
+
+static const char* SOCKET_PATH = "query-server-test.sock";
+
+static int connect_to_server() {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, SOCKET_PATH);
+    int descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connect(descriptor, (struct sockaddr*) &address, sizeof(address)) < 0){
+        close(descriptor);
+        return -1;
+    }
+    return descriptor;
+}
+
+static int ask(int descriptor, const char* request, char* response, int size) {
+    int length = 0;
+    send(descriptor, request, strlen(request), 0);
+    while (length < size - 1){
+        ssize_t received = recv(descriptor, response + length, size - 1 - length, 0);
+        if (received <= 0){
+            break;
+        }
+        length += (int) received;
+        if (response[length - 1] == '\n'){
+            break;
+        }
+    }
+    response[length] = '\0';
+    return length;
+}
+
+static void* run_client(void* argument) {
+    int* errors = argument;
+    char response[4096];
+    int descriptor = connect_to_server();
+    for (int i = 0; i < 50; i++){
+        ask(descriptor, "TOPK 3 w0\n", response, sizeof(response));
+        if (strncmp(response, "OK w1 ", 6) != 0){
+            (*errors)++;
+        }
+    }
+    close(descriptor);
+    return NULL;
+}
+
+void test_query_server(){
+    Embedding_model_ptr embedding_model = create_embedding_model3(1000, 16);
+    char word[16];
+    for (int i = 0; i < 1000; i++){
+        sprintf(word, "w%d", i);
+        embedding_model_set_word(embedding_model, i, word);
+        float* row = embedding_model->vectors + (size_t) i * 16;
+        row[0] = 1;
+        row[1 + i % 15] = i * 0.001f;
+    }
+    Query_server_ptr query_server = create_query_server(embedding_model, SOCKET_PATH, 0);
+    if (!start_query_server(query_server)){
+        printf("Error 1\n");
+        return;
+    }
+    char response[4096];
+    int descriptor = connect_to_server();
+    ask(descriptor, "VECTOR w15\n", response, sizeof(response));
+    if (strncmp(response, "OK 1 0.015 0 0", 14) != 0){
+        printf("Error 2\n");
+    }
+    ask(descriptor, "SIMILARITY w1 w16\n", response, sizeof(response));
+    if (fabs(atof(response + 3) - cosine_similarity_of_rows(query_server->nearest_neighbors, 1, 16)) > 1e-5){
+        printf("Error 3\n");
+    }
+    ask(descriptor, "TOPK 2 w0\n", response, sizeof(response));
+    if (strncmp(response, "OK w1 ", 6) != 0 || strstr(response, " w0 ") != NULL){
+        printf("Error 4\n");
+    }
+    ask(descriptor, "VECTOR unknown\n", response, sizeof(response));
+    if (strncmp(response, "ERR", 3) != 0){
+        printf("Error 5\n");
+    }
+    int errors[CLIENT_COUNT] = {0};
+    pthread_t clients[CLIENT_COUNT];
+    for (int i = 0; i < CLIENT_COUNT; i++){
+        pthread_create(&clients[i], NULL, run_client, &errors[i]);
+    }
+    for (int i = 0; i < CLIENT_COUNT; i++){
+        pthread_join(clients[i], NULL);
+        if (errors[i] != 0){
+            printf("Error 6\n");
+        }
+    }
+    ask(descriptor, "STATS\n", response, sizeof(response));
+    if (strstr(response, "topk_count=401 ") == NULL){
+        printf("Error 7\n");
+    }
+    close(descriptor);
+    stop_query_server(query_server);
+    free_query_server(query_server);
+    free_embedding_model(embedding_model);
+}
+
+int main(){
+    test_query_server();
+}
@@ -0,0 +1,81 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <Memory/Memory.h>
+
+#include "../src/SentenceEmbedder.h"
+
+/**
+ * Reads a whole file into memory.
+ * @param file_name Name of the file.
+ * @param size Output, size of the file.
+ * @return Contents of the file, NULL if it could not be read.
+ */
+static char* read_file(const char* file_name, long* size) {
+    FILE* input = fopen(file_name, "rb");
+    if (input == NULL){
+        return NULL;
+    }
+    fseek(input, 0, SEEK_END);
+    *size = ftell(input);
+    fseek(input, 0, SEEK_SET);
+    char* result = malloc_(*size + 1);
+    if (fread(result, 1, *size, input) != (size_t) *size){
+        free_(result);
+        result = NULL;
+    }
+    fclose(input);
+    return result;
+}
+
+/**
+ * Embeds english-xs with one, four and zero threads, the last taken as one, and checks that the files hold one row
+ * per sentence and are identical, since the writer keeps the corpus order whatever the number of workers. Files
+ * that can not be opened or written are reported.
+ */
+void test_embed_corpus(){
+    Corpus_ptr english = create_corpus2("english-xs.txt");
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    Neural_network_ptr neural_network = create_neural_network(english, parameter);
+    Embedding_model_ptr embedding_model = create_embedding_model(neural_network);
+    Sentence_embedder_ptr sentence_embedder = create_sentence_embedder(embedding_model, neural_network->vocabulary, 1e-3);
+    long long sentence_count = embed_corpus(sentence_embedder, english, "english-xs-sentences1.bin", 1);
+    if (sentence_count <= SENTENCE_BATCH_SIZE){
+        printf("Error 1 %lld\n", sentence_count);
+    }
+    if (embed_corpus(sentence_embedder, english, "english-xs-sentences4.bin", 4) != sentence_count ||
+        embed_corpus(sentence_embedder, english, "english-xs-sentences0.bin", 0) != sentence_count){
+        printf("Error 2\n");
+    }
+    long size1, size4, size0;
+    char* file1 = read_file("english-xs-sentences1.bin", &size1);
+    char* file4 = read_file("english-xs-sentences4.bin", &size4);
+    char* file0 = read_file("english-xs-sentences0.bin", &size0);
+    if (file1 == NULL || file4 == NULL || file0 == NULL || size1 != sentence_count * embedding_model->vector_length * (long) sizeof(float) ||
+        size4 != size1 || size0 != size1 || memcmp(file1, file4, size1) != 0 || memcmp(file1, file0, size1) != 0){
+        printf("Error 3\n");
+    }
+    free_(file1);
+    free_(file4);
+    free_(file0);
+    if (embed_corpus(sentence_embedder, english, "missing-directory/english-xs-sentences.bin", 2) != -1 ||
+        embed_corpus(sentence_embedder, english, "/dev/full", 2) != -1){
+        printf("Error 4\n");
+    }
+    unlink("english-xs-sentences1.bin");
+    unlink("english-xs-sentences4.bin");
+    unlink("english-xs-sentences0.bin");
+    free_sentence_embedder(sentence_embedder);
+    free_embedding_model(embedding_model);
+    free_neural_network(neural_network);
+    free_word_to_vec_parameter(parameter);
+    free_corpus(english);
+}
+
+int main(){
+    test_embed_corpus();
+}
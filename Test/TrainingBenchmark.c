@@ -0,0 +1,107 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <time.h>
+#include <math.h>
+#include <unistd.h>
+#include <Memory/Memory.h>
+#include <Corpus.h>
+
+#include "../src/NeuralNetwork.h"
+#include "../src/ParallelTraining.h"
+
+/**
+ * Writes a synthetic corpus whose word frequencies follow a Zipf like distribution over vocabulary_size words.
+ * With a large vocabulary, the weight matrices do not fit into the last level cache, so most rows read while
+ * training come from memory.
+ * @param file_name Name of the corpus file.
+ * @param vocabulary_size Number of distinct words.
+ * @param sentence_count Number of sentences.
+ */
+static void write_zipf_corpus(const char* file_name, int vocabulary_size, int sentence_count) {
+    FILE* output = fopen(file_name, "w");
+    unsigned long long next_random = 1;
+    for (int i = 0; i < sentence_count; i++){
+        for (int j = 0; j < 20; j++){
+            next_random = next_random * 25214903917ULL + 11;
+            double uniform = ((next_random >> 16) & 0xFFFFFFFF) / 4294967296.0;
+            int index = (int) (exp(uniform * log(vocabulary_size)));
+            fprintf(output, "%sw%d", j > 0 ? " " : "", index);
+        }
+        fprintf(output, "\n");
+    }
+    fclose(output);
+}
+
+/**
+ * Measures the throughput of the single threaded trainer with both weight matrices allocated on the heap row by
+ * row, and placed in one slab of huge pages in frequency order. Built with PHASE_COUNTERS, the training also prints
+ * the data TLB misses of each phase. The single threaded trainer issues no prefetches, so this measures the layout
+ * alone.
+ * @param corpus Corpus to train on.
+ */
+static void benchmark_row_layout(Corpus_ptr corpus) {
+    for (int huge_pages = 0; huge_pages <= 1; huge_pages++){
+        Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+        parameter->cbow = 1;
+        parameter->number_of_iterations = 1;
+        parameter->layer_size = 128;
+        parameter->huge_pages = huge_pages;
+        Neural_network_ptr neural_network = create_neural_network(corpus, parameter);
+        long long words = neural_network->vocabulary->total_number_of_words;
+        struct timespec start, end;
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        Vectorized_dictionary_ptr dictionary = train(neural_network);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+        printf("%s rows: %.3lf seconds, %.0lf words/sec\n", huge_pages ? "Huge page" : "Heap", seconds, words / seconds);
+        free_vectorized_dictionary(dictionary);
+        free_neural_network(neural_network);
+        free_word_to_vec_parameter(parameter);
+    }
+}
+
+/**
+ * Measures the training throughput of the multi-threaded trainer, with one thread per online cpu, for several
+ * prefetch distances on a vocabulary of several hundred thousand words, for both CBow and SkipGram, and compares the
+ * row layouts of the weight matrices. Every distance trains a freshly initialized network, so that all distances
+ * start from the same weights. The sequential trainer used when thread_count is 1 does not prefetch, so the
+ * prefetch distance only matters for the multi-threaded trainer.
+ */
+int main(){
+    start_large_memory_check();
+    int distances[] = {0, 1, 2, 4, 8, 16};
+    int distance_count = sizeof(distances) / sizeof(int);
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    write_zipf_corpus("training-benchmark.txt", 500000, 100000);
+    Corpus_ptr corpus = create_corpus2("training-benchmark.txt");
+    for (int cbow = 1; cbow >= 0; cbow--){
+        for (int i = 0; i < distance_count; i++){
+            Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+            parameter->cbow = cbow;
+            parameter->number_of_iterations = 1;
+            parameter->layer_size = 128;
+            parameter->thread_count = processors > 1 ? (int) processors : 2;
+            parameter->prefetch_distance = distances[i];
+            Neural_network_ptr neural_network = create_neural_network(corpus, parameter);
+            long long words = neural_network->vocabulary->total_number_of_words;
+            if (i == 0){
+                printf("%s vocabulary %d words %lld threads %d\n", cbow ? "CBow" : "SkipGram", size_of_vocabulary(neural_network->vocabulary), words, parameter->thread_count);
+            }
+            struct timespec start, end;
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            train_parallel(neural_network);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+            printf("Prefetch distance %d: %.3lf seconds, %.0lf words/sec\n", distances[i], seconds, words / seconds);
+            free_neural_network(neural_network);
+            free_word_to_vec_parameter(parameter);
+        }
+    }
+    benchmark_row_layout(corpus);
+    free_corpus(corpus);
+    remove("training-benchmark.txt");
+    end_memory_check();
+}
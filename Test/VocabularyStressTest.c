@@ -0,0 +1,169 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <Corpus.h>
+#include <Memory/Memory.h>
+
+#include "../src/Vocabulary.h"
+#include "../src/Iteration.h"
+
+/**
+ * Writes a corpus of the words w0 to w9999, where word wi occurs 100000 / (i + 1) times, about a million tokens in
+ * sentences of ten words, and counts it through create_vocabulary. Every count, the total and the order of the
+ * vocabulary must be the ones of the generated corpus.
+ */
+static void test_count_generated_corpus() {
+    int word_count = 10000, top_count = 100000;
+    long long total = 0, written = 0;
+    FILE* output = fopen("vocabulary-stress.txt", "w");
+    for (int round = 0; round < top_count; round++){
+        for (int i = 0; i < word_count && top_count / (i + 1) > round; i++){
+            fprintf(output, written % 10 == 9 ? "w%d\n" : "w%d ", i);
+            written++;
+        }
+    }
+    fprintf(output, "\n");
+    fclose(output);
+    for (int i = 0; i < word_count; i++){
+        total += top_count / (i + 1);
+    }
+    clock_t start = clock();
+    Corpus_ptr corpus = create_corpus2("vocabulary-stress.txt");
+    Vocabulary_ptr vocabulary = create_vocabulary(corpus);
+    printf("Vocabulary counted from %lld tokens in %.3lf seconds\n", total, (clock() - start) / (double) CLOCKS_PER_SEC);
+    if (size_of_vocabulary(vocabulary) != word_count || vocabulary->total_number_of_words != total || written != total){
+        printf("Error 13 %d %lld\n", size_of_vocabulary(vocabulary), vocabulary->total_number_of_words);
+    }
+    char name[32];
+    for (int i = 0; i < word_count; i++){
+        sprintf(name, "w%d", i);
+        int* position = hash_map_get(vocabulary->word_map, name);
+        if (position == NULL || vocabulary_get_word(vocabulary, *position)->count != top_count / (i + 1)){
+            printf("Error 14 %s\n", name);
+            break;
+        }
+    }
+    if (strcmp(vocabulary_get_word(vocabulary, 0)->name, "w0") != 0 || vocabulary_get_word(vocabulary, 0)->count != top_count){
+        printf("Error 15\n");
+    }
+    free_vocabulary(vocabulary);
+    free_corpus(corpus);
+    remove("vocabulary-stress.txt");
+}
+
+/**
+ * Builds a synthetic vocabulary of one million words with Zipf distributed counts. The most frequent word occurs
+ * four billion times and the corpus has more than fifty billion tokens, so every counter overflows if it is
+ * stored in 32 bits. The vocabulary is also saved into a vocabulary file and loaded back, and the file is rejected
+ * after the frequency rank of its first record, 32 bytes into the record behind the 72 byte header, is set out
+ * of range. Finally a generated corpus file is counted through create_vocabulary.
+ */
+int main(){
+    start_large_memory_check();
+    int word_count = 1000000;
+    long long top_count = 4000000000LL;
+    long long total = 0;
+    char name[32];
+    clock_t start = clock();
+    Vocabulary_ptr vocabulary = create_vocabulary2();
+    for (int i = 0; i < word_count; i++){
+        sprintf(name, "w%d", i);
+        long long count = top_count / (i + 1);
+        array_list_add(vocabulary->vocabulary, create_vocabulary_word(name, count));
+        total += count;
+    }
+    vocabulary->total_number_of_words = total;
+    prepare_vocabulary(vocabulary);
+    printf("Vocabulary prepared in %.3lf seconds\n", (clock() - start) / (double) CLOCKS_PER_SEC);
+    if (vocabulary->total_number_of_words <= 50000000000LL){
+        printf("Error 1 %lld\n", vocabulary->total_number_of_words);
+    }
+    if (vocabulary_get_word(vocabulary, get_position(vocabulary, "w0"))->count != top_count){
+        printf("Error 2 %lld\n", vocabulary_get_word(vocabulary, get_position(vocabulary, "w0"))->count);
+    }
+    Vocabulary_word_ptr frequent = vocabulary_get_word(vocabulary, get_position(vocabulary, "w0"));
+    Vocabulary_word_ptr rare = vocabulary_get_word(vocabulary, get_position(vocabulary, "w999999"));
+    if (frequent->code_length >= rare->code_length || rare->code_length > MAX_CODE_LENGTH){
+        printf("Error 3 %d %d\n", frequent->code_length, rare->code_length);
+    }
+    if (get_table_value(vocabulary, 0) != 0 || get_table_value(vocabulary, vocabulary->table->size - 1) >= word_count){
+        printf("Error 4\n");
+    }
+    for (int i = 1; i < vocabulary->table->size; i++){
+        if (get_table_value(vocabulary, i) < get_table_value(vocabulary, i - 1)){
+            printf("Error 5 %d\n", i);
+            break;
+        }
+    }
+    Corpus_fingerprint fingerprint = {1, 2, 3, 0};
+    if (!save_vocabulary(vocabulary, "vocabulary-stress.cache", &fingerprint)){
+        printf("Error 8\n");
+    }
+    start = clock();
+    Vocabulary_ptr loaded = create_vocabulary5("vocabulary-stress.cache", &fingerprint);
+    printf("Vocabulary loaded in %.3lf seconds\n", (clock() - start) / (double) CLOCKS_PER_SEC);
+    if (loaded == NULL || size_of_vocabulary(loaded) != word_count || loaded->total_number_of_words != total ||
+        loaded->table->size != vocabulary->table->size){
+        printf("Error 9\n");
+    } else {
+        for (int i = 0; i < word_count; i++){
+            Vocabulary_word_ptr word1 = vocabulary_get_word(vocabulary, i);
+            Vocabulary_word_ptr word2 = vocabulary_get_word(loaded, i);
+            if (word1->count != word2->count || word1->frequency_rank != word2->frequency_rank || word1->code_length != word2->code_length ||
+                memcmp(word1->code, word2->code, word1->code_length * sizeof(int)) != 0 || memcmp(word1->point, word2->point, word1->code_length * sizeof(int)) != 0 ||
+                get_position(loaded, word1->name) != i){
+                printf("Error 10 %s\n", word1->name);
+                break;
+            }
+        }
+        free_vocabulary(loaded);
+    }
+    fingerprint.content_hash++;
+    loaded = create_vocabulary5("vocabulary-stress.cache", &fingerprint);
+    if (loaded != NULL){
+        printf("Error 11\n");
+        free_vocabulary(loaded);
+    }
+    fingerprint.content_hash--;
+    FILE* cache = fopen("vocabulary-stress.cache", "r+b");
+    int corrupt_rank = word_count;
+    fseek(cache, 72 + 32, SEEK_SET);
+    fwrite(&corrupt_rank, sizeof(int), 1, cache);
+    fclose(cache);
+    loaded = create_vocabulary5("vocabulary-stress.cache", &fingerprint);
+    if (loaded != NULL){
+        printf("Error 12\n");
+        free_vocabulary(loaded);
+    }
+    remove("vocabulary-stress.cache");
+    Word_to_vec_parameter_ptr parameter = create_word_to_vec_parameter();
+    Iteration_ptr iteration = create_iteration(NULL, parameter);
+    double previous_alpha = iteration->alpha;
+    start = clock();
+    for (int i = 0; i < parameter->number_of_iterations; i++){
+        iteration->word_count = 0;
+        iteration->last_word_count = 0;
+        while (iteration->word_count < total){
+            iteration->word_count += 10001;
+            alpha_update(iteration, total);
+            if (iteration->alpha > previous_alpha || iteration->alpha <= 0){
+                printf("Error 6 %.10lf %.10lf\n", previous_alpha, iteration->alpha);
+                break;
+            }
+            previous_alpha = iteration->alpha;
+        }
+    }
+    printf("Learning rate scheduled over %lld words in %.3lf seconds\n", parameter->number_of_iterations * total, (clock() - start) / (double) CLOCKS_PER_SEC);
+    if (iteration->alpha > parameter->alpha * 0.001){
+        printf("Error 7 %.10lf\n", iteration->alpha);
+    }
+    free_iteration(iteration);
+    free_word_to_vec_parameter(parameter);
+    free_vocabulary(vocabulary);
+    test_count_generated_corpus();
+    end_memory_check();
+}
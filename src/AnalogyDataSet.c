@@ -0,0 +1,344 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <math.h>
+#include <pthread.h>
+#include <FileUtils.h>
+#include <StringUtils.h>
+#include <Memory/Memory.h>
+#include "AnalogyDataSet.h"
+
+#define ANALOGY_PANEL_WIDTH 64
+#define ANALOGY_TILE_ROWS 8
+#define ANALOGY_BLOCK_PANELS 8
+#define ANALOGY_KERNEL_ROWS 4
+#define ANALOGY_KERNEL_COLUMNS 32
+
+struct analogy_task{
+    const Embedding_model* embedding_model;
+    const float* inverse_norms;
+    const float* panels;
+    const int* query_words;
+    int question_count;
+    int panel_count;
+    int terms;
+    Analogy_method method;
+    int start;
+    int end;
+    float* best_scores;
+    int* best_words;
+};
+
+typedef struct analogy_task Analogy_task;
+
+/**
+ * Constructor for the analogy dataset. Reads analogy questions from an input file, one question of four words per
+ * line. Lines starting with ':' are section headers and are skipped.
+ * @param file_name Input file that stores the analogy questions.
+ * @return Analogy dataset read from an input file
+ */
+Analogy_data_set_ptr create_analogy_data_set(const char *file_name) {
+    Analogy_data_set_ptr result = create_analogy_data_set2();
+    Array_list_ptr lines = read_lines(file_name);
+    for (int i = 0; i < lines->size; i++){
+        char* line = array_list_get(lines, i);
+        if (line[0] == ':'){
+            continue;
+        }
+        Array_list_ptr items = str_split(line, ' ');
+        if (items->size >= 4){
+            array_list_add(result->questions, create_analogy_question(array_list_get(items, 0),
+                                                                      array_list_get(items, 1),
+                                                                      array_list_get(items, 2),
+                                                                      array_list_get(items, 3)));
+        }
+        free_array_list(items, free_);
+    }
+    free_array_list(lines, free_);
+    return result;
+}
+
+/**
+ * Empty constructor for the analogy dataset.
+ * @return Empty analogy dataset
+ */
+Analogy_data_set_ptr create_analogy_data_set2() {
+    Analogy_data_set_ptr result = malloc_(sizeof(Analogy_data_set));
+    result->questions = create_array_list();
+    return result;
+}
+
+/**
+ * Frees memory allocated for an analogy dataset. Frees questions array list.
+ * @param analogy_data_set Analogy dataset to deallocate
+ */
+void free_analogy_data_set(Analogy_data_set_ptr analogy_data_set) {
+    free_array_list(analogy_data_set->questions, (void (*)(void *)) free_analogy_question);
+    free_(analogy_data_set);
+}
+
+/**
+ * Multiplies a tile of consecutive vocabulary rows with all query columns of a panel. Query columns are stored
+ * dimension major, and the products are accumulated in blocks of ANALOGY_KERNEL_ROWS rows and
+ * ANALOGY_KERNEL_COLUMNS columns that fit into registers, so every loaded query value is used for several rows.
+ * Rows past the end of a short tile repeat its last row and their products are ignored.
+ * @param task Analogy task
+ * @param row First vocabulary row of the tile.
+ * @param rows Number of rows in the tile.
+ * @param panel Index of the panel.
+ * @param products Output products, one set of ANALOGY_TILE_ROWS x ANALOGY_PANEL_WIDTH values per term.
+ */
+static void multiply_tile(const Analogy_task* task, int row, int rows, int panel, float products[3][ANALOGY_TILE_ROWS][ANALOGY_PANEL_WIDTH]) {
+    int vector_length = task->embedding_model->vector_length;
+    for (int t = 0; t < task->terms; t++){
+        const float* panel_data = task->panels + ((size_t) panel * task->terms + t) * vector_length * ANALOGY_PANEL_WIDTH;
+        for (int r0 = 0; r0 < rows; r0 += ANALOGY_KERNEL_ROWS){
+            const float* vectors[ANALOGY_KERNEL_ROWS];
+            for (int r = 0; r < ANALOGY_KERNEL_ROWS; r++){
+                vectors[r] = embedding_model_vector(task->embedding_model, row + (r0 + r < rows ? r0 + r : rows - 1));
+            }
+            for (int q0 = 0; q0 < ANALOGY_PANEL_WIDTH; q0 += ANALOGY_KERNEL_COLUMNS){
+                float sums[ANALOGY_KERNEL_ROWS][ANALOGY_KERNEL_COLUMNS] = {0};
+                for (int d = 0; d < vector_length; d++){
+                    const float* column = panel_data + (size_t) d * ANALOGY_PANEL_WIDTH + q0;
+                    for (int r = 0; r < ANALOGY_KERNEL_ROWS; r++){
+                        float value = vectors[r][d];
+                        for (int q = 0; q < ANALOGY_KERNEL_COLUMNS; q++){
+                            sums[r][q] += value * column[q];
+                        }
+                    }
+                }
+                for (int r = 0; r < ANALOGY_KERNEL_ROWS && r0 + r < rows; r++){
+                    for (int q = 0; q < ANALOGY_KERNEL_COLUMNS; q++){
+                        products[t][r0 + r][q0 + q] = sums[r][q];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Scores a tile of vocabulary rows against the questions of a panel and keeps the best scoring word of each
+ * question. The query words of a question are never an answer.
+ * @param task Analogy task
+ * @param row First vocabulary row of the tile.
+ * @param rows Number of rows in the tile.
+ * @param panel Index of the panel.
+ */
+static void score_tile(const Analogy_task* task, int row, int rows, int panel) {
+    float products[3][ANALOGY_TILE_ROWS][ANALOGY_PANEL_WIDTH];
+    multiply_tile(task, row, rows, panel, products);
+    for (int q = 0; q < ANALOGY_PANEL_WIDTH; q++){
+        int question = panel * ANALOGY_PANEL_WIDTH + q;
+        if (question >= task->question_count){
+            break;
+        }
+        const int* query = task->query_words + 3 * question;
+        if (query[0] == -1){
+            continue;
+        }
+        for (int r = 0; r < rows; r++){
+            int word = row + r;
+            float score;
+            if (word == query[0] || word == query[1] || word == query[2]){
+                continue;
+            }
+            if (task->method == THREE_COS_ADD){
+                score = products[0][r][q] * task->inverse_norms[word];
+            } else {
+                float cos1 = (products[0][r][q] * task->inverse_norms[word] + 1) / 2;
+                float cos2 = (products[1][r][q] * task->inverse_norms[word] + 1) / 2;
+                float cos3 = (products[2][r][q] * task->inverse_norms[word] + 1) / 2;
+                score = cos2 * cos3 / (cos1 + 0.001f);
+            }
+            if (score > task->best_scores[question]){
+                task->best_scores[question] = score;
+                task->best_words[question] = word;
+            }
+        }
+    }
+}
+
+/**
+ * Thread function scanning a range of the vocabulary. Panels are processed in blocks of ANALOGY_BLOCK_PANELS, so
+ * that a block of queries stays in cache while the vocabulary range is streamed once per block.
+ * @param argument Analogy task.
+ * @return NULL
+ */
+static void* run_analogy_task(void* argument) {
+    Analogy_task* task = argument;
+    for (int block = 0; block < task->panel_count; block += ANALOGY_BLOCK_PANELS){
+        int block_end = block + ANALOGY_BLOCK_PANELS < task->panel_count ? block + ANALOGY_BLOCK_PANELS : task->panel_count;
+        for (int row = task->start; row < task->end; row += ANALOGY_TILE_ROWS){
+            int rows = task->end - row < ANALOGY_TILE_ROWS ? task->end - row : ANALOGY_TILE_ROWS;
+            for (int panel = block; panel < block_end; panel++){
+                score_tile(task, row, rows, panel);
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Writes the query columns of a question into its panel. For 3CosAdd the single query is b - a + c over the
+ * normalized vectors, for 3CosMul the normalized vectors a, b and c are stored as three separate terms.
+ * @param task Analogy task
+ * @param panels Panels of the task to be filled.
+ * @param question Index of the question.
+ */
+static void fill_query_columns(const Analogy_task* task, float* panels, int question) {
+    const Embedding_model* embedding_model = task->embedding_model;
+    int vector_length = embedding_model->vector_length;
+    int panel = question / ANALOGY_PANEL_WIDTH;
+    int q = question % ANALOGY_PANEL_WIDTH;
+    const int* query = task->query_words + 3 * question;
+    for (int t = 0; t < task->terms; t++){
+        float* panel_data = panels + ((size_t) panel * task->terms + t) * vector_length * ANALOGY_PANEL_WIDTH;
+        for (int d = 0; d < vector_length; d++){
+            float value;
+            if (task->method == THREE_COS_ADD){
+                value = embedding_model_vector(embedding_model, query[1])[d] * task->inverse_norms[query[1]]
+                        - embedding_model_vector(embedding_model, query[0])[d] * task->inverse_norms[query[0]]
+                        + embedding_model_vector(embedding_model, query[2])[d] * task->inverse_norms[query[2]];
+            } else {
+                value = embedding_model_vector(embedding_model, query[t])[d] * task->inverse_norms[query[t]];
+            }
+            panel_data[(size_t) d * ANALOGY_PANEL_WIDTH + q] = value;
+        }
+    }
+}
+
+/**
+ * Answers all questions of the dataset over the full vocabulary of the model. The inverse norms of the word vectors
+ * are computed once, so cosine similarities are dot products scaled by the inverse norm of the candidate, and the
+ * model itself is not copied. Questions are packed into panels of ANALOGY_PANEL_WIDTH query columns and every
+ * thread multiplies its range of the vocabulary with the panels as a blocked matrix product, keeping the best
+ * candidate of each question. The results of the threads are merged in vocabulary order, so ties are broken by the
+ * smallest row as in a sequential scan.
+ * @param analogy_data_set Analogy dataset
+ * @param embedding_model Embedding model storing the word vectors.
+ * @param method THREE_COS_ADD or THREE_COS_MUL.
+ * @return Row of the answer of each question, -1 if one of the first three words does not exist in the model.
+ */
+int *solve_analogies(const Analogy_data_set* analogy_data_set, const Embedding_model* embedding_model, Analogy_method method) {
+    int question_count = analogy_data_set->questions->size;
+    int word_count = embedding_model->word_count;
+    int vector_length = embedding_model->vector_length;
+    int tile_count = (word_count + ANALOGY_TILE_ROWS - 1) / ANALOGY_TILE_ROWS;
+    int thread_count = embedding_model->thread_count < tile_count ? embedding_model->thread_count : tile_count;
+    int* result = malloc_(question_count * sizeof(int));
+    if (question_count == 0 || thread_count == 0){
+        for (int i = 0; i < question_count; i++){
+            result[i] = -1;
+        }
+        return result;
+    }
+    Analogy_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    bool started[thread_count];
+    Analogy_task task;
+    float* inverse_norms = malloc_(word_count * sizeof(float));
+    int* query_words = malloc_(3 * question_count * sizeof(int));
+    for (int i = 0; i < word_count; i++){
+        const float* vector = embedding_model_vector(embedding_model, i);
+        double norm = 0;
+        for (int j = 0; j < vector_length; j++){
+            norm += vector[j] * vector[j];
+        }
+        inverse_norms[i] = norm > 0 ? (float) (1 / sqrt(norm)) : 0;
+    }
+    task.embedding_model = embedding_model;
+    task.inverse_norms = inverse_norms;
+    task.query_words = query_words;
+    task.question_count = question_count;
+    task.panel_count = (question_count + ANALOGY_PANEL_WIDTH - 1) / ANALOGY_PANEL_WIDTH;
+    task.terms = method == THREE_COS_ADD ? 1 : 3;
+    task.method = method;
+    float* panels = calloc_((size_t) task.panel_count * task.terms * vector_length * ANALOGY_PANEL_WIDTH, sizeof(float));
+    task.panels = panels;
+    for (int i = 0; i < question_count; i++){
+        Analogy_question_ptr question = array_list_get(analogy_data_set->questions, i);
+        query_words[3 * i] = embedding_model_index(embedding_model, question->word1);
+        query_words[3 * i + 1] = embedding_model_index(embedding_model, question->word2);
+        query_words[3 * i + 2] = embedding_model_index(embedding_model, question->word3);
+        if (query_words[3 * i] == -1 || query_words[3 * i + 1] == -1 || query_words[3 * i + 2] == -1){
+            query_words[3 * i] = -1;
+        } else {
+            fill_query_columns(&task, panels, i);
+        }
+    }
+    float* best_scores = malloc_((size_t) thread_count * question_count * sizeof(float));
+    int* best_words = malloc_((size_t) thread_count * question_count * sizeof(int));
+    for (int i = 0; i < thread_count * question_count; i++){
+        best_scores[i] = -INFINITY;
+        best_words[i] = -1;
+    }
+    for (int i = 0; i < thread_count; i++){
+        tasks[i] = task;
+        tasks[i].start = (int) ((long long) tile_count * i / thread_count) * ANALOGY_TILE_ROWS;
+        tasks[i].end = (int) ((long long) tile_count * (i + 1) / thread_count) * ANALOGY_TILE_ROWS;
+        if (tasks[i].end > word_count){
+            tasks[i].end = word_count;
+        }
+        tasks[i].best_scores = best_scores + (size_t) i * question_count;
+        tasks[i].best_words = best_words + (size_t) i * question_count;
+        started[i] = pthread_create(&threads[i], NULL, run_analogy_task, &tasks[i]) == 0;
+    }
+    for (int i = 0; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            run_analogy_task(&tasks[i]);
+        }
+    }
+    for (int i = 0; i < question_count; i++){
+        float best_score = -INFINITY;
+        result[i] = -1;
+        if (query_words[3 * i] == -1){
+            continue;
+        }
+        for (int j = 0; j < thread_count; j++){
+            if (best_words[(size_t) j * question_count + i] != -1 && best_scores[(size_t) j * question_count + i] > best_score){
+                best_score = best_scores[(size_t) j * question_count + i];
+                result[i] = best_words[(size_t) j * question_count + i];
+            }
+        }
+    }
+    free_(best_scores);
+    free_(best_words);
+    free_(panels);
+    free_(query_words);
+    free_(inverse_norms);
+    return result;
+}
+
+/**
+ * Calculates the accuracy of the model on the analogy dataset. As in the pairwise similarity evaluation, questions
+ * with a word that does not exist in the model are not counted.
+ * @param analogy_data_set Analogy dataset
+ * @param embedding_model Embedding model storing the word vectors.
+ * @param method THREE_COS_ADD or THREE_COS_MUL.
+ * @return Ratio of the questions answered correctly to the questions whose words all exist in the model.
+ */
+double analogy_accuracy(const Analogy_data_set* analogy_data_set, const Embedding_model* embedding_model, Analogy_method method) {
+    int* answers = solve_analogies(analogy_data_set, embedding_model, method);
+    int correct = 0, total = 0;
+    for (int i = 0; i < analogy_data_set->questions->size; i++){
+        Analogy_question_ptr question = array_list_get(analogy_data_set->questions, i);
+        int expected = embedding_model_index(embedding_model, question->word4);
+        if (answers[i] == -1 || expected == -1){
+            continue;
+        }
+        total++;
+        if (answers[i] == expected){
+            correct++;
+        }
+    }
+    free_(answers);
+    if (total == 0){
+        return 0;
+    }
+    return correct / (double) total;
+}
@@ -0,0 +1,37 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_ANALOGYDATASET_H
+#define WORDTOVEC_ANALOGYDATASET_H
+
+#include <ArrayList.h>
+#include "AnalogyQuestion.h"
+#include "EmbeddingModel.h"
+
+enum analogy_method{
+    THREE_COS_ADD,
+    THREE_COS_MUL
+};
+
+typedef enum analogy_method Analogy_method;
+
+struct analogy_data_set{
+    Array_list_ptr questions;
+};
+
+typedef struct analogy_data_set Analogy_data_set;
+
+typedef Analogy_data_set *Analogy_data_set_ptr;
+
+Analogy_data_set_ptr create_analogy_data_set(const char* file_name);
+
+Analogy_data_set_ptr create_analogy_data_set2();
+
+void free_analogy_data_set(Analogy_data_set_ptr analogy_data_set);
+
+int* solve_analogies(const Analogy_data_set* analogy_data_set, const Embedding_model* embedding_model, Analogy_method method);
+
+double analogy_accuracy(const Analogy_data_set* analogy_data_set, const Embedding_model* embedding_model, Analogy_method method);
+
+#endif //WORDTOVEC_ANALOGYDATASET_H
@@ -0,0 +1,36 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <StringUtils.h>
+#include <Memory/Memory.h>
+#include "AnalogyQuestion.h"
+
+/**
+ * Constructor of the AnalogyQuestion object. An analogy question word1 : word2 :: word3 : word4 asks for the word
+ * that is related to word3 as word2 is related to word1, word4 being the expected answer.
+ * @param word1 First word
+ * @param word2 Second word
+ * @param word3 Third word
+ * @param word4 Expected answer
+ */
+Analogy_question_ptr create_analogy_question(const char *word1, const char *word2, const char *word3, const char *word4) {
+    Analogy_question_ptr result = malloc_(sizeof(Analogy_question));
+    result->word1 = str_copy(result->word1, word1);
+    result->word2 = str_copy(result->word2, word2);
+    result->word3 = str_copy(result->word3, word3);
+    result->word4 = str_copy(result->word4, word4);
+    return result;
+}
+
+/**
+ * Frees memory allocated for analogy question.
+ * @param analogy_question Analogy question to deallocate.
+ */
+void free_analogy_question(Analogy_question_ptr analogy_question) {
+    free_(analogy_question->word1);
+    free_(analogy_question->word2);
+    free_(analogy_question->word3);
+    free_(analogy_question->word4);
+    free_(analogy_question);
+}
@@ -0,0 +1,23 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_ANALOGYQUESTION_H
+#define WORDTOVEC_ANALOGYQUESTION_H
+
+struct analogy_question{
+    char* word1;
+    char* word2;
+    char* word3;
+    char* word4;
+};
+
+typedef struct analogy_question Analogy_question;
+
+typedef Analogy_question *Analogy_question_ptr;
+
+Analogy_question_ptr create_analogy_question(const char* word1, const char* word2, const char* word3, const char* word4);
+
+void free_analogy_question(Analogy_question_ptr analogy_question);
+
+#endif //WORDTOVEC_ANALOGYQUESTION_H
@@ -0,0 +1,415 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <Memory/Memory.h>
+#include "Cooccurrence.h"
+
+struct cooccurrence_file_header{
+    int magic;
+    int vocabulary_size;
+    long long record_count;
+};
+
+typedef struct cooccurrence_file_header Cooccurrence_file_header;
+
+struct cooccurrence_counter{
+    Cooccurrence_record* buffer;
+    long long size;
+    long long capacity;
+    const char* file_name;
+    int spill_count;
+    bool failed;
+};
+
+typedef struct cooccurrence_counter Cooccurrence_counter;
+
+struct merge_source{
+    Cooccurrence_record record;
+    FILE* input;
+};
+
+typedef struct merge_source Merge_source;
+
+/**
+ * Compares two co-occurrence records first with respect to their first words, then with respect to their second
+ * words.
+ * @param record1 First record to compare.
+ * @param record2 Second record to compare.
+ * @return -1 if the first record comes before, 1 if it comes after the second record, 0 if they are the same pair.
+ */
+int compare_cooccurrence_record(const Cooccurrence_record* record1, const Cooccurrence_record* record2) {
+    if (record1->word1 != record2->word1){
+        return record1->word1 < record2->word1 ? -1 : 1;
+    }
+    if (record1->word2 != record2->word2){
+        return record1->word2 < record2->word2 ? -1 : 1;
+    }
+    return 0;
+}
+
+/**
+ * Sorts the buffer of the counter and adds up the records of the same word pair, so that every pair occurs once.
+ * @param counter Current co-occurrence counter
+ */
+static void compact_counter(Cooccurrence_counter* counter) {
+    long long size = 0;
+    qsort(counter->buffer, counter->size, sizeof(Cooccurrence_record), (int (*)(const void *, const void *)) compare_cooccurrence_record);
+    for (long long i = 0; i < counter->size; i++){
+        if (size > 0 && compare_cooccurrence_record(&counter->buffer[size - 1], &counter->buffer[i]) == 0){
+            counter->buffer[size - 1].value += counter->buffer[i].value;
+        } else {
+            counter->buffer[size] = counter->buffer[i];
+            size++;
+        }
+    }
+    counter->size = size;
+}
+
+/**
+ * Returns the name of a spill file of the counter.
+ * @param counter Current co-occurrence counter
+ * @param index Index of the spill file.
+ * @param spill_name Output buffer of at least strlen(file_name) + 16 bytes.
+ */
+static void spill_file_name(const Cooccurrence_counter* counter, int index, char* spill_name) {
+    sprintf(spill_name, "%s.%d", counter->file_name, index);
+}
+
+/**
+ * Writes the sorted records of the buffer into the next spill file and empties the buffer. If the spill file
+ * cannot be written, the counter is marked as failed; the records are dropped, but counting continues so that the
+ * corpus is still read to its end, and create_cooccurrence_matrix reports the failure.
+ * @param counter Current co-occurrence counter
+ */
+static void spill_counter(Cooccurrence_counter* counter) {
+    char* spill_name = malloc_(strlen(counter->file_name) + 16);
+    spill_file_name(counter, counter->spill_count, spill_name);
+    FILE* output = fopen(spill_name, "wb");
+    counter->spill_count++;
+    if (output == NULL){
+        counter->failed = true;
+    } else {
+        if (fwrite(counter->buffer, sizeof(Cooccurrence_record), counter->size, output) != (size_t) counter->size){
+            counter->failed = true;
+        }
+        if (fclose(output) != 0){
+            counter->failed = true;
+        }
+    }
+    free_(spill_name);
+    counter->size = 0;
+}
+
+/**
+ * Adds the weight of a word pair to the counter. When the buffer is full, the records of the same pair are added
+ * up; if that frees less than half of the buffer, the buffer is spilled to disk. The memory used for counting is
+ * therefore bounded by the capacity of the buffer, whatever the size of the corpus.
+ * @param counter Current co-occurrence counter
+ * @param word1 Index of the center word.
+ * @param word2 Index of the context word.
+ * @param value Weight of the occurrence.
+ */
+static void add_cooccurrence(Cooccurrence_counter* counter, int word1, int word2, double value) {
+    if (counter->size == counter->capacity){
+        compact_counter(counter);
+        if (counter->size > counter->capacity / 2){
+            spill_counter(counter);
+        }
+    }
+    counter->buffer[counter->size].word1 = word1;
+    counter->buffer[counter->size].word2 = word2;
+    counter->buffer[counter->size].value = value;
+    counter->size++;
+}
+
+/**
+ * Moves the source at the given position of a min heap of merge sources down to its place.
+ * @param heap Merge sources ordered by their current records.
+ * @param size Number of sources in the heap.
+ * @param position Position of the source to move.
+ */
+static void sift_merge_source(Merge_source* heap, int size, int position) {
+    while (true){
+        int smallest = position;
+        int left = 2 * position + 1;
+        int right = left + 1;
+        if (left < size && compare_cooccurrence_record(&heap[left].record, &heap[smallest].record) < 0){
+            smallest = left;
+        }
+        if (right < size && compare_cooccurrence_record(&heap[right].record, &heap[smallest].record) < 0){
+            smallest = right;
+        }
+        if (smallest == position){
+            break;
+        }
+        Merge_source temporary = heap[position];
+        heap[position] = heap[smallest];
+        heap[smallest] = temporary;
+        position = smallest;
+    }
+}
+
+/**
+ * Merges the spill files first to first + count - 1 of the counter into the output with a k-way merge, adding up
+ * the records of the same pair coming from different spills. Only one record per spill is kept in memory. A spill
+ * that cannot be opened or read, or an output that cannot be written, fails the whole merge, so that no counts are
+ * lost silently.
+ * @param counter Current co-occurrence counter
+ * @param first Index of the first spill file to merge.
+ * @param count Number of spill files to merge, at most COOCCURRENCE_MERGE_FAN_IN.
+ * @param output Output file.
+ * @return Number of records written, -1 if a spill could not be read or the output could not be written.
+ */
+static long long merge_spill_range(const Cooccurrence_counter* counter, int first, int count, FILE* output) {
+    Merge_source* heap = malloc_(count * sizeof(Merge_source));
+    char* spill_name = malloc_(strlen(counter->file_name) + 16);
+    int size = 0;
+    long long record_count = 0;
+    bool failed = false;
+    Cooccurrence_record current;
+    for (int i = 0; i < count && !failed; i++){
+        spill_file_name(counter, first + i, spill_name);
+        heap[size].input = fopen(spill_name, "rb");
+        if (heap[size].input == NULL){
+            failed = true;
+        } else if (fread(&heap[size].record, sizeof(Cooccurrence_record), 1, heap[size].input) == 1){
+            size++;
+        } else {
+            failed = ferror(heap[size].input) != 0;
+            fclose(heap[size].input);
+        }
+    }
+    for (int i = size / 2 - 1; i >= 0; i--){
+        sift_merge_source(heap, size, i);
+    }
+    while (size > 0 && !failed){
+        if (record_count > 0 && compare_cooccurrence_record(&current, &heap[0].record) == 0){
+            current.value += heap[0].record.value;
+        } else {
+            if (record_count > 0 && fwrite(&current, sizeof(Cooccurrence_record), 1, output) != 1){
+                failed = true;
+            }
+            current = heap[0].record;
+            record_count++;
+        }
+        if (fread(&heap[0].record, sizeof(Cooccurrence_record), 1, heap[0].input) != 1){
+            if (ferror(heap[0].input)){
+                failed = true;
+            }
+            fclose(heap[0].input);
+            size--;
+            heap[0] = heap[size];
+        }
+        sift_merge_source(heap, size, 0);
+    }
+    if (!failed && record_count > 0 && fwrite(&current, sizeof(Cooccurrence_record), 1, output) != 1){
+        failed = true;
+    }
+    for (int i = 0; i < size; i++){
+        fclose(heap[i].input);
+    }
+    free_(spill_name);
+    free_(heap);
+    return failed ? -1 : record_count;
+}
+
+/**
+ * Removes the spill files first to last - 1 of the counter.
+ * @param counter Current co-occurrence counter
+ * @param first Index of the first spill file to remove.
+ * @param last Index after the last spill file to remove.
+ */
+static void remove_spills(const Cooccurrence_counter* counter, int first, int last) {
+    char* spill_name = malloc_(strlen(counter->file_name) + 16);
+    for (int i = first; i < last; i++){
+        spill_file_name(counter, i, spill_name);
+        remove(spill_name);
+    }
+    free_(spill_name);
+}
+
+/**
+ * Merges the spill files of the counter into the output. At most COOCCURRENCE_MERGE_FAN_IN spills are open at a
+ * time: while there are more, the oldest COOCCURRENCE_MERGE_FAN_IN spills are merged into a new spill file, so a
+ * large corpus needs a few extra passes over its spills but never runs out of file descriptors. Spill files are
+ * removed as soon as they are merged, and all of them are removed if the merge fails.
+ * @param counter Current co-occurrence counter
+ * @param output Output file positioned after the header.
+ * @return Number of records written, -1 if a spill could not be read or written.
+ */
+static long long merge_spills(Cooccurrence_counter* counter, FILE* output) {
+    int first = 0;
+    int last = counter->spill_count;
+    char* spill_name = malloc_(strlen(counter->file_name) + 16);
+    long long record_count = 0;
+    while (record_count != -1 && last - first > COOCCURRENCE_MERGE_FAN_IN){
+        spill_file_name(counter, last, spill_name);
+        FILE* merged = fopen(spill_name, "wb");
+        last++;
+        if (merged == NULL){
+            record_count = -1;
+        } else {
+            record_count = merge_spill_range(counter, first, COOCCURRENCE_MERGE_FAN_IN, merged);
+            if (fclose(merged) != 0){
+                record_count = -1;
+            }
+        }
+        remove_spills(counter, first, first + COOCCURRENCE_MERGE_FAN_IN);
+        first += COOCCURRENCE_MERGE_FAN_IN;
+    }
+    if (record_count != -1){
+        record_count = merge_spill_range(counter, first, last - first, output);
+    }
+    remove_spills(counter, first, last);
+    free_(spill_name);
+    return record_count;
+}
+
+/**
+ * Counts the co-occurrences of the words of a corpus in a single pass and saves them as a co-occurrence file.
+ * Every context word within the window of a center word adds 1 / d to the pair in both directions, where d is the
+ * distance of the words in the sentence. Pairs are accumulated in a buffer of at most cooccurrence_memory_limit
+ * bytes, which is sorted and spilled to disk whenever it fills up; the spills are merged into the file, whose
+ * records are sorted with respect to the first and second words. The returned matrix maps the file, so it can be
+ * trained many times, or reopened with create_cooccurrence_matrix2, without reading the corpus again.
+ * @param corpus Corpus to count.
+ * @param vocabulary Vocabulary of the corpus, words are identified by their indexes in the vocabulary.
+ * @param phrase_detector Phrase detector rewriting the sentences of the corpus, NULL if no phrases are detected.
+ * @param parameter Parameter holding the window and the memory limit.
+ * @param file_name Name of the co-occurrence file. Spill files are named by appending a number to it.
+ * @return Co-occurrence matrix mapped from the file, NULL if a spill or the file could not be written or read.
+ */
+Cooccurrence_matrix_ptr create_cooccurrence_matrix(Corpus_ptr corpus,
+                                                   Vocabulary_ptr vocabulary,
+                                                   Phrase_detector_ptr phrase_detector,
+                                                   Word_to_vec_parameter_ptr parameter,
+                                                   const char* file_name) {
+    Cooccurrence_counter counter;
+    counter.capacity = parameter->cooccurrence_memory_limit / (long long) sizeof(Cooccurrence_record);
+    if (counter.capacity < 2){
+        counter.capacity = 2;
+    }
+    counter.buffer = malloc_(counter.capacity * sizeof(Cooccurrence_record));
+    counter.size = 0;
+    counter.file_name = file_name;
+    counter.spill_count = 0;
+    counter.failed = false;
+    corpus_open(corpus);
+    Sentence_ptr sentence = phrase_get_sentence(phrase_detector, corpus);
+    while (sentence != NULL){
+        int word_count = sentence_word_count(sentence);
+        int positions[word_count];
+        int length = 0;
+        for (int i = 0; i < word_count; i++){
+            int* position = hash_map_get(vocabulary->word_map, sentence_get_word(sentence, i));
+            if (position != NULL){
+                positions[length] = *position;
+                length++;
+            }
+        }
+        for (int i = 0; i < length; i++){
+            for (int j = i > parameter->window ? i - parameter->window : 0; j < i; j++){
+                add_cooccurrence(&counter, positions[i], positions[j], 1.0 / (i - j));
+                add_cooccurrence(&counter, positions[j], positions[i], 1.0 / (i - j));
+            }
+        }
+        sentence = phrase_get_sentence(phrase_detector, corpus);
+    }
+    corpus_close(corpus);
+    compact_counter(&counter);
+    FILE* output = counter.failed ? NULL : fopen(file_name, "wb");
+    if (output == NULL){
+        free_(counter.buffer);
+        remove_spills(&counter, 0, counter.spill_count);
+        return NULL;
+    }
+    Cooccurrence_file_header header;
+    header.magic = COOCCURRENCE_FILE_MAGIC;
+    header.vocabulary_size = size_of_vocabulary(vocabulary);
+    header.record_count = 0;
+    bool written = fwrite(&header, sizeof(Cooccurrence_file_header), 1, output) == 1;
+    if (counter.spill_count == 0){
+        written = written && fwrite(counter.buffer, sizeof(Cooccurrence_record), counter.size, output) == (size_t) counter.size;
+        header.record_count = counter.size;
+        free_(counter.buffer);
+    } else {
+        spill_counter(&counter);
+        free_(counter.buffer);
+        header.record_count = counter.failed ? -1 : merge_spills(&counter, output);
+        if (counter.failed){
+            remove_spills(&counter, 0, counter.spill_count);
+        }
+        written = written && header.record_count != -1;
+    }
+    written = written && fseek(output, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(Cooccurrence_file_header), 1, output) == 1;
+    if (fclose(output) != 0 || !written){
+        remove(file_name);
+        return NULL;
+    }
+    Cooccurrence_matrix_ptr result = create_cooccurrence_matrix2(file_name);
+    if (result != NULL){
+        result->spill_count = counter.spill_count;
+    }
+    return result;
+}
+
+/**
+ * Opens a co-occurrence file saved by create_cooccurrence_matrix. The records are memory mapped read only. The
+ * counts in the header must not be negative, the records must fit in the file, and the word indexes of every
+ * record must be inside the vocabulary of the file.
+ * @param file_name Name of the co-occurrence file.
+ * @return Co-occurrence matrix, NULL if the file could not be opened, is not a co-occurrence file or is corrupt.
+ */
+Cooccurrence_matrix_ptr create_cooccurrence_matrix2(const char* file_name) {
+    int descriptor = open(file_name, O_RDONLY);
+    if (descriptor == -1){
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) == -1 || status.st_size < (off_t) sizeof(Cooccurrence_file_header)){
+        close(descriptor);
+        return NULL;
+    }
+    void* mapped = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (mapped == MAP_FAILED){
+        return NULL;
+    }
+    const Cooccurrence_file_header* header = mapped;
+    bool valid = header->magic == COOCCURRENCE_FILE_MAGIC && header->vocabulary_size >= 0 && header->record_count >= 0 &&
+                 header->record_count <= (long long) ((status.st_size - sizeof(Cooccurrence_file_header)) / sizeof(Cooccurrence_record));
+    const Cooccurrence_record* records = (const Cooccurrence_record*) ((const char*) mapped + sizeof(Cooccurrence_file_header));
+    for (long long i = 0; valid && i < header->record_count; i++){
+        valid = records[i].word1 >= 0 && records[i].word1 < header->vocabulary_size &&
+                records[i].word2 >= 0 && records[i].word2 < header->vocabulary_size;
+    }
+    if (!valid){
+        munmap(mapped, status.st_size);
+        return NULL;
+    }
+    Cooccurrence_matrix_ptr result = malloc_(sizeof(Cooccurrence_matrix));
+    result->records = records;
+    result->record_count = header->record_count;
+    result->vocabulary_size = header->vocabulary_size;
+    result->spill_count = 0;
+    result->mapped = mapped;
+    result->mapped_size = status.st_size;
+    return result;
+}
+
+/**
+ * Frees memory allocated for the co-occurrence matrix and unmaps its file. The file is not removed.
+ * @param cooccurrence_matrix Co-occurrence matrix to deallocate.
+ */
+void free_cooccurrence_matrix(Cooccurrence_matrix_ptr cooccurrence_matrix) {
+    munmap(cooccurrence_matrix->mapped, cooccurrence_matrix->mapped_size);
+    free_(cooccurrence_matrix);
+}
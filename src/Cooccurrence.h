@@ -0,0 +1,49 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_COOCCURRENCE_H
+#define WORDTOVEC_COOCCURRENCE_H
+
+#include <Corpus.h>
+#include "Vocabulary.h"
+#include "PhraseDetector.h"
+#include "WordToVecParameter.h"
+
+static int COOCCURRENCE_FILE_MAGIC = 0x43563257;
+static int COOCCURRENCE_MERGE_FAN_IN = 64;
+
+struct cooccurrence_record{
+    int word1;
+    int word2;
+    double value;
+};
+
+typedef struct cooccurrence_record Cooccurrence_record;
+
+struct cooccurrence_matrix{
+    const Cooccurrence_record* records;
+    long long record_count;
+    int vocabulary_size;
+    int spill_count;
+    void* mapped;
+    size_t mapped_size;
+};
+
+typedef struct cooccurrence_matrix Cooccurrence_matrix;
+
+typedef Cooccurrence_matrix *Cooccurrence_matrix_ptr;
+
+Cooccurrence_matrix_ptr create_cooccurrence_matrix(Corpus_ptr corpus,
+                                                   Vocabulary_ptr vocabulary,
+                                                   Phrase_detector_ptr phrase_detector,
+                                                   Word_to_vec_parameter_ptr parameter,
+                                                   const char* file_name);
+
+Cooccurrence_matrix_ptr create_cooccurrence_matrix2(const char* file_name);
+
+void free_cooccurrence_matrix(Cooccurrence_matrix_ptr cooccurrence_matrix);
+
+int compare_cooccurrence_record(const Cooccurrence_record* record1, const Cooccurrence_record* record2);
+
+#endif //WORDTOVEC_COOCCURRENCE_H
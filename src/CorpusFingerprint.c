@@ -0,0 +1,98 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <Memory/Memory.h>
+#include "CorpusFingerprint.h"
+
+/**
+ * Adds bytes to a 64 bit FNV-1a hash.
+ * @param hash Current hash.
+ * @param bytes Bytes to add.
+ * @param length Number of bytes.
+ * @return Hash of the bytes added so far.
+ */
+static unsigned long long fnv_hash(unsigned long long hash, const void* bytes, size_t length) {
+    const unsigned char* current = bytes;
+    for (size_t i = 0; i < length; i++){
+        hash ^= current[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Computes the fingerprint of a corpus file: its size, its modification time, and a hash of FINGERPRINT_BLOCK_COUNT
+ * blocks of FINGERPRINT_BLOCK_SIZE bytes spread evenly over the file, the first and the last block included. Only
+ * the sampled blocks are read, so the fingerprint of a corpus of any size costs a few disk reads. If the sentences
+ * are read through a phrase detector, its thresholds are hashed too, since they change the words of the
+ * vocabulary.
+ * @param file_name Name of the corpus file.
+ * @param phrase_detector Phrase detector rewriting the sentences of the corpus, NULL if no phrases are detected.
+ * @return Fingerprint of the corpus, with size -1 if the file can not be read.
+ */
+Corpus_fingerprint create_corpus_fingerprint(const char* file_name, const Phrase_detector* phrase_detector) {
+    Corpus_fingerprint result;
+    struct stat status;
+    memset(&result, 0, sizeof(Corpus_fingerprint));
+    result.size = -1;
+    FILE* input = file_name != NULL ? fopen(file_name, "rb") : NULL;
+    if (input == NULL){
+        return result;
+    }
+    if (fstat(fileno(input), &status) == -1){
+        fclose(input);
+        return result;
+    }
+    result.size = status.st_size;
+    result.modification_time = (long long) status.st_mtim.tv_sec * 1000000000LL + status.st_mtim.tv_nsec;
+    unsigned long long hash = 14695981039346656037ULL;
+    char* block = malloc_(FINGERPRINT_BLOCK_SIZE);
+    for (int i = 0; i < FINGERPRINT_BLOCK_COUNT; i++){
+        long long offset = 0;
+        if (result.size > FINGERPRINT_BLOCK_SIZE){
+            offset = (result.size - FINGERPRINT_BLOCK_SIZE) * i / (FINGERPRINT_BLOCK_COUNT - 1);
+        }
+        fseek(input, offset, SEEK_SET);
+        size_t length = fread(block, 1, FINGERPRINT_BLOCK_SIZE, input);
+        hash = fnv_hash(hash, block, length);
+    }
+    free_(block);
+    fclose(input);
+    result.content_hash = hash;
+    if (phrase_detector != NULL){
+        hash = 14695981039346656037ULL;
+        hash = fnv_hash(hash, &phrase_detector->min_count, sizeof(int));
+        hash = fnv_hash(hash, &phrase_detector->threshold, sizeof(double));
+        hash = fnv_hash(hash, &phrase_detector->unigram_table_size, sizeof(int));
+        hash = fnv_hash(hash, &phrase_detector->bigram_table_size, sizeof(int));
+        result.phrase_hash = hash;
+    }
+    return result;
+}
+
+/**
+ * Checks if a fingerprint was computed from a readable file.
+ * @param fingerprint Fingerprint to check.
+ * @return True if the corpus file could be read.
+ */
+bool is_valid_fingerprint(const Corpus_fingerprint* fingerprint) {
+    return fingerprint->size >= 0;
+}
+
+/**
+ * Compares two fingerprints.
+ * @param fingerprint1 First fingerprint.
+ * @param fingerprint2 Second fingerprint.
+ * @return True if both fingerprints are valid and equal.
+ */
+bool same_fingerprint(const Corpus_fingerprint* fingerprint1, const Corpus_fingerprint* fingerprint2) {
+    return is_valid_fingerprint(fingerprint1) && is_valid_fingerprint(fingerprint2) &&
+           fingerprint1->size == fingerprint2->size &&
+           fingerprint1->modification_time == fingerprint2->modification_time &&
+           fingerprint1->content_hash == fingerprint2->content_hash &&
+           fingerprint1->phrase_hash == fingerprint2->phrase_hash;
+}
@@ -0,0 +1,29 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_CORPUSFINGERPRINT_H
+#define WORDTOVEC_CORPUSFINGERPRINT_H
+
+#include <stdbool.h>
+#include "PhraseDetector.h"
+
+static int FINGERPRINT_BLOCK_COUNT = 16;
+static int FINGERPRINT_BLOCK_SIZE = 4096;
+
+struct corpus_fingerprint{
+    long long size;
+    long long modification_time;
+    unsigned long long content_hash;
+    unsigned long long phrase_hash;
+};
+
+typedef struct corpus_fingerprint Corpus_fingerprint;
+
+Corpus_fingerprint create_corpus_fingerprint(const char* file_name, const Phrase_detector* phrase_detector);
+
+bool is_valid_fingerprint(const Corpus_fingerprint* fingerprint);
+
+bool same_fingerprint(const Corpus_fingerprint* fingerprint1, const Corpus_fingerprint* fingerprint2);
+
+#endif //WORDTOVEC_CORPUSFINGERPRINT_H
@@ -0,0 +1,129 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <string.h>
+#include <sys/mman.h>
+#include <Memory/Memory.h>
+#include "CorpusShard.h"
+
+/**
+ * Empty constructor for a corpus shard. A shard stores the sentences of a contiguous part of the corpus as
+ * vocabulary indexes, sentences are separated with SENTENCE_END.
+ * @return Empty corpus shard.
+ */
+Corpus_shard_ptr create_corpus_shard() {
+    Corpus_shard_ptr result = malloc_(sizeof(Corpus_shard));
+    result->capacity = 1024;
+    result->tokens = malloc_(result->capacity * sizeof(int));
+    result->token_count = 0;
+    result->word_count = 0;
+    result->mapped = false;
+    result->original_tokens = NULL;
+    return result;
+}
+
+/**
+ * Reads the corpus once and splits it into shard_count shards with (approximately) the same number of words.
+ * Every word is replaced with its index in the vocabulary, so the training threads never hash a string.
+ * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * @param phrase_detector Phrase detector rewriting the sentences of the corpus, NULL if no phrases are detected.
+ * @param vocabulary Vocabulary of the corpus.
+ * @param shard_count Number of shards.
+ * @return Array of shard_count shards.
+ */
+Corpus_shard_ptr *create_corpus_shards(Corpus_ptr corpus,
+                                       Phrase_detector_ptr phrase_detector,
+                                       Vocabulary_ptr vocabulary,
+                                       int shard_count) {
+    Corpus_shard_ptr* result = malloc_(shard_count * sizeof(Corpus_shard_ptr));
+    long long word_count = 0;
+    int current = 0;
+    for (int i = 0; i < shard_count; i++){
+        result[i] = create_corpus_shard();
+    }
+    corpus_open(corpus);
+    Sentence_ptr sentence = phrase_get_sentence(phrase_detector, corpus);
+    while (sentence != NULL){
+        while (current < shard_count - 1 && word_count >= vocabulary->total_number_of_words * (current + 1) / shard_count){
+            current++;
+        }
+        for (int i = 0; i < sentence_word_count(sentence); i++){
+            corpus_shard_add_token(result[current], get_position(vocabulary, sentence_get_word(sentence, i)));
+        }
+        corpus_shard_add_token(result[current], SENTENCE_END);
+        word_count += sentence_word_count(sentence);
+        sentence = phrase_get_sentence(phrase_detector, corpus);
+    }
+    corpus_close(corpus);
+    return result;
+}
+
+/**
+ * Appends a token to the shard. If the token is not SENTENCE_END, the word count is also incremented.
+ * @param corpus_shard Current corpus shard
+ * @param token Vocabulary index of the word or SENTENCE_END.
+ */
+void corpus_shard_add_token(Corpus_shard_ptr corpus_shard, int token) {
+    if (corpus_shard->token_count == corpus_shard->capacity){
+        corpus_shard->capacity *= 2;
+        corpus_shard->tokens = realloc_(corpus_shard->tokens, corpus_shard->capacity * sizeof(int));
+    }
+    corpus_shard->tokens[corpus_shard->token_count] = token;
+    corpus_shard->token_count++;
+    if (token != SENTENCE_END){
+        corpus_shard->word_count++;
+    }
+}
+
+/**
+ * Moves the tokens of the shard into freshly mapped pages. Since the pages are first touched by the calling
+ * thread, the kernel places them on the NUMA node of that thread. Training threads do not use the shared
+ * allocator, so the original token array is kept in original_tokens and freed with the shard by the thread that
+ * created it. Shards that are empty, already mapped, or for which no pages can be mapped are left in place.
+ * @param corpus_shard Current corpus shard
+ */
+void localize_corpus_shard(Corpus_shard_ptr corpus_shard) {
+    if (corpus_shard->token_count == 0 || corpus_shard->mapped){
+        return;
+    }
+    int* tokens = mmap(NULL, corpus_shard->token_count * sizeof(int), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (tokens == MAP_FAILED){
+        return;
+    }
+    memcpy(tokens, corpus_shard->tokens, corpus_shard->token_count * sizeof(int));
+    corpus_shard->original_tokens = corpus_shard->tokens;
+    corpus_shard->tokens = tokens;
+    corpus_shard->capacity = corpus_shard->token_count;
+    corpus_shard->mapped = true;
+}
+
+/**
+ * Frees memory allocated for the corpus shard.
+ * @param corpus_shard Corpus shard to deallocate.
+ */
+void free_corpus_shard(Corpus_shard_ptr corpus_shard) {
+    if (corpus_shard->mapped){
+        if (corpus_shard->tokens != NULL){
+            munmap(corpus_shard->tokens, corpus_shard->capacity * sizeof(int));
+        }
+    } else {
+        free_(corpus_shard->tokens);
+    }
+    if (corpus_shard->original_tokens != NULL){
+        free_(corpus_shard->original_tokens);
+    }
+    free_(corpus_shard);
+}
+
+/**
+ * Frees memory allocated for an array of corpus shards.
+ * @param corpus_shards Corpus shards to deallocate.
+ * @param shard_count Number of shards.
+ */
+void free_corpus_shards(Corpus_shard_ptr *corpus_shards, int shard_count) {
+    for (int i = 0; i < shard_count; i++){
+        free_corpus_shard(corpus_shards[i]);
+    }
+    free_(corpus_shards);
+}
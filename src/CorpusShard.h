@@ -0,0 +1,41 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_CORPUSSHARD_H
+#define WORDTOVEC_CORPUSSHARD_H
+
+#include <Corpus.h>
+#include "Vocabulary.h"
+
+static int SENTENCE_END = -1;
+
+struct corpus_shard{
+    int* tokens;
+    long long token_count;
+    long long capacity;
+    long long word_count;
+    bool mapped;
+    int* original_tokens;
+};
+
+typedef struct corpus_shard Corpus_shard;
+
+typedef Corpus_shard *Corpus_shard_ptr;
+
+Corpus_shard_ptr create_corpus_shard();
+
+Corpus_shard_ptr* create_corpus_shards(Corpus_ptr corpus,
+                                       Phrase_detector_ptr phrase_detector,
+                                       Vocabulary_ptr vocabulary,
+                                       int shard_count);
+
+void free_corpus_shard(Corpus_shard_ptr corpus_shard);
+
+void free_corpus_shards(Corpus_shard_ptr* corpus_shards, int shard_count);
+
+void corpus_shard_add_token(Corpus_shard_ptr corpus_shard, int token);
+
+void localize_corpus_shard(Corpus_shard_ptr corpus_shard);
+
+#endif //WORDTOVEC_CORPUSSHARD_H
@@ -0,0 +1,441 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <math.h>
+#include <string.h>
+#include <pthread.h>
+#include <Memory/Memory.h>
+#include "DimensionReduction.h"
+
+#define REDUCTION_ROW_BLOCK 16
+#define REDUCTION_PANEL_ROWS 64
+
+struct reduction_task{
+    const float* input;
+    const double* left;
+    const double* right;
+    double* output;
+    int columns;
+    int width;
+    int start;
+    int end;
+};
+
+typedef struct reduction_task Reduction_task;
+
+/**
+ * Multiplies the rows start to end of the float input matrix with the right matrix. The rows are processed in
+ * blocks of REDUCTION_ROW_BLOCK rows, and the right matrix in panels of REDUCTION_PANEL_ROWS rows, so that a panel
+ * stays in the cache while it is used by all rows of the block. The innermost loop runs over the contiguous
+ * columns of the output and the panel, and is vectorized by the compiler.
+ * @param argument Reduction task, output has columns width.
+ * @return NULL
+ */
+static void* run_projection_task(void* argument) {
+    Reduction_task* task = argument;
+    int width = task->width;
+    for (int block = task->start; block < task->end; block += REDUCTION_ROW_BLOCK){
+        int block_end = block + REDUCTION_ROW_BLOCK < task->end ? block + REDUCTION_ROW_BLOCK : task->end;
+        for (int panel = 0; panel < task->columns; panel += REDUCTION_PANEL_ROWS){
+            int panel_end = panel + REDUCTION_PANEL_ROWS < task->columns ? panel + REDUCTION_PANEL_ROWS : task->columns;
+            for (int i = block; i < block_end; i++){
+                const float* row = task->input + (size_t) i * task->columns;
+                double* output = task->output + (size_t) i * width;
+                for (int k = panel; k < panel_end; k++){
+                    double value = row[k];
+                    const double* right = task->right + (size_t) k * width;
+                    for (int j = 0; j < width; j++){
+                        output[j] += value * right[j];
+                    }
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Accumulates the product of the transpose of the rows start to end of the float input matrix with the same rows
+ * of the left matrix into the output of the task, a columns x width partial sum owned by the task.
+ * @param argument Reduction task.
+ * @return NULL
+ */
+static void* run_transpose_task(void* argument) {
+    Reduction_task* task = argument;
+    int width = task->width;
+    for (int i = task->start; i < task->end; i++){
+        const float* row = task->input + (size_t) i * task->columns;
+        const double* left = task->left + (size_t) i * width;
+        for (int k = 0; k < task->columns; k++){
+            double value = row[k];
+            double* output = task->output + (size_t) k * width;
+            for (int j = 0; j < width; j++){
+                output[j] += value * left[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Multiplies the rows start to end of the double left matrix, which has width columns, with the width x width
+ * right matrix.
+ * @param argument Reduction task.
+ * @return NULL
+ */
+static void* run_basis_task(void* argument) {
+    Reduction_task* task = argument;
+    int width = task->width;
+    for (int i = task->start; i < task->end; i++){
+        const double* left = task->left + (size_t) i * width;
+        double* output = task->output + (size_t) i * width;
+        for (int k = 0; k < width; k++){
+            double value = left[k];
+            const double* right = task->right + (size_t) k * width;
+            for (int j = 0; j < width; j++){
+                output[j] += value * right[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Accumulates the Gram matrix of the rows start to end of the double left matrix into the output of the task, a
+ * width x width partial sum owned by the task.
+ * @param argument Reduction task.
+ * @return NULL
+ */
+static void* run_gram_task(void* argument) {
+    Reduction_task* task = argument;
+    int width = task->width;
+    for (int i = task->start; i < task->end; i++){
+        const double* left = task->left + (size_t) i * width;
+        for (int k = 0; k < width; k++){
+            double value = left[k];
+            double* output = task->output + (size_t) k * width;
+            for (int j = 0; j < width; j++){
+                output[j] += value * left[j];
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Splits the rows of a task into thread_count contiguous ranges and runs them in parallel. If partial_size is zero,
+ * every range writes its own rows of the output. Otherwise every range accumulates into its own partial sum of
+ * partial_size elements, and the partial sums are added into the output in range order, so the result does not
+ * depend on the scheduling of the threads.
+ * @param function Task function.
+ * @param task Task template, start and end give the rows to process.
+ * @param thread_count Number of threads.
+ * @param partial_size Size of the partial sum of a range, 0 if ranges write disjoint rows of the output.
+ */
+static void run_reduction_tasks(void* (*function)(void*), const Reduction_task* task, int thread_count, size_t partial_size) {
+    int rows = task->end - task->start;
+    if (thread_count > rows / REDUCTION_ROW_BLOCK){
+        thread_count = rows / REDUCTION_ROW_BLOCK > 0 ? rows / REDUCTION_ROW_BLOCK : 1;
+    }
+    Reduction_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    for (int i = 0; i < thread_count; i++){
+        tasks[i] = *task;
+        tasks[i].start = task->start + (int) ((long long) rows * i / thread_count);
+        tasks[i].end = task->start + (int) ((long long) rows * (i + 1) / thread_count);
+        if (partial_size > 0){
+            tasks[i].output = calloc_(partial_size, sizeof(double));
+        }
+    }
+    bool started[thread_count];
+    for (int i = 1; i < thread_count; i++){
+        started[i] = pthread_create(&threads[i], NULL, function, &tasks[i]) == 0;
+    }
+    function(&tasks[0]);
+    for (int i = 1; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            function(&tasks[i]);
+        }
+    }
+    if (partial_size > 0){
+        for (int i = 0; i < thread_count; i++){
+            for (size_t j = 0; j < partial_size; j++){
+                task->output[j] += tasks[i].output[j];
+            }
+            free_(tasks[i].output);
+        }
+    }
+}
+
+/**
+ * Computes the eigenvalues and eigenvectors of a symmetric matrix with the cyclic Jacobi method. The eigenvalues
+ * are sorted in descending order, and eigenvector i is stored in column i of vectors.
+ * @param matrix Symmetric size x size matrix, destroyed by the function.
+ * @param size Size of the matrix.
+ * @param values Output eigenvalues.
+ * @param vectors Output size x size matrix of eigenvectors.
+ */
+static void symmetric_eigen(double* matrix, int size, double* values, double* vectors) {
+    for (int i = 0; i < size; i++){
+        for (int j = 0; j < size; j++){
+            vectors[i * size + j] = i == j ? 1.0 : 0.0;
+        }
+    }
+    for (int sweep = 0; sweep < 100; sweep++){
+        double off_diagonal = 0, diagonal = 0;
+        for (int i = 0; i < size; i++){
+            diagonal += matrix[i * size + i] * matrix[i * size + i];
+            for (int j = i + 1; j < size; j++){
+                off_diagonal += matrix[i * size + j] * matrix[i * size + j];
+            }
+        }
+        if (off_diagonal <= 1e-22 * diagonal){
+            break;
+        }
+        for (int p = 0; p < size; p++){
+            for (int q = p + 1; q < size; q++){
+                double apq = matrix[p * size + q];
+                if (fabs(apq) < 1e-300){
+                    continue;
+                }
+                double theta = (matrix[q * size + q] - matrix[p * size + p]) / (2 * apq);
+                double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1));
+                double c = 1 / sqrt(t * t + 1), s = t * c;
+                for (int k = 0; k < size; k++){
+                    double akp = matrix[k * size + p], akq = matrix[k * size + q];
+                    matrix[k * size + p] = c * akp - s * akq;
+                    matrix[k * size + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < size; k++){
+                    double apk = matrix[p * size + k], aqk = matrix[q * size + k];
+                    matrix[p * size + k] = c * apk - s * aqk;
+                    matrix[q * size + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < size; k++){
+                    double vkp = vectors[k * size + p], vkq = vectors[k * size + q];
+                    vectors[k * size + p] = c * vkp - s * vkq;
+                    vectors[k * size + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    for (int i = 0; i < size; i++){
+        values[i] = matrix[i * size + i];
+    }
+    for (int i = 0; i < size; i++){
+        int best = i;
+        for (int j = i + 1; j < size; j++){
+            if (values[j] > values[best]){
+                best = j;
+            }
+        }
+        if (best != i){
+            double value = values[i];
+            values[i] = values[best];
+            values[best] = value;
+            for (int k = 0; k < size; k++){
+                value = vectors[k * size + i];
+                vectors[k * size + i] = vectors[k * size + best];
+                vectors[k * size + best] = value;
+            }
+        }
+    }
+}
+
+/**
+ * Replaces the columns of a tall rows x width matrix with an orthonormal basis of their span. The Gram matrix of
+ * the columns is diagonalized, and the matrix is multiplied with the eigenvectors scaled by the inverse square
+ * roots of the eigenvalues. Directions with negligible eigenvalues are set to zero.
+ * @param matrix Matrix to orthonormalize, rows x width.
+ * @param rows Number of rows.
+ * @param width Number of columns.
+ * @param thread_count Number of threads.
+ */
+static void orthonormalize(double* matrix, int rows, int width, int thread_count) {
+    double* gram = calloc_((size_t) width * width, sizeof(double));
+    double* values = malloc_(width * sizeof(double));
+    double* vectors = malloc_((size_t) width * width * sizeof(double));
+    double* result = calloc_((size_t) rows * width, sizeof(double));
+    Reduction_task task = {NULL, matrix, NULL, gram, 0, width, 0, rows};
+    run_reduction_tasks(run_gram_task, &task, thread_count, (size_t) width * width);
+    symmetric_eigen(gram, width, values, vectors);
+    for (int j = 0; j < width; j++){
+        double scale = values[j] > 1e-12 * values[0] ? 1 / sqrt(values[j]) : 0;
+        for (int i = 0; i < width; i++){
+            vectors[i * width + j] *= scale;
+        }
+    }
+    task.right = vectors;
+    task.output = result;
+    run_reduction_tasks(run_basis_task, &task, thread_count, 0);
+    memcpy(matrix, result, (size_t) rows * width * sizeof(double));
+    free_(gram);
+    free_(values);
+    free_(vectors);
+    free_(result);
+}
+
+/**
+ * Returns the next standard normal random number, generated with the Box-Muller transform from a linear
+ * congruential generator.
+ * @param next_random State of the generator.
+ * @return Standard normal random number.
+ */
+static double normal_random(unsigned long long* next_random) {
+    *next_random = *next_random * 25214903917ULL + 11;
+    double u1 = (((*next_random >> 16) & 0xFFFFFFFF) + 1.0) / 4294967297.0;
+    *next_random = *next_random * 25214903917ULL + 11;
+    double u2 = ((*next_random >> 16) & 0xFFFFFFFF) / 4294967296.0;
+    return sqrt(-2 * log(u1)) * cos(2 * M_PI * u2);
+}
+
+/**
+ * Computes the principal directions of the centered input matrix with randomized PCA. The range of the matrix is
+ * sampled with dimension + PCA_OVERSAMPLING Gaussian directions, refined with PCA_POWER_ITERATIONS power
+ * iterations, and the small projected matrix is diagonalized exactly.
+ * @param centered Centered input matrix, rows x columns.
+ * @param rows Number of rows.
+ * @param columns Number of columns.
+ * @param dimension Number of principal directions.
+ * @param seed Seed of the random directions.
+ * @param thread_count Number of threads.
+ * @return columns x dimension matrix of principal directions.
+ */
+static double* principal_directions(const float* centered, int rows, int columns, int dimension, unsigned long long seed, int thread_count) {
+    int width = dimension + PCA_OVERSAMPLING < columns ? dimension + PCA_OVERSAMPLING : columns;
+    double* omega = malloc_((size_t) columns * width * sizeof(double));
+    double* range = calloc_((size_t) rows * width, sizeof(double));
+    unsigned long long next_random = seed;
+    for (size_t i = 0; i < (size_t) columns * width; i++){
+        omega[i] = normal_random(&next_random);
+    }
+    Reduction_task task = {centered, NULL, omega, range, columns, width, 0, rows};
+    run_reduction_tasks(run_projection_task, &task, thread_count, 0);
+    for (int iteration = 0; iteration < PCA_POWER_ITERATIONS; iteration++){
+        orthonormalize(range, rows, width, thread_count);
+        memset(omega, 0, (size_t) columns * width * sizeof(double));
+        Reduction_task transpose = {centered, range, NULL, omega, columns, width, 0, rows};
+        run_reduction_tasks(run_transpose_task, &transpose, thread_count, (size_t) columns * width);
+        orthonormalize(omega, columns, width, thread_count);
+        memset(range, 0, (size_t) rows * width * sizeof(double));
+        run_reduction_tasks(run_projection_task, &task, thread_count, 0);
+    }
+    orthonormalize(range, rows, width, thread_count);
+    double* projected = omega;
+    memset(projected, 0, (size_t) columns * width * sizeof(double));
+    Reduction_task transpose = {centered, range, NULL, projected, columns, width, 0, rows};
+    run_reduction_tasks(run_transpose_task, &transpose, thread_count, (size_t) columns * width);
+    double* gram = calloc_((size_t) width * width, sizeof(double));
+    double* values = malloc_(width * sizeof(double));
+    double* vectors = malloc_((size_t) width * width * sizeof(double));
+    Reduction_task gram_task = {NULL, projected, NULL, gram, 0, width, 0, columns};
+    run_reduction_tasks(run_gram_task, &gram_task, thread_count, (size_t) width * width);
+    symmetric_eigen(gram, width, values, vectors);
+    double* directions = calloc_((size_t) columns * dimension, sizeof(double));
+    for (int i = 0; i < columns; i++){
+        for (int k = 0; k < width; k++){
+            for (int j = 0; j < dimension; j++){
+                directions[i * dimension + j] += projected[i * width + k] * vectors[k * width + j];
+            }
+        }
+    }
+    for (int j = 0; j < dimension; j++){
+        double scale = values[j] > 0 ? 1 / sqrt(values[j]) : 0;
+        for (int i = 0; i < columns; i++){
+            directions[i * dimension + j] *= scale;
+        }
+    }
+    free_(omega);
+    free_(range);
+    free_(gram);
+    free_(values);
+    free_(vectors);
+    return directions;
+}
+
+/**
+ * Reduces the dimension of the word vectors of a model. Randomized PCA centers the vectors and projects them onto
+ * their top principal directions. Gaussian projection multiplies the vectors with a random matrix of N(0, 1 /
+ * dimension) entries; sparse projection uses entries of +-sqrt(3 / dimension) with probability 1/6 each and 0
+ * otherwise. All methods multiply the vector matrix with a cache blocked kernel on the threads of the model.
+ * @param embedding_model Model to reduce.
+ * @param dimension Length of the reduced vectors, smaller than the vector length of the model.
+ * @param method Reduction method.
+ * @param seed Seed of the random directions.
+ * @return Model with the same words and reduced vectors, NULL if the dimension is not smaller than the vector
+ * length of the model.
+ */
+Embedding_model_ptr reduce_embedding_model(const Embedding_model* embedding_model, int dimension, Reduction_method method, unsigned long long seed) {
+    int rows = embedding_model->word_count;
+    int columns = embedding_model->vector_length;
+    if (dimension <= 0 || dimension >= columns){
+        return NULL;
+    }
+    double* directions;
+    float* input = embedding_model->vectors;
+    if (method == RANDOMIZED_PCA){
+        double* mean = calloc_(columns, sizeof(double));
+        for (int i = 0; i < rows; i++){
+            for (int j = 0; j < columns; j++){
+                mean[j] += input[(size_t) i * columns + j];
+            }
+        }
+        input = malloc_((size_t) rows * columns * sizeof(float));
+        for (int i = 0; i < rows; i++){
+            for (int j = 0; j < columns; j++){
+                input[(size_t) i * columns + j] = (float) (embedding_model->vectors[(size_t) i * columns + j] - mean[j] / rows);
+            }
+        }
+        free_(mean);
+        directions = principal_directions(input, rows, columns, dimension, seed, embedding_model->thread_count);
+    } else {
+        unsigned long long next_random = seed;
+        directions = malloc_((size_t) columns * dimension * sizeof(double));
+        for (size_t i = 0; i < (size_t) columns * dimension; i++){
+            if (method == GAUSSIAN_PROJECTION){
+                directions[i] = normal_random(&next_random) / sqrt(dimension);
+            } else {
+                next_random = next_random * 25214903917ULL + 11;
+                int choice = (int) ((next_random >> 16) % 6);
+                directions[i] = choice == 0 ? sqrt(3.0 / dimension) : (choice == 1 ? -sqrt(3.0 / dimension) : 0);
+            }
+        }
+    }
+    double* reduced = calloc_((size_t) rows * dimension, sizeof(double));
+    Reduction_task task = {input, NULL, directions, reduced, columns, dimension, 0, rows};
+    run_reduction_tasks(run_projection_task, &task, embedding_model->thread_count, 0);
+    Embedding_model_ptr result = create_embedding_model3(rows, dimension);
+    for (int i = 0; i < rows; i++){
+        embedding_model_set_word(result, i, embedding_model->words[i]);
+    }
+    for (size_t i = 0; i < (size_t) rows * dimension; i++){
+        result->vectors[i] = (float) reduced[i];
+    }
+    if (input != embedding_model->vectors){
+        free_(input);
+    }
+    free_(directions);
+    free_(reduced);
+    return result;
+}
+
+/**
+ * Measures how much of the quality of a model on a semantic dataset is retained after dimension reduction, as the
+ * ratio of the Spearman correlations of the reduced and the original model.
+ * @param semantic_data_set Semantic dataset.
+ * @param original Original model.
+ * @param reduced Reduced model.
+ * @return Spearman correlation of the reduced model divided by the Spearman correlation of the original model.
+ */
+double spearman_retention(Semantic_data_set_ptr semantic_data_set, const Embedding_model* original, const Embedding_model* reduced) {
+    Semantic_data_set_ptr original_similarities = calculate_similarities2(semantic_data_set, original);
+    Semantic_data_set_ptr reduced_similarities = calculate_similarities2(semantic_data_set, reduced);
+    double original_correlation = spearman_correlation(semantic_data_set, original_similarities);
+    double reduced_correlation = spearman_correlation(semantic_data_set, reduced_similarities);
+    free_semantic_data_set(original_similarities);
+    free_semantic_data_set(reduced_similarities);
+    return reduced_correlation / original_correlation;
+}
@@ -0,0 +1,26 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_DIMENSIONREDUCTION_H
+#define WORDTOVEC_DIMENSIONREDUCTION_H
+
+#include "EmbeddingModel.h"
+#include "SemanticDataSet.h"
+
+static int PCA_OVERSAMPLING = 10;
+static int PCA_POWER_ITERATIONS = 2;
+
+enum reduction_method{
+    RANDOMIZED_PCA,
+    GAUSSIAN_PROJECTION,
+    SPARSE_PROJECTION
+};
+
+typedef enum reduction_method Reduction_method;
+
+Embedding_model_ptr reduce_embedding_model(const Embedding_model* embedding_model, int dimension, Reduction_method method, unsigned long long seed);
+
+double spearman_retention(Semantic_data_set_ptr semantic_data_set, const Embedding_model* original, const Embedding_model* reduced);
+
+#endif //WORDTOVEC_DIMENSIONREDUCTION_H
@@ -0,0 +1,600 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <StringUtils.h>
+#include <Memory/Memory.h>
+#include "EmbeddingModel.h"
+
+struct lookup_task{
+    const Embedding_model* embedding_model;
+    const char** words;
+    int start;
+    int end;
+    float* output;
+    bool pooled;
+    int found;
+};
+
+typedef struct lookup_task Lookup_task;
+
+struct model_file_header{
+    int magic;
+    int version;
+    int word_count;
+    int vector_length;
+    long long vectors_offset;
+};
+
+typedef struct model_file_header Model_file_header;
+
+struct delta_file_header{
+    int magic;
+    int base_version;
+    int version;
+    int word_count;
+    int vector_length;
+    int row_count;
+};
+
+typedef struct delta_file_header Delta_file_header;
+
+/**
+ * Allocates an embedding model with the given number of words and vector length. Vectors are stored as a single
+ * contiguous row major float matrix, so that a batch of words can be copied without touching any boxed vector.
+ * Words and the word map are filled later with embedding_model_set_word.
+ * @param word_count Number of words in the model.
+ * @param vector_length Length of each word vector.
+ * @return Allocated embedding model with zero vectors.
+ */
+Embedding_model_ptr create_embedding_model3(int word_count, int vector_length) {
+    Embedding_model_ptr result = malloc_(sizeof(Embedding_model));
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    result->word_count = word_count;
+    result->vector_length = vector_length;
+    result->vectors = calloc_((size_t) word_count * vector_length, sizeof(float));
+    result->words = calloc_(word_count, sizeof(char*));
+    result->word_map = create_string_hash_map();
+    result->thread_count = processors > 0 ? (int) processors : 1;
+    result->version = 0;
+    result->mapped = NULL;
+    result->mapped_size = 0;
+    return result;
+}
+
+/**
+ * Constructs a read only embedding model from a trained neural network. Word vectors are copied from the
+ * word_vectors matrix in vocabulary order.
+ * @param neural_network Trained neural network.
+ * @return Embedding model storing the trained word vectors.
+ */
+Embedding_model_ptr create_embedding_model(Neural_network_ptr neural_network) {
+    int word_count = size_of_vocabulary(neural_network->vocabulary);
+    Embedding_model_ptr result = create_embedding_model3(word_count, neural_network->vector_length);
+    for (int i = 0; i < word_count; i++){
+        embedding_model_set_word(result, i, vocabulary_get_word(neural_network->vocabulary, i)->name);
+        float* row = result->vectors + (size_t) i * result->vector_length;
+        for (int j = 0; j < result->vector_length; j++){
+            row[j] = (float) neural_network->word_vectors[i][j];
+        }
+    }
+    return result;
+}
+
+/**
+ * Constructs a read only embedding model from a vectorized dictionary. All vectors in the dictionary are assumed
+ * to have the same length as the first one.
+ * @param dictionary Vectorized dictionary that stores the word vectors.
+ * @return Embedding model storing the dictionary vectors.
+ */
+Embedding_model_ptr create_embedding_model2(Vectorized_dictionary_ptr dictionary) {
+    Array_list_ptr words = dictionary->dictionary.words;
+    int vector_length = 0;
+    if (words->size > 0){
+        vector_length = ((Vectorized_word_ptr) array_list_get(words, 0))->vector->size;
+    }
+    Embedding_model_ptr result = create_embedding_model3(words->size, vector_length);
+    for (int i = 0; i < words->size; i++){
+        Vectorized_word_ptr word = array_list_get(words, i);
+        embedding_model_set_word(result, i, word->word.name);
+        float* row = result->vectors + (size_t) i * vector_length;
+        for (int j = 0; j < vector_length; j++){
+            row[j] = (float) get_value(word->vector, j);
+        }
+    }
+    return result;
+}
+
+/**
+ * Frees memory allocated for the embedding model. Frees vectors, words and the word map. Vectors of a model
+ * loaded from a file are unmapped.
+ * @param embedding_model Embedding model to deallocate.
+ */
+void free_embedding_model(Embedding_model_ptr embedding_model) {
+    free_hash_map2(embedding_model->word_map, NULL, free_);
+    for (int i = 0; i < embedding_model->word_count; i++){
+        free_(embedding_model->words[i]);
+    }
+    free_(embedding_model->words);
+    if (embedding_model->mapped != NULL){
+        munmap(embedding_model->mapped, embedding_model->mapped_size);
+    } else {
+        free_(embedding_model->vectors);
+    }
+    free_(embedding_model);
+}
+
+/**
+ * Sets the word at a given row of the model and registers it in the word map.
+ * @param embedding_model Current embedding model
+ * @param index Row of the word.
+ * @param word Word to be stored.
+ */
+void embedding_model_set_word(Embedding_model_ptr embedding_model, int index, const char *word) {
+    int* position = malloc_(sizeof(int));
+    *position = index;
+    embedding_model->words[index] = str_copy(embedding_model->words[index], word);
+    hash_map_insert(embedding_model->word_map, embedding_model->words[index], position);
+}
+
+/**
+ * Returns the row of a word in the model.
+ * @param embedding_model Current embedding model
+ * @param word Word to be searched.
+ * @return Row of the word, -1 if the word does not exist in the model.
+ */
+int embedding_model_index(const Embedding_model* embedding_model, const char *word) {
+    int* position = hash_map_get(embedding_model->word_map, word);
+    if (position == NULL){
+        return -1;
+    }
+    return *position;
+}
+
+/**
+ * Accessor for the vector at a given row.
+ * @param embedding_model Current embedding model
+ * @param index Row of the word.
+ * @return Pointer to the first element of the word vector.
+ */
+const float *embedding_model_vector(const Embedding_model* embedding_model, int index) {
+    return embedding_model->vectors + (size_t) index * embedding_model->vector_length;
+}
+
+/**
+ * Copies (or accumulates, if the task is pooled) the vectors of the words in the task range.
+ * @param task Lookup task storing the word range and output buffer.
+ */
+static void run_lookup_task(Lookup_task* task) {
+    const Embedding_model* embedding_model = task->embedding_model;
+    int vector_length = embedding_model->vector_length;
+    task->found = 0;
+    for (int i = task->start; i < task->end; i++){
+        int index = embedding_model_index(embedding_model, task->words[i]);
+        float* output = task->pooled ? task->output : task->output + (size_t) i * vector_length;
+        if (index != -1){
+            const float* row = embedding_model_vector(embedding_model, index);
+            if (task->pooled){
+                for (int j = 0; j < vector_length; j++){
+                    output[j] += row[j];
+                }
+            } else {
+                memcpy(output, row, vector_length * sizeof(float));
+            }
+            task->found++;
+        } else {
+            if (!task->pooled){
+                memset(output, 0, vector_length * sizeof(float));
+            }
+        }
+    }
+}
+
+static void* lookup_thread(void* task) {
+    run_lookup_task(task);
+    return NULL;
+}
+
+/**
+ * Returns the number of threads used for a batch. Only large batches are worth the thread start up cost.
+ * @param embedding_model Current embedding model
+ * @param count Number of words in the batch.
+ * @return Number of threads that will process the batch.
+ */
+static int lookup_thread_count(const Embedding_model* embedding_model, int count) {
+    if (count >= PARALLEL_LOOKUP_THRESHOLD && embedding_model->thread_count > 1){
+        return embedding_model->thread_count;
+    }
+    return 1;
+}
+
+/**
+ * Splits the words into contiguous ranges and runs one lookup task per range. Small batches are processed in the
+ * calling thread; large batches are distributed over the threads of the model. Tasks and thread handles live on
+ * the stack, so a lookup does not allocate any memory.
+ * @param embedding_model Current embedding model
+ * @param words Words to be searched.
+ * @param count Number of words.
+ * @param output Output buffer. If pooled is true, each task accumulates into its own vector_length slice.
+ * @param pooled If true, tasks accumulate the vectors instead of copying them.
+ * @return Number of words found in the model.
+ */
+static int run_lookup(const Embedding_model* embedding_model, const char** words, int count, float* output, bool pooled) {
+    int thread_count = lookup_thread_count(embedding_model, count);
+    Lookup_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    int found = 0;
+    for (int i = 0; i < thread_count; i++){
+        tasks[i].embedding_model = embedding_model;
+        tasks[i].words = words;
+        tasks[i].start = (int) ((long long) count * i / thread_count);
+        tasks[i].end = (int) ((long long) count * (i + 1) / thread_count);
+        tasks[i].pooled = pooled;
+        tasks[i].output = pooled ? output + (size_t) i * embedding_model->vector_length : output;
+    }
+    bool started[thread_count];
+    for (int i = 1; i < thread_count; i++){
+        started[i] = pthread_create(&threads[i], NULL, lookup_thread, &tasks[i]) == 0;
+    }
+    run_lookup_task(&tasks[0]);
+    for (int i = 1; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            run_lookup_task(&tasks[i]);
+        }
+    }
+    for (int i = 0; i < thread_count; i++){
+        found += tasks[i].found;
+    }
+    return found;
+}
+
+/**
+ * Looks up a batch of words and writes their vectors into a caller provided contiguous matrix. Row i of the output
+ * stores the vector of words[i]; rows of the words that do not exist in the model are set to zero. The model is
+ * only read, so the function can be called concurrently from several threads.
+ * @param embedding_model Current embedding model
+ * @param words Words to be searched.
+ * @param count Number of words.
+ * @param output Output matrix with count * vector_length floats.
+ * @return Number of words found in the model.
+ */
+int lookup_vectors(const Embedding_model* embedding_model, const char **words, int count, float *output) {
+    return run_lookup(embedding_model, words, count, output, false);
+}
+
+/**
+ * Looks up a batch of words and pools their vectors into a single sentence vector. Words that do not exist in the
+ * model are skipped, mean pooling divides by the number of words found.
+ * @param embedding_model Current embedding model
+ * @param words Words to be searched.
+ * @param count Number of words.
+ * @param pooling Pooling type, sum or mean.
+ * @param output Output vector with vector_length floats.
+ * @return Number of words found in the model.
+ */
+int lookup_pooled_vector(const Embedding_model* embedding_model,
+                         const char **words,
+                         int count,
+                         Pooling_type pooling,
+                         float *output) {
+    int vector_length = embedding_model->vector_length;
+    int thread_count = lookup_thread_count(embedding_model, count);
+    float partial_sums[thread_count * vector_length];
+    memset(partial_sums, 0, sizeof(partial_sums));
+    int found = run_lookup(embedding_model, words, count, partial_sums, true);
+    for (int j = 0; j < vector_length; j++){
+        output[j] = partial_sums[j];
+    }
+    for (int i = 1; i < thread_count; i++){
+        for (int j = 0; j < vector_length; j++){
+            output[j] += partial_sums[i * vector_length + j];
+        }
+    }
+    if (pooling == MEAN_POOLING && found > 0){
+        for (int j = 0; j < vector_length; j++){
+            output[j] /= found;
+        }
+    }
+    return found;
+}
+
+/**
+ * Writes the header and the words of a model file, followed by zeros up to the page aligned offset of the vectors.
+ * @param output Model file.
+ * @param version Version of the model.
+ * @param word_count Number of words in the model.
+ * @param vector_length Length of each word vector.
+ * @param words Words of the model.
+ * @return True if everything is written.
+ */
+static bool write_model_words(FILE* output, int version, int word_count, int vector_length, char* const* words) {
+    long long page_size = sysconf(_SC_PAGESIZE);
+    long long words_size = 0;
+    for (int i = 0; i < word_count; i++){
+        words_size += (long long) strlen(words[i]) + 1;
+    }
+    Model_file_header header;
+    header.magic = MODEL_FILE_MAGIC;
+    header.version = version;
+    header.word_count = word_count;
+    header.vector_length = vector_length;
+    header.vectors_offset = (sizeof(Model_file_header) + words_size + page_size - 1) / page_size * page_size;
+    bool written = fwrite(&header, sizeof(Model_file_header), 1, output) == 1;
+    for (int i = 0; i < word_count && written; i++){
+        size_t length = strlen(words[i]) + 1;
+        written = fwrite(words[i], 1, length, output) == length;
+    }
+    for (long long i = sizeof(Model_file_header) + words_size; i < header.vectors_offset && written; i++){
+        written = fputc(0, output) != EOF;
+    }
+    return written;
+}
+
+/**
+ * Saves the model in binary form. The file starts with a header, followed by the words as null terminated strings,
+ * followed by the vectors as a row major float matrix starting at a page aligned offset, so that the vectors can be
+ * mapped in place by create_embedding_model4.
+ * @param embedding_model Current embedding model
+ * @param file_name Name of the model file.
+ * @return True if the model is saved, false if the file could not be written.
+ */
+bool save_embedding_model(const Embedding_model* embedding_model, const char* file_name) {
+    FILE* output = fopen(file_name, "wb");
+    if (output == NULL){
+        return false;
+    }
+    bool written = write_model_words(output, embedding_model->version, embedding_model->word_count, embedding_model->vector_length, embedding_model->words);
+    size_t vector_count = (size_t) embedding_model->word_count * embedding_model->vector_length;
+    written = written && fwrite(embedding_model->vectors, sizeof(float), vector_count, output) == vector_count;
+    return fclose(output) == 0 && written;
+}
+
+/**
+ * Saves the word vectors of a network in the format of save_embedding_model. The rows are converted to float and
+ * written one at a time, so the vectors are never copied into memory as a whole; with weight files, they are read
+ * straight from the mapped matrix.
+ * @param neural_network Current neural network object
+ * @param file_name Name of the model file.
+ * @param version Version stored in the model file.
+ * @return True if the model is saved, false if the file could not be written.
+ */
+static bool save_network_vectors(Neural_network_ptr neural_network, const char* file_name, int version) {
+    FILE* output = fopen(file_name, "wb");
+    if (output == NULL){
+        return false;
+    }
+    int word_count = size_of_vocabulary(neural_network->vocabulary);
+    int vector_length = neural_network->vector_length;
+    char** words = malloc_(word_count * sizeof(char*));
+    for (int i = 0; i < word_count; i++){
+        words[i] = vocabulary_get_word(neural_network->vocabulary, i)->name;
+    }
+    bool written = write_model_words(output, version, word_count, vector_length, words);
+    free_(words);
+    float row[vector_length];
+    for (int i = 0; i < word_count && written; i++){
+        for (int j = 0; j < vector_length; j++){
+            row[j] = (float) neural_network->word_vectors[i][j];
+        }
+        written = fwrite(row, sizeof(float), vector_length, output) == (size_t) vector_length;
+    }
+    return fclose(output) == 0 && written;
+}
+
+/**
+ * Saves the word vectors of a network as the base model of a sequence of delta snapshots, and starts a new
+ * snapshot version, so that the next delta only contains the rows updated after this call.
+ * @param neural_network Current neural network object
+ * @param file_name Name of the model file.
+ * @return True if the model is saved, false if the file could not be written.
+ */
+bool save_embedding_model2(Neural_network_ptr neural_network, const char* file_name) {
+    bool result = save_network_vectors(neural_network, file_name, neural_network->snapshot_version);
+    if (result){
+        neural_network->snapshot_version++;
+    }
+    return result;
+}
+
+/**
+ * Exports the word vectors of a trained network into a model file and maps the file as a read only embedding model.
+ * Unlike export_word_vectors and create_embedding_model, the vectors are never held in memory as a whole, so this is
+ * the way to export a network whose weight matrices are stored in files because they do not fit in memory.
+ * @param neural_network Trained neural network.
+ * @param file_name Name of the model file, it is overwritten if it exists.
+ * @return Embedding model mapped from the file, NULL if the file could not be written or mapped.
+ */
+Embedding_model_ptr create_embedding_model5(Neural_network_ptr neural_network, const char* file_name) {
+    if (!save_network_vectors(neural_network, file_name, neural_network->snapshot_version)){
+        return NULL;
+    }
+    return create_embedding_model4(file_name, false);
+}
+
+/**
+ * Checks the header and the words of a mapped model file. The counts must not be negative, the vectors must lie
+ * behind the header and inside the file, and every word must be terminated before the vectors start, so that no
+ * field of a corrupt or truncated file leads to a read outside the mapping.
+ * @param header Header at the start of the mapping.
+ * @param file_size Size of the mapped file.
+ * @return True if the words and the vectors can be read from the mapping.
+ */
+static bool valid_model_file(const Model_file_header* header, off_t file_size) {
+    if (header->magic != MODEL_FILE_MAGIC || header->word_count < 0 || header->vector_length < 1 ||
+        header->vectors_offset < (long long) sizeof(Model_file_header) || header->vectors_offset > (long long) file_size ||
+        header->vectors_offset % sizeof(float) != 0 ||
+        (size_t) header->word_count * (size_t) header->vector_length > ((size_t) file_size - (size_t) header->vectors_offset) / sizeof(float)){
+        return false;
+    }
+    const char* word = (const char*) header + sizeof(Model_file_header);
+    const char* words_end = (const char*) header + header->vectors_offset;
+    for (int i = 0; i < header->word_count; i++){
+        const char* end = memchr(word, '\0', words_end - word);
+        if (end == NULL){
+            return false;
+        }
+        word = end + 1;
+    }
+    return true;
+}
+
+/**
+ * Loads a model saved by save_embedding_model. The vectors are not read but memory mapped from the file; the
+ * words are copied into the word map. If the model is writable, the file is mapped shared and deltas applied to the
+ * model are written through to the file; otherwise the mapping is private and deltas only change the copy in
+ * memory.
+ * @param file_name Name of the model file.
+ * @param writable If true, changes to the vectors are written back to the file.
+ * @return Loaded embedding model, NULL if the file could not be opened, is not a model file or is corrupt.
+ */
+Embedding_model_ptr create_embedding_model4(const char* file_name, bool writable) {
+    int descriptor = open(file_name, writable ? O_RDWR : O_RDONLY);
+    if (descriptor == -1){
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) == -1 || status.st_size < (off_t) sizeof(Model_file_header)){
+        close(descriptor);
+        return NULL;
+    }
+    void* mapped = mmap(NULL, status.st_size, PROT_READ | PROT_WRITE, writable ? MAP_SHARED : MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapped == MAP_FAILED){
+        return NULL;
+    }
+    const Model_file_header* header = mapped;
+    if (!valid_model_file(header, status.st_size)){
+        munmap(mapped, status.st_size);
+        return NULL;
+    }
+    Embedding_model_ptr result = malloc_(sizeof(Embedding_model));
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    result->word_count = header->word_count;
+    result->vector_length = header->vector_length;
+    result->vectors = (float*) ((char*) mapped + header->vectors_offset);
+    result->words = calloc_(header->word_count, sizeof(char*));
+    result->word_map = create_string_hash_map();
+    result->thread_count = processors > 0 ? (int) processors : 1;
+    result->version = header->version;
+    result->mapped = mapped;
+    result->mapped_size = status.st_size;
+    const char* word = (const char*) mapped + sizeof(Model_file_header);
+    for (int i = 0; i < result->word_count; i++){
+        embedding_model_set_word(result, i, word);
+        word += strlen(word) + 1;
+    }
+    madvise(result->vectors, (size_t) result->word_count * result->vector_length * sizeof(float), MADV_RANDOM);
+    return result;
+}
+
+/**
+ * Saves the rows of the word vectors updated since the last snapshot as a delta file, and starts a new snapshot
+ * version. The file starts with a header holding the version the delta applies to, followed by the indexes of the
+ * changed rows and their vectors. Rare words are not updated between most snapshots, so a delta is usually a small
+ * fraction of the whole model.
+ * @param neural_network Current neural network object
+ * @param file_name Name of the delta file.
+ * @return Number of rows in the delta, -1 if the file could not be written.
+ */
+int save_embedding_delta(Neural_network_ptr neural_network, const char* file_name) {
+    int size = size_of_vocabulary(neural_network->vocabulary);
+    FILE* output = fopen(file_name, "wb");
+    if (output == NULL){
+        return -1;
+    }
+    int* rows = malloc_(size * sizeof(int));
+    float* vector = malloc_(neural_network->vector_length * sizeof(float));
+    Delta_file_header header;
+    header.magic = DELTA_FILE_MAGIC;
+    header.base_version = neural_network->snapshot_version - 1;
+    header.version = neural_network->snapshot_version;
+    header.word_count = size;
+    header.vector_length = neural_network->vector_length;
+    header.row_count = 0;
+    for (int i = 0; i < size; i++){
+        if (neural_network->row_versions[i] == neural_network->snapshot_version){
+            rows[header.row_count] = i;
+            header.row_count++;
+        }
+    }
+    bool written = fwrite(&header, sizeof(Delta_file_header), 1, output) == 1 &&
+                   fwrite(rows, sizeof(int), header.row_count, output) == (size_t) header.row_count;
+    for (int i = 0; i < header.row_count && written; i++){
+        for (int j = 0; j < neural_network->vector_length; j++){
+            vector[j] = (float) neural_network->word_vectors[rows[i]][j];
+        }
+        written = fwrite(vector, sizeof(float), neural_network->vector_length, output) == (size_t) neural_network->vector_length;
+    }
+    free_(rows);
+    free_(vector);
+    if (fclose(output) != 0 || !written){
+        return -1;
+    }
+    neural_network->snapshot_version++;
+    return header.row_count;
+}
+
+/**
+ * Applies a delta file to the model. The header, the row count, every row index and the size of the file are
+ * validated, and all vectors are read into a scratch buffer before any row of the model is changed, so a truncated
+ * or corrupt delta leaves the model, and the file of a mapped model, untouched. A delta only applies to the version
+ * it was taken against, so deltas must be applied in the order they were saved; the version of the model, and of
+ * the file if the model is mapped, is advanced afterwards.
+ * @param embedding_model Current embedding model
+ * @param file_name Name of the delta file.
+ * @return Number of rows applied, -1 if the file could not be read or does not apply to the model.
+ */
+int apply_embedding_delta(Embedding_model_ptr embedding_model, const char* file_name) {
+    FILE* input = fopen(file_name, "rb");
+    if (input == NULL){
+        return -1;
+    }
+    struct stat status;
+    Delta_file_header header;
+    if (fstat(fileno(input), &status) == -1 ||
+        fread(&header, sizeof(Delta_file_header), 1, input) != 1 || header.magic != DELTA_FILE_MAGIC ||
+        header.word_count != embedding_model->word_count || header.vector_length != embedding_model->vector_length ||
+        header.base_version != embedding_model->version ||
+        header.row_count < 0 || header.row_count > embedding_model->word_count ||
+        (long long) status.st_size != (long long) sizeof(Delta_file_header) +
+        (long long) header.row_count * (long long) (sizeof(int) + embedding_model->vector_length * sizeof(float))){
+        fclose(input);
+        return -1;
+    }
+    size_t vector_size = (size_t) embedding_model->vector_length * sizeof(float);
+    int* rows = malloc_(header.row_count * sizeof(int) + 1);
+    float* vectors = malloc_(header.row_count * vector_size + 1);
+    int result = header.row_count;
+    if (fread(rows, sizeof(int), header.row_count, input) != (size_t) header.row_count ||
+        fread(vectors, vector_size, header.row_count, input) != (size_t) header.row_count){
+        result = -1;
+    }
+    for (int i = 0; i < header.row_count && result != -1; i++){
+        if (rows[i] < 0 || rows[i] >= embedding_model->word_count){
+            result = -1;
+        }
+    }
+    fclose(input);
+    if (result != -1){
+        for (int i = 0; i < header.row_count; i++){
+            memcpy(embedding_model->vectors + (size_t) rows[i] * embedding_model->vector_length,
+                   vectors + (size_t) i * embedding_model->vector_length, vector_size);
+        }
+        embedding_model->version = header.version;
+        if (embedding_model->mapped != NULL){
+            ((Model_file_header*) embedding_model->mapped)->version = header.version;
+        }
+    }
+    free_(rows);
+    free_(vectors);
+    return result;
+}
@@ -0,0 +1,73 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_EMBEDDINGMODEL_H
+#define WORDTOVEC_EMBEDDINGMODEL_H
+
+#include <HashMap/HashMap.h>
+#include <Dictionary/VectorizedDictionary.h>
+#include "NeuralNetwork.h"
+
+static int PARALLEL_LOOKUP_THRESHOLD = 4096;
+static int MODEL_FILE_MAGIC = 0x4d563257;
+static int DELTA_FILE_MAGIC = 0x44563257;
+
+enum pooling_type{
+    SUM_POOLING,
+    MEAN_POOLING
+};
+
+typedef enum pooling_type Pooling_type;
+
+struct embedding_model{
+    float* vectors;
+    char** words;
+    Hash_map_ptr word_map;
+    int word_count;
+    int vector_length;
+    int thread_count;
+    int version;
+    void* mapped;
+    size_t mapped_size;
+};
+
+typedef struct embedding_model Embedding_model;
+
+typedef Embedding_model *Embedding_model_ptr;
+
+Embedding_model_ptr create_embedding_model(Neural_network_ptr neural_network);
+
+Embedding_model_ptr create_embedding_model2(Vectorized_dictionary_ptr dictionary);
+
+Embedding_model_ptr create_embedding_model3(int word_count, int vector_length);
+
+Embedding_model_ptr create_embedding_model4(const char* file_name, bool writable);
+
+Embedding_model_ptr create_embedding_model5(Neural_network_ptr neural_network, const char* file_name);
+
+void free_embedding_model(Embedding_model_ptr embedding_model);
+
+void embedding_model_set_word(Embedding_model_ptr embedding_model, int index, const char* word);
+
+int embedding_model_index(const Embedding_model* embedding_model, const char* word);
+
+const float* embedding_model_vector(const Embedding_model* embedding_model, int index);
+
+int lookup_vectors(const Embedding_model* embedding_model, const char** words, int count, float* output);
+
+int lookup_pooled_vector(const Embedding_model* embedding_model,
+                         const char** words,
+                         int count,
+                         Pooling_type pooling,
+                         float* output);
+
+bool save_embedding_model(const Embedding_model* embedding_model, const char* file_name);
+
+bool save_embedding_model2(Neural_network_ptr neural_network, const char* file_name);
+
+int save_embedding_delta(Neural_network_ptr neural_network, const char* file_name);
+
+int apply_embedding_delta(Embedding_model_ptr embedding_model, const char* file_name);
+
+#endif //WORDTOVEC_EMBEDDINGMODEL_H
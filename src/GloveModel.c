@@ -0,0 +1,200 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <Memory/Memory.h>
+#include "GloveModel.h"
+
+struct glove_task{
+    Glove_model_ptr glove_model;
+    long long start;
+    long long end;
+    unsigned long long seed;
+    double cost;
+};
+
+typedef struct glove_task Glove_task;
+
+/**
+ * Constructor for a GloVe model trained on a co-occurrence matrix. Each word has a word vector and a context
+ * vector, both followed by a bias, initialized with random weights between -0.5 / layer_size and 0.5 / layer_size.
+ * The AdaGrad sums of squared gradients start from 1. The vocabulary and the matrix are not owned by the model, so
+ * several models with different parameters can be trained on the same counts.
+ * @param vocabulary Vocabulary the co-occurrence matrix is counted with.
+ * @param cooccurrence_matrix Co-occurrence matrix of the corpus.
+ * @param parameter Parameters holding the layer size, number of iterations, thread count, seed and GloVe weighting.
+ * @return GloVe model, NULL if the matrix is not counted with a vocabulary of the same size.
+ */
+Glove_model_ptr create_glove_model(Vocabulary_ptr vocabulary,
+                                   const Cooccurrence_matrix* cooccurrence_matrix,
+                                   Word_to_vec_parameter_ptr parameter) {
+    int row = size_of_vocabulary(vocabulary);
+    if (cooccurrence_matrix->vocabulary_size != row){
+        return NULL;
+    }
+    Glove_model_ptr result = malloc_(sizeof(Glove_model));
+    result->vocabulary = vocabulary;
+    result->cooccurrence_matrix = cooccurrence_matrix;
+    result->parameter = parameter;
+    result->vector_length = parameter->layer_size;
+    result->word_vectors = create_weight_matrix(row, result->vector_length + 1);
+    result->context_vectors = create_weight_matrix(row, result->vector_length + 1);
+    result->word_gradients = create_weight_matrix(row, result->vector_length + 1);
+    result->context_gradients = create_weight_matrix(row, result->vector_length + 1);
+    result->epoch_costs = calloc_(parameter->number_of_iterations > 0 ? parameter->number_of_iterations : 1, sizeof(double));
+    srandom(parameter->seed);
+    for (int i = 0; i < row; i++){
+        for (int j = 0; j <= result->vector_length; j++){
+            result->word_vectors->rows[i][j] = (((double) random()) / RAND_MAX - 0.5) / result->vector_length;
+            result->context_vectors->rows[i][j] = (((double) random()) / RAND_MAX - 0.5) / result->vector_length;
+            result->word_gradients->rows[i][j] = 1.0;
+            result->context_gradients->rows[i][j] = 1.0;
+        }
+    }
+    return result;
+}
+
+/**
+ * Frees memory allocated for the GloVe model. The vocabulary and the co-occurrence matrix are not freed.
+ * @param glove_model GloVe model to deallocate.
+ */
+void free_glove_model(Glove_model_ptr glove_model) {
+    free_weight_matrix(glove_model->word_vectors);
+    free_weight_matrix(glove_model->context_vectors);
+    free_weight_matrix(glove_model->word_gradients);
+    free_weight_matrix(glove_model->context_gradients);
+    free_(glove_model->epoch_costs);
+    free_(glove_model);
+}
+
+/**
+ * Returns the greatest common divisor of two numbers.
+ * @param a First number.
+ * @param b Second number.
+ * @return Greatest common divisor of a and b.
+ */
+static long long greatest_common_divisor(long long a, long long b) {
+    while (b != 0){
+        long long remainder = a % b;
+        a = b;
+        b = remainder;
+    }
+    return a;
+}
+
+/**
+ * Trains the records start to end of the co-occurrence matrix for one epoch with AdaGrad. The records are sorted
+ * by word, so they are visited in a shuffled order: starting from a random record, the task repeatedly jumps by a
+ * random step coprime with the number of records, which visits every record exactly once without storing a
+ * permutation. For a pair with count x, the weighted error f(x) (w . c + b + b' - log x) updates both vectors and
+ * both biases, each coordinate with a learning rate divided by the square root of its sum of squared gradients.
+ * Threads update the shared rows without locking.
+ * @param argument GloVe task.
+ * @return NULL
+ */
+static void* run_glove_task(void* argument) {
+    Glove_task* task = argument;
+    Glove_model_ptr glove_model = task->glove_model;
+    Word_to_vec_parameter_ptr parameter = glove_model->parameter;
+    const Cooccurrence_record* records = glove_model->cooccurrence_matrix->records;
+    int vector_length = glove_model->vector_length;
+    long long count = task->end - task->start;
+    unsigned long long next_random = task->seed;
+    task->cost = 0;
+    if (count <= 0){
+        return NULL;
+    }
+    next_random = next_random * 25214903917ULL + 11;
+    long long position = (long long) ((next_random >> 16) % count);
+    next_random = next_random * 25214903917ULL + 11;
+    long long step = (long long) ((next_random >> 16) % count) | 1;
+    while (greatest_common_divisor(step, count) != 1){
+        step = (step + 2) % count;
+    }
+    for (long long i = 0; i < count; i++){
+        const Cooccurrence_record* record = &records[task->start + position];
+        double* word = glove_model->word_vectors->rows[record->word1];
+        double* context = glove_model->context_vectors->rows[record->word2];
+        double* word_gradient = glove_model->word_gradients->rows[record->word1];
+        double* context_gradient = glove_model->context_gradients->rows[record->word2];
+        double difference = word[vector_length] + context[vector_length] - log(record->value);
+        for (int j = 0; j < vector_length; j++){
+            difference += word[j] * context[j];
+        }
+        double weighted = record->value > parameter->glove_x_max ? difference : pow(record->value / parameter->glove_x_max, parameter->glove_power) * difference;
+        if (isfinite(weighted)){
+            task->cost += 0.5 * weighted * difference;
+            weighted *= parameter->glove_learning_rate;
+            for (int j = 0; j < vector_length; j++){
+                double word_update = weighted * context[j];
+                double context_update = weighted * word[j];
+                word[j] -= word_update / sqrt(word_gradient[j]);
+                context[j] -= context_update / sqrt(context_gradient[j]);
+                word_gradient[j] += word_update * word_update;
+                context_gradient[j] += context_update * context_update;
+            }
+            word[vector_length] -= weighted / sqrt(word_gradient[vector_length]);
+            context[vector_length] -= weighted / sqrt(context_gradient[vector_length]);
+            word_gradient[vector_length] += weighted * weighted;
+            context_gradient[vector_length] += weighted * weighted;
+        }
+        position += step;
+        if (position >= count){
+            position -= count;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Main method for training GloVe vectors. Each iteration makes one pass over the co-occurrence matrix, whose
+ * records are split into contiguous ranges over the threads, so the cost of an iteration depends on the number of
+ * distinct word pairs, not on the size of the corpus. The mean cost of each iteration is kept in epoch_costs. The
+ * vector of a word is the sum of its word and context vectors.
+ * @param glove_model Current GloVe model
+ * @return Dictionary of word vectors.
+ */
+Vectorized_dictionary_ptr train_glove(Glove_model_ptr glove_model) {
+    Vectorized_dictionary_ptr result = create_vectorized_dictionary();
+    const Cooccurrence_matrix* cooccurrence_matrix = glove_model->cooccurrence_matrix;
+    int thread_count = glove_model->parameter->thread_count > 0 ? glove_model->parameter->thread_count : 1;
+    Glove_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    for (int iteration = 0; iteration < glove_model->parameter->number_of_iterations; iteration++){
+        double cost = 0;
+        for (int i = 0; i < thread_count; i++){
+            tasks[i].glove_model = glove_model;
+            tasks[i].start = cooccurrence_matrix->record_count * i / thread_count;
+            tasks[i].end = cooccurrence_matrix->record_count * (i + 1) / thread_count;
+            tasks[i].seed = (unsigned long long) glove_model->parameter->seed * 1000003ULL + iteration * 7919ULL + i;
+        }
+        bool started[thread_count];
+        for (int i = 1; i < thread_count; i++){
+            started[i] = pthread_create(&threads[i], NULL, run_glove_task, &tasks[i]) == 0;
+        }
+        run_glove_task(&tasks[0]);
+        for (int i = 1; i < thread_count; i++){
+            if (started[i]){
+                pthread_join(threads[i], NULL);
+            } else {
+                run_glove_task(&tasks[i]);
+            }
+        }
+        for (int i = 0; i < thread_count; i++){
+            cost += tasks[i].cost;
+        }
+        glove_model->epoch_costs[iteration] = cooccurrence_matrix->record_count > 0 ? cost / cooccurrence_matrix->record_count : 0;
+    }
+    for (int i = 0; i < size_of_vocabulary(glove_model->vocabulary); i++){
+        Vector_ptr vector = create_vector2(0, 0);
+        for (int j = 0; j < glove_model->vector_length; j++){
+            add_value_to_vector(vector, glove_model->word_vectors->rows[i][j] + glove_model->context_vectors->rows[i][j]);
+        }
+        add_word((Dictionary_ptr) result, (Word_ptr) create_vectorized_word(vocabulary_get_word(glove_model->vocabulary, i)->name, vector));
+    }
+    sort((Dictionary_ptr) result);
+    return result;
+}
@@ -0,0 +1,38 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_GLOVEMODEL_H
+#define WORDTOVEC_GLOVEMODEL_H
+
+#include <Dictionary/VectorizedDictionary.h>
+#include "Vocabulary.h"
+#include "WordToVecParameter.h"
+#include "WeightMatrix.h"
+#include "Cooccurrence.h"
+
+struct glove_model{
+    Vocabulary_ptr vocabulary;
+    const Cooccurrence_matrix* cooccurrence_matrix;
+    Word_to_vec_parameter_ptr parameter;
+    int vector_length;
+    Weight_matrix_ptr word_vectors;
+    Weight_matrix_ptr context_vectors;
+    Weight_matrix_ptr word_gradients;
+    Weight_matrix_ptr context_gradients;
+    double* epoch_costs;
+};
+
+typedef struct glove_model Glove_model;
+
+typedef Glove_model *Glove_model_ptr;
+
+Glove_model_ptr create_glove_model(Vocabulary_ptr vocabulary,
+                                   const Cooccurrence_matrix* cooccurrence_matrix,
+                                   Word_to_vec_parameter_ptr parameter);
+
+void free_glove_model(Glove_model_ptr glove_model);
+
+Vectorized_dictionary_ptr train_glove(Glove_model_ptr glove_model);
+
+#endif //WORDTOVEC_GLOVEMODEL_H
@@ -7,11 +7,24 @@
 
 /**
  * Constructor for the Iteration class. Get corpus and parameter as input, sets the corresponding
- * parameters.
+ * parameters. Since the number of words in the corpus is not known yet, the learning rate scheduler is constructed
+ * by the first alpha_update.
  * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
  * @param parameter Parameters of the Word2Vec algorithm.
  */
 Iteration_ptr create_iteration(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter) {
+    return create_iteration2(corpus, parameter, NULL, 0);
+}
+
+/**
+ * Constructor for the Iteration class, where the sentences of the corpus are read through a phrase detector. The
+ * learning rate scheduler is constructed once here for the given number of words.
+ * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * @param parameter Parameters of the Word2Vec algorithm.
+ * @param phrase_detector Phrase detector rewriting the sentences of the corpus, NULL if no phrases are detected.
+ * @param total_number_of_words Total number of words in the corpus.
+ */
+Iteration_ptr create_iteration2(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter, Phrase_detector_ptr phrase_detector, long long total_number_of_words) {
     Iteration_ptr result = malloc_(sizeof(Iteration));
     result->word_count = 0;
     result->last_word_count = 0;
@@ -20,8 +33,10 @@ Iteration_ptr create_iteration(Corpus_ptr corpus, Word_to_vec_parameter_ptr para
     result->sentence_position = 0;
     result->corpus = corpus;
     result->parameter = parameter;
+    result->phrase_detector = phrase_detector;
     result->starting_alpha = parameter->alpha;
     result->alpha = parameter->alpha;
+    result->scheduler = create_learning_rate_scheduler(parameter, total_number_of_words);
     return result;
 }
 
@@ -34,17 +49,20 @@ void free_iteration(Iteration_ptr iteration) {
 }
 
 /**
- * Updates the alpha parameter after 10000 words has been processed.
+ * Updates the alpha parameter after 10000 words has been processed. The new learning rate is computed by the
+ * learning rate scheduler of the iteration, which is constructed again only if the number of words differs from
+ * the one it was constructed for.
  * @param iteration Current iteration object
  * @param total_number_of_words Total number of words in the corpus
  */
-void alpha_update(Iteration_ptr iteration, int total_number_of_words) {
+void alpha_update(Iteration_ptr iteration, long long total_number_of_words) {
     if (iteration->word_count - iteration->last_word_count > 10000) {
+        if (iteration->scheduler.epoch_word_count != total_number_of_words){
+            iteration->scheduler = create_learning_rate_scheduler(iteration->parameter, total_number_of_words);
+        }
         iteration->word_count_actual += iteration->word_count - iteration->last_word_count;
         iteration->last_word_count = iteration->word_count;
-        iteration->alpha = iteration->starting_alpha * (1 - iteration->word_count_actual / (iteration->parameter->number_of_iterations * total_number_of_words + 1.0));
-        if (iteration->alpha < iteration->starting_alpha * 0.0001)
-            iteration->alpha = iteration->starting_alpha * 0.0001;
+        iteration->alpha = scheduled_alpha(&iteration->scheduler, iteration->word_count_actual);
     }
 }
 
@@ -62,14 +80,14 @@ Sentence_ptr sentence_update(Iteration_ptr iteration, Sentence_ptr current_sente
     if (iteration->sentence_position >= sentence_word_count(current_sentence)) {
         iteration->word_count += sentence_word_count(current_sentence);
         iteration->sentence_position = 0;
-        Sentence* sentence = corpus_get_sentence2(iteration->corpus);
+        Sentence* sentence = phrase_get_sentence(iteration->phrase_detector, iteration->corpus);
         if (sentence == NULL){
             iteration->iteration_count++;
             iteration->word_count = 0;
             iteration->last_word_count = 0;
             corpus_close(iteration->corpus);
             corpus_open(iteration->corpus);
-            sentence = corpus_get_sentence2(iteration->corpus);
+            sentence = phrase_get_sentence(iteration->phrase_detector, iteration->corpus);
         }
         return sentence;
     }
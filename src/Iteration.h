@@ -7,17 +7,21 @@
 
 #include <Corpus.h>
 #include "WordToVecParameter.h"
+#include "PhraseDetector.h"
+#include "LearningRateScheduler.h"
 
 struct iteration{
-    int word_count;
-    int last_word_count;
-    int word_count_actual;
+    long long word_count;
+    long long last_word_count;
+    long long word_count_actual;
     int iteration_count;
     int sentence_position;
     double starting_alpha;
     double alpha;
     Word_to_vec_parameter_ptr parameter;
     Corpus_ptr corpus;
+    Phrase_detector_ptr phrase_detector;
+    Learning_rate_scheduler scheduler;
 };
 
 typedef struct iteration Iteration;
@@ -26,9 +30,11 @@ typedef Iteration *Iteration_ptr;
 
 Iteration_ptr create_iteration(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter);
 
+Iteration_ptr create_iteration2(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter, Phrase_detector_ptr phrase_detector, long long total_number_of_words);
+
 void free_iteration(Iteration_ptr iteration);
 
-void alpha_update(Iteration_ptr iteration, int total_number_of_words);
+void alpha_update(Iteration_ptr iteration, long long total_number_of_words);
 
 Sentence_ptr sentence_update(Iteration_ptr iteration, Sentence_ptr current_sentence);
 
@@ -0,0 +1,383 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <math.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <Memory/Memory.h>
+#include "KnnGraph.h"
+
+struct knn_graph_file_header{
+    int magic;
+    int word_count;
+    int vector_length;
+    int k;
+    int completed_rows;
+    unsigned long long model_hash;
+};
+
+typedef struct knn_graph_file_header Knn_graph_file_header;
+
+struct knn_task{
+    const Nearest_neighbors* nearest_neighbors;
+    int k;
+    int start;
+    int end;
+    atomic_int* next_block;
+    char* records;
+    float* panel;
+};
+
+typedef struct knn_task Knn_task;
+
+/**
+ * Returns the size of the record of one row in a graph file: the rows of its k neighbors best first, followed by
+ * their cosine similarities.
+ * @param k Number of neighbors per row.
+ * @return Size of a record in bytes.
+ */
+static size_t knn_record_size(int k) {
+    return (size_t) k * (sizeof(int) + sizeof(float));
+}
+
+/**
+ * Hashes the inverse norms of the rows of a model with FNV-1a. Retraining or replacing the model changes the norms,
+ * so a graph file is only resumed for the model it was started with.
+ * @param nearest_neighbors Nearest neighbor index of the model.
+ * @return Hash of the model.
+ */
+static unsigned long long knn_model_hash(const Nearest_neighbors* nearest_neighbors) {
+    const unsigned char* bytes = (const unsigned char*) nearest_neighbors->inverse_norms;
+    size_t size = (size_t) nearest_neighbors->embedding_model->word_count * sizeof(float);
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++){
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Transposes the normalized rows start to end of the model into a dimension major panel of KNN_QUERY_ROWS
+ * columns. Columns beyond the last row are zero.
+ * @param nearest_neighbors Nearest neighbor index of the model.
+ * @param start First row of the block.
+ * @param end Row after the last row of the block.
+ * @param panel Output panel, vector_length x KNN_QUERY_ROWS.
+ */
+static void fill_knn_panel(const Nearest_neighbors* nearest_neighbors, int start, int end, float* panel) {
+    const Embedding_model* embedding_model = nearest_neighbors->embedding_model;
+    memset(panel, 0, (size_t) embedding_model->vector_length * KNN_QUERY_ROWS * sizeof(float));
+    for (int q = 0; q < end - start; q++){
+        const float* row = embedding_model_vector(embedding_model, start + q);
+        float scale = nearest_neighbors->inverse_norms[start + q];
+        for (int d = 0; d < embedding_model->vector_length; d++){
+            panel[(size_t) d * KNN_QUERY_ROWS + q] = row[d] * scale;
+        }
+    }
+}
+
+/**
+ * Finds the k nearest rows of the rows start to end of the model, excluding the row itself. The rows are
+ * normalized and transposed into a panel that stays in the first level cache, and the whole model streams past
+ * it: the kernel multiplies KNN_KERNEL_ROWS rows of the model with KNN_KERNEL_QUERIES columns of the panel at
+ * a time, so the partial sums live in registers and every value loaded is used several times. Each score goes
+ * into the bounded heap of its query, which is kept in place in the output records. Since the rows are scanned in
+ * increasing order, a score that does not beat the worst neighbor of a full heap can never enter it, and is
+ * rejected without a call.
+ * @param nearest_neighbors Nearest neighbor index of the model.
+ * @param k Number of neighbors per row.
+ * @param start First row of the block.
+ * @param end Row after the last row of the block.
+ * @param panel Panel buffer, vector_length x KNN_QUERY_ROWS.
+ * @param records Output records of the block.
+ */
+static void search_knn_block(const Nearest_neighbors* nearest_neighbors,
+                             int k,
+                             int start,
+                             int end,
+                             float* panel,
+                             char* records) {
+    const Embedding_model* embedding_model = nearest_neighbors->embedding_model;
+    int vector_length = embedding_model->vector_length;
+    int word_count = embedding_model->word_count;
+    int query_count = end - start;
+    int sizes[KNN_QUERY_ROWS];
+    float* heap_scores[KNN_QUERY_ROWS];
+    int* heap_indices[KNN_QUERY_ROWS];
+    for (int q = 0; q < query_count; q++){
+        sizes[q] = 0;
+        heap_indices[q] = (int*) (records + q * knn_record_size(k));
+        heap_scores[q] = (float*) (heap_indices[q] + k);
+    }
+    fill_knn_panel(nearest_neighbors, start, end, panel);
+    for (int c = 0; c < word_count; c += KNN_KERNEL_ROWS){
+        const float* rows[KNN_KERNEL_ROWS];
+        for (int r = 0; r < KNN_KERNEL_ROWS; r++){
+            rows[r] = embedding_model_vector(embedding_model, c + r < word_count ? c + r : word_count - 1);
+        }
+        for (int column = 0; column < query_count; column += KNN_KERNEL_QUERIES){
+            float sums[KNN_KERNEL_ROWS][KNN_KERNEL_QUERIES] = {{0}};
+            for (int d = 0; d < vector_length; d++){
+                const float* restrict values = panel + (size_t) d * KNN_QUERY_ROWS + column;
+                float row_values[KNN_KERNEL_ROWS];
+                for (int r = 0; r < KNN_KERNEL_ROWS; r++){
+                    row_values[r] = rows[r][d];
+                }
+                for (int q = 0; q < KNN_KERNEL_QUERIES; q++){
+                    for (int r = 0; r < KNN_KERNEL_ROWS; r++){
+                        sums[r][q] += row_values[r] * values[q];
+                    }
+                }
+            }
+            for (int r = 0; r < KNN_KERNEL_ROWS && c + r < word_count; r++){
+                float scale = nearest_neighbors->inverse_norms[c + r];
+                for (int q = 0; q < KNN_KERNEL_QUERIES && column + q < query_count; q++){
+                    float score = sums[r][q] * scale;
+                    int query = column + q;
+                    if ((sizes[query] < k || score > heap_scores[query][0]) && start + query != c + r){
+                        push_neighbor(heap_scores[query], heap_indices[query], &sizes[query], k, score, c + r);
+                    }
+                }
+            }
+        }
+    }
+    for (int q = 0; q < query_count; q++){
+        sort_neighbors(heap_scores[q], heap_indices[q], sizes[q], k);
+    }
+}
+
+/**
+ * Main function of a graph thread. The thread takes the next block of KNN_QUERY_ROWS rows of the task until all
+ * rows are taken, so that threads finishing early help with the remaining blocks.
+ * @param argument Graph task.
+ * @return NULL
+ */
+static void* run_knn_task(void* argument) {
+    Knn_task* task = argument;
+    while (true){
+        int start = task->start + atomic_fetch_add(task->next_block, 1) * KNN_QUERY_ROWS;
+        if (start >= task->end){
+            break;
+        }
+        int end = start + KNN_QUERY_ROWS < task->end ? start + KNN_QUERY_ROWS : task->end;
+        search_knn_block(task->nearest_neighbors, task->k, start, end, task->panel, task->records + (size_t) (start - task->start) * knn_record_size(task->k));
+    }
+    return NULL;
+}
+
+/**
+ * Finds the k nearest rows of the rows start to end of the model with the threads of the index.
+ * @param nearest_neighbors Nearest neighbor index of the model.
+ * @param k Number of neighbors per row.
+ * @param start First row.
+ * @param end Row after the last row.
+ * @param records Output records of the rows.
+ */
+static void search_knn_rows(const Nearest_neighbors* nearest_neighbors, int k, int start, int end, char* records) {
+    int block_count = (end - start + KNN_QUERY_ROWS - 1) / KNN_QUERY_ROWS;
+    int thread_count = nearest_neighbors->thread_count < block_count ? nearest_neighbors->thread_count : block_count;
+    if (thread_count < 1){
+        thread_count = 1;
+    }
+    atomic_int next_block;
+    atomic_init(&next_block, 0);
+    float* panels = malloc_((size_t) thread_count * nearest_neighbors->embedding_model->vector_length * KNN_QUERY_ROWS * sizeof(float));
+    Knn_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    for (int i = 0; i < thread_count; i++){
+        tasks[i].nearest_neighbors = nearest_neighbors;
+        tasks[i].k = k;
+        tasks[i].start = start;
+        tasks[i].end = end;
+        tasks[i].next_block = &next_block;
+        tasks[i].records = records;
+        tasks[i].panel = panels + (size_t) i * nearest_neighbors->embedding_model->vector_length * KNN_QUERY_ROWS;
+    }
+    bool started[thread_count];
+    for (int i = 1; i < thread_count; i++){
+        started[i] = pthread_create(&threads[i], NULL, run_knn_task, &tasks[i]) == 0;
+    }
+    run_knn_task(&tasks[0]);
+    for (int i = 1; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            run_knn_task(&tasks[i]);
+        }
+    }
+    free_(panels);
+}
+
+/**
+ * Writes a buffer to a file at an offset, repeating the write until all of it is written.
+ * @param descriptor File descriptor.
+ * @param buffer Buffer to write.
+ * @param size Size of the buffer.
+ * @param offset Offset in the file.
+ * @return True if the whole buffer is written.
+ */
+static bool write_knn_buffer(int descriptor, const void* buffer, size_t size, off_t offset) {
+    const char* bytes = buffer;
+    while (size > 0){
+        ssize_t written = pwrite(descriptor, bytes, size, offset);
+        if (written <= 0){
+            return false;
+        }
+        bytes += written;
+        size -= written;
+        offset += written;
+    }
+    return true;
+}
+
+/**
+ * Computes the k nearest neighbors of every row of the model and saves them as a graph file.
+ * @param nearest_neighbors Nearest neighbor index of the model.
+ * @param k Number of neighbors per row.
+ * @param file_name Name of the graph file.
+ * @return Number of rows of the graph, -1 if k is not positive or the file could not be written.
+ */
+int build_knn_graph(const Nearest_neighbors* nearest_neighbors, int k, const char* file_name) {
+    return build_knn_graph2(nearest_neighbors, k, file_name, -1);
+}
+
+/**
+ * Computes the k nearest neighbors by cosine similarity of the rows of the model, excluding the row itself, and
+ * appends them to a graph file. The file starts with a header, followed by one fixed size record per row holding
+ * the rows of its neighbors best first and their similarities; rows with fewer than k other rows are padded with
+ * row -1. The rows are computed in chunks of KNN_CHECKPOINT_ROWS rows; after each chunk is written and synced,
+ * the header records the number of completed rows. If the file already holds a graph of the same model and k,
+ * the computation resumes after its completed rows, so an interrupted job only loses its last chunk. A graph file
+ * of another model or k is started over, a file that is not a graph file is not touched.
+ * @param nearest_neighbors Nearest neighbor index of the model.
+ * @param k Number of neighbors per row.
+ * @param file_name Name of the graph file.
+ * @param row_limit Maximum number of rows computed by this call, -1 for all remaining rows.
+ * @return Number of completed rows in the file, -1 if k is not positive or the file could not be written.
+ */
+int build_knn_graph2(const Nearest_neighbors* nearest_neighbors, int k, const char* file_name, int row_limit) {
+    const Embedding_model* embedding_model = nearest_neighbors->embedding_model;
+    if (k < 1){
+        return -1;
+    }
+    int descriptor = open(file_name, O_RDWR | O_CREAT, 0644);
+    if (descriptor == -1){
+        return -1;
+    }
+    Knn_graph_file_header expected, header;
+    memset(&expected, 0, sizeof(Knn_graph_file_header));
+    expected.magic = KNN_GRAPH_FILE_MAGIC;
+    expected.word_count = embedding_model->word_count;
+    expected.vector_length = embedding_model->vector_length;
+    expected.k = k;
+    expected.model_hash = knn_model_hash(nearest_neighbors);
+    ssize_t read_size = pread(descriptor, &header, sizeof(Knn_graph_file_header), 0);
+    if (read_size > 0 && (read_size != sizeof(Knn_graph_file_header) || header.magic != KNN_GRAPH_FILE_MAGIC)){
+        close(descriptor);
+        return -1;
+    }
+    if (read_size == 0 || header.word_count != expected.word_count || header.vector_length != expected.vector_length ||
+        header.k != expected.k || header.model_hash != expected.model_hash ||
+        header.completed_rows < 0 || header.completed_rows > header.word_count){
+        header = expected;
+        if (ftruncate(descriptor, 0) != 0 || !write_knn_buffer(descriptor, &header, sizeof(Knn_graph_file_header), 0)){
+            close(descriptor);
+            return -1;
+        }
+    }
+    int end = embedding_model->word_count;
+    if (row_limit >= 0 && header.completed_rows + (long long) row_limit < end){
+        end = header.completed_rows + row_limit;
+    }
+    int chunk_rows = end - header.completed_rows < KNN_CHECKPOINT_ROWS ? end - header.completed_rows : KNN_CHECKPOINT_ROWS;
+    char* records = malloc_(chunk_rows > 0 ? chunk_rows * knn_record_size(k) : 1);
+    bool written = true;
+    while (written && header.completed_rows < end){
+        int chunk_end = header.completed_rows + chunk_rows < end ? header.completed_rows + chunk_rows : end;
+        search_knn_rows(nearest_neighbors, k, header.completed_rows, chunk_end, records);
+        off_t offset = (off_t) (sizeof(Knn_graph_file_header) + header.completed_rows * knn_record_size(k));
+        written = write_knn_buffer(descriptor, records, (chunk_end - header.completed_rows) * knn_record_size(k), offset) && fdatasync(descriptor) == 0;
+        if (written){
+            header.completed_rows = chunk_end;
+            written = write_knn_buffer(descriptor, &header, sizeof(Knn_graph_file_header), 0) && fdatasync(descriptor) == 0;
+        }
+    }
+    if (written && header.completed_rows == embedding_model->word_count){
+        written = ftruncate(descriptor, (off_t) (sizeof(Knn_graph_file_header) + header.completed_rows * knn_record_size(k))) == 0;
+    }
+    free_(records);
+    close(descriptor);
+    return written ? header.completed_rows : -1;
+}
+
+/**
+ * Opens a complete graph file saved by build_knn_graph. The records are memory mapped read only.
+ * @param file_name Name of the graph file.
+ * @return Graph, NULL if the file could not be opened, is not a graph file or is not complete.
+ */
+Knn_graph_ptr create_knn_graph(const char* file_name) {
+    int descriptor = open(file_name, O_RDONLY);
+    if (descriptor == -1){
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) == -1 || status.st_size < (off_t) sizeof(Knn_graph_file_header)){
+        close(descriptor);
+        return NULL;
+    }
+    void* mapped = mmap(NULL, status.st_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    close(descriptor);
+    if (mapped == MAP_FAILED){
+        return NULL;
+    }
+    const Knn_graph_file_header* header = mapped;
+    if (header->magic != KNN_GRAPH_FILE_MAGIC || header->k < 0 || header->word_count < 0 ||
+        header->completed_rows != header->word_count ||
+        sizeof(Knn_graph_file_header) + header->word_count * knn_record_size(header->k) > (size_t) status.st_size){
+        munmap(mapped, status.st_size);
+        return NULL;
+    }
+    Knn_graph_ptr result = malloc_(sizeof(Knn_graph));
+    result->records = (const char*) mapped + sizeof(Knn_graph_file_header);
+    result->word_count = header->word_count;
+    result->k = header->k;
+    result->mapped = mapped;
+    result->mapped_size = status.st_size;
+    madvise(mapped, status.st_size, MADV_SEQUENTIAL);
+    return result;
+}
+
+/**
+ * Frees memory allocated for the graph and unmaps its file. The file is not removed.
+ * @param knn_graph Graph to deallocate.
+ */
+void free_knn_graph(Knn_graph_ptr knn_graph) {
+    munmap(knn_graph->mapped, knn_graph->mapped_size);
+    free_(knn_graph);
+}
+
+/**
+ * Returns the neighbors of a row, best first, -1 for padding.
+ * @param knn_graph Current graph
+ * @param row Row of the model.
+ * @return Array of k rows.
+ */
+const int* knn_graph_neighbors(const Knn_graph* knn_graph, int row) {
+    return (const int*) (knn_graph->records + (size_t) row * knn_record_size(knn_graph->k));
+}
+
+/**
+ * Returns the cosine similarities of the neighbors of a row, in the order of knn_graph_neighbors.
+ * @param knn_graph Current graph
+ * @param row Row of the model.
+ * @return Array of k similarities.
+ */
+const float* knn_graph_scores(const Knn_graph* knn_graph, int row) {
+    return (const float*) (knn_graph_neighbors(knn_graph, row) + knn_graph->k);
+}
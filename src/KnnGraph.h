@@ -0,0 +1,41 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_KNNGRAPH_H
+#define WORDTOVEC_KNNGRAPH_H
+
+#include "NearestNeighbors.h"
+
+#define KNN_KERNEL_ROWS 4
+#define KNN_KERNEL_QUERIES 16
+
+static int KNN_GRAPH_FILE_MAGIC = 0x4b563257;
+static int KNN_QUERY_ROWS = 64;
+static int KNN_CHECKPOINT_ROWS = 1 << 14;
+
+struct knn_graph{
+    const char* records;
+    int word_count;
+    int k;
+    void* mapped;
+    size_t mapped_size;
+};
+
+typedef struct knn_graph Knn_graph;
+
+typedef Knn_graph *Knn_graph_ptr;
+
+int build_knn_graph(const Nearest_neighbors* nearest_neighbors, int k, const char* file_name);
+
+int build_knn_graph2(const Nearest_neighbors* nearest_neighbors, int k, const char* file_name, int row_limit);
+
+Knn_graph_ptr create_knn_graph(const char* file_name);
+
+void free_knn_graph(Knn_graph_ptr knn_graph);
+
+const int* knn_graph_neighbors(const Knn_graph* knn_graph, int row);
+
+const float* knn_graph_scores(const Knn_graph* knn_graph, int row);
+
+#endif //WORDTOVEC_KNNGRAPH_H
@@ -0,0 +1,51 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "KnnGraph.h"
+
+/**
+ * Computes the k nearest neighbor graph of a model saved with save_embedding_model. The graph is checkpointed every
+ * KNN_CHECKPOINT_ROWS rows, so running the same command again after an interruption continues where the previous
+ * run stopped. Progress and the estimated remaining time are printed after every checkpoint.
+ */
+int main(int argc, char** argv) {
+    if (argc < 4){
+        fprintf(stderr, "Usage: %s model_file k graph_file\n", argv[0]);
+        return 1;
+    }
+    int k = atoi(argv[2]);
+    Embedding_model_ptr embedding_model = create_embedding_model4(argv[1], false);
+    if (embedding_model == NULL){
+        fprintf(stderr, "Cannot load model %s\n", argv[1]);
+        return 1;
+    }
+    Nearest_neighbors_ptr nearest_neighbors = create_nearest_neighbors(embedding_model);
+    int word_count = embedding_model->word_count;
+    int first = build_knn_graph2(nearest_neighbors, k, argv[3], 0);
+    int completed = first;
+    if (first > 0){
+        printf("Resuming after %d of %d rows\n", first, word_count);
+    }
+    struct timespec start, now;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (completed != -1 && completed < word_count){
+        completed = build_knn_graph2(nearest_neighbors, k, argv[3], KNN_CHECKPOINT_ROWS);
+        if (completed != -1){
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            double elapsed = (double) (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+            printf("%d of %d rows, %.0f seconds elapsed, %.0f seconds remaining\n", completed, word_count, elapsed,
+                   elapsed * (word_count - completed) / (completed - first));
+            fflush(stdout);
+        }
+    }
+    if (completed == -1){
+        fprintf(stderr, "Cannot write graph %s\n", argv[3]);
+    }
+    free_nearest_neighbors(nearest_neighbors);
+    free_embedding_model(embedding_model);
+    return completed == word_count ? 0 : 1;
+}
@@ -0,0 +1,61 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <math.h>
+#include "LearningRateScheduler.h"
+
+/**
+ * Constructor for the learning rate scheduler. The scheduler only stores the schedule settings of the parameter
+ * and the length of the training, so it is returned by value and needs no deallocation.
+ * @param parameter Parameters of the Word2Vec algorithm.
+ * @param epoch_word_count Number of words processed in one pass over the corpus.
+ * @return Learning rate scheduler.
+ */
+Learning_rate_scheduler create_learning_rate_scheduler(const Word_to_vec_parameter* parameter, long long epoch_word_count) {
+    Learning_rate_scheduler result;
+    result.schedule = parameter->schedule;
+    result.starting_alpha = parameter->alpha;
+    result.minimum_alpha = parameter->alpha * 0.0001;
+    result.warmup_ratio = parameter->warmup_ratio;
+    result.restart_per_epoch = parameter->restart_per_epoch;
+    result.epoch_word_count = epoch_word_count;
+    result.total_word_count = parameter->number_of_iterations * epoch_word_count;
+    return result;
+}
+
+/**
+ * Returns the learning rate after a given number of words has been processed. The learning rate depends only on
+ * the number of processed words, so the threads of a parallel training can compute it from a shared progress
+ * counter without any further synchronization. The first warmup_ratio of the schedule increases the learning rate
+ * linearly up to alpha, the rest decays it linearly or along a half cosine. If the schedule restarts per epoch,
+ * every epoch runs the whole schedule again. With a linear schedule, no warmup and no restarts, the learning rate
+ * is the classic Word2Vec decay.
+ * @param scheduler Current learning rate scheduler
+ * @param word_count_actual Number of words processed so far over all epochs.
+ * @return Learning rate, never less than 0.0001 times the starting learning rate.
+ */
+double scheduled_alpha(const Learning_rate_scheduler* scheduler, long long word_count_actual) {
+    double position = (double) word_count_actual;
+    double span = (double) scheduler->total_word_count;
+    double alpha;
+    if (scheduler->restart_per_epoch && scheduler->epoch_word_count > 0){
+        position = (double) (word_count_actual % scheduler->epoch_word_count);
+        span = (double) scheduler->epoch_word_count;
+    }
+    double warmup = scheduler->warmup_ratio * span;
+    if (position < warmup){
+        alpha = scheduler->starting_alpha * (position + 1) / warmup;
+    } else {
+        double fraction = (position - warmup) / (span - warmup + 1.0);
+        if (scheduler->schedule == COSINE_SCHEDULE){
+            alpha = scheduler->minimum_alpha + (scheduler->starting_alpha - scheduler->minimum_alpha) * 0.5 * (1 + cos(M_PI * fraction));
+        } else {
+            alpha = scheduler->starting_alpha * (1 - fraction);
+        }
+    }
+    if (alpha < scheduler->minimum_alpha){
+        alpha = scheduler->minimum_alpha;
+    }
+    return alpha;
+}
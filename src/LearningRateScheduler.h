@@ -0,0 +1,26 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_LEARNINGRATESCHEDULER_H
+#define WORDTOVEC_LEARNINGRATESCHEDULER_H
+
+#include "WordToVecParameter.h"
+
+struct learning_rate_scheduler{
+    Schedule_type schedule;
+    double starting_alpha;
+    double minimum_alpha;
+    double warmup_ratio;
+    bool restart_per_epoch;
+    long long epoch_word_count;
+    long long total_word_count;
+};
+
+typedef struct learning_rate_scheduler Learning_rate_scheduler;
+
+Learning_rate_scheduler create_learning_rate_scheduler(const Word_to_vec_parameter* parameter, long long epoch_word_count);
+
+double scheduled_alpha(const Learning_rate_scheduler* scheduler, long long word_count_actual);
+
+#endif //WORDTOVEC_LEARNINGRATESCHEDULER_H
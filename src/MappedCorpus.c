@@ -0,0 +1,444 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <Memory/Memory.h>
+#include "MappedCorpus.h"
+
+struct word_entry{
+    unsigned long long hash;
+    const char* word;
+    int length;
+    int index;
+    long long count;
+};
+
+typedef struct word_entry Word_entry;
+
+struct word_table{
+    Word_entry* entries;
+    size_t capacity;
+    size_t size;
+    bool mapped;
+};
+
+typedef struct word_table Word_table;
+
+struct ingestion_task{
+    const Mapped_corpus* mapped_corpus;
+    size_t start;
+    size_t end;
+    Word_table table;
+    const Word_table* vocabulary_table;
+    Corpus_shard_ptr shard;
+    long long word_count;
+    bool on_calling_thread;
+    bool failed;
+};
+
+typedef struct ingestion_task Ingestion_task;
+
+/**
+ * Constructor for a mapped corpus. The text file is mapped read only, so the words of the corpus are read in
+ * place without copying a line or allocating a sentence.
+ * @param file_name Name of the corpus file. Sentences are lines, words are separated with spaces or tabs.
+ * @param thread_count Number of threads used to tokenize the corpus.
+ * @return Mapped corpus, NULL if the file can not be opened or mapped.
+ */
+Mapped_corpus_ptr create_mapped_corpus(const char *file_name, int thread_count) {
+    struct stat status;
+    int descriptor = open(file_name, O_RDONLY);
+    if (descriptor == -1){
+        return NULL;
+    }
+    if (fstat(descriptor, &status) == -1){
+        close(descriptor);
+        return NULL;
+    }
+    const char* data = NULL;
+    if (status.st_size > 0){
+        data = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (data == MAP_FAILED){
+            close(descriptor);
+            return NULL;
+        }
+        madvise((void*) data, status.st_size, MADV_SEQUENTIAL);
+    }
+    Mapped_corpus_ptr result = malloc_(sizeof(Mapped_corpus));
+    result->data = data;
+    result->size = status.st_size;
+    result->descriptor = descriptor;
+    result->thread_count = thread_count > 0 ? thread_count : 1;
+    return result;
+}
+
+/**
+ * Frees memory allocated for the mapped corpus and unmaps the file.
+ * @param mapped_corpus Mapped corpus to deallocate.
+ */
+void free_mapped_corpus(Mapped_corpus_ptr mapped_corpus) {
+    if (mapped_corpus->data != NULL){
+        munmap((void*) mapped_corpus->data, mapped_corpus->size);
+    }
+    close(mapped_corpus->descriptor);
+    free_(mapped_corpus);
+}
+
+/**
+ * Splits the corpus into range_count byte ranges of approximately equal size. Every boundary is moved to the
+ * beginning of the next line, so no sentence is split between two ranges.
+ * @param mapped_corpus Current mapped corpus
+ * @param range_count Number of ranges.
+ * @return Array of range_count + 1 offsets, range i spans the bytes from offset i to offset i + 1.
+ */
+size_t *split_mapped_corpus(const Mapped_corpus* mapped_corpus, int range_count) {
+    size_t* result = malloc_((range_count + 1) * sizeof(size_t));
+    result[0] = 0;
+    for (int i = 1; i < range_count; i++){
+        size_t offset = mapped_corpus->size / range_count * i;
+        if (offset < result[i - 1]){
+            offset = result[i - 1];
+        }
+        while (offset > 0 && offset < mapped_corpus->size && mapped_corpus->data[offset - 1] != '\n'){
+            offset++;
+        }
+        result[i] = offset;
+    }
+    result[range_count] = mapped_corpus->size;
+    return result;
+}
+
+static bool is_separator(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+/**
+ * FNV-1a hash of a word given as a byte range.
+ * @param word First byte of the word.
+ * @param length Length of the word.
+ * @return Hash value of the word.
+ */
+static unsigned long long hash_word(const char* word, int length) {
+    unsigned long long hash = 14695981039346656037ULL;
+    for (int i = 0; i < length; i++){
+        hash = (hash ^ (unsigned char) word[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Allocates the entries of a word table. Tables of the tokenizing threads are mapped, so that their pages are
+ * placed on the NUMA node of the thread and the shared allocator is not used off the calling thread. Tables of the
+ * calling thread are allocated on the heap.
+ * @param table Word table
+ * @param capacity Number of entries, a power of two.
+ * @param mapped True if the table is allocated by a tokenizing thread.
+ * @return False if no pages can be mapped, the table is then left empty.
+ */
+static bool allocate_word_table(Word_table* table, size_t capacity, bool mapped) {
+    table->size = 0;
+    table->mapped = mapped;
+    if (mapped){
+        table->entries = mmap(NULL, capacity * sizeof(Word_entry), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (table->entries == MAP_FAILED){
+            table->entries = NULL;
+            table->capacity = 0;
+            return false;
+        }
+    } else {
+        table->entries = calloc_(capacity, sizeof(Word_entry));
+    }
+    table->capacity = capacity;
+    return true;
+}
+
+static void free_word_table(Word_table* table) {
+    if (table->mapped){
+        if (table->entries != NULL){
+            munmap(table->entries, table->capacity * sizeof(Word_entry));
+        }
+    } else {
+        free_(table->entries);
+    }
+}
+
+/**
+ * Finds the slot of a word in a word table with linear probing. Empty slots have no word.
+ * @param table Word table
+ * @param hash Hash of the word.
+ * @param word First byte of the word.
+ * @param length Length of the word.
+ * @return Slot storing the word, or the empty slot where it should be inserted.
+ */
+static Word_entry* find_word(const Word_table* table, unsigned long long hash, const char* word, int length) {
+    size_t mask = table->capacity - 1;
+    size_t slot = hash & mask;
+    while (table->entries[slot].word != NULL){
+        Word_entry* entry = &table->entries[slot];
+        if (entry->hash == hash && entry->length == length && memcmp(entry->word, word, length) == 0){
+            return entry;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return &table->entries[slot];
+}
+
+/**
+ * Adds count occurrences of a word to the table, doubling the table when it becomes half full.
+ * @param table Word table
+ * @param hash Hash of the word.
+ * @param word First byte of the word.
+ * @param length Length of the word.
+ * @param count Number of occurrences to add.
+ * @return False if the mapped table can not be doubled, the table is then left unchanged.
+ */
+static bool add_word_count(Word_table* table, unsigned long long hash, const char* word, int length, long long count) {
+    Word_entry* entry = find_word(table, hash, word, length);
+    if (entry->word == NULL){
+        if (2 * (table->size + 1) > table->capacity){
+            Word_table larger;
+            if (!allocate_word_table(&larger, 2 * table->capacity, table->mapped)){
+                return false;
+            }
+            for (size_t i = 0; i < table->capacity; i++){
+                if (table->entries[i].word != NULL){
+                    *find_word(&larger, table->entries[i].hash, table->entries[i].word, table->entries[i].length) = table->entries[i];
+                }
+            }
+            larger.size = table->size;
+            free_word_table(table);
+            *table = larger;
+            entry = find_word(table, hash, word, length);
+        }
+        entry->hash = hash;
+        entry->word = word;
+        entry->length = length;
+        entry->count = 0;
+        table->size++;
+    }
+    entry->count += count;
+    return true;
+}
+
+/**
+ * Thread function counting the words of a byte range. Words are keyed by their position in the mapped file, so
+ * counting a word allocates nothing. A tokenizing thread only maps pages; if its table can not be mapped or
+ * doubled, the table is unmapped and the task is marked as failed, so that the calling thread counts the range
+ * again into a heap table.
+ * @param argument Ingestion task.
+ * @return NULL
+ */
+static void* count_range(void* argument) {
+    Ingestion_task* task = argument;
+    const char* data = task->mapped_corpus->data;
+    size_t position = task->start;
+    task->word_count = 0;
+    task->failed = !allocate_word_table(&task->table, 1 << 16, !task->on_calling_thread);
+    if (task->failed){
+        return NULL;
+    }
+    while (position < task->end){
+        while (position < task->end && (is_separator(data[position]) || data[position] == '\n')){
+            position++;
+        }
+        size_t start = position;
+        while (position < task->end && !is_separator(data[position]) && data[position] != '\n'){
+            position++;
+        }
+        if (position > start){
+            if (!add_word_count(&task->table, hash_word(data + start, (int) (position - start)), data + start, (int) (position - start), 1)){
+                free_word_table(&task->table);
+                task->table.entries = NULL;
+                task->failed = true;
+                return NULL;
+            }
+            task->word_count++;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Thread function converting a byte range into a shard of vocabulary indexes. The tokens are written into pages
+ * mapped by the thread itself, sized for the worst case of one token per byte of the range plus the closing
+ * SENTENCE_END, so only the touched pages take memory and they are placed on the NUMA node of the thread. If no
+ * pages can be mapped, the task is marked as failed and the calling thread tokenizes the range again into a heap
+ * array.
+ * @param argument Ingestion task.
+ * @return NULL
+ */
+static void* tokenize_range(void* argument) {
+    Ingestion_task* task = argument;
+    const char* data = task->mapped_corpus->data;
+    Corpus_shard_ptr shard = task->shard;
+    size_t position = task->start;
+    bool sentence_started = false;
+    shard->capacity = (long long) (task->end - task->start) + 1;
+    shard->mapped = !task->on_calling_thread;
+    if (shard->mapped){
+        shard->tokens = mmap(NULL, shard->capacity * sizeof(int), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        task->failed = shard->tokens == MAP_FAILED;
+        if (task->failed){
+            shard->tokens = NULL;
+            return NULL;
+        }
+    } else {
+        shard->tokens = malloc_(shard->capacity * sizeof(int));
+    }
+    while (position < task->end){
+        if (data[position] == '\n'){
+            if (sentence_started){
+                shard->tokens[shard->token_count++] = SENTENCE_END;
+                sentence_started = false;
+            }
+            position++;
+            continue;
+        }
+        if (is_separator(data[position])){
+            position++;
+            continue;
+        }
+        size_t start = position;
+        while (position < task->end && !is_separator(data[position]) && data[position] != '\n'){
+            position++;
+        }
+        int length = (int) (position - start);
+        Word_entry* entry = find_word(task->vocabulary_table, hash_word(data + start, length), data + start, length);
+        if (entry->word != NULL){
+            shard->tokens[shard->token_count++] = entry->index;
+            shard->word_count++;
+            sentence_started = true;
+        }
+    }
+    if (sentence_started){
+        shard->tokens[shard->token_count++] = SENTENCE_END;
+    }
+    return NULL;
+}
+
+/**
+ * Counts the words of the corpus in parallel and adds them to the vocabulary. Every thread counts its own byte
+ * range into a private table, and the tables are merged on the calling thread. Only one string is allocated for
+ * each distinct word. Ranges of threads that can not be started or whose tables can not be mapped are counted by
+ * the calling thread.
+ * @param mapped_corpus Current mapped corpus
+ * @param vocabulary Vocabulary to which the words and their counts are added.
+ */
+void count_mapped_corpus_words(const Mapped_corpus* mapped_corpus, Vocabulary_ptr vocabulary) {
+    int thread_count = mapped_corpus->thread_count;
+    Ingestion_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    bool started[thread_count];
+    size_t* ranges = split_mapped_corpus(mapped_corpus, thread_count);
+    Word_table merged;
+    int max_length = 0;
+    for (int i = 0; i < thread_count; i++){
+        tasks[i].mapped_corpus = mapped_corpus;
+        tasks[i].start = ranges[i];
+        tasks[i].end = ranges[i + 1];
+        tasks[i].on_calling_thread = false;
+        tasks[i].failed = false;
+        started[i] = pthread_create(&threads[i], NULL, count_range, &tasks[i]) == 0;
+    }
+    allocate_word_table(&merged, 1 << 16, false);
+    for (int i = 0; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        }
+        if (!started[i] || tasks[i].failed){
+            tasks[i].on_calling_thread = true;
+            count_range(&tasks[i]);
+        }
+        for (size_t j = 0; j < tasks[i].table.capacity; j++){
+            Word_entry* entry = &tasks[i].table.entries[j];
+            if (entry->word != NULL){
+                add_word_count(&merged, entry->hash, entry->word, entry->length, entry->count);
+            }
+        }
+        vocabulary->total_number_of_words += tasks[i].word_count;
+        free_word_table(&tasks[i].table);
+    }
+    for (size_t i = 0; i < merged.capacity; i++){
+        if (merged.entries[i].word != NULL && merged.entries[i].length > max_length){
+            max_length = merged.entries[i].length;
+        }
+    }
+    char* name = malloc_(max_length + 1);
+    for (size_t i = 0; i < merged.capacity; i++){
+        Word_entry* entry = &merged.entries[i];
+        if (entry->word != NULL){
+            memcpy(name, entry->word, entry->length);
+            name[entry->length] = '\0';
+            array_list_add(vocabulary->vocabulary, create_vocabulary_word(name, entry->count));
+        }
+    }
+    free_(name);
+    free_word_table(&merged);
+    free_(ranges);
+}
+
+/**
+ * Converts the corpus in parallel into shard_count shards of vocabulary indexes, one shard per byte range. The
+ * vocabulary is indexed in a table keyed by the bytes of the words, so the threads look up words directly in the
+ * mapped file. Ranges of threads that can not be started or whose tokens can not be mapped are tokenized by the
+ * calling thread.
+ * @param mapped_corpus Current mapped corpus
+ * @param vocabulary Vocabulary of the corpus.
+ * @param shard_count Number of shards.
+ * @return Array of shard_count shards.
+ */
+Corpus_shard_ptr *create_mapped_corpus_shards(const Mapped_corpus* mapped_corpus, Vocabulary_ptr vocabulary, int shard_count) {
+    Corpus_shard_ptr* result = malloc_(shard_count * sizeof(Corpus_shard_ptr));
+    Ingestion_task tasks[shard_count];
+    pthread_t threads[shard_count];
+    bool started[shard_count];
+    size_t* ranges = split_mapped_corpus(mapped_corpus, shard_count);
+    Word_table vocabulary_table;
+    size_t capacity = 16;
+    while (capacity < 2 * (size_t) size_of_vocabulary(vocabulary)){
+        capacity *= 2;
+    }
+    allocate_word_table(&vocabulary_table, capacity, false);
+    for (int i = 0; i < size_of_vocabulary(vocabulary); i++){
+        char* name = vocabulary_get_word(vocabulary, i)->name;
+        int length = (int) strlen(name);
+        Word_entry* entry = find_word(&vocabulary_table, hash_word(name, length), name, length);
+        entry->hash = hash_word(name, length);
+        entry->word = name;
+        entry->length = length;
+        entry->index = i;
+    }
+    for (int i = 0; i < shard_count; i++){
+        result[i] = malloc_(sizeof(Corpus_shard));
+        result[i]->tokens = NULL;
+        result[i]->token_count = 0;
+        result[i]->word_count = 0;
+        result[i]->original_tokens = NULL;
+        tasks[i].mapped_corpus = mapped_corpus;
+        tasks[i].start = ranges[i];
+        tasks[i].end = ranges[i + 1];
+        tasks[i].vocabulary_table = &vocabulary_table;
+        tasks[i].shard = result[i];
+        tasks[i].on_calling_thread = false;
+        tasks[i].failed = false;
+        started[i] = pthread_create(&threads[i], NULL, tokenize_range, &tasks[i]) == 0;
+    }
+    for (int i = 0; i < shard_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        }
+        if (!started[i] || tasks[i].failed){
+            tasks[i].on_calling_thread = true;
+            tokenize_range(&tasks[i]);
+        }
+    }
+    free_word_table(&vocabulary_table);
+    free_(ranges);
+    return result;
+}
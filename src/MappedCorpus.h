@@ -0,0 +1,33 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_MAPPEDCORPUS_H
+#define WORDTOVEC_MAPPEDCORPUS_H
+
+#include <stddef.h>
+#include "Vocabulary.h"
+#include "CorpusShard.h"
+
+struct mapped_corpus{
+    const char* data;
+    size_t size;
+    int descriptor;
+    int thread_count;
+};
+
+typedef struct mapped_corpus Mapped_corpus;
+
+typedef Mapped_corpus *Mapped_corpus_ptr;
+
+Mapped_corpus_ptr create_mapped_corpus(const char* file_name, int thread_count);
+
+void free_mapped_corpus(Mapped_corpus_ptr mapped_corpus);
+
+size_t* split_mapped_corpus(const Mapped_corpus* mapped_corpus, int range_count);
+
+void count_mapped_corpus_words(const Mapped_corpus* mapped_corpus, Vocabulary_ptr vocabulary);
+
+Corpus_shard_ptr* create_mapped_corpus_shards(const Mapped_corpus* mapped_corpus, Vocabulary_ptr vocabulary, int shard_count);
+
+#endif //WORDTOVEC_MAPPEDCORPUS_H
@@ -0,0 +1,241 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "MemoryFootprint.h"
+#include "NeuralNetwork.h"
+#include "ParallelTraining.h"
+
+/**
+ * Returns the number of bytes the heap allocator uses for an allocation of the given size: the requested size
+ * plus the chunk header, rounded up to 16 bytes, and at least the minimum chunk of 32 bytes. Boxed values such as
+ * the integers of the unigram table cost a chunk each, which is several times their own size.
+ * @param size Requested size in bytes.
+ * @return Bytes used by the allocation.
+ */
+size_t heap_allocation_size(size_t size) {
+    size_t chunk = (size + sizeof(size_t) + 15) & ~((size_t) 15);
+    return chunk < 32 ? 32 : chunk;
+}
+
+/**
+ * Returns the bytes of the pointer array of an array list with the given number of elements. Array lists double
+ * their capacity when full, so the capacity is taken as the next power of two.
+ * @param size Number of elements.
+ * @return Bytes of the array list and its pointer array.
+ */
+static size_t array_list_size(long long size) {
+    long long capacity = 1;
+    while (capacity < size){
+        capacity *= 2;
+    }
+    return heap_allocation_size(sizeof(Array_list)) + heap_allocation_size(capacity * sizeof(void*));
+}
+
+/**
+ * Returns the bytes of a string hash map entry whose key is owned elsewhere: the node, the list cell holding the
+ * node, the bucket pointer and the boxed value.
+ * @param value_size Size of the boxed value.
+ * @return Bytes of one entry.
+ */
+static size_t hash_map_entry_size(size_t value_size) {
+    return heap_allocation_size(2 * sizeof(void*)) + heap_allocation_size(2 * sizeof(void*)) + sizeof(void*) + heap_allocation_size(value_size);
+}
+
+/**
+ * Returns the bytes of the vocabulary words, the list storing them, the word map and the boxed unigram table.
+ * @param vocabulary_size Number of words in the vocabulary.
+ * @param name_bytes Total length of the words, including the terminating zeros.
+ * @return Bytes of the vocabulary.
+ */
+static size_t vocabulary_size_of(int vocabulary_size, size_t name_bytes) {
+    return heap_allocation_size(sizeof(Vocabulary)) + array_list_size(vocabulary_size) +
+           (size_t) vocabulary_size * (heap_allocation_size(sizeof(Vocabulary_word)) + hash_map_entry_size(sizeof(int))) +
+           name_bytes + array_list_size(2LL * vocabulary_size) + 2 * (size_t) vocabulary_size * heap_allocation_size(sizeof(int)) +
+           (size_t) vocabulary_size * sizeof(size_t);
+}
+
+/**
+ * Returns the bytes of the boxed exp table.
+ * @return Bytes of the table.
+ */
+static size_t tables_size_of() {
+    return array_list_size(EXP_TABLE_SIZE + 1) + (EXP_TABLE_SIZE + 1) * heap_allocation_size(sizeof(double));
+}
+
+/**
+ * Returns the bytes of the dictionary exported by train: a vectorized word with a boxed vector per word.
+ * @param vocabulary_size Number of words in the dictionary.
+ * @param name_bytes Total length of the words, including the terminating zeros.
+ * @param vector_length Length of the word vectors.
+ * @return Bytes of the dictionary.
+ */
+static size_t dictionary_size_of(int vocabulary_size, size_t name_bytes, int vector_length) {
+    size_t word = heap_allocation_size(sizeof(Vectorized_word)) + heap_allocation_size(sizeof(Vector)) +
+                  array_list_size(vector_length) + vector_length * heap_allocation_size(sizeof(double));
+    return heap_allocation_size(sizeof(Vectorized_dictionary)) + array_list_size(vocabulary_size) +
+           (size_t) vocabulary_size * (word + hash_map_entry_size(0)) + name_bytes + (size_t) vocabulary_size * sizeof(size_t);
+}
+
+/**
+ * Returns the bytes of one weight matrix: the rows and the array of row pointers. Rows of a heap matrix are
+ * allocated one by one; rows of a mapped matrix are parts of a single slab.
+ * @param vocabulary_size Number of rows.
+ * @param vector_length Number of columns.
+ * @param slab Size of the mapped slab, 0 if the rows are allocated on the heap.
+ * @return Bytes of the weight matrix.
+ */
+static size_t weight_matrix_size_of(int vocabulary_size, int vector_length, size_t slab) {
+    size_t rows = slab > 0 ? slab : (size_t) vocabulary_size * heap_allocation_size(vector_length * sizeof(double));
+    return rows + heap_allocation_size((size_t) vocabulary_size * sizeof(double*)) + heap_allocation_size(sizeof(Weight_matrix));
+}
+
+/**
+ * Estimates the memory a training run will need before anything is allocated. Weight matrices, tables and
+ * training buffers are computed exactly from the parameter; the vocabulary and the dictionary assume words of
+ * ASSUMED_WORD_LENGTH characters, and the corpus shards assume sentences of ASSUMED_SENTENCE_LENGTH words, with the
+ * worst case slack of the doubling token arrays. The peak is reached either while training, when the shards and
+ * thread buffers are alive, or after training, when the dictionary is filled. The peak resident memory of the
+ * process is only known after training and is left 0.
+ * @param vocabulary_size Number of words in the vocabulary.
+ * @param corpus_word_count Number of words in the corpus.
+ * @param parameter Parameters of the Word2Vec algorithm.
+ * @return Estimated bytes per subsystem and the estimated peak.
+ */
+Memory_footprint estimate_memory_footprint(int vocabulary_size, long long corpus_word_count, const Word_to_vec_parameter* parameter) {
+    Memory_footprint result;
+    int vector_length = parameter->layer_size;
+    int thread_count = parameter->thread_count;
+    size_t name_bytes = (size_t) vocabulary_size * heap_allocation_size(ASSUMED_WORD_LENGTH + 1);
+    size_t slab = 0;
+    if (parameter->weight_file_prefix != NULL || (parameter->numa_aware && thread_count > 1)){
+        slab = (size_t) vocabulary_size * vector_length * sizeof(double);
+    } else if (parameter->huge_pages){
+        slab = ((size_t) vocabulary_size * vector_length * sizeof(double) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    }
+    result.weight_matrices = 2 * weight_matrix_size_of(vocabulary_size, vector_length, slab) + (size_t) vocabulary_size * sizeof(int);
+    result.vocabulary = vocabulary_size_of(vocabulary_size, name_bytes);
+    result.tables = tables_size_of();
+    result.dictionary = dictionary_size_of(vocabulary_size, name_bytes, vector_length);
+    result.corpus_shards = 0;
+    result.thread_buffers = 0;
+    if (thread_count > 1){
+        long long tokens = (corpus_word_count + corpus_word_count / ASSUMED_SENTENCE_LENGTH + thread_count - 1) / thread_count;
+        long long capacity = 1024;
+        while (capacity < tokens){
+            capacity *= 2;
+        }
+        result.corpus_shards = thread_count * (heap_allocation_size(sizeof(Corpus_shard)) + capacity * sizeof(int));
+        if (parameter->numa_aware){
+            result.corpus_shards *= 2;
+        }
+        int distance = parameter->prefetch_distance;
+        size_t negatives_per_plan = 2 * parameter->window * parameter->negative_sampling_size;
+        size_t thread = 2 * vector_length * sizeof(double) + (distance + 1) * (sizeof(Position_plan) + negatives_per_plan * sizeof(int)) +
+                        (size_t) (vocabulary_size + 63) / 64 * sizeof(unsigned long long);
+        if (parameter->deterministic){
+            int bounds[2] = {2 * parameter->window,
+                             parameter->hierarchical_soft_max ? MAX_CODE_LENGTH :
+                             (parameter->cbow ? parameter->negative_sampling_size + 1 : 2 * parameter->window * (parameter->negative_sampling_size + 1))};
+            for (int i = 0; i < 2; i++){
+                long long capacity_of_overlay = 16LL * parameter->deterministic_interval + bounds[i];
+                if (capacity_of_overlay > vocabulary_size){
+                    capacity_of_overlay = vocabulary_size;
+                }
+                thread += (size_t) vocabulary_size * sizeof(int) + capacity_of_overlay * (sizeof(int) + vector_length * sizeof(double));
+            }
+        } else {
+            if (parameter->hot_word_count > 0 && !parameter->hierarchical_soft_max){
+                int hot = parameter->hot_word_count < vocabulary_size ? parameter->hot_word_count : vocabulary_size;
+                thread += 2 * (size_t) hot * vector_length * sizeof(double);
+            }
+            if (parameter->hs_cached_levels > 0 && parameter->hierarchical_soft_max){
+                long long nodes = parameter->hs_cached_levels < 31 ? (1LL << parameter->hs_cached_levels) - 1 : vocabulary_size;
+                if (nodes > vocabulary_size){
+                    nodes = vocabulary_size;
+                }
+                thread += 2 * (size_t) nodes * vector_length * sizeof(double);
+            }
+        }
+        result.thread_buffers = thread_count * thread + 2 * (size_t) vocabulary_size * sizeof(int) + (EXP_TABLE_SIZE + 1) * sizeof(double);
+    }
+    size_t training = result.corpus_shards + result.thread_buffers;
+    result.peak = result.weight_matrices + result.vocabulary + result.tables + (training > result.dictionary ? training : result.dictionary);
+    result.peak_resident = 0;
+    return result;
+}
+
+/**
+ * Completes the memory footprint of a trained network. The bytes of each subsystem are measured by the allocator
+ * when the subsystem is created: the vocabulary by the constructor, the weight matrices and the exp table by
+ * initialize_neural_network, the corpus shards and thread buffers by the multi-threaded trainer while they are
+ * alive, and the dictionary by train. The peak is computed from these measurements the same way the estimate
+ * computes it, and the peak resident memory of the process is read from the kernel, so that both can be compared
+ * with estimate_memory_footprint.
+ * @param neural_network Current neural network object
+ */
+void measure_memory_footprint(Neural_network_ptr neural_network) {
+    Memory_footprint* footprint = &neural_network->memory_footprint;
+    size_t training = footprint->corpus_shards + footprint->thread_buffers;
+    footprint->peak = footprint->weight_matrices + footprint->vocabulary + footprint->tables +
+                      (training > footprint->dictionary ? training : footprint->dictionary);
+    footprint->peak_resident = peak_resident_memory();
+}
+
+/**
+ * Returns the bytes currently allocated by the heap allocator, including the chunks it serves from their own
+ * mappings. Without the GNU C library the resident memory of the process is returned instead.
+ * @return Allocated bytes.
+ */
+size_t allocated_memory() {
+#ifdef __GLIBC__
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+#else
+    return current_resident_memory();
+#endif
+}
+
+/**
+ * Returns the bytes allocated since an earlier call of allocated_memory. It must be called while no other thread
+ * allocates or frees memory; if more memory was freed than allocated, 0 is returned.
+ * @param start Value of allocated_memory at the start of the measurement.
+ * @return Bytes allocated since start.
+ */
+size_t allocated_memory_since(size_t start) {
+    size_t current = allocated_memory();
+    return current > start ? current - start : 0;
+}
+
+/**
+ * Returns the current resident set size of the process.
+ * @return Resident memory in bytes, 0 if it can not be read.
+ */
+size_t current_resident_memory() {
+    FILE* input = fopen("/proc/self/statm", "r");
+    if (input == NULL){
+        return 0;
+    }
+    unsigned long long size, resident;
+    int read = fscanf(input, "%llu %llu", &size, &resident);
+    fclose(input);
+    return read == 2 ? (size_t) resident * (size_t) sysconf(_SC_PAGESIZE) : 0;
+}
+
+/**
+ * Returns the peak resident set size of the process, as reported by the kernel.
+ * @return Peak resident memory in bytes.
+ */
+size_t peak_resident_memory() {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0){
+        return 0;
+    }
+    return (size_t) usage.ru_maxrss * 1024;
+}
@@ -0,0 +1,44 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_MEMORYFOOTPRINT_H
+#define WORDTOVEC_MEMORYFOOTPRINT_H
+
+#include <stddef.h>
+#include <Dictionary/VectorizedDictionary.h>
+#include "WordToVecParameter.h"
+
+static int ASSUMED_WORD_LENGTH = 8;
+static int ASSUMED_SENTENCE_LENGTH = 20;
+
+struct memory_footprint{
+    size_t weight_matrices;
+    size_t vocabulary;
+    size_t tables;
+    size_t corpus_shards;
+    size_t thread_buffers;
+    size_t dictionary;
+    size_t peak;
+    size_t peak_resident;
+};
+
+typedef struct memory_footprint Memory_footprint;
+
+struct neural_network;
+
+Memory_footprint estimate_memory_footprint(int vocabulary_size, long long corpus_word_count, const Word_to_vec_parameter* parameter);
+
+void measure_memory_footprint(struct neural_network* neural_network);
+
+size_t heap_allocation_size(size_t size);
+
+size_t allocated_memory();
+
+size_t allocated_memory_since(size_t start);
+
+size_t current_resident_memory();
+
+size_t peak_resident_memory();
+
+#endif //WORDTOVEC_MEMORYFOOTPRINT_H
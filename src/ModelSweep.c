@@ -0,0 +1,232 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <Memory/Memory.h>
+#include "ModelSweep.h"
+#include "ParallelTraining.h"
+
+struct sweep_model{
+    Model_sweep_ptr model_sweep;
+    Parallel_training training;
+    Training_thread training_thread;
+};
+
+typedef struct sweep_model Sweep_model;
+
+/**
+ * Constructor for a sweep training several Word2Vec models with different parameters on the same corpus. The
+ * vocabulary is constructed once, or loaded from the vocabulary cache file of the first parameter, and shared by
+ * all networks; the memory footprint of every network includes the shared vocabulary. Each network gets a copy of
+ * its parameter with a single thread, since every model is trained by exactly one thread; hot rows, cached tree levels and the
+ * deterministic mode, which only coordinate several threads updating the same model, are switched off in the copy.
+ * The weights of each network are initialized exactly as a network created alone with the same seed.
+ * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * @param phrase_detector Phrase detector rewriting the sentences of the corpus, NULL if no phrases are detected.
+ * @param parameters Parameters of the models, they are copied.
+ * @param model_count Number of models.
+ * @return Model sweep.
+ */
+Model_sweep_ptr create_model_sweep(Corpus_ptr corpus,
+                                   Phrase_detector_ptr phrase_detector,
+                                   Word_to_vec_parameter_ptr* parameters,
+                                   int model_count) {
+    Model_sweep_ptr result = malloc_(sizeof(Model_sweep));
+    result->corpus = corpus;
+    result->phrase_detector = phrase_detector;
+    size_t allocated = allocated_memory();
+    if (model_count > 0 && parameters[0]->vocabulary_cache_file != NULL){
+        result->vocabulary = create_vocabulary6(corpus, phrase_detector, parameters[0]->vocabulary_cache_file);
+    } else {
+        result->vocabulary = create_vocabulary3(corpus, phrase_detector);
+    }
+    size_t vocabulary_size = allocated_memory_since(allocated);
+    result->model_count = model_count;
+    result->number_of_iterations = 0;
+    result->epoch = 0;
+    result->parameters = malloc_(model_count * sizeof(Word_to_vec_parameter));
+    result->neural_networks = malloc_(model_count * sizeof(Neural_network_ptr));
+    for (int i = 0; i < model_count; i++){
+        result->parameters[i] = *parameters[i];
+        result->parameters[i].thread_count = 1;
+        result->parameters[i].hot_word_count = 0;
+        result->parameters[i].hs_cached_levels = 0;
+        result->parameters[i].deterministic = false;
+        result->neural_networks[i] = create_neural_network4(result->vocabulary, corpus, &result->parameters[i], phrase_detector);
+        result->neural_networks[i]->memory_footprint.vocabulary = vocabulary_size;
+        if (result->parameters[i].number_of_iterations > result->number_of_iterations){
+            result->number_of_iterations = result->parameters[i].number_of_iterations;
+        }
+    }
+    result->blocks[0] = create_corpus_shard();
+    result->blocks[1] = create_corpus_shard();
+    return result;
+}
+
+/**
+ * Frees memory allocated for the model sweep, its networks, the parameter copies and the shared vocabulary.
+ * @param model_sweep Model sweep to deallocate.
+ */
+void free_model_sweep(Model_sweep_ptr model_sweep) {
+    for (int i = 0; i < model_sweep->model_count; i++){
+        free_neural_network(model_sweep->neural_networks[i]);
+    }
+    free_(model_sweep->neural_networks);
+    free_(model_sweep->parameters);
+    free_vocabulary(model_sweep->vocabulary);
+    free_corpus_shard(model_sweep->blocks[0]);
+    free_corpus_shard(model_sweep->blocks[1]);
+    free_(model_sweep);
+}
+
+/**
+ * Reads the next sentences of the corpus into a block, until the block holds SWEEP_BLOCK_SIZE tokens or the
+ * current epoch ends, so that a block never spans two epochs. At the end of the corpus the corpus is reopened for
+ * the next epoch. After the last epoch, the block is left empty.
+ * @param model_sweep Current model sweep
+ * @param index Index of the block to fill.
+ */
+static void fill_sweep_block(Model_sweep_ptr model_sweep, int index) {
+    Corpus_shard_ptr block = model_sweep->blocks[index];
+    block->token_count = 0;
+    block->word_count = 0;
+    model_sweep->block_epochs[index] = model_sweep->epoch;
+    while (model_sweep->epoch < model_sweep->number_of_iterations && block->token_count < SWEEP_BLOCK_SIZE){
+        Sentence_ptr sentence = phrase_get_sentence(model_sweep->phrase_detector, model_sweep->corpus);
+        if (sentence == NULL){
+            corpus_close(model_sweep->corpus);
+            model_sweep->epoch++;
+            if (model_sweep->epoch < model_sweep->number_of_iterations){
+                corpus_open(model_sweep->corpus);
+            }
+            if (block->token_count > 0){
+                break;
+            }
+            model_sweep->block_epochs[index] = model_sweep->epoch;
+            continue;
+        }
+        for (int i = 0; i < sentence_word_count(sentence); i++){
+            corpus_shard_add_token(block, get_position(model_sweep->vocabulary, sentence_get_word(sentence, i)));
+        }
+        corpus_shard_add_token(block, SENTENCE_END);
+    }
+}
+
+/**
+ * Trains one model of the sweep on a block. Blocks of epochs beyond the number of iterations of the model are
+ * skipped.
+ * @param sweep_model Sweep model.
+ * @param index Index of the block.
+ */
+static void train_sweep_block(Sweep_model* sweep_model, int index) {
+    Model_sweep_ptr model_sweep = sweep_model->model_sweep;
+    Corpus_shard_ptr block = model_sweep->blocks[index];
+    if (model_sweep->block_epochs[index] >= sweep_model->training.neural_network->parameter->number_of_iterations){
+        return;
+    }
+    long long sentence_start = 0;
+    for (long long i = 0; i < block->token_count; i++){
+        if (block->tokens[i] == SENTENCE_END){
+            train_sentence(&sweep_model->training_thread, block->tokens + sentence_start, (int) (i - sentence_start));
+            sentence_start = i + 1;
+        }
+    }
+}
+
+/**
+ * Main function of the thread training one model of the sweep. The thread waits until all model threads are
+ * created and the barrier is initialized. In round r the thread trains on block r mod 2, while the calling thread
+ * fills the other block; the rounds are separated by a barrier shared by the started model threads and the reader.
+ * The thread stops at the first empty block.
+ * @param argument Sweep model.
+ * @return NULL
+ */
+static void* run_sweep_model(void* argument) {
+    Sweep_model* sweep_model = argument;
+    Model_sweep_ptr model_sweep = sweep_model->model_sweep;
+    pthread_mutex_lock(&model_sweep->start_mutex);
+    pthread_mutex_unlock(&model_sweep->start_mutex);
+    for (int round = 0; ; round++){
+        pthread_barrier_wait(&model_sweep->barrier);
+        if (model_sweep->blocks[round % 2]->token_count == 0){
+            break;
+        }
+        train_sweep_block(sweep_model, round % 2);
+    }
+    return NULL;
+}
+
+/**
+ * Trains all models of the sweep in a single pass over the corpus per epoch. The calling thread reads and
+ * tokenizes the corpus once into blocks of vocabulary indexes, double buffered, and every model is advanced over
+ * each block in lockstep by a thread of its own, with the CBow or SkipGram kernels of the multi-threaded trainer.
+ * Reading, tokenization and the vocabulary are therefore paid once for the whole sweep, and the wall clock time
+ * of the sweep approaches the time of its slowest model when there are enough cores. Models whose thread can not be
+ * started are trained by the calling thread, after it has filled the next block.
+ * @param model_sweep Current model sweep
+ * @return Array of model_count dictionaries of word vectors, in the order of the parameters.
+ */
+Vectorized_dictionary_ptr* train_model_sweep(Model_sweep_ptr model_sweep) {
+    int model_count = model_sweep->model_count;
+    Sweep_model* models = malloc_(model_count * sizeof(Sweep_model));
+    pthread_t* handles = malloc_(model_count * sizeof(pthread_t));
+    Vectorized_dictionary_ptr* result = malloc_(model_count * sizeof(Vectorized_dictionary_ptr));
+    bool* started = malloc_(model_count * sizeof(bool));
+    int started_count = 0;
+    model_sweep->epoch = 0;
+    if (model_sweep->number_of_iterations > 0){
+        corpus_open(model_sweep->corpus);
+    }
+    fill_sweep_block(model_sweep, 0);
+    for (int i = 0; i < model_count; i++){
+        Neural_network_ptr neural_network = model_sweep->neural_networks[i];
+        neural_network->memory_footprint.corpus_shards = 0;
+        neural_network->memory_footprint.thread_buffers = 0;
+        models[i].model_sweep = model_sweep;
+        prepare_parallel_training(&models[i].training, neural_network);
+        create_training_thread(&models[i].training_thread, &models[i].training, NULL, 0);
+    }
+    pthread_mutex_init(&model_sweep->start_mutex, NULL);
+    pthread_mutex_lock(&model_sweep->start_mutex);
+    for (int i = 0; i < model_count; i++){
+        started[i] = pthread_create(&handles[i], NULL, run_sweep_model, &models[i]) == 0;
+        if (started[i]){
+            started_count++;
+        }
+    }
+    pthread_barrier_init(&model_sweep->barrier, NULL, started_count + 1);
+    pthread_mutex_unlock(&model_sweep->start_mutex);
+    for (int round = 0; ; round++){
+        pthread_barrier_wait(&model_sweep->barrier);
+        if (model_sweep->blocks[round % 2]->token_count == 0){
+            break;
+        }
+        fill_sweep_block(model_sweep, (round + 1) % 2);
+        for (int i = 0; i < model_count; i++){
+            if (!started[i]){
+                train_sweep_block(&models[i], round % 2);
+            }
+        }
+    }
+    for (int i = 0; i < model_count; i++){
+        if (started[i]){
+            pthread_join(handles[i], NULL);
+        }
+    }
+    for (int i = 0; i < model_count; i++){
+        free_training_thread(&models[i].training_thread);
+        free_parallel_training(&models[i].training);
+        size_t allocated = allocated_memory();
+        result[i] = export_word_vectors(model_sweep->neural_networks[i]);
+        model_sweep->neural_networks[i]->memory_footprint.dictionary = allocated_memory_since(allocated);
+        model_sweep->neural_networks[i]->memory_footprint.corpus_shards = 2 * heap_allocation_size(sizeof(Corpus_shard)) +
+                (model_sweep->blocks[0]->capacity + model_sweep->blocks[1]->capacity) * sizeof(int);
+        measure_memory_footprint(model_sweep->neural_networks[i]);
+    }
+    pthread_barrier_destroy(&model_sweep->barrier);
+    pthread_mutex_destroy(&model_sweep->start_mutex);
+    free_(started);
+    free_(models);
+    free_(handles);
+    return result;
+}
@@ -0,0 +1,42 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_MODELSWEEP_H
+#define WORDTOVEC_MODELSWEEP_H
+
+#include <pthread.h>
+#include "NeuralNetwork.h"
+#include "CorpusShard.h"
+
+static int SWEEP_BLOCK_SIZE = 1 << 18;
+
+struct model_sweep{
+    Corpus_ptr corpus;
+    Phrase_detector_ptr phrase_detector;
+    Vocabulary_ptr vocabulary;
+    Word_to_vec_parameter* parameters;
+    Neural_network_ptr* neural_networks;
+    int model_count;
+    int number_of_iterations;
+    int epoch;
+    Corpus_shard_ptr blocks[2];
+    int block_epochs[2];
+    pthread_barrier_t barrier;
+    pthread_mutex_t start_mutex;
+};
+
+typedef struct model_sweep Model_sweep;
+
+typedef Model_sweep *Model_sweep_ptr;
+
+Model_sweep_ptr create_model_sweep(Corpus_ptr corpus,
+                                   Phrase_detector_ptr phrase_detector,
+                                   Word_to_vec_parameter_ptr* parameters,
+                                   int model_count);
+
+void free_model_sweep(Model_sweep_ptr model_sweep);
+
+Vectorized_dictionary_ptr* train_model_sweep(Model_sweep_ptr model_sweep);
+
+#endif //WORDTOVEC_MODELSWEEP_H
@@ -0,0 +1,288 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <math.h>
+#include <pthread.h>
+#include <Memory/Memory.h>
+#include "NearestNeighbors.h"
+
+struct neighbor_task{
+    const Nearest_neighbors* nearest_neighbors;
+    const float* columns;
+    int query_count;
+    int stride;
+    int k;
+    int start;
+    int end;
+    float* tile_scores;
+    float* heap_scores;
+    int* heap_indices;
+};
+
+typedef struct neighbor_task Neighbor_task;
+
+/**
+ * Constructor for the nearest neighbor index of a model. The inverse norms of all rows are computed once, so that
+ * cosine similarities are dot products scaled by a precomputed factor.
+ * @param embedding_model Model to search, not owned by the index.
+ * @return Nearest neighbor index.
+ */
+Nearest_neighbors_ptr create_nearest_neighbors(const Embedding_model* embedding_model) {
+    Nearest_neighbors_ptr result = malloc_(sizeof(Nearest_neighbors));
+    result->embedding_model = embedding_model;
+    result->thread_count = embedding_model->thread_count;
+    result->inverse_norms = malloc_(embedding_model->word_count * sizeof(float));
+    for (int i = 0; i < embedding_model->word_count; i++){
+        const float* row = embedding_model_vector(embedding_model, i);
+        double norm = 0;
+        for (int j = 0; j < embedding_model->vector_length; j++){
+            norm += row[j] * row[j];
+        }
+        result->inverse_norms[i] = norm > 0 ? (float) (1 / sqrt(norm)) : 0;
+    }
+    return result;
+}
+
+/**
+ * Frees memory allocated for the nearest neighbor index. The model is not freed.
+ * @param nearest_neighbors Nearest neighbor index to deallocate.
+ */
+void free_nearest_neighbors(Nearest_neighbors_ptr nearest_neighbors) {
+    free_(nearest_neighbors->inverse_norms);
+    free_(nearest_neighbors);
+}
+
+/**
+ * Pushes a candidate into a bounded min heap keeping the k best scores. Ties are broken in favor of the smaller
+ * row, so results do not depend on how the rows are split over the threads.
+ * @param scores Scores of the heap.
+ * @param indices Rows of the heap.
+ * @param size Current size of the heap, updated by the function.
+ * @param k Capacity of the heap.
+ * @param score Score of the candidate.
+ * @param index Row of the candidate.
+ */
+void push_neighbor(float* scores, int* indices, int* size, int k, float score, int index) {
+    int position;
+    if (*size < k){
+        position = *size;
+        (*size)++;
+        while (position > 0){
+            int parent = (position - 1) / 2;
+            if (scores[parent] < score || (scores[parent] == score && indices[parent] > index)){
+                break;
+            }
+            scores[position] = scores[parent];
+            indices[position] = indices[parent];
+            position = parent;
+        }
+    } else {
+        if (score < scores[0] || (score == scores[0] && index > indices[0])){
+            return;
+        }
+        position = 0;
+        while (true){
+            int child = 2 * position + 1;
+            if (child >= k){
+                break;
+            }
+            if (child + 1 < k && (scores[child + 1] < scores[child] || (scores[child + 1] == scores[child] && indices[child + 1] > indices[child]))){
+                child++;
+            }
+            if (score < scores[child] || (score == scores[child] && index > indices[child])){
+                break;
+            }
+            scores[position] = scores[child];
+            indices[position] = indices[child];
+            position = child;
+        }
+    }
+    scores[position] = score;
+    indices[position] = index;
+}
+
+/**
+ * Sorts the candidates of a neighbor heap best first, with ties in favor of the smaller row, and fills the unused
+ * entries up to k with row -1 and score -infinity.
+ * @param scores Scores of the heap.
+ * @param indices Rows of the heap.
+ * @param size Number of candidates in the heap.
+ * @param k Capacity of the heap.
+ */
+void sort_neighbors(float* scores, int* indices, int size, int k) {
+    for (int i = 1; i < size; i++){
+        float score = scores[i];
+        int index = indices[i];
+        int j = i - 1;
+        while (j >= 0 && (scores[j] < score || (scores[j] == score && indices[j] > index))){
+            scores[j + 1] = scores[j];
+            indices[j + 1] = indices[j];
+            j--;
+        }
+        scores[j + 1] = score;
+        indices[j + 1] = index;
+    }
+    for (int i = size; i < k; i++){
+        scores[i] = -INFINITY;
+        indices[i] = -1;
+    }
+}
+
+/**
+ * Scans the rows start to end of the model for all queries of the task. Every row is read once per batch instead
+ * of once per query: the queries are stored dimension major, so each value of the row is multiplied with the same
+ * dimension of all queries in a loop the compiler vectorizes. Scores are collected for tiles of NEIGHBOR_TILE_ROWS
+ * rows, then each query keeps its k best rows in its own heap.
+ * @param argument Neighbor task.
+ * @return NULL
+ */
+static void* run_neighbor_task(void* argument) {
+    Neighbor_task* task = argument;
+    const Embedding_model* embedding_model = task->nearest_neighbors->embedding_model;
+    int vector_length = embedding_model->vector_length;
+    int sizes[task->query_count];
+    for (int q = 0; q < task->query_count; q++){
+        sizes[q] = 0;
+    }
+    for (int tile = task->start; tile < task->end; tile += NEIGHBOR_TILE_ROWS){
+        int tile_end = tile + NEIGHBOR_TILE_ROWS < task->end ? tile + NEIGHBOR_TILE_ROWS : task->end;
+        for (int i = tile; i < tile_end; i++){
+            const float* row = embedding_model_vector(embedding_model, i);
+            float sums[task->stride];
+            for (int q = 0; q < task->stride; q++){
+                sums[q] = 0;
+            }
+            for (int d = 0; d < vector_length; d++){
+                float value = row[d];
+                const float* column = task->columns + (size_t) d * task->stride;
+                for (int q = 0; q < task->stride; q++){
+                    sums[q] += value * column[q];
+                }
+            }
+            for (int q = 0; q < task->query_count; q++){
+                task->tile_scores[(size_t) q * NEIGHBOR_TILE_ROWS + i - tile] = sums[q] * task->nearest_neighbors->inverse_norms[i];
+            }
+        }
+        for (int q = 0; q < task->query_count; q++){
+            float* heap_scores = task->heap_scores + (size_t) q * task->k;
+            int* heap_indices = task->heap_indices + (size_t) q * task->k;
+            for (int i = tile; i < tile_end; i++){
+                push_neighbor(heap_scores, heap_indices, &sizes[q], task->k, task->tile_scores[(size_t) q * NEIGHBOR_TILE_ROWS + i - tile], i);
+            }
+        }
+    }
+    for (int q = 0; q < task->query_count; q++){
+        for (int i = sizes[q]; i < task->k; i++){
+            task->heap_scores[(size_t) q * task->k + i] = -INFINITY;
+            task->heap_indices[(size_t) q * task->k + i] = -1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Finds the k rows of the model with the highest cosine similarity to each query of a batch. Queries are
+ * normalized and transposed into dimension major columns padded to a multiple of 8 queries, the rows of the model are split into contiguous ranges over the threads of the index, and the heaps
+ * of the ranges are merged in range order. All buffers are allocated by the calling thread.
+ * @param nearest_neighbors Current nearest neighbor index
+ * @param queries Query vectors, query_count x vector_length.
+ * @param query_count Number of queries.
+ * @param k Number of neighbors per query.
+ * @param indices Output rows, query_count x k, best first, -1 if the model has fewer than k rows.
+ * @param scores Output cosine similarities, query_count x k.
+ */
+void search_nearest_neighbors(const Nearest_neighbors* nearest_neighbors,
+                              const float* queries,
+                              int query_count,
+                              int k,
+                              int* indices,
+                              float* scores) {
+    const Embedding_model* embedding_model = nearest_neighbors->embedding_model;
+    int vector_length = embedding_model->vector_length;
+    int tile_count = (embedding_model->word_count + NEIGHBOR_TILE_ROWS - 1) / NEIGHBOR_TILE_ROWS;
+    int thread_count = nearest_neighbors->thread_count < tile_count ? nearest_neighbors->thread_count : tile_count;
+    if (thread_count < 1){
+        thread_count = 1;
+    }
+    int stride = (query_count + 7) / 8 * 8;
+    float* columns = calloc_((size_t) vector_length * stride, sizeof(float));
+    for (int q = 0; q < query_count; q++){
+        double norm = 0;
+        for (int j = 0; j < vector_length; j++){
+            norm += queries[(size_t) q * vector_length + j] * queries[(size_t) q * vector_length + j];
+        }
+        float scale = norm > 0 ? (float) (1 / sqrt(norm)) : 0;
+        for (int j = 0; j < vector_length; j++){
+            columns[(size_t) j * stride + q] = queries[(size_t) q * vector_length + j] * scale;
+        }
+    }
+    float* tile_scores = malloc_((size_t) thread_count * query_count * NEIGHBOR_TILE_ROWS * sizeof(float));
+    float* heap_scores = malloc_((size_t) thread_count * query_count * k * sizeof(float));
+    int* heap_indices = malloc_((size_t) thread_count * query_count * k * sizeof(int));
+    Neighbor_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    for (int i = 0; i < thread_count; i++){
+        tasks[i].nearest_neighbors = nearest_neighbors;
+        tasks[i].columns = columns;
+        tasks[i].query_count = query_count;
+        tasks[i].stride = stride;
+        tasks[i].k = k;
+        tasks[i].start = (int) ((long long) tile_count * i / thread_count) * NEIGHBOR_TILE_ROWS;
+        tasks[i].end = (int) ((long long) tile_count * (i + 1) / thread_count) * NEIGHBOR_TILE_ROWS;
+        if (tasks[i].end > embedding_model->word_count){
+            tasks[i].end = embedding_model->word_count;
+        }
+        tasks[i].tile_scores = tile_scores + (size_t) i * query_count * NEIGHBOR_TILE_ROWS;
+        tasks[i].heap_scores = heap_scores + (size_t) i * query_count * k;
+        tasks[i].heap_indices = heap_indices + (size_t) i * query_count * k;
+    }
+    bool started[thread_count];
+    for (int i = 1; i < thread_count; i++){
+        started[i] = pthread_create(&threads[i], NULL, run_neighbor_task, &tasks[i]) == 0;
+    }
+    run_neighbor_task(&tasks[0]);
+    for (int i = 1; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            run_neighbor_task(&tasks[i]);
+        }
+    }
+    for (int q = 0; q < query_count; q++){
+        float* best_scores = scores + (size_t) q * k;
+        int* best_indices = indices + (size_t) q * k;
+        int size = 0;
+        for (int i = 0; i < thread_count; i++){
+            for (int j = 0; j < k; j++){
+                int index = tasks[i].heap_indices[(size_t) q * k + j];
+                if (index != -1){
+                    push_neighbor(best_scores, best_indices, &size, k, tasks[i].heap_scores[(size_t) q * k + j], index);
+                }
+            }
+        }
+        sort_neighbors(best_scores, best_indices, size, k);
+    }
+    free_(columns);
+    free_(tile_scores);
+    free_(heap_scores);
+    free_(heap_indices);
+}
+
+/**
+ * Returns the cosine similarity of two rows of the model.
+ * @param nearest_neighbors Current nearest neighbor index
+ * @param row1 First row.
+ * @param row2 Second row.
+ * @return Cosine similarity of the rows.
+ */
+float cosine_similarity_of_rows(const Nearest_neighbors* nearest_neighbors, int row1, int row2) {
+    const Embedding_model* embedding_model = nearest_neighbors->embedding_model;
+    const float* vector1 = embedding_model_vector(embedding_model, row1);
+    const float* vector2 = embedding_model_vector(embedding_model, row2);
+    float dot = 0;
+    for (int j = 0; j < embedding_model->vector_length; j++){
+        dot += vector1[j] * vector2[j];
+    }
+    return dot * nearest_neighbors->inverse_norms[row1] * nearest_neighbors->inverse_norms[row2];
+}
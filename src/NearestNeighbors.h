@@ -0,0 +1,39 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_NEARESTNEIGHBORS_H
+#define WORDTOVEC_NEARESTNEIGHBORS_H
+
+#include "EmbeddingModel.h"
+
+static int NEIGHBOR_TILE_ROWS = 256;
+
+struct nearest_neighbors{
+    const Embedding_model* embedding_model;
+    float* inverse_norms;
+    int thread_count;
+};
+
+typedef struct nearest_neighbors Nearest_neighbors;
+
+typedef Nearest_neighbors *Nearest_neighbors_ptr;
+
+Nearest_neighbors_ptr create_nearest_neighbors(const Embedding_model* embedding_model);
+
+void free_nearest_neighbors(Nearest_neighbors_ptr nearest_neighbors);
+
+void search_nearest_neighbors(const Nearest_neighbors* nearest_neighbors,
+                              const float* queries,
+                              int query_count,
+                              int k,
+                              int* indices,
+                              float* scores);
+
+void push_neighbor(float* scores, int* indices, int* size, int k, float score, int index);
+
+void sort_neighbors(float* scores, int* indices, int size, int k);
+
+float cosine_similarity_of_rows(const Nearest_neighbors* nearest_neighbors, int row1, int row2);
+
+#endif //WORDTOVEC_NEARESTNEIGHBORS_H
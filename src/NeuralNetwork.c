@@ -3,49 +3,522 @@
 //
 
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #include <math.h>
 #include <Memory/Memory.h>
 #include "NeuralNetwork.h"
 #include "Iteration.h"
+#include "ParallelTraining.h"
+#include "ValidationMonitor.h"
 
 /**
- * Constructor for the NeuralNetwork class. Gets corpus and network parameters as input and sets the
- * corresponding parameters first. After that, initializes the network with random weights between -0.5 and 0.5.
- * Constructs vector update matrix and prepares the exp table.
- * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * Creates both weight matrices of the network on memory mapped files named with the weight file prefix of the
+ * parameter. The row of each word is placed at its frequency rank, so the rows of the words covering 90 percent
+ * of the corpus form a contiguous resident prefix of each file.
+ * @param neural_network Current neural network object
+ * @return Words in frequency order, used to initialize the rows sequentially in file order, NULL if a file could
+ * not be created or mapped.
+ */
+static int* create_mapped_weight_matrices(Neural_network_ptr neural_network) {
+    Vocabulary_ptr vocabulary = neural_network->vocabulary;
+    int row = size_of_vocabulary(vocabulary);
+    int resident_row_count = 0;
+    long long covered = 0;
+    int* row_order = malloc_(row * sizeof(int));
+    int* order = malloc_(row * sizeof(int));
+    char* file_name = malloc_(strlen(neural_network->parameter->weight_file_prefix) + 10);
+    for (int i = 0; i < row; i++){
+        Vocabulary_word_ptr word = vocabulary_get_word(vocabulary, i);
+        row_order[i] = word->frequency_rank;
+        order[word->frequency_rank] = i;
+    }
+    while (resident_row_count < row && covered < vocabulary->total_number_of_words * 0.9){
+        covered += vocabulary_get_word(vocabulary, order[resident_row_count])->count;
+        resident_row_count++;
+    }
+    sprintf(file_name, "%s.vectors", neural_network->parameter->weight_file_prefix);
+    neural_network->word_vectors_matrix = create_mapped_weight_matrix(row, neural_network->vector_length, file_name, row_order, resident_row_count);
+    sprintf(file_name, "%s.update", neural_network->parameter->weight_file_prefix);
+    neural_network->word_vector_update_matrix = create_mapped_weight_matrix(row, neural_network->vector_length, file_name, row_order, resident_row_count);
+    free_(file_name);
+    free_(row_order);
+    if (neural_network->word_vectors_matrix == NULL || neural_network->word_vector_update_matrix == NULL){
+        if (neural_network->word_vectors_matrix != NULL){
+            free_weight_matrix(neural_network->word_vectors_matrix);
+        }
+        if (neural_network->word_vector_update_matrix != NULL){
+            free_weight_matrix(neural_network->word_vector_update_matrix);
+        }
+        free_(order);
+        return NULL;
+    }
+    return order;
+}
+
+/**
+ * Creates both weight matrices of the network in one slab of huge pages. The row of each word vector is placed at
+ * its frequency rank. The rows of the output matrix are words for negative sampling, also placed at their frequency
+ * rank, and inner nodes of the Huffman tree for hierarchical softmax, placed from the root down, since the nodes
+ * near the root are on the path of every word.
+ * @param neural_network Current neural network object
+ */
+static void create_huge_page_matrices(Neural_network_ptr neural_network) {
+    Vocabulary_ptr vocabulary = neural_network->vocabulary;
+    int row = size_of_vocabulary(vocabulary);
+    int* input_order = malloc_(row * sizeof(int));
+    int* output_order = malloc_(row * sizeof(int));
+    for (int i = 0; i < row; i++){
+        input_order[i] = vocabulary_get_word(vocabulary, i)->frequency_rank;
+        if (neural_network->parameter->hierarchical_soft_max){
+            output_order[i] = i < row - 1 ? row - 2 - i : row - 1;
+        } else {
+            output_order[i] = input_order[i];
+        }
+    }
+    int* row_orders[2] = {input_order, output_order};
+    Weight_matrix_ptr matrices[2];
+    create_huge_page_weight_matrices(2, row, neural_network->vector_length, row_orders, matrices);
+    neural_network->word_vectors_matrix = matrices[0];
+    neural_network->word_vector_update_matrix = matrices[1];
+    free_(input_order);
+    free_(output_order);
+}
+
+/**
+ * Trains the CBow network on the current position of the sentence: the vectors of the context words are averaged,
+ * the output rows of the target word are updated with hierarchical softmax or negative sampling, and the context
+ * word vectors are updated.
+ * @param neural_network Current neural network object
+ * @param iteration Current iteration, holding the position in the sentence and the learning rate.
+ * @param current_sentence Current sentence.
+ * @param outputs Buffer for the average of the context vectors.
+ * @param output_update Buffer for the update of the context vectors.
+ * @param vector_length Length of the word vectors.
+ */
+TRAINING_INLINE void cbow_sentence_position(Neural_network_ptr neural_network,
+                                            Iteration_ptr iteration,
+                                            Sentence_ptr current_sentence,
+                                            double* outputs,
+                                            double* output_update,
+                                            int vector_length) {
+    int word_index, last_word_index;
+    int target, label, l2, b, cw;
+    double f, g;
+    Vocabulary_word_ptr current_word;
+    TRAINING_PHASE(neural_network, TOKEN_RESOLUTION_PHASE);
+    word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, iteration->sentence_position));
+    current_word = vocabulary_get_word(neural_network->vocabulary, word_index);
+    for (int i = 0; i < vector_length; i++){
+        outputs[i] = 0;
+        output_update[i] = 0;
+    }
+    b = random() % neural_network->parameter->window;
+    cw = 0;
+    for (int a = b; a < neural_network->parameter->window * 2 + 1 - b; a++){
+        int c = iteration->sentence_position - neural_network->parameter->window + a;
+        if (a != neural_network->parameter->window && sentence_safe_index(current_sentence, c)) {
+            TRAINING_PHASE(neural_network, TOKEN_RESOLUTION_PHASE);
+            last_word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, c));
+            TRAINING_PHASE(neural_network, CONTEXT_GATHER_PHASE);
+            training_add_vector(outputs, neural_network->word_vectors[last_word_index], vector_length);
+            cw++;
+        }
+    }
+    if (cw > 0) {
+        training_divide_vector(outputs, cw, vector_length);
+        if (neural_network->parameter->hierarchical_soft_max){
+            for (int d = 0; d < current_word->code_length; d++) {
+                TRAINING_PHASE(neural_network, FORWARD_PHASE);
+                l2 = current_word->point[d];
+                f = training_dot_product(outputs, neural_network->word_vector_update[l2], vector_length);
+                TRAINING_PHASE(neural_network, SIGMOID_PHASE);
+                if (f <= -MAX_EXP || f >= MAX_EXP){
+                    continue;
+                } else{
+                    int index = (int)((f + MAX_EXP) * (EXP_TABLE_SIZE / MAX_EXP / 2));
+                    if (index >= 0 && index < EXP_TABLE_SIZE){
+                        f = array_list_get_double(neural_network->exp_table, index);
+                    } else {
+                        continue;
+                    }
+                }
+                g = (1 - current_word->code[d] - f) * iteration->alpha;
+                TRAINING_PHASE(neural_network, UPDATE_PHASE);
+                training_update_output(output_update, neural_network->word_vector_update[l2], outputs, g, vector_length);
+            }
+        } else {
+            for (int d = 0; d < neural_network->parameter->negative_sampling_size + 1; d++) {
+                TRAINING_PHASE(neural_network, TOKEN_RESOLUTION_PHASE);
+                if (d == 0) {
+                    target = word_index;
+                    label = 1;
+                } else {
+                    target = get_table_value(neural_network->vocabulary, random() % neural_network->vocabulary->table->size);
+                    if (target == 0)
+                        target = random() % (size_of_vocabulary(neural_network->vocabulary) - 1) + 1;
+                    if (target == word_index)
+                        continue;
+                    label = 0;
+                }
+                TRAINING_PHASE(neural_network, FORWARD_PHASE);
+                l2 = target;
+                f = training_dot_product(outputs, neural_network->word_vector_update[l2], vector_length);
+                TRAINING_PHASE(neural_network, SIGMOID_PHASE);
+                g = calculate_g(neural_network, f, iteration->alpha, label);
+                TRAINING_PHASE(neural_network, UPDATE_PHASE);
+                training_update_output(output_update, neural_network->word_vector_update[l2], outputs, g, vector_length);
+            }
+        }
+        for (int a = b; a < neural_network->parameter->window * 2 + 1 - b; a++){
+            int c = iteration->sentence_position - neural_network->parameter->window + a;
+            if (a != neural_network->parameter->window && sentence_safe_index(current_sentence, c)) {
+                TRAINING_PHASE(neural_network, TOKEN_RESOLUTION_PHASE);
+                last_word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, c));
+                TRAINING_PHASE(neural_network, UPDATE_PHASE);
+                training_add_vector(neural_network->word_vectors[last_word_index], output_update, vector_length);
+                neural_network->row_versions[last_word_index] = neural_network->snapshot_version;
+            }
+        }
+    }
+}
+
+/**
+ * Trains the SkipGram network on the current position of the sentence: for every context word, the output rows of
+ * the target word are updated with hierarchical softmax or negative sampling, and the context word vector is
+ * updated.
+ * @param neural_network Current neural network object
+ * @param iteration Current iteration, holding the position in the sentence and the learning rate.
+ * @param current_sentence Current sentence.
+ * @param outputs Not used.
+ * @param output_update Buffer for the update of a context vector.
+ * @param vector_length Length of the word vectors.
+ */
+TRAINING_INLINE void skip_gram_sentence_position(Neural_network_ptr neural_network,
+                                                 Iteration_ptr iteration,
+                                                 Sentence_ptr current_sentence,
+                                                 double* outputs,
+                                                 double* output_update,
+                                                 int vector_length) {
+    int word_index, last_word_index;
+    int target, label, l1, l2, b;
+    double f, g;
+    Vocabulary_word_ptr current_word;
+    TRAINING_PHASE(neural_network, TOKEN_RESOLUTION_PHASE);
+    word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, iteration->sentence_position));
+    current_word = vocabulary_get_word(neural_network->vocabulary, word_index);
+    for (int i = 0; i < vector_length; i++){
+        output_update[i] = 0;
+    }
+    b = random() % neural_network->parameter->window;
+    for (int a = b; a < neural_network->parameter->window * 2 + 1 - b; a++) {
+        int c = iteration->sentence_position - neural_network->parameter->window + a;
+        if (a != neural_network->parameter->window && sentence_safe_index(current_sentence, c)) {
+            TRAINING_PHASE(neural_network, TOKEN_RESOLUTION_PHASE);
+            last_word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, c));
+            TRAINING_PHASE(neural_network, CONTEXT_GATHER_PHASE);
+            l1 = last_word_index;
+            for (int i = 0; i < vector_length; i++){
+                output_update[i] = 0;
+            }
+            if (neural_network->parameter->hierarchical_soft_max) {
+                for (int d = 0; d < current_word->code_length; d++) {
+                    TRAINING_PHASE(neural_network, FORWARD_PHASE);
+                    l2 = current_word->point[d];
+                    f = training_dot_product(neural_network->word_vectors[l1], neural_network->word_vector_update[l2], vector_length);
+                    TRAINING_PHASE(neural_network, SIGMOID_PHASE);
+                    if (f <= -MAX_EXP || f >= MAX_EXP){
+                        continue;
+                    } else{
+                        int index = (int)((f + MAX_EXP) * (EXP_TABLE_SIZE / MAX_EXP / 2));
+                        if (index >= 0 && index < EXP_TABLE_SIZE){
+                            f = array_list_get_double(neural_network->exp_table, index);
+                        } else {
+                            continue;
+                        }
+                    }
+                    g = (1 - current_word->code[d] - f) * iteration->alpha;
+                    TRAINING_PHASE(neural_network, UPDATE_PHASE);
+                    training_update_output(output_update, neural_network->word_vector_update[l2], neural_network->word_vectors[l1], g, vector_length);
+                }
+            } else {
+                for (int d = 0; d < neural_network->parameter->negative_sampling_size + 1; d++) {
+                    TRAINING_PHASE(neural_network, TOKEN_RESOLUTION_PHASE);
+                    if (d == 0) {
+                        target = word_index;
+                        label = 1;
+                    } else {
+                        target = get_table_value(neural_network->vocabulary, random() % neural_network->vocabulary->table->size);
+                        if (target == 0)
+                            target = random() % (size_of_vocabulary(neural_network->vocabulary) - 1) + 1;
+                        if (target == word_index)
+                            continue;
+                        label = 0;
+                    }
+                    TRAINING_PHASE(neural_network, FORWARD_PHASE);
+                    l2 = target;
+                    f = training_dot_product(neural_network->word_vectors[l1], neural_network->word_vector_update[l2], vector_length);
+                    TRAINING_PHASE(neural_network, SIGMOID_PHASE);
+                    g = calculate_g(neural_network, f, iteration->alpha, label);
+                    TRAINING_PHASE(neural_network, UPDATE_PHASE);
+                    training_update_output(output_update, neural_network->word_vector_update[l2], neural_network->word_vectors[l1], g, vector_length);
+                }
+            }
+            TRAINING_PHASE(neural_network, UPDATE_PHASE);
+            training_add_vector(neural_network->word_vectors[l1], output_update, vector_length);
+            neural_network->row_versions[l1] = neural_network->snapshot_version;
+        }
+    }
+}
+
+/**
+ * Trains the CBow version of Word2Vec algorithm on the current position of the sentence, for any vector length.
+ * @param neural_network Current neural network object
+ * @param iteration Current iteration, holding the position in the sentence and the learning rate.
+ * @param current_sentence Current sentence.
+ * @param outputs Buffer for the average of the context vectors.
+ * @param output_update Buffer for the update of the context vectors.
+ */
+static void train_cbow_sentence_position(Neural_network_ptr neural_network, Iteration_ptr iteration, Sentence_ptr current_sentence, double* outputs, double* output_update) {
+    cbow_sentence_position(neural_network, iteration, current_sentence, outputs, output_update, neural_network->vector_length);
+}
+
+/**
+ * Trains the SkipGram version of Word2Vec algorithm on the current position of the sentence, for any vector length.
+ * @param neural_network Current neural network object
+ * @param iteration Current iteration, holding the position in the sentence and the learning rate.
+ * @param current_sentence Current sentence.
+ * @param outputs Not used.
+ * @param output_update Buffer for the update of the context vectors.
+ */
+static void train_skip_gram_sentence_position(Neural_network_ptr neural_network, Iteration_ptr iteration, Sentence_ptr current_sentence, double* outputs, double* output_update) {
+    skip_gram_sentence_position(neural_network, iteration, current_sentence, outputs, output_update, neural_network->vector_length);
+}
+
+/**
+ * Generates the sequential CBow and SkipGram position trainers for a vector length, in the same way as the position
+ * trainers of the training threads. The operations are done in the same order as for any length, so a specialized
+ * trainer produces exactly the same results.
+ */
+#define DEFINE_SENTENCE_POSITION_TRAINERS(N) \
+static void train_cbow_sentence_position_##N(Neural_network_ptr neural_network, Iteration_ptr iteration, Sentence_ptr current_sentence, double* outputs, double* output_update) { \
+    cbow_sentence_position(neural_network, iteration, current_sentence, outputs, output_update, N); \
+} \
+static void train_skip_gram_sentence_position_##N(Neural_network_ptr neural_network, Iteration_ptr iteration, Sentence_ptr current_sentence, double* outputs, double* output_update) { \
+    skip_gram_sentence_position(neural_network, iteration, current_sentence, outputs, output_update, N); \
+}
+
+TRAINING_KERNEL_WIDTHS(DEFINE_SENTENCE_POSITION_TRAINERS)
+
+#define SELECT_SENTENCE_POSITION_TRAINER(N) \
+    case N: \
+        return cbow ? train_cbow_sentence_position_##N : train_skip_gram_sentence_position_##N;
+
+/**
+ * Returns the sequential position trainer for the algorithm and the vector length. Common layer sizes have width
+ * specialized trainers, all other sizes use the trainers that read the vector length at run time.
+ * @param cbow True for CBow, false for SkipGram.
+ * @param vector_length Length of the word vectors.
+ * @return Sequential position trainer.
+ */
+static Sentence_position_trainer select_sentence_position_trainer(bool cbow, int vector_length) {
+    switch (vector_length) {
+        TRAINING_KERNEL_WIDTHS(SELECT_SENTENCE_POSITION_TRAINER)
+        default:
+            return cbow ? train_cbow_sentence_position : train_skip_gram_sentence_position;
+    }
+}
+
+/**
+ * Initializes a network whose vocabulary is constructed: selects the sequential position trainers for the vector
+ * length, allocates the weight matrices, initializes the word vectors with random weights between -0.5 and 0.5 and
+ * prepares the exp table. Every row of the word vectors carries the snapshot version in which it was last updated,
+ * so that snapshots can export only the changed rows.
+ * @param result Neural network to initialize.
  * @param parameter Parameters of the Word2Vec algorithm.
+ * @return True if the network is initialized, false if the weight files of the parameter could not be created or
+ * mapped, in which case nothing is left allocated.
  */
-Neural_network_ptr create_neural_network(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter) {
-    Neural_network_ptr result = malloc_(sizeof(Neural_network));
+static bool initialize_neural_network(Neural_network_ptr result, Word_to_vec_parameter_ptr parameter) {
     int row;
-    srandom(parameter->seed);
-    result->vocabulary = create_vocabulary(corpus);
     result->parameter = parameter;
     result->vector_length = parameter->layer_size;
-    result->corpus = corpus;
+    result->cbow_position_trainer = select_sentence_position_trainer(true, result->vector_length);
+    result->skip_gram_position_trainer = select_sentence_position_trainer(false, result->vector_length);
+    result->validation_monitor = NULL;
+    result->phase_counters = NULL;
     result->exp_table = create_array_list();
     row = size_of_vocabulary(result->vocabulary);
-    result->word_vectors = allocate_2d(row, result->vector_length);
-    for (int i = 0; i < row; i++) {
+    size_t allocated = allocated_memory();
+    result->row_versions = calloc_(row, sizeof(int));
+    result->snapshot_version = 1;
+    int* order = NULL;
+    if (parameter->weight_file_prefix != NULL){
+        result->numa_topology = NULL;
+        order = create_mapped_weight_matrices(result);
+        if (order == NULL){
+            free_(result->row_versions);
+            free_array_list(result->exp_table, free_);
+            return false;
+        }
+    } else if (parameter->huge_pages){
+        result->numa_topology = NULL;
+        create_huge_page_matrices(result);
+    } else if (parameter->numa_aware && parameter->thread_count > 1){
+        result->numa_topology = create_numa_topology();
+        result->word_vectors_matrix = create_numa_weight_matrix(row, result->vector_length, result->numa_topology, parameter->thread_count);
+        result->word_vector_update_matrix = create_numa_weight_matrix(row, result->vector_length, result->numa_topology, parameter->thread_count);
+    } else {
+        result->numa_topology = NULL;
+        result->word_vectors_matrix = create_weight_matrix(row, result->vector_length);
+        result->word_vector_update_matrix = create_weight_matrix(row, result->vector_length);
+    }
+    result->word_vectors = result->word_vectors_matrix->rows;
+    result->word_vector_update = result->word_vector_update_matrix->rows;
+    result->memory_footprint.weight_matrices = allocated_memory_since(allocated);
+    if (result->word_vectors_matrix->placement != HEAP_PLACEMENT){
+        result->memory_footprint.weight_matrices += result->word_vectors_matrix->size + result->word_vector_update_matrix->size;
+    }
+    for (int k = 0; k < row; k++) {
+        int i = order != NULL ? order[k] : k;
         for (int j = 0; j < result->vector_length; j++) {
             result->word_vectors[i][j] = -0.5 + ((double)random()) / RAND_MAX;
         }
     }
-    result->word_vector_update = allocate_2d(row, result->vector_length);
+    if (order != NULL){
+        free_(order);
+    }
+    allocated = allocated_memory();
     prepare_exp_table(result);
+    result->memory_footprint.tables = allocated_memory_since(allocated);
+    return true;
+}
+
+/**
+ * Constructor for the NeuralNetwork class. Gets corpus and network parameters as input and sets the
+ * corresponding parameters first. After that, initializes the network with random weights between -0.5 and 0.5.
+ * Constructs vector update matrix and prepares the exp table. If the parameter is NUMA aware and training is
+ * multi-threaded, both matrices are distributed over the NUMA nodes of the machine. If the parameter has a weight
+ * file prefix, both matrices are backed by memory mapped files with rows in frequency order. Otherwise, if the
+ * parameter asks for huge pages, both matrices are placed in one slab of huge pages with rows in frequency order.
+ * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * @param parameter Parameters of the Word2Vec algorithm.
+ * @return Neural network, NULL if the parameter has a weight file prefix and the weight files could not be created
+ * or mapped.
+ */
+Neural_network_ptr create_neural_network(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter) {
+    return create_neural_network2(corpus, parameter, NULL);
+}
+
+/**
+ * Constructor for the NeuralNetwork class, where the sentences of the corpus are read through a phrase detector
+ * both while constructing the vocabulary and while training. The phrase detector is not owned by the network. If
+ * the parameter has a vocabulary cache file, the vocabulary is loaded from it when it was saved for the same corpus,
+ * and saved into it otherwise.
+ * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * @param parameter Parameters of the Word2Vec algorithm.
+ * @param phrase_detector Phrase detector rewriting the sentences of the corpus, NULL if no phrases are detected.
+ * @return Neural network, NULL if the parameter has a weight file prefix and the weight files could not be created
+ * or mapped.
+ */
+Neural_network_ptr create_neural_network2(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter, Phrase_detector_ptr phrase_detector) {
+    Neural_network_ptr result = malloc_(sizeof(Neural_network));
+    srandom(parameter->seed);
+    memset(&result->memory_footprint, 0, sizeof(Memory_footprint));
+    size_t allocated = allocated_memory();
+    if (parameter->vocabulary_cache_file != NULL){
+        result->vocabulary = create_vocabulary6(corpus, phrase_detector, parameter->vocabulary_cache_file);
+    } else {
+        result->vocabulary = create_vocabulary3(corpus, phrase_detector);
+    }
+    result->memory_footprint.vocabulary = allocated_memory_since(allocated);
+    result->owns_vocabulary = true;
+    result->phrase_detector = phrase_detector;
+    result->corpus = corpus;
+    result->mapped_corpus = NULL;
+    if (!initialize_neural_network(result, parameter)){
+        free_vocabulary(result->vocabulary);
+        free_(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Constructor for the NeuralNetwork class from a mapped corpus. The vocabulary is counted and the training shards
+ * are tokenized in place by several threads, so the network is always trained with the multi-threaded trainer,
+ * even with a single thread. The mapped corpus is not owned by the network.
+ * @param mapped_corpus Mapped corpus used to train word vectors using Word2Vec algorithm.
+ * @param parameter Parameters of the Word2Vec algorithm.
+ * @return Neural network, NULL if the parameter has a weight file prefix and the weight files could not be created
+ * or mapped.
+ */
+Neural_network_ptr create_neural_network3(Mapped_corpus_ptr mapped_corpus, Word_to_vec_parameter_ptr parameter) {
+    Neural_network_ptr result = malloc_(sizeof(Neural_network));
+    srandom(parameter->seed);
+    memset(&result->memory_footprint, 0, sizeof(Memory_footprint));
+    size_t allocated = allocated_memory();
+    result->vocabulary = create_vocabulary4(mapped_corpus);
+    result->memory_footprint.vocabulary = allocated_memory_since(allocated);
+    result->owns_vocabulary = true;
+    result->phrase_detector = NULL;
+    result->corpus = NULL;
+    result->mapped_corpus = mapped_corpus;
+    if (!initialize_neural_network(result, parameter)){
+        free_vocabulary(result->vocabulary);
+        free_(result);
+        return NULL;
+    }
     return result;
 }
 
 /**
- * Frees memory allocated for the neural network. Freesword vector update, word vectors, vocabulary, exp_table.
+ * Constructor for the NeuralNetwork class on a vocabulary that is already constructed, so that several networks
+ * with different parameters can share the vocabulary of the same corpus. The vocabulary and the phrase detector
+ * are not owned by the network, and the vocabulary is not counted in its memory footprint. The weights are
+ * initialized exactly as with create_neural_network2 for the same seed.
+ * @param vocabulary Vocabulary of the corpus.
+ * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * @param parameter Parameters of the Word2Vec algorithm.
+ * @param phrase_detector Phrase detector the vocabulary is constructed with, NULL if no phrases are detected.
+ * @return Neural network, NULL if the parameter has a weight file prefix and the weight files could not be created
+ * or mapped.
+ */
+Neural_network_ptr create_neural_network4(Vocabulary_ptr vocabulary,
+                                          Corpus_ptr corpus,
+                                          Word_to_vec_parameter_ptr parameter,
+                                          Phrase_detector_ptr phrase_detector) {
+    Neural_network_ptr result = malloc_(sizeof(Neural_network));
+    srandom(parameter->seed);
+    memset(&result->memory_footprint, 0, sizeof(Memory_footprint));
+    result->vocabulary = vocabulary;
+    result->owns_vocabulary = false;
+    result->phrase_detector = phrase_detector;
+    result->corpus = corpus;
+    result->mapped_corpus = NULL;
+    if (!initialize_neural_network(result, parameter)){
+        free_(result);
+        return NULL;
+    }
+    return result;
+}
+
+/**
+ * Frees memory allocated for the neural network. Freesword vector update, word vectors, vocabulary (if it is owned
+ * by the network), exp_table.
  * @param neural_network Neural network to deallocate.
  */
 void free_neural_network(Neural_network_ptr neural_network) {
-    int row = size_of_vocabulary(neural_network->vocabulary);
-    free_2d(neural_network->word_vector_update, row);
-    free_2d(neural_network->word_vectors, row);
-    free_vocabulary(neural_network->vocabulary);
+    free_weight_matrix(neural_network->word_vector_update_matrix);
+    free_weight_matrix(neural_network->word_vectors_matrix);
+    if (neural_network->numa_topology != NULL){
+        free_numa_topology(neural_network->numa_topology);
+    }
+    if (neural_network->owns_vocabulary){
+        free_vocabulary(neural_network->vocabulary);
+    }
     free_array_list(neural_network->exp_table, free_);
+    free_(neural_network->row_versions);
     free_(neural_network);
 }
 
@@ -88,17 +561,68 @@ double calculate_g(Neural_network_ptr neural_network, double f, double alpha, do
 }
 
 /**
- * Main method for training the Word2Vec algorithm. Depending on the training parameter, CBox or SkipGram algorithm
- * is applied.
+ * Trains the word vectors of the network without exporting them. Depending on the training parameter, CBow or
+ * SkipGram algorithm is applied. If more than one thread is requested, or the network is constructed from a mapped
+ * corpus, the corpus is split into shards and trained in parallel. If the network has a validation monitor, the
+ * word vectors are evaluated in the background while training and the training stops early once the validation
+ * correlation plateaus. At the end, the peak and the peak resident memory of the process are stored in the memory
+ * footprint of the network. When built with PHASE_COUNTERS, the single threaded trainers are sampled with phase
+ * counters, whose breakdown is printed at the end. A network whose weights are stored in files is trained this way
+ * and exported with create_embedding_model5, which never holds all vectors in memory.
+ * @param neural_network Current neural network object
+ */
+void train_network(Neural_network_ptr neural_network) {
+    neural_network->memory_footprint.corpus_shards = 0;
+    neural_network->memory_footprint.thread_buffers = 0;
+    neural_network->memory_footprint.dictionary = 0;
+    if (neural_network->validation_monitor != NULL){
+        start_validation_monitor(neural_network->validation_monitor, neural_network->vocabulary, neural_network->vector_length);
+    }
+    if (neural_network->parameter->thread_count > 1 || neural_network->mapped_corpus != NULL){
+        train_parallel(neural_network);
+    } else {
+#ifdef PHASE_COUNTERS
+        neural_network->phase_counters = create_phase_counters();
+#endif
+        if (neural_network->parameter->cbow){
+            train_cbow(neural_network);
+        } else {
+            train_skip_gram(neural_network);
+        }
+#ifdef PHASE_COUNTERS
+        print_phase_counters(neural_network->phase_counters, stdout);
+        free_phase_counters(neural_network->phase_counters);
+        neural_network->phase_counters = NULL;
+#endif
+    }
+    if (neural_network->validation_monitor != NULL){
+        finish_validation_monitor(neural_network->validation_monitor);
+    }
+    measure_memory_footprint(neural_network);
+}
+
+/**
+ * Main method for training the Word2Vec algorithm. The network is trained with train_network and its word vectors
+ * are exported into a dictionary, whose memory is added to the memory footprint of the network.
+ * @param neural_network Current neural network object
  * @return Dictionary of word vectors.
  */
 Vectorized_dictionary_ptr train(Neural_network_ptr neural_network) {
+    train_network(neural_network);
+    size_t allocated = allocated_memory();
+    Vectorized_dictionary_ptr result = export_word_vectors(neural_network);
+    neural_network->memory_footprint.dictionary = allocated_memory_since(allocated);
+    measure_memory_footprint(neural_network);
+    return result;
+}
+
+/**
+ * Copies the current word vectors of the network into a dictionary sorted by word.
+ * @param neural_network Current neural network object
+ * @return Dictionary of word vectors.
+ */
+Vectorized_dictionary_ptr export_word_vectors(Neural_network_ptr neural_network) {
     Vectorized_dictionary_ptr result = create_vectorized_dictionary();
-    if (neural_network->parameter->cbow){
-        train_cbow(neural_network);
-    } else {
-        train_skip_gram(neural_network);
-    }
     for (int i = 0; i < size_of_vocabulary(neural_network->vocabulary); i++){
         Vector_ptr vector = create_vector2(0, 0);
         for (int j = 0; j < neural_network->vector_length; j++){
@@ -124,12 +648,24 @@ void update_output(Neural_network_ptr neural_network,
                    const double *outputs,
                    int l2,
                    double g) {
-    for (int j = 0; j < neural_network->vector_length; j++){
-        outputUpdate[j] += neural_network->word_vector_update[l2][j] * g;
-    }
-    for (int j = 0; j < neural_network->vector_length; j++){
-        neural_network->word_vector_update[l2][j] += outputs[j] * g;
-    }
+    update_output_row(neural_network, outputUpdate, neural_network->word_vector_update[l2], outputs, g);
+}
+
+/**
+ * Calculate the update of outputs for a given output row. It also updates the output row itself. The row may be
+ * a row of the word_vector_update matrix or a private copy of it kept by a training thread.
+ * @param neural_network Current neural network object
+ * @param outputUpdate Output update to be added.
+ * @param row Output row to be updated.
+ * @param outputs Current outputs.
+ * @param g Multiplier for the update.
+ */
+void update_output_row(Neural_network_ptr neural_network,
+                       double *outputUpdate,
+                       double *row,
+                       const double *outputs,
+                       double g) {
+    training_update_output(outputUpdate, row, outputs, g, neural_network->vector_length);
 }
 
 /**
@@ -140,11 +676,7 @@ void update_output(Neural_network_ptr neural_network,
  * @return Dot product of two given vectors.
  */
 double dot_product_array(Neural_network_ptr neural_network, const double *vector1, const double *vector2) {
-    double sum = 0;
-    for (int j = 0; j < neural_network->vector_length; j++){
-        sum += vector1[j] * vector2[j];
-    }
-    return sum;
+    return training_dot_product(vector1, vector2, neural_network->vector_length);
 }
 
 /**
@@ -152,86 +684,21 @@ double dot_product_array(Neural_network_ptr neural_network, const double *vector
  * @param neural_network Current neural network object
  */
 void train_cbow(Neural_network_ptr neural_network) {
-    int word_index, last_word_index;
-    Iteration_ptr iteration = create_iteration(neural_network->corpus, neural_network->parameter);
-    int target, label, l2, b, cw;
-    double f, g;
+    Iteration_ptr iteration = create_iteration2(neural_network->corpus, neural_network->parameter, neural_network->phrase_detector, neural_network->vocabulary->total_number_of_words);
     corpus_open(neural_network->corpus);
-    Sentence_ptr current_sentence = corpus_get_sentence2(neural_network->corpus);
-    Vocabulary_word_ptr current_word;
+    Sentence_ptr current_sentence = phrase_get_sentence(neural_network->phrase_detector, neural_network->corpus);
     srandom(neural_network->parameter->seed);
     double* outputs = malloc_(neural_network->vector_length * sizeof(double));
     double* output_update = malloc_(neural_network->vector_length * sizeof(double));
     while (iteration->iteration_count < neural_network->parameter->number_of_iterations) {
+        TRAINING_SAMPLE(neural_network);
         alpha_update(iteration, neural_network->vocabulary->total_number_of_words);
-        word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, iteration->sentence_position));
-        current_word = vocabulary_get_word(neural_network->vocabulary, word_index);
-        for (int i = 0; i < neural_network->vector_length; i++){
-            outputs[i] = 0;
-            output_update[i] = 0;
-        }
-        b = random() % neural_network->parameter->window;
-        cw = 0;
-        for (int a = b; a < neural_network->parameter->window * 2 + 1 - b; a++){
-            int c = iteration->sentence_position - neural_network->parameter->window + a;
-            if (a != neural_network->parameter->window && sentence_safe_index(current_sentence, c)) {
-                last_word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, c));
-                for (int j = 0; j < neural_network->vector_length; j++){
-                    outputs[j] += neural_network->word_vectors[last_word_index][j];
-                }
-                cw++;
-            }
-        }
-        if (cw > 0) {
-            for (int j = 0; j < neural_network->vector_length; j++){
-                outputs[j] /= cw;
-            }
-            if (neural_network->parameter->hierarchical_soft_max){
-                for (int d = 0; d < current_word->code_length; d++) {
-                    l2 = current_word->point[d];
-                    f = dot_product_array(neural_network, outputs, neural_network->word_vector_update[l2]);
-                    if (f <= -MAX_EXP || f >= MAX_EXP){
-                        continue;
-                    } else{
-                        int index = (int)((f + MAX_EXP) * (EXP_TABLE_SIZE / MAX_EXP / 2));
-                        if (index >= 0 && index < EXP_TABLE_SIZE){
-                            f = array_list_get_double(neural_network->exp_table, index);
-                        } else {
-                            continue;
-                        }
-                    }
-                    g = (1 - current_word->code[d] - f) * iteration->alpha;
-                    update_output(neural_network, output_update, outputs, l2, g);
-                }
-            } else {
-                for (int d = 0; d < neural_network->parameter->negative_sampling_size + 1; d++) {
-                    if (d == 0) {
-                        target = word_index;
-                        label = 1;
-                    } else {
-                        target = get_table_value(neural_network->vocabulary, random() % neural_network->vocabulary->table->size);
-                        if (target == 0)
-                            target = random() % (size_of_vocabulary(neural_network->vocabulary) - 1) + 1;
-                        if (target == word_index)
-                            continue;
-                        label = 0;
-                    }
-                    l2 = target;
-                    f = dot_product_array(neural_network, outputs, neural_network->word_vector_update[l2]);
-                    g = calculate_g(neural_network, f, iteration->alpha, label);
-                    update_output(neural_network, output_update, outputs, l2, g);
-                }
-            }
-            for (int a = b; a < neural_network->parameter->window * 2 + 1 - b; a++){
-                int c = iteration->sentence_position - neural_network->parameter->window + a;
-                if (a != neural_network->parameter->window && sentence_safe_index(current_sentence, c)) {
-                    last_word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, c));
-                    for (int j = 0; j < neural_network->vector_length; j++){
-                        neural_network->word_vectors[last_word_index][j] += output_update[j];
-                    }
-                }
-            }
+        if (neural_network->validation_monitor != NULL &&
+            validation_checkpoint(neural_network->validation_monitor, neural_network->word_vectors, iteration->word_count_actual)){
+            break;
         }
+        neural_network->cbow_position_trainer(neural_network, iteration, current_sentence, outputs, output_update);
+        TRAINING_PHASE(neural_network, CORPUS_ADVANCE_PHASE);
         current_sentence = sentence_update(iteration, current_sentence);
     }
     corpus_close(neural_network->corpus);
@@ -245,72 +712,20 @@ void train_cbow(Neural_network_ptr neural_network) {
  * @param neural_network Current neural network object
  */
 void train_skip_gram(Neural_network_ptr neural_network) {
-    int word_index, last_word_index;
-    Iteration_ptr iteration = create_iteration(neural_network->corpus, neural_network->parameter);
-    int target, label, l1, l2, b;
-    double f, g;
+    Iteration_ptr iteration = create_iteration2(neural_network->corpus, neural_network->parameter, neural_network->phrase_detector, neural_network->vocabulary->total_number_of_words);
     corpus_open(neural_network->corpus);
-    Sentence_ptr current_sentence = corpus_get_sentence2(neural_network->corpus);
-    Vocabulary_word_ptr current_word;
+    Sentence_ptr current_sentence = phrase_get_sentence(neural_network->phrase_detector, neural_network->corpus);
     srandom(neural_network->parameter->seed);
     double* output_update = malloc_(neural_network->vector_length * sizeof(double));
     while (iteration->iteration_count < neural_network->parameter->number_of_iterations) {
+        TRAINING_SAMPLE(neural_network);
         alpha_update(iteration, neural_network->vocabulary->total_number_of_words);
-        word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, iteration->sentence_position));
-        current_word = vocabulary_get_word(neural_network->vocabulary, word_index);
-        for (int i = 0; i < neural_network->vector_length; i++){
-            output_update[i] = 0;
-        }
-        b = random() % neural_network->parameter->window;
-        for (int a = b; a < neural_network->parameter->window * 2 + 1 - b; a++) {
-            int c = iteration->sentence_position - neural_network->parameter->window + a;
-            if (a != neural_network->parameter->window && sentence_safe_index(current_sentence, c)) {
-                last_word_index = get_position(neural_network->vocabulary, array_list_get(current_sentence->words, c));
-                l1 = last_word_index;
-                for (int i = 0; i < neural_network->vector_length; i++){
-                    output_update[i] = 0;
-                }
-                if (neural_network->parameter->hierarchical_soft_max) {
-                    for (int d = 0; d < current_word->code_length; d++) {
-                        l2 = current_word->point[d];
-                        f = dot_product_array(neural_network, neural_network->word_vectors[l1], neural_network->word_vector_update[l2]);
-                        if (f <= -MAX_EXP || f >= MAX_EXP){
-                            continue;
-                        } else{
-                            int index = (int)((f + MAX_EXP) * (EXP_TABLE_SIZE / MAX_EXP / 2));
-                            if (index >= 0 && index < EXP_TABLE_SIZE){
-                                f = array_list_get_double(neural_network->exp_table, index);
-                            } else {
-                                continue;
-                            }
-                        }
-                        g = (1 - current_word->code[d] - f) * iteration->alpha;
-                        update_output(neural_network, output_update, neural_network->word_vectors[l1], l2, g);
-                    }
-                } else {
-                    for (int d = 0; d < neural_network->parameter->negative_sampling_size + 1; d++) {
-                        if (d == 0) {
-                            target = word_index;
-                            label = 1;
-                        } else {
-                            target = get_table_value(neural_network->vocabulary, random() % neural_network->vocabulary->table->size);
-                            if (target == 0)
-                                target = random() % (size_of_vocabulary(neural_network->vocabulary) - 1) + 1;
-                            if (target == word_index)
-                                continue;
-                            label = 0;
-                        }
-                        l2 = target;
-                        f = dot_product_array(neural_network, neural_network->word_vectors[l1], neural_network->word_vector_update[l2]);
-                        g = calculate_g(neural_network, f, iteration->alpha, label);
-                        update_output(neural_network, output_update, neural_network->word_vectors[l1], l2, g);
-                    }
-                }
-                for (int j = 0; j < neural_network->vector_length; j++){
-                    neural_network->word_vectors[l1][j] += output_update[j];
-                }
-            }
+        if (neural_network->validation_monitor != NULL &&
+            validation_checkpoint(neural_network->validation_monitor, neural_network->word_vectors, iteration->word_count_actual)){
+            break;
         }
+        neural_network->skip_gram_position_trainer(neural_network, iteration, current_sentence, NULL, output_update);
+        TRAINING_PHASE(neural_network, CORPUS_ADVANCE_PHASE);
         current_sentence = sentence_update(iteration, current_sentence);
     }
     corpus_close(neural_network->corpus);
@@ -8,18 +8,44 @@
 #include <Dictionary/VectorizedDictionary.h>
 #include "Vocabulary.h"
 #include "WordToVecParameter.h"
+#include "WeightMatrix.h"
+#include "TrainingKernels.h"
+#include "MappedCorpus.h"
+#include "MemoryFootprint.h"
+#include "PhaseCounters.h"
 
 static int EXP_TABLE_SIZE = 1000;
 static int MAX_EXP = 6;
 
+struct validation_monitor;
+
+struct neural_network;
+
+struct iteration;
+
+typedef void (*Sentence_position_trainer)(struct neural_network* neural_network, struct iteration* iteration, Sentence_ptr current_sentence, double* outputs, double* output_update);
+
 struct neural_network{
     double** word_vectors;
     double** word_vector_update;
+    Weight_matrix_ptr word_vectors_matrix;
+    Weight_matrix_ptr word_vector_update_matrix;
+    Numa_topology_ptr numa_topology;
     Vocabulary_ptr vocabulary;
+    bool owns_vocabulary;
     Word_to_vec_parameter_ptr parameter;
     Corpus_ptr corpus;
+    Mapped_corpus_ptr mapped_corpus;
+    Phrase_detector_ptr phrase_detector;
     Array_list_ptr exp_table;
     int vector_length;
+    Sentence_position_trainer cbow_position_trainer;
+    Sentence_position_trainer skip_gram_position_trainer;
+    struct validation_monitor* validation_monitor;
+    Phase_counters_ptr phase_counters;
+    int* row_versions;
+    int snapshot_version;
+    Memory_footprint memory_footprint;
 };
 
 typedef struct neural_network Neural_network;
@@ -28,16 +54,31 @@ typedef Neural_network *Neural_network_ptr;
 
 Neural_network_ptr create_neural_network(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter);
 
+Neural_network_ptr create_neural_network2(Corpus_ptr corpus, Word_to_vec_parameter_ptr parameter, Phrase_detector_ptr phrase_detector);
+
+Neural_network_ptr create_neural_network3(Mapped_corpus_ptr mapped_corpus, Word_to_vec_parameter_ptr parameter);
+
+Neural_network_ptr create_neural_network4(Vocabulary_ptr vocabulary,
+                                          Corpus_ptr corpus,
+                                          Word_to_vec_parameter_ptr parameter,
+                                          Phrase_detector_ptr phrase_detector);
+
 void free_neural_network(Neural_network_ptr neural_network);
 
 void prepare_exp_table(Neural_network_ptr neural_network);
 
 double calculate_g(Neural_network_ptr neural_network, double f, double alpha, double label);
 
+void train_network(Neural_network_ptr neural_network);
+
 Vectorized_dictionary_ptr train(Neural_network_ptr neural_network);
 
+Vectorized_dictionary_ptr export_word_vectors(Neural_network_ptr neural_network);
+
 void update_output(Neural_network_ptr neural_network, double* outputUpdate, const double* outputs, int l2, double g);
 
+void update_output_row(Neural_network_ptr neural_network, double* outputUpdate, double* row, const double* outputs, double g);
+
 double dot_product_array(Neural_network_ptr neural_network, const double* vector1, const double* vector2);
 
 void train_cbow(Neural_network_ptr neural_network);
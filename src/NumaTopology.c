@@ -0,0 +1,205 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sched.h>
+#include <Memory/Memory.h>
+#include "NumaTopology.h"
+
+struct first_touch_task{
+    char* data;
+    size_t size;
+    int cpu;
+};
+
+typedef struct first_touch_task First_touch_task;
+
+/**
+ * Parses a cpulist string of the form "0-3,8-11" and stores the cpus in the given array.
+ * @param line Cpulist string.
+ * @param cpus Output array, may be NULL if only the number of cpus is required.
+ * @return Number of cpus in the list.
+ */
+static int parse_cpu_list(const char* line, int* cpus) {
+    int count = 0;
+    const char* p = line;
+    while (*p >= '0' && *p <= '9'){
+        int first, last;
+        int read = 0;
+        if (sscanf(p, "%d-%d%n", &first, &last, &read) != 2){
+            sscanf(p, "%d%n", &first, &read);
+            last = first;
+        }
+        for (int cpu = first; cpu <= last; cpu++){
+            if (cpus != NULL){
+                cpus[count] = cpu;
+            }
+            count++;
+        }
+        p += read;
+        if (*p == ','){
+            p++;
+        }
+    }
+    return count;
+}
+
+/**
+ * Reads the cpu list of a NUMA node from sysfs.
+ * @param node Index of the node.
+ * @param line Output buffer.
+ * @param length Length of the output buffer.
+ * @return True if the node exists, false otherwise.
+ */
+static bool read_node_cpu_list(int node, char* line, int length) {
+    char file_name[64];
+    sprintf(file_name, "/sys/devices/system/node/node%d/cpulist", node);
+    FILE* input = fopen(file_name, "r");
+    if (input == NULL){
+        return false;
+    }
+    if (fgets(line, length, input) == NULL){
+        line[0] = '\0';
+    }
+    fclose(input);
+    return true;
+}
+
+/**
+ * Constructor for the NUMA topology. Nodes and their cpus are read from sysfs. If the system does not expose its
+ * topology, all online cpus are put into a single node.
+ * @return NUMA topology of the machine.
+ */
+Numa_topology_ptr create_numa_topology() {
+    Numa_topology_ptr result = malloc_(sizeof(Numa_topology));
+    char line[4096];
+    int node_count = 0;
+    while (read_node_cpu_list(node_count, line, sizeof(line))){
+        node_count++;
+    }
+    if (node_count == 0){
+        long processors = sysconf(_SC_NPROCESSORS_ONLN);
+        result->node_count = 1;
+        result->cpu_counts = malloc_(sizeof(int));
+        result->cpus = malloc_(sizeof(int*));
+        result->cpu_counts[0] = processors > 0 ? (int) processors : 1;
+        result->cpus[0] = malloc_(result->cpu_counts[0] * sizeof(int));
+        for (int i = 0; i < result->cpu_counts[0]; i++){
+            result->cpus[0][i] = i;
+        }
+        return result;
+    }
+    result->node_count = node_count;
+    result->cpu_counts = malloc_(node_count * sizeof(int));
+    result->cpus = malloc_(node_count * sizeof(int*));
+    for (int i = 0; i < node_count; i++){
+        read_node_cpu_list(i, line, sizeof(line));
+        result->cpu_counts[i] = parse_cpu_list(line, NULL);
+        result->cpus[i] = malloc_((result->cpu_counts[i] > 0 ? result->cpu_counts[i] : 1) * sizeof(int));
+        parse_cpu_list(line, result->cpus[i]);
+    }
+    return result;
+}
+
+/**
+ * Frees memory allocated for the NUMA topology.
+ * @param numa_topology NUMA topology to deallocate.
+ */
+void free_numa_topology(Numa_topology_ptr numa_topology) {
+    for (int i = 0; i < numa_topology->node_count; i++){
+        free_(numa_topology->cpus[i]);
+    }
+    free_(numa_topology->cpus);
+    free_(numa_topology->cpu_counts);
+    free_(numa_topology);
+}
+
+/**
+ * Returns the node a thread is assigned to. Threads are distributed over the nodes in round robin order, so that
+ * every node gets the same number of threads.
+ * @param numa_topology Current NUMA topology
+ * @param thread_index Index of the thread.
+ * @return Node of the thread.
+ */
+int numa_node_of_thread(const Numa_topology* numa_topology, int thread_index) {
+    int node = thread_index % numa_topology->node_count;
+    while (numa_topology->cpu_counts[node] == 0){
+        node = (node + 1) % numa_topology->node_count;
+    }
+    return node;
+}
+
+/**
+ * Returns the cpu a thread is pinned to. The k'th thread of a node is pinned to the k'th cpu of that node.
+ * @param numa_topology Current NUMA topology
+ * @param thread_index Index of the thread.
+ * @return Cpu of the thread.
+ */
+int numa_cpu_of_thread(const Numa_topology* numa_topology, int thread_index) {
+    int node = numa_node_of_thread(numa_topology, thread_index);
+    int k = thread_index / numa_topology->node_count;
+    return numa_topology->cpus[node][k % numa_topology->cpu_counts[node]];
+}
+
+/**
+ * Pins the calling thread to the given cpu. On systems without thread affinity support the function does
+ * nothing.
+ * @param cpu Cpu to pin the thread to.
+ */
+void pin_thread_to_cpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &set);
+#endif
+}
+
+static void* first_touch(void* task) {
+    First_touch_task* touch_task = task;
+    pin_thread_to_cpu(touch_task->cpu);
+    memset(touch_task->data, 0, touch_task->size);
+    return NULL;
+}
+
+/**
+ * Touches the pages of a freshly mapped memory area from pinned threads. The area is split into thread_count
+ * page aligned parts and each part is touched by a thread pinned to the same cpu as the training thread with the
+ * same index, so the parts are placed on the nodes in round robin order. A part whose thread can not be started is
+ * touched by the calling thread, which is not pinned.
+ * @param numa_topology Current NUMA topology
+ * @param data Start of the memory area, must be page aligned and not yet touched.
+ * @param size Size of the memory area in bytes.
+ * @param thread_count Number of threads.
+ */
+void first_touch_partitioned(const Numa_topology* numa_topology, void *data, size_t size, int thread_count) {
+    First_touch_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    bool started[thread_count];
+    size_t page_size = sysconf(_SC_PAGESIZE);
+    size_t pages = (size + page_size - 1) / page_size;
+    for (int i = 0; i < thread_count; i++){
+        size_t start = pages * i / thread_count * page_size;
+        size_t end = pages * (i + 1) / thread_count * page_size;
+        if (end > size){
+            end = size;
+        }
+        tasks[i].data = (char*) data + start;
+        tasks[i].size = end > start ? end - start : 0;
+        tasks[i].cpu = numa_cpu_of_thread(numa_topology, i);
+        started[i] = pthread_create(&threads[i], NULL, first_touch, &tasks[i]) == 0;
+    }
+    for (int i = 0; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            memset(tasks[i].data, 0, tasks[i].size);
+        }
+    }
+}
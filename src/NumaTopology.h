@@ -0,0 +1,32 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_NUMATOPOLOGY_H
+#define WORDTOVEC_NUMATOPOLOGY_H
+
+#include <stddef.h>
+
+struct numa_topology{
+    int node_count;
+    int* cpu_counts;
+    int** cpus;
+};
+
+typedef struct numa_topology Numa_topology;
+
+typedef Numa_topology *Numa_topology_ptr;
+
+Numa_topology_ptr create_numa_topology();
+
+void free_numa_topology(Numa_topology_ptr numa_topology);
+
+int numa_node_of_thread(const Numa_topology* numa_topology, int thread_index);
+
+int numa_cpu_of_thread(const Numa_topology* numa_topology, int thread_index);
+
+void pin_thread_to_cpu(int cpu);
+
+void first_touch_partitioned(const Numa_topology* numa_topology, void* data, size_t size, int thread_count);
+
+#endif //WORDTOVEC_NUMATOPOLOGY_H
@@ -0,0 +1,1145 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdlib.h>
+#include <string.h>
+#include <Memory/Memory.h>
+#include "ParallelTraining.h"
+#include "ValidationMonitor.h"
+
+/**
+ * Advances the random number generator of the thread. Each thread has its own linear congruential generator, so
+ * that threads do not contend on the lock of the global random stream.
+ * @param training_thread Current training thread
+ * @return Next random number.
+ */
+static unsigned long long thread_random(Training_thread_ptr training_thread) {
+    training_thread->next_random = training_thread->next_random * 25214903917ULL + 11;
+    return training_thread->next_random >> 16;
+}
+
+/**
+ * Calculates G value in the Word2Vec algorithm using the unboxed exp table of the training.
+ * @param training Current parallel training
+ * @param f F value.
+ * @param alpha Learning rate alpha.
+ * @param label Label of the instance.
+ * @return Calculated G value.
+ */
+static double thread_calculate_g(Parallel_training_ptr training, double f, double alpha, double label) {
+    if (f > MAX_EXP){
+        return (label - 1) * alpha;
+    } else {
+        if (f < -MAX_EXP){
+            return label * alpha;
+        } else {
+            int index = (int) ((f + MAX_EXP) * (EXP_TABLE_SIZE / MAX_EXP / 2));
+            if (index >= 0 && index < EXP_TABLE_SIZE){
+                return (label - training->exp_table[index]) * alpha;
+            } else {
+                return (label - 1) * alpha;
+            }
+        }
+    }
+}
+
+/**
+ * Updates the learning rate of the thread after 10000 words has been processed. The number of words processed by
+ * all threads is kept in a shared atomic counter, so the learning rate follows the global progress. The same
+ * counter drives the checkpoints of the validation monitor.
+ * @param training_thread Current training thread
+ */
+static void thread_alpha_update(Training_thread_ptr training_thread) {
+    Parallel_training_ptr training = training_thread->training;
+    if (training_thread->word_count - training_thread->last_word_count > 10000) {
+        long long processed = training_thread->word_count - training_thread->last_word_count;
+        long long word_count_actual = atomic_fetch_add_explicit(&training->word_count_actual, processed, memory_order_relaxed) + processed;
+        training_thread->last_word_count = training_thread->word_count;
+        training_thread->alpha = scheduled_alpha(&training->scheduler, word_count_actual);
+        if (training->neural_network->validation_monitor != NULL){
+            validation_checkpoint(training->neural_network->validation_monitor, training->neural_network->word_vectors, word_count_actual);
+        }
+    }
+}
+
+/**
+ * Returns the overlay copy of a row, copying the shared row into the overlay when the row is first accessed in the
+ * current round.
+ * @param overlay Row overlay of the thread.
+ * @param shared Shared matrix.
+ * @param word Index of the row.
+ * @param vector_length Length of the rows.
+ * @return Overlay copy of the row.
+ */
+static double* overlay_row(Row_overlay* overlay, double** shared, int word, int vector_length) {
+    int slot = overlay->slot[word];
+    if (slot == -1){
+        slot = overlay->count;
+        overlay->count++;
+        overlay->slot[word] = slot;
+        overlay->words[slot] = word;
+        memcpy(overlay->rows + (size_t) slot * vector_length, shared[word], vector_length * sizeof(double));
+    }
+    return overlay->rows + (size_t) slot * vector_length;
+}
+
+/**
+ * Returns the input row of the word_vectors matrix the thread should read and update, and marks the row as changed
+ * in the bitmap of the thread; the bitmaps are merged into the row versions of the network after training, so the
+ * threads do not write to a shared array on every token. In deterministic mode the row is served from the overlay
+ * of the thread, otherwise from the shared matrix.
+ * @param training_thread Current training thread
+ * @param l1 Index of the input row.
+ * @return Overlay copy of the row in deterministic mode, the shared row otherwise.
+ */
+double *thread_input_row(Training_thread_ptr training_thread, int l1) {
+    Neural_network_ptr neural_network = training_thread->training->neural_network;
+    training_thread->changed_rows[l1 / 64] |= 1ULL << (l1 % 64);
+    if (training_thread->input_overlay.slot != NULL){
+        return overlay_row(&training_thread->input_overlay, neural_network->word_vectors, l1, neural_network->vector_length);
+    }
+    return neural_network->word_vectors[l1];
+}
+
+/**
+ * Returns the output row of the word_vector_update matrix the thread should read and update. In deterministic
+ * mode the row is served from the overlay of the thread. Otherwise rows selected as hot are served from the
+ * private copy of the thread, all other rows from the shared matrix.
+ * @param training_thread Current training thread
+ * @param l2 Index of the output row.
+ * @return Overlay or private copy of the row, the shared row otherwise.
+ */
+double *thread_output_row(Training_thread_ptr training_thread, int l2) {
+    if (training_thread->output_overlay.slot != NULL){
+        Neural_network_ptr neural_network = training_thread->training->neural_network;
+        return overlay_row(&training_thread->output_overlay, neural_network->word_vector_update, l2, neural_network->vector_length);
+    }
+    if (training_thread->private_rows != NULL){
+        int slot = training_thread->training->private_slot[l2];
+        if (slot != -1){
+            return training_thread->private_rows + (size_t) slot * training_thread->training->neural_network->vector_length;
+        }
+    }
+    return training_thread->training->neural_network->word_vector_update[l2];
+}
+
+/**
+ * Marks the input rows changed by a thread as changed in the current snapshot version of the network.
+ * @param training_thread Training thread that has been joined.
+ */
+static void merge_changed_rows(Training_thread_ptr training_thread) {
+    Neural_network_ptr neural_network = training_thread->training->neural_network;
+    int size = size_of_vocabulary(neural_network->vocabulary);
+    for (int i = 0; i < (size + 63) / 64; i++){
+        unsigned long long bits = training_thread->changed_rows[i];
+        while (bits != 0){
+            neural_network->row_versions[i * 64 + __builtin_ctzll(bits)] = neural_network->snapshot_version;
+            bits &= bits - 1;
+        }
+    }
+}
+
+/**
+ * Copies the hot rows of the shared word_vector_update matrix into the private copy of the thread. The base copy
+ * remembers the values read, so that only the difference is added to the shared matrix on the next merge.
+ * @param training_thread Current training thread
+ */
+static void load_private_rows(Training_thread_ptr training_thread) {
+    Parallel_training_ptr training = training_thread->training;
+    int vector_length = training->neural_network->vector_length;
+    for (int slot = 0; slot < training->private_row_count; slot++){
+        double* shared = training->neural_network->word_vector_update[training->private_rows_of_slot[slot]];
+        memcpy(training_thread->private_rows + (size_t) slot * vector_length, shared, vector_length * sizeof(double));
+        memcpy(training_thread->private_base + (size_t) slot * vector_length, shared, vector_length * sizeof(double));
+    }
+}
+
+/**
+ * Adds the updates accumulated in the private rows of the thread to the shared word_vector_update matrix and
+ * reloads the private rows, so that the thread also sees the updates of the other threads.
+ * @param training_thread Current training thread
+ */
+void merge_private_rows(Training_thread_ptr training_thread) {
+    Parallel_training_ptr training = training_thread->training;
+    int vector_length = training->neural_network->vector_length;
+    for (int slot = 0; slot < training->private_row_count; slot++){
+        double* shared = training->neural_network->word_vector_update[training->private_rows_of_slot[slot]];
+        double* private_row = training_thread->private_rows + (size_t) slot * vector_length;
+        double* base = training_thread->private_base + (size_t) slot * vector_length;
+        for (int j = 0; j < vector_length; j++){
+            shared[j] += private_row[j] - base[j];
+        }
+    }
+    load_private_rows(training_thread);
+    training_thread->last_merge_word_count = training_thread->word_count;
+}
+
+/**
+ * Advances the random number generator used for negative sampling. Negative samples have their own stream, so the
+ * samples drawn do not depend on how far ahead they are drawn.
+ * @param training_thread Current training thread
+ * @return Next random number.
+ */
+static unsigned long long thread_negative_random(Training_thread_ptr training_thread) {
+    training_thread->next_negative_random = training_thread->next_negative_random * 25214903917ULL + 11;
+    return training_thread->next_negative_random >> 16;
+}
+
+/**
+ * Draws a negative sample for a word.
+ * @param training_thread Current training thread
+ * @param word_index Index of the current word.
+ * @return Index of the target word, -1 if the sample is the word itself and has to be skipped.
+ */
+static int negative_sample(Training_thread_ptr training_thread, int word_index) {
+    Parallel_training_ptr training = training_thread->training;
+    int target = training->table[thread_negative_random(training_thread) % training->table_size];
+    if (target == 0)
+        target = thread_negative_random(training_thread) % (size_of_vocabulary(training->neural_network->vocabulary) - 1) + 1;
+    if (target == word_index)
+        return -1;
+    return target;
+}
+
+/**
+ * Draws the random decisions of a position before it is trained: the window shrink b and, for negative sampling,
+ * the negative samples of every context (skip-gram) or of the averaged context (CBow).
+ * @param training_thread Current training thread
+ * @param sentence Vocabulary indexes of the words of the sentence.
+ * @param length Number of words in the sentence.
+ * @param position Position of the word.
+ * @param plan Output plan of the position.
+ */
+void plan_position(Training_thread_ptr training_thread, const int *sentence, int length, int position, Position_plan *plan) {
+    Word_to_vec_parameter_ptr parameter = training_thread->training->neural_network->parameter;
+    int window = parameter->window;
+    int groups = 1;
+    plan->b = thread_random(training_thread) % window;
+    if (parameter->hierarchical_soft_max){
+        return;
+    }
+    if (!parameter->cbow){
+        groups = 0;
+        for (int a = plan->b; a < window * 2 + 1 - plan->b; a++){
+            int c = position - window + a;
+            if (a != window && c >= 0 && c < length){
+                groups++;
+            }
+        }
+    }
+    for (int i = 0; i < groups * parameter->negative_sampling_size; i++){
+        plan->negatives[i] = negative_sample(training_thread, sentence[position]);
+    }
+}
+
+/**
+ * Issues prefetches for all cache lines of a row.
+ * @param row Row to prefetch.
+ * @param vector_length Length of the row.
+ */
+static void prefetch_row(const double* row, int vector_length) {
+    for (int j = 0; j < vector_length; j += 64 / sizeof(double)){
+        __builtin_prefetch(row + j, 1, 3);
+    }
+}
+
+/**
+ * Returns the output row to prefetch. In deterministic mode the overlay is not filled ahead of time, so the shared
+ * row, from which the overlay copy will be made, is prefetched.
+ * @param training_thread Current training thread
+ * @param l2 Index of the output row.
+ * @return Row to prefetch.
+ */
+static const double* prefetch_output_row(Training_thread_ptr training_thread, int l2) {
+    if (training_thread->output_overlay.slot != NULL){
+        return training_thread->training->neural_network->word_vector_update[l2];
+    }
+    return thread_output_row(training_thread, l2);
+}
+
+/**
+ * Prefetches the rows a planned position will touch: the word_vectors rows of its contexts and the
+ * word_vector_update rows of its positive and negative samples, or of the Huffman points of the word. Called a
+ * few positions ahead, so that the rows arrive from memory while the current position is trained.
+ * @param training_thread Current training thread
+ * @param sentence Vocabulary indexes of the words of the sentence.
+ * @param length Number of words in the sentence.
+ * @param position Position of the word.
+ * @param plan Plan of the position.
+ */
+void prefetch_position(Training_thread_ptr training_thread, const int *sentence, int length, int position, const Position_plan *plan) {
+    Neural_network_ptr neural_network = training_thread->training->neural_network;
+    Word_to_vec_parameter_ptr parameter = neural_network->parameter;
+    int window = parameter->window;
+    int groups = 0;
+    for (int a = plan->b; a < window * 2 + 1 - plan->b; a++){
+        int c = position - window + a;
+        if (a != window && c >= 0 && c < length){
+            prefetch_row(neural_network->word_vectors[sentence[c]], neural_network->vector_length);
+            groups++;
+        }
+    }
+    if (parameter->hierarchical_soft_max){
+        Vocabulary_word_ptr word = vocabulary_get_word(neural_network->vocabulary, sentence[position]);
+        for (int d = 0; d < word->code_length; d++){
+            prefetch_row(prefetch_output_row(training_thread, word->point[d]), neural_network->vector_length);
+        }
+    } else {
+        if (parameter->cbow){
+            groups = 1;
+        }
+        prefetch_row(prefetch_output_row(training_thread, sentence[position]), neural_network->vector_length);
+        for (int i = 0; i < groups * parameter->negative_sampling_size; i++){
+            if (plan->negatives[i] != -1){
+                prefetch_row(prefetch_output_row(training_thread, plan->negatives[i]), neural_network->vector_length);
+            }
+        }
+    }
+}
+
+/**
+ * Trains the CBow version of Word2Vec algorithm on one position of a sentence given as vocabulary indexes. The body
+ * is inlined into every trainer, so that the kernels see the vector length as a constant in the width specialized
+ * trainers.
+ * @param training_thread Current training thread
+ * @param sentence Vocabulary indexes of the words of the sentence.
+ * @param length Number of words in the sentence.
+ * @param position Position of the current word.
+ * @param plan Window shrink and negative samples drawn for the position.
+ * @param vector_length Length of the word vectors.
+ */
+TRAINING_INLINE void cbow_position(Training_thread_ptr training_thread, const int *sentence, int length, int position, const Position_plan *plan, int vector_length) {
+    Neural_network_ptr neural_network = training_thread->training->neural_network;
+    int window = neural_network->parameter->window;
+    int word_index = sentence[position];
+    Vocabulary_word_ptr current_word = vocabulary_get_word(neural_network->vocabulary, word_index);
+    double* outputs = training_thread->outputs;
+    double* output_update = training_thread->output_update;
+    int target, label, l2, b = plan->b, cw = 0;
+    double f, g;
+    double* row;
+    for (int i = 0; i < vector_length; i++){
+        outputs[i] = 0;
+        output_update[i] = 0;
+    }
+    for (int a = b; a < window * 2 + 1 - b; a++){
+        int c = position - window + a;
+        if (a != window && c >= 0 && c < length) {
+            training_add_vector(outputs, thread_input_row(training_thread, sentence[c]), vector_length);
+            cw++;
+        }
+    }
+    if (cw == 0) {
+        return;
+    }
+    training_divide_vector(outputs, cw, vector_length);
+    if (neural_network->parameter->hierarchical_soft_max){
+        for (int d = 0; d < current_word->code_length; d++) {
+            l2 = current_word->point[d];
+            row = thread_output_row(training_thread, l2);
+            f = training_dot_product(outputs, row, vector_length);
+            if (f <= -MAX_EXP || f >= MAX_EXP){
+                continue;
+            }
+            int index = (int)((f + MAX_EXP) * (EXP_TABLE_SIZE / MAX_EXP / 2));
+            if (index < 0 || index >= EXP_TABLE_SIZE){
+                continue;
+            }
+            f = training_thread->training->exp_table[index];
+            g = (1 - current_word->code[d] - f) * training_thread->alpha;
+            training_update_output(output_update, row, outputs, g, vector_length);
+        }
+    } else {
+        for (int d = 0; d < neural_network->parameter->negative_sampling_size + 1; d++) {
+            if (d == 0) {
+                target = word_index;
+                label = 1;
+            } else {
+                target = plan->negatives[d - 1];
+                label = 0;
+            }
+            if (target == -1){
+                continue;
+            }
+            l2 = target;
+            row = thread_output_row(training_thread, l2);
+            f = training_dot_product(outputs, row, vector_length);
+            g = thread_calculate_g(training_thread->training, f, training_thread->alpha, label);
+            training_update_output(output_update, row, outputs, g, vector_length);
+        }
+    }
+    for (int a = b; a < window * 2 + 1 - b; a++){
+        int c = position - window + a;
+        if (a != window && c >= 0 && c < length) {
+            training_add_vector(thread_input_row(training_thread, sentence[c]), output_update, vector_length);
+        }
+    }
+}
+
+/**
+ * Trains the SkipGram version of Word2Vec algorithm on one position of a sentence given as vocabulary indexes. The
+ * body is inlined into every trainer, like the CBow body.
+ * @param training_thread Current training thread
+ * @param sentence Vocabulary indexes of the words of the sentence.
+ * @param length Number of words in the sentence.
+ * @param position Position of the current word.
+ * @param plan Window shrink and negative samples drawn for the position.
+ * @param vector_length Length of the word vectors.
+ */
+TRAINING_INLINE void skip_gram_position(Training_thread_ptr training_thread, const int *sentence, int length, int position, const Position_plan *plan, int vector_length) {
+    Neural_network_ptr neural_network = training_thread->training->neural_network;
+    int window = neural_network->parameter->window;
+    int word_index = sentence[position];
+    Vocabulary_word_ptr current_word = vocabulary_get_word(neural_network->vocabulary, word_index);
+    double* output_update = training_thread->output_update;
+    int target, label, l1, l2, b = plan->b;
+    const int* negatives = plan->negatives;
+    double f, g;
+    double* row;
+    double* input;
+    for (int a = b; a < window * 2 + 1 - b; a++) {
+        int c = position - window + a;
+        if (a == window || c < 0 || c >= length) {
+            continue;
+        }
+        l1 = sentence[c];
+        input = thread_input_row(training_thread, l1);
+        for (int i = 0; i < vector_length; i++){
+            output_update[i] = 0;
+        }
+        if (neural_network->parameter->hierarchical_soft_max) {
+            for (int d = 0; d < current_word->code_length; d++) {
+                l2 = current_word->point[d];
+                row = thread_output_row(training_thread, l2);
+                f = training_dot_product(input, row, vector_length);
+                if (f <= -MAX_EXP || f >= MAX_EXP){
+                    continue;
+                }
+                int index = (int)((f + MAX_EXP) * (EXP_TABLE_SIZE / MAX_EXP / 2));
+                if (index < 0 || index >= EXP_TABLE_SIZE){
+                    continue;
+                }
+                f = training_thread->training->exp_table[index];
+                g = (1 - current_word->code[d] - f) * training_thread->alpha;
+                training_update_output(output_update, row, input, g, vector_length);
+            }
+        } else {
+            for (int d = 0; d < neural_network->parameter->negative_sampling_size + 1; d++) {
+                if (d == 0) {
+                    target = word_index;
+                    label = 1;
+                } else {
+                    target = negatives[d - 1];
+                    label = 0;
+                }
+                if (target == -1){
+                    continue;
+                }
+                l2 = target;
+                row = thread_output_row(training_thread, l2);
+                f = training_dot_product(input, row, vector_length);
+                g = thread_calculate_g(training_thread->training, f, training_thread->alpha, label);
+                training_update_output(output_update, row, input, g, vector_length);
+            }
+            negatives += neural_network->parameter->negative_sampling_size;
+        }
+        training_add_vector(input, output_update, vector_length);
+    }
+}
+
+/**
+ * Trains the CBow version of Word2Vec algorithm on one position of a sentence, for any vector length.
+ * @param training_thread Current training thread
+ * @param sentence Vocabulary indexes of the words of the sentence.
+ * @param length Number of words in the sentence.
+ * @param position Position of the current word.
+ * @param plan Window shrink and negative samples drawn for the position.
+ */
+void train_cbow_position(Training_thread_ptr training_thread, const int *sentence, int length, int position, const Position_plan *plan) {
+    cbow_position(training_thread, sentence, length, position, plan, training_thread->training->neural_network->vector_length);
+}
+
+/**
+ * Trains the SkipGram version of Word2Vec algorithm on one position of a sentence, for any vector length.
+ * @param training_thread Current training thread
+ * @param sentence Vocabulary indexes of the words of the sentence.
+ * @param length Number of words in the sentence.
+ * @param position Position of the current word.
+ * @param plan Window shrink and negative samples drawn for the position.
+ */
+void train_skip_gram_position(Training_thread_ptr training_thread, const int *sentence, int length, int position, const Position_plan *plan) {
+    skip_gram_position(training_thread, sentence, length, position, plan, training_thread->training->neural_network->vector_length);
+}
+
+/**
+ * Generates the CBow and SkipGram position trainers for a vector length. Since the length is a compile time constant
+ * in them, the compiler fully unrolls and vectorizes the kernels. The operations are done in the same order as in
+ * the trainers for any length, so a specialized trainer produces exactly the same results.
+ */
+#define DEFINE_POSITION_TRAINERS(N) \
+static void train_cbow_position_##N(Training_thread_ptr training_thread, const int *sentence, int length, int position, const Position_plan *plan) { \
+    cbow_position(training_thread, sentence, length, position, plan, N); \
+} \
+static void train_skip_gram_position_##N(Training_thread_ptr training_thread, const int *sentence, int length, int position, const Position_plan *plan) { \
+    skip_gram_position(training_thread, sentence, length, position, plan, N); \
+}
+
+TRAINING_KERNEL_WIDTHS(DEFINE_POSITION_TRAINERS)
+
+#define SELECT_POSITION_TRAINER(N) \
+    case N: \
+        return cbow ? train_cbow_position_##N : train_skip_gram_position_##N;
+
+/**
+ * Returns the position trainer for the algorithm and the vector length. Common layer sizes have width specialized
+ * trainers, all other sizes use the trainers that read the vector length at run time.
+ * @param cbow True for CBow, false for SkipGram.
+ * @param vector_length Length of the word vectors.
+ * @return Position trainer.
+ */
+static Position_trainer select_position_trainer(bool cbow, int vector_length) {
+    switch (vector_length) {
+        TRAINING_KERNEL_WIDTHS(SELECT_POSITION_TRAINER)
+        default:
+            return cbow ? train_cbow_position : train_skip_gram_position;
+    }
+}
+
+/**
+ * Trains one position of a sentence. Positions are planned prefetch_distance positions before they are trained,
+ * and the rows a planned position will touch are prefetched, so that the memory latency of the rows of upcoming
+ * positions overlaps with the arithmetic of the current position. The plans are kept in a ring buffer of
+ * prefetch_distance + 1 slots.
+ * @param training_thread Current training thread
+ * @param sentence Vocabulary indexes of the words of the sentence.
+ * @param length Number of words in the sentence.
+ * @param position Position to train.
+ * @param planned Number of positions of the sentence planned so far, advanced by this function.
+ */
+static void train_position(Training_thread_ptr training_thread, const int* sentence, int length, int position, int* planned) {
+    int distance = training_thread->training->neural_network->parameter->prefetch_distance;
+    while (*planned < length && *planned <= position + distance){
+        Position_plan* plan = &training_thread->plans[*planned % (distance + 1)];
+        plan_position(training_thread, sentence, length, *planned, plan);
+        if (distance > 0){
+            prefetch_position(training_thread, sentence, length, *planned, plan);
+        }
+        (*planned)++;
+    }
+    training_thread->training->position_trainer(training_thread, sentence, length, position, &training_thread->plans[position % (distance + 1)]);
+}
+
+/**
+ * Trains on all positions of one sentence.
+ * @param training_thread Current training thread
+ * @param sentence Vocabulary indexes of the words of the sentence.
+ * @param length Number of words in the sentence.
+ */
+void train_sentence(Training_thread_ptr training_thread, const int* sentence, int length) {
+    int planned = 0;
+    for (int position = 0; position < length; position++){
+        thread_alpha_update(training_thread);
+        train_position(training_thread, sentence, length, position, &planned);
+    }
+    training_thread->word_count += length;
+    if (training_thread->private_rows != NULL &&
+        training_thread->word_count - training_thread->last_merge_word_count >= training_thread->training->neural_network->parameter->hot_merge_interval){
+        merge_private_rows(training_thread);
+    }
+}
+
+/**
+ * Advances the cursor of the thread in deterministic mode to the next position to train. The cursor walks the
+ * sentences of the shard of the thread number_of_iterations times; sentence_end is -1 when the end of the current
+ * sentence has not been located yet.
+ * @param training_thread Current training thread
+ * @return True if there is a position to train, false if the thread has finished its shard.
+ */
+static bool deterministic_cursor(Training_thread_ptr training_thread) {
+    Corpus_shard_ptr shard = training_thread->shard;
+    int number_of_iterations = training_thread->training->neural_network->parameter->number_of_iterations;
+    while (training_thread->iteration < number_of_iterations){
+        if (training_thread->sentence_end == -1){
+            long long i = training_thread->sentence_start;
+            while (i < shard->token_count && shard->tokens[i] != SENTENCE_END){
+                i++;
+            }
+            if (i >= shard->token_count){
+                training_thread->iteration++;
+                training_thread->sentence_start = 0;
+                continue;
+            }
+            training_thread->sentence_end = i;
+            training_thread->position = 0;
+            training_thread->planned = 0;
+        }
+        if (training_thread->position < training_thread->sentence_end - training_thread->sentence_start){
+            return true;
+        }
+        training_thread->sentence_start = training_thread->sentence_end + 1;
+        training_thread->sentence_end = -1;
+    }
+    return false;
+}
+
+/**
+ * Returns the maximum number of distinct rows of one matrix a single position can touch.
+ * @param parameter Parameters of the training.
+ * @param input True for the word_vectors matrix, false for the word_vector_update matrix.
+ * @return Maximum number of rows touched by one position.
+ */
+static int rows_per_position(Word_to_vec_parameter_ptr parameter, bool input) {
+    if (input){
+        return 2 * parameter->window;
+    }
+    if (parameter->hierarchical_soft_max){
+        return MAX_CODE_LENGTH;
+    }
+    if (parameter->cbow){
+        return parameter->negative_sampling_size + 1;
+    }
+    return 2 * parameter->window * (parameter->negative_sampling_size + 1);
+}
+
+/**
+ * Checks if both overlays of the thread can take the rows of one more position.
+ * @param training_thread Current training thread
+ * @param vocabulary_size Number of words in the vocabulary.
+ * @return True if one more position can be trained in the current round.
+ */
+static bool overlays_have_room(Training_thread_ptr training_thread, int vocabulary_size) {
+    Word_to_vec_parameter_ptr parameter = training_thread->training->neural_network->parameter;
+    Row_overlay* overlays[2] = {&training_thread->input_overlay, &training_thread->output_overlay};
+    for (int i = 0; i < 2; i++){
+        if (overlays[i]->capacity < vocabulary_size &&
+            overlays[i]->count + rows_per_position(parameter, i == 0) > overlays[i]->capacity){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Turns the rows of an overlay into deltas against the shared matrix, that is, the change the thread made to each
+ * row in the current round.
+ * @param overlay Row overlay of the thread.
+ * @param shared Shared matrix.
+ * @param vector_length Length of the rows.
+ */
+static void overlay_to_delta(Row_overlay* overlay, double** shared, int vector_length) {
+    for (int i = 0; i < overlay->count; i++){
+        double* row = overlay->rows + (size_t) i * vector_length;
+        const double* base = shared[overlay->words[i]];
+        for (int j = 0; j < vector_length; j++){
+            row[j] -= base[j];
+        }
+    }
+}
+
+/**
+ * Adds the deltas of the overlays of all threads to the rows of the shared matrix owned by the current thread. A
+ * thread owns the rows whose index is congruent to its id modulo the number of threads, and adds the deltas in the
+ * order of the thread ids, so the floating point result does not depend on the scheduling of the threads.
+ * @param training_thread Current training thread
+ * @param threads All training threads.
+ * @param input True to merge the input overlays into word_vectors, false to merge the output overlays into
+ *              word_vector_update.
+ */
+static void merge_overlays(Training_thread_ptr training_thread, Training_thread_ptr threads, bool input) {
+    Neural_network_ptr neural_network = training_thread->training->neural_network;
+    int thread_count = neural_network->parameter->thread_count;
+    double** shared = input ? neural_network->word_vectors : neural_network->word_vector_update;
+    for (int s = 0; s < thread_count; s++){
+        Row_overlay* overlay = input ? &threads[s].input_overlay : &threads[s].output_overlay;
+        for (int i = 0; i < overlay->count; i++){
+            if (overlay->words[i] % thread_count == training_thread->id){
+                training_add_vector(shared[overlay->words[i]], overlay->rows + (size_t) i * neural_network->vector_length, neural_network->vector_length);
+            }
+        }
+    }
+}
+
+/**
+ * Empties an overlay for the next round.
+ * @param overlay Row overlay of the thread.
+ */
+static void reset_overlay(Row_overlay* overlay) {
+    for (int i = 0; i < overlay->count; i++){
+        overlay->slot[overlay->words[i]] = -1;
+    }
+    overlay->count = 0;
+}
+
+/**
+ * Trains one round of a thread in deterministic mode: at most deterministic_interval positions are trained into
+ * the overlays of the thread, which are then turned into deltas against the shared matrices.
+ * @param training_thread Current training thread
+ * @param word_count_actual Number of words trained by all threads until the start of the round.
+ */
+static void train_deterministic_round(Training_thread_ptr training_thread, long long word_count_actual) {
+    Parallel_training_ptr training = training_thread->training;
+    Neural_network_ptr neural_network = training->neural_network;
+    int vocabulary_size = size_of_vocabulary(neural_network->vocabulary);
+    bool finished = false;
+    training_thread->alpha = scheduled_alpha(&training->scheduler, word_count_actual);
+    for (int i = 0; i < neural_network->parameter->deterministic_interval && overlays_have_room(training_thread, vocabulary_size); i++){
+        if (!deterministic_cursor(training_thread)){
+            finished = true;
+            break;
+        }
+        const int* sentence = training_thread->shard->tokens + training_thread->sentence_start;
+        int length = (int) (training_thread->sentence_end - training_thread->sentence_start);
+        train_position(training_thread, sentence, length, training_thread->position, &training_thread->planned);
+        training_thread->position++;
+        training_thread->word_count++;
+    }
+    if (!finished && !deterministic_cursor(training_thread)){
+        finished = true;
+    }
+    training->thread_word_counts[training_thread->id] = training_thread->word_count;
+    training->thread_finished[training_thread->id] = finished;
+    overlay_to_delta(&training_thread->input_overlay, neural_network->word_vectors, neural_network->vector_length);
+    overlay_to_delta(&training_thread->output_overlay, neural_network->word_vector_update, neural_network->vector_length);
+}
+
+/**
+ * Sums the word counts of all threads at the end of a round.
+ * @param training Current parallel training
+ * @param word_count_actual Output, number of words trained by all threads.
+ * @return True if all threads have finished their shards.
+ */
+static bool deterministic_round_totals(Parallel_training_ptr training, long long* word_count_actual) {
+    bool all_finished = true;
+    *word_count_actual = 0;
+    for (int i = 0; i < training->neural_network->parameter->thread_count; i++){
+        *word_count_actual += training->thread_word_counts[i];
+        all_finished = all_finished && training->thread_finished[i];
+    }
+    return all_finished;
+}
+
+/**
+ * Deterministic training loop of a thread. Training proceeds in rounds of at most deterministic_interval positions.
+ * Within a round every thread reads the shared matrices as they were at the start of the round and writes its
+ * updates into its own overlays; between rounds, the overlays of all threads are merged into the shared matrices
+ * in thread order. The learning rate, the validation checkpoints and the stopping decision are all computed from
+ * the word counts at the round boundaries, so for a given seed and thread count the trained vectors do not
+ * depend on the scheduling of the threads.
+ * @param training_thread Current training thread
+ * @param threads All training threads.
+ */
+static void run_deterministic_rounds(Training_thread_ptr training_thread, Training_thread_ptr threads) {
+    Parallel_training_ptr training = training_thread->training;
+    Neural_network_ptr neural_network = training->neural_network;
+    long long word_count_actual = 0;
+    while (true){
+        train_deterministic_round(training_thread, word_count_actual);
+        pthread_barrier_wait(&training->round_barrier);
+        bool all_finished = deterministic_round_totals(training, &word_count_actual);
+        bool stop = neural_network->validation_monitor != NULL && validation_should_stop(neural_network->validation_monitor);
+        merge_overlays(training_thread, threads, true);
+        merge_overlays(training_thread, threads, false);
+        pthread_barrier_wait(&training->round_barrier);
+        reset_overlay(&training_thread->input_overlay);
+        reset_overlay(&training_thread->output_overlay);
+        if (all_finished || stop){
+            break;
+        }
+        if (training_thread->id == 0 && neural_network->validation_monitor != NULL){
+            validation_checkpoint2(neural_network->validation_monitor, neural_network->word_vectors, word_count_actual);
+        }
+    }
+}
+
+/**
+ * Runs the rounds of all threads one after another on the calling thread, when not every training thread could be
+ * started. Each round trains every thread and then merges the overlays of every thread, exactly as the threads
+ * would between two barriers, so the trained vectors are the same as with the threads.
+ * @param training Current parallel training
+ */
+static void run_deterministic_rounds_inline(Parallel_training_ptr training) {
+    Neural_network_ptr neural_network = training->neural_network;
+    int thread_count = neural_network->parameter->thread_count;
+    long long word_count_actual = 0;
+    while (true){
+        for (int i = 0; i < thread_count; i++){
+            train_deterministic_round(&training->threads[i], word_count_actual);
+        }
+        bool all_finished = deterministic_round_totals(training, &word_count_actual);
+        bool stop = neural_network->validation_monitor != NULL && validation_should_stop(neural_network->validation_monitor);
+        for (int i = 0; i < thread_count; i++){
+            merge_overlays(&training->threads[i], training->threads, true);
+            merge_overlays(&training->threads[i], training->threads, false);
+        }
+        for (int i = 0; i < thread_count; i++){
+            reset_overlay(&training->threads[i].input_overlay);
+            reset_overlay(&training->threads[i].output_overlay);
+        }
+        if (all_finished || stop){
+            break;
+        }
+        if (neural_network->validation_monitor != NULL){
+            validation_checkpoint2(neural_network->validation_monitor, neural_network->word_vectors, word_count_actual);
+        }
+    }
+}
+
+/**
+ * Makes number_of_iterations passes of a thread over its shard, updating the shared weight matrices without locks.
+ * @param training_thread Current training thread
+ */
+static void train_thread_shard(Training_thread_ptr training_thread) {
+    Neural_network_ptr neural_network = training_thread->training->neural_network;
+    Corpus_shard_ptr shard = training_thread->shard;
+    if (training_thread->private_rows != NULL){
+        load_private_rows(training_thread);
+    }
+    for (int iteration = 0; iteration < neural_network->parameter->number_of_iterations; iteration++){
+        long long sentence_start = 0;
+        for (long long i = 0; i < shard->token_count; i++){
+            if (shard->tokens[i] == SENTENCE_END){
+                train_sentence(training_thread, shard->tokens + sentence_start, (int) (i - sentence_start));
+                sentence_start = i + 1;
+                if (neural_network->validation_monitor != NULL && validation_should_stop(neural_network->validation_monitor)){
+                    iteration = neural_network->parameter->number_of_iterations;
+                    break;
+                }
+            }
+        }
+    }
+    if (training_thread->private_rows != NULL){
+        merge_private_rows(training_thread);
+    }
+}
+
+/**
+ * Main function of a training thread. If the network is NUMA aware, the thread is pinned to its cpu and copies
+ * its shard into memory of its own node before training. The thread then trains its shard, or in deterministic
+ * mode waits until all threads are started and trains in synchronized rounds. If some thread could not be started,
+ * the deterministic rounds are run by the calling thread instead, and the thread returns without training.
+ * @param argument Training thread.
+ * @return NULL
+ */
+static void* run_training_thread(void* argument) {
+    Training_thread_ptr training_thread = argument;
+    Parallel_training_ptr training = training_thread->training;
+    Neural_network_ptr neural_network = training->neural_network;
+    if (neural_network->numa_topology != NULL){
+        pin_thread_to_cpu(numa_cpu_of_thread(neural_network->numa_topology, training_thread->id));
+        localize_corpus_shard(training_thread->shard);
+    }
+    if (neural_network->parameter->deterministic){
+        pthread_mutex_lock(&training->start_mutex);
+        pthread_mutex_unlock(&training->start_mutex);
+        if (!training->all_started){
+            return NULL;
+        }
+        run_deterministic_rounds(training_thread, training->threads);
+        return NULL;
+    }
+    train_thread_shard(training_thread);
+    return NULL;
+}
+
+static int compare_hot_word(const void* first, const void* second) {
+    const long long* word1 = first;
+    const long long* word2 = second;
+    if (word1[0] != word2[0]){
+        return word1[0] > word2[0] ? -1 : 1;
+    }
+    return word1[1] < word2[1] ? -1 : (word1[1] > word2[1] ? 1 : 0);
+}
+
+/**
+ * Selects the hot_word_count most frequent words as hot rows. Frequent words are the positive targets and the
+ * negative samples of most updates, so their output rows are the ones contended by all threads.
+ * @param training Current parallel training
+ */
+static void select_hot_words(Parallel_training_ptr training) {
+    Vocabulary_ptr vocabulary = training->neural_network->vocabulary;
+    int size = size_of_vocabulary(vocabulary);
+    long long* words = malloc_(2 * size * sizeof(long long));
+    for (int i = 0; i < size; i++){
+        words[2 * i] = vocabulary_get_word(vocabulary, i)->count;
+        words[2 * i + 1] = i;
+    }
+    qsort(words, size, 2 * sizeof(long long), compare_hot_word);
+    training->private_row_count = training->neural_network->parameter->hot_word_count < size ? training->neural_network->parameter->hot_word_count : size;
+    training->private_rows_of_slot = malloc_(training->private_row_count * sizeof(int));
+    for (int i = 0; i < size; i++){
+        training->private_slot[i] = -1;
+    }
+    for (int slot = 0; slot < training->private_row_count; slot++){
+        training->private_rows_of_slot[slot] = (int) words[2 * slot + 1];
+        training->private_slot[words[2 * slot + 1]] = slot;
+    }
+    free_(words);
+}
+
+/**
+ * Selects the inner nodes of the top hs_cached_levels levels of the Huffman tree as private rows. Every path of the
+ * hierarchical softmax starts at the root, so the output rows of the top levels are updated by nearly every token
+ * and are the ones contended by all threads. Nodes are numbered level by level, starting from the root.
+ * @param training Current parallel training
+ */
+static void select_tree_top_nodes(Parallel_training_ptr training) {
+    Vocabulary_ptr vocabulary = training->neural_network->vocabulary;
+    int size = size_of_vocabulary(vocabulary);
+    int levels = training->neural_network->parameter->hs_cached_levels;
+    training->private_rows_of_slot = malloc_(size * sizeof(int));
+    training->private_row_count = 0;
+    for (int i = 0; i < size; i++){
+        training->private_slot[i] = -1;
+    }
+    for (int level = 0; level < levels; level++){
+        for (int i = 0; i < size; i++){
+            Vocabulary_word_ptr word = vocabulary_get_word(vocabulary, i);
+            if (level < word->code_length && training->private_slot[word->point[level]] == -1){
+                training->private_slot[word->point[level]] = training->private_row_count;
+                training->private_rows_of_slot[training->private_row_count] = word->point[level];
+                training->private_row_count++;
+            }
+        }
+    }
+}
+
+/**
+ * Allocates an overlay for one of the weight matrices. The overlay has room for 16 distinct rows per position of a
+ * round, or for the whole matrix if that is smaller; a round ends early if the overlay fills up.
+ * @param overlay Overlay to allocate.
+ * @param neural_network Current neural network object
+ * @param input True for the word_vectors matrix, false for the word_vector_update matrix.
+ */
+static void create_overlay(Row_overlay* overlay, Neural_network_ptr neural_network, bool input) {
+    int size = size_of_vocabulary(neural_network->vocabulary);
+    int bound = rows_per_position(neural_network->parameter, input);
+    long long capacity = 16LL * neural_network->parameter->deterministic_interval + bound;
+    overlay->capacity = capacity < size ? (int) capacity : size;
+    overlay->count = 0;
+    overlay->slot = malloc_(size * sizeof(int));
+    for (int i = 0; i < size; i++){
+        overlay->slot[i] = -1;
+    }
+    overlay->words = malloc_(overlay->capacity * sizeof(int));
+    overlay->rows = malloc_((size_t) overlay->capacity * neural_network->vector_length * sizeof(double));
+}
+
+/**
+ * Frees memory allocated for an overlay.
+ * @param overlay Overlay to deallocate.
+ */
+static void free_overlay(Row_overlay* overlay) {
+    free_(overlay->slot);
+    free_(overlay->words);
+    free_(overlay->rows);
+}
+
+/**
+ * Prepares what the threads training a network share: the position trainer for the vector length is selected,
+ * the unigram and exp tables are unboxed into plain arrays, the private rows are selected, and the word counter and learning rate scheduler are initialized. The bytes
+ * allocated for the tables and private row slots are added to the memory footprint of the network, so no other
+ * thread may allocate memory meanwhile.
+ * @param training Parallel training to prepare.
+ * @param neural_network Current neural network object
+ */
+void prepare_parallel_training(Parallel_training_ptr training, Neural_network_ptr neural_network) {
+    Vocabulary_ptr vocabulary = neural_network->vocabulary;
+    size_t allocated = allocated_memory();
+    training->neural_network = neural_network;
+    training->position_trainer = select_position_trainer(neural_network->parameter->cbow, neural_network->vector_length);
+    training->table_size = vocabulary->table->size;
+    training->table = malloc_(training->table_size * sizeof(int));
+    for (int i = 0; i < training->table_size; i++){
+        training->table[i] = get_table_value(vocabulary, i);
+    }
+    training->exp_table = malloc_((EXP_TABLE_SIZE + 1) * sizeof(double));
+    for (int i = 0; i <= EXP_TABLE_SIZE; i++){
+        training->exp_table[i] = array_list_get_double(neural_network->exp_table, i);
+    }
+    training->private_row_count = 0;
+    training->private_slot = NULL;
+    training->private_rows_of_slot = NULL;
+    if (neural_network->parameter->hot_word_count > 0 && !neural_network->parameter->hierarchical_soft_max && !neural_network->parameter->deterministic){
+        training->private_slot = malloc_(size_of_vocabulary(vocabulary) * sizeof(int));
+        select_hot_words(training);
+    }
+    if (neural_network->parameter->hs_cached_levels > 0 && neural_network->parameter->hierarchical_soft_max && !neural_network->parameter->deterministic){
+        training->private_slot = malloc_(size_of_vocabulary(vocabulary) * sizeof(int));
+        select_tree_top_nodes(training);
+    }
+    neural_network->memory_footprint.thread_buffers += allocated_memory_since(allocated);
+    atomic_init(&training->word_count_actual, 0);
+    training->scheduler = create_learning_rate_scheduler(neural_network->parameter, vocabulary->total_number_of_words);
+}
+
+/**
+ * Frees memory allocated for the tables and private rows of a parallel training.
+ * @param training Parallel training to deallocate.
+ */
+void free_parallel_training(Parallel_training_ptr training) {
+    free_(training->table);
+    free_(training->exp_table);
+    if (training->private_slot != NULL){
+        free_(training->private_slot);
+        free_(training->private_rows_of_slot);
+    }
+}
+
+/**
+ * Initializes a training thread of a parallel training: seeds its random generators from the seed of the
+ * parameter and its id, and allocates its buffers, private rows and, in deterministic mode, its overlays. The
+ * bytes allocated for the buffers are added to the memory footprint of the network, so no other thread may
+ * allocate memory meanwhile.
+ * @param training_thread Training thread to initialize.
+ * @param training Parallel training the thread belongs to.
+ * @param shard Shard the thread trains on.
+ * @param id Index of the thread.
+ */
+void create_training_thread(Training_thread_ptr training_thread, Parallel_training_ptr training, Corpus_shard_ptr shard, int id) {
+    Neural_network_ptr neural_network = training->neural_network;
+    int distance = neural_network->parameter->prefetch_distance;
+    int negatives_per_plan = 2 * neural_network->parameter->window * neural_network->parameter->negative_sampling_size;
+    size_t allocated = allocated_memory();
+    training_thread->training = training;
+    training_thread->shard = shard;
+    training_thread->id = id;
+    training_thread->next_random = (unsigned long long) neural_network->parameter->seed + id;
+    training_thread->next_negative_random = ((unsigned long long) neural_network->parameter->seed + id) * 2862933555777941757ULL + 3037000493ULL;
+    training_thread->word_count = 0;
+    training_thread->last_word_count = 0;
+    training_thread->alpha = neural_network->parameter->alpha;
+    training_thread->outputs = malloc_(neural_network->vector_length * sizeof(double));
+    training_thread->output_update = malloc_(neural_network->vector_length * sizeof(double));
+    training_thread->private_rows = NULL;
+    training_thread->private_base = NULL;
+    training_thread->last_merge_word_count = 0;
+    if (training->private_row_count > 0){
+        training_thread->private_rows = malloc_((size_t) training->private_row_count * neural_network->vector_length * sizeof(double));
+        training_thread->private_base = malloc_((size_t) training->private_row_count * neural_network->vector_length * sizeof(double));
+    }
+    training_thread->changed_rows = calloc_((size_of_vocabulary(neural_network->vocabulary) + 63) / 64, sizeof(unsigned long long));
+    training_thread->plans = malloc_((distance + 1) * sizeof(Position_plan));
+    training_thread->negative_buffer = malloc_((size_t) (distance + 1) * negatives_per_plan * sizeof(int));
+    for (int j = 0; j <= distance; j++){
+        training_thread->plans[j].negatives = training_thread->negative_buffer + (size_t) j * negatives_per_plan;
+    }
+    training_thread->input_overlay.slot = NULL;
+    training_thread->output_overlay.slot = NULL;
+    if (neural_network->parameter->deterministic){
+        create_overlay(&training_thread->input_overlay, neural_network, true);
+        create_overlay(&training_thread->output_overlay, neural_network, false);
+        training_thread->iteration = 0;
+        training_thread->sentence_start = 0;
+        training_thread->sentence_end = -1;
+        training_thread->position = 0;
+        training_thread->planned = 0;
+    }
+    neural_network->memory_footprint.thread_buffers += allocated_memory_since(allocated);
+}
+
+/**
+ * Frees memory allocated for the buffers of a training thread.
+ * @param training_thread Training thread to deallocate.
+ */
+void free_training_thread(Training_thread_ptr training_thread) {
+    free_(training_thread->outputs);
+    free_(training_thread->output_update);
+    free_(training_thread->changed_rows);
+    free_(training_thread->plans);
+    free_(training_thread->negative_buffer);
+    if (training_thread->private_rows != NULL){
+        free_(training_thread->private_rows);
+        free_(training_thread->private_base);
+    }
+    if (training_thread->input_overlay.slot != NULL){
+        free_overlay(&training_thread->input_overlay);
+        free_overlay(&training_thread->output_overlay);
+    }
+}
+
+/**
+ * Multi-threaded training of the Word2Vec algorithm. The corpus is converted once into thread_count shards of
+ * vocabulary indexes, and every thread trains on its own shard, updating the shared weight matrices without
+ * locks. Unigram and exp tables are unboxed into plain arrays before the threads are started. Each thread keeps
+ * private copies of the hot output rows, or with hierarchical softmax of the top levels of the Huffman tree, and
+ * writes them back every hot_merge_interval words. In deterministic mode, every thread gets an overlay per weight
+ * matrix holding the rows it updated in the current round, and private rows are not used. The memory of the shards
+ * and of the buffers of all threads is measured before the first thread starts. Every call tokenizes the corpus
+ * again into new shards, which take 4 bytes per token (8 with NUMA aware threads, which copy their shards to their
+ * nodes and leave the original arrays to the calling thread), and frees them before returning, so repeated calls do not accumulate memory. The shard of a thread that can not be
+ * started is trained by the calling thread; in deterministic mode, the started threads then return before their
+ * first round and the calling thread runs the rounds of all threads.
+ * @param neural_network Current neural network object
+ */
+void train_parallel(Neural_network_ptr neural_network) {
+    int thread_count = neural_network->parameter->thread_count;
+    Vocabulary_ptr vocabulary = neural_network->vocabulary;
+    Parallel_training training;
+    Training_thread threads[thread_count];
+    pthread_t handles[thread_count];
+    Memory_footprint* footprint = &neural_network->memory_footprint;
+    size_t allocated = allocated_memory();
+    if (neural_network->mapped_corpus != NULL){
+        training.shards = create_mapped_corpus_shards(neural_network->mapped_corpus, vocabulary, thread_count);
+    } else {
+        training.shards = create_corpus_shards(neural_network->corpus, neural_network->phrase_detector, vocabulary, thread_count);
+    }
+    footprint->corpus_shards += allocated_memory_since(allocated);
+    if (neural_network->numa_topology != NULL){
+        footprint->corpus_shards *= 2;
+    }
+    prepare_parallel_training(&training, neural_network);
+    training.threads = threads;
+    if (neural_network->parameter->deterministic){
+        pthread_barrier_init(&training.round_barrier, NULL, thread_count);
+        training.thread_word_counts = calloc_(thread_count, sizeof(long long));
+        training.thread_finished = calloc_(thread_count, sizeof(bool));
+    }
+    for (int i = 0; i < thread_count; i++){
+        create_training_thread(&threads[i], &training, training.shards[i], i);
+    }
+    bool started[thread_count];
+    training.all_started = true;
+    pthread_mutex_init(&training.start_mutex, NULL);
+    pthread_mutex_lock(&training.start_mutex);
+    for (int i = 0; i < thread_count; i++){
+        started[i] = pthread_create(&handles[i], NULL, run_training_thread, &threads[i]) == 0;
+        training.all_started = training.all_started && started[i];
+    }
+    pthread_mutex_unlock(&training.start_mutex);
+    if (!training.all_started){
+        if (neural_network->parameter->deterministic){
+            for (int i = 0; i < thread_count; i++){
+                if (started[i]){
+                    pthread_join(handles[i], NULL);
+                    started[i] = false;
+                }
+            }
+            run_deterministic_rounds_inline(&training);
+        } else {
+            for (int i = 0; i < thread_count; i++){
+                if (!started[i]){
+                    train_thread_shard(&threads[i]);
+                }
+            }
+        }
+    }
+    for (int i = 0; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(handles[i], NULL);
+        }
+    }
+    for (int i = 0; i < thread_count; i++){
+        merge_changed_rows(&threads[i]);
+        free_training_thread(&threads[i]);
+    }
+    pthread_mutex_destroy(&training.start_mutex);
+    if (neural_network->parameter->deterministic){
+        pthread_barrier_destroy(&training.round_barrier);
+        free_(training.thread_word_counts);
+        free_(training.thread_finished);
+    }
+    free_corpus_shards(training.shards, thread_count);
+    free_parallel_training(&training);
+}
@@ -0,0 +1,117 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_PARALLELTRAINING_H
+#define WORDTOVEC_PARALLELTRAINING_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include "NeuralNetwork.h"
+#include "CorpusShard.h"
+#include "LearningRateScheduler.h"
+
+struct row_overlay{
+    int* slot;
+    double* rows;
+    int* words;
+    int count;
+    int capacity;
+};
+
+typedef struct row_overlay Row_overlay;
+
+struct training_thread;
+
+struct position_plan;
+
+typedef void (*Position_trainer)(struct training_thread* training_thread, const int* sentence, int length, int position, const struct position_plan* plan);
+
+struct parallel_training{
+    Neural_network_ptr neural_network;
+    Corpus_shard_ptr* shards;
+    int* table;
+    int table_size;
+    double* exp_table;
+    int* private_slot;
+    int* private_rows_of_slot;
+    int private_row_count;
+    _Atomic long long word_count_actual;
+    Learning_rate_scheduler scheduler;
+    pthread_barrier_t round_barrier;
+    pthread_mutex_t start_mutex;
+    bool all_started;
+    struct training_thread* threads;
+    Position_trainer position_trainer;
+    long long* thread_word_counts;
+    bool* thread_finished;
+};
+
+typedef struct parallel_training Parallel_training;
+
+typedef Parallel_training *Parallel_training_ptr;
+
+struct position_plan{
+    int b;
+    int* negatives;
+};
+
+typedef struct position_plan Position_plan;
+
+struct training_thread{
+    Parallel_training_ptr training;
+    Corpus_shard_ptr shard;
+    int id;
+    unsigned long long next_random;
+    unsigned long long next_negative_random;
+    long long word_count;
+    long long last_word_count;
+    double alpha;
+    double* outputs;
+    double* output_update;
+    double* private_rows;
+    double* private_base;
+    long long last_merge_word_count;
+    unsigned long long* changed_rows;
+    Position_plan* plans;
+    int* negative_buffer;
+    Row_overlay input_overlay;
+    Row_overlay output_overlay;
+    int iteration;
+    long long sentence_start;
+    long long sentence_end;
+    int position;
+    int planned;
+};
+
+typedef struct training_thread Training_thread;
+
+typedef Training_thread *Training_thread_ptr;
+
+void train_parallel(Neural_network_ptr neural_network);
+
+void prepare_parallel_training(Parallel_training_ptr training, Neural_network_ptr neural_network);
+
+void free_parallel_training(Parallel_training_ptr training);
+
+void create_training_thread(Training_thread_ptr training_thread, Parallel_training_ptr training, Corpus_shard_ptr shard, int id);
+
+void free_training_thread(Training_thread_ptr training_thread);
+
+void train_sentence(Training_thread_ptr training_thread, const int* sentence, int length);
+
+double* thread_input_row(Training_thread_ptr training_thread, int l1);
+
+double* thread_output_row(Training_thread_ptr training_thread, int l2);
+
+void merge_private_rows(Training_thread_ptr training_thread);
+
+void plan_position(Training_thread_ptr training_thread, const int* sentence, int length, int position, Position_plan* plan);
+
+void prefetch_position(Training_thread_ptr training_thread, const int* sentence, int length, int position, const Position_plan* plan);
+
+void train_cbow_position(Training_thread_ptr training_thread, const int* sentence, int length, int position, const Position_plan* plan);
+
+void train_skip_gram_position(Training_thread_ptr training_thread, const int* sentence, int length, int position, const Position_plan* plan);
+
+#endif //WORDTOVEC_PARALLELTRAINING_H
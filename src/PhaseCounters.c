@@ -0,0 +1,230 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <Memory/Memory.h>
+#include "PhaseCounters.h"
+
+static const char* PHASE_NAMES[TRAINING_PHASE_COUNT] = {"token resolution", "context gather", "forward", "sigmoid", "update", "corpus advance"};
+
+/**
+ * Returns the current value of the monotonic clock in nanoseconds.
+ * @return Current time in nanoseconds.
+ */
+static unsigned long long phase_clock() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long) now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+/**
+ * Opens a hardware counter of the calling thread, counting user space only. The first counter opened is the group
+ * leader and starts disabled; the others join its group, so that all of them are read with a single system call.
+ * @param type Type of the event, PERF_TYPE_HARDWARE or PERF_TYPE_HW_CACHE.
+ * @param config Event of the given type.
+ * @param group Descriptor of the group leader, -1 for the leader itself.
+ * @return Descriptor of the counter, -1 if the event is not supported or not permitted.
+ */
+static int open_phase_counter(unsigned int type, unsigned long long config, int group) {
+    struct perf_event_attr attribute;
+    memset(&attribute, 0, sizeof(attribute));
+    attribute.size = sizeof(attribute);
+    attribute.type = type;
+    attribute.config = config;
+    attribute.disabled = group == -1;
+    attribute.exclude_kernel = 1;
+    attribute.exclude_hv = 1;
+    attribute.read_format = PERF_FORMAT_GROUP;
+    return (int) syscall(SYS_perf_event_open, &attribute, 0, -1, group, 0);
+}
+
+/**
+ * Reads the counters of the group into values. Counters that could not be opened read as zero.
+ * @param phase_counters Current phase counters
+ * @param values Output array of PHASE_COUNTER_COUNT values.
+ */
+static void read_phase_counters(const Phase_counters* phase_counters, unsigned long long* values) {
+    unsigned long long buffer[PHASE_COUNTER_COUNT + 1];
+    memset(values, 0, PHASE_COUNTER_COUNT * sizeof(unsigned long long));
+    if (phase_counters->group == -1 || read(phase_counters->group, buffer, sizeof(buffer)) <= 0){
+        return;
+    }
+    for (int i = 0; i < PHASE_COUNTER_COUNT; i++){
+        if (phase_counters->positions[i] != -1 && phase_counters->positions[i] < (int) buffer[0]){
+            values[i] = buffer[1 + phase_counters->positions[i]];
+        }
+    }
+}
+
+/**
+ * Measures what a phase boundary itself costs by reading the counters and the clock many times back to back. The
+ * mean cost per read is later subtracted from every phase once per call, so that short phases are not dominated by
+ * the reads around them.
+ * @param phase_counters Current phase counters
+ */
+static void calibrate_phase_counters(Phase_counters_ptr phase_counters) {
+    unsigned long long first[PHASE_COUNTER_COUNT], last[PHASE_COUNTER_COUNT];
+    unsigned long long start = phase_clock(), end = 0;
+    read_phase_counters(phase_counters, first);
+    for (int i = 0; i < PHASE_CALIBRATION_READS; i++){
+        read_phase_counters(phase_counters, last);
+        end = phase_clock();
+    }
+    for (int i = 0; i < PHASE_COUNTER_COUNT; i++){
+        phase_counters->read_overhead[i] = (double) (last[i] - first[i]) / PHASE_CALIBRATION_READS;
+    }
+    phase_counters->time_overhead = (double) (end - start) / PHASE_CALIBRATION_READS;
+}
+
+/**
+ * Constructor for the phase counters of the calling thread. Cycles, instructions, last level cache misses and data
+ * TLB misses are opened as one perf event group. Events the processor or the kernel does not provide, for example
+ * when perf_event_paranoid forbids them or inside a virtual machine, are left out; if none can be opened, only the
+ * time of the phases is measured.
+ * @return Phase counters.
+ */
+Phase_counters_ptr create_phase_counters() {
+    Phase_counters_ptr result = calloc_(1, sizeof(Phase_counters));
+    unsigned int types[PHASE_COUNTER_COUNT] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE};
+    unsigned long long configs[PHASE_COUNTER_COUNT] = {PERF_COUNT_HW_CPU_CYCLES,
+                                                       PERF_COUNT_HW_INSTRUCTIONS,
+                                                       PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+                                                       PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+    result->group = -1;
+    for (int i = 0; i < PHASE_COUNTER_COUNT; i++){
+        result->descriptors[i] = open_phase_counter(types[i], configs[i], result->group);
+        result->positions[i] = -1;
+        if (result->descriptors[i] != -1){
+            if (result->group == -1){
+                result->group = result->descriptors[i];
+            }
+            result->positions[i] = result->opened;
+            result->opened++;
+        }
+    }
+    if (result->group != -1){
+        ioctl(result->group, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(result->group, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+    result->current = -1;
+    calibrate_phase_counters(result);
+    return result;
+}
+
+/**
+ * Frees memory allocated for the phase counters and closes the counters.
+ * @param phase_counters Phase counters to deallocate.
+ */
+void free_phase_counters(Phase_counters_ptr phase_counters) {
+    for (int i = 0; i < PHASE_COUNTER_COUNT; i++){
+        if (phase_counters->descriptors[i] != -1){
+            close(phase_counters->descriptors[i]);
+        }
+    }
+    free_(phase_counters);
+}
+
+/**
+ * Reads the counters and the clock, and adds the difference since the previous boundary to the current phase.
+ * @param phase_counters Current phase counters
+ */
+static void close_training_phase(Phase_counters_ptr phase_counters) {
+    unsigned long long values[PHASE_COUNTER_COUNT];
+    read_phase_counters(phase_counters, values);
+    unsigned long long now = phase_clock();
+    if (phase_counters->current != -1){
+        for (int i = 0; i < PHASE_COUNTER_COUNT; i++){
+            phase_counters->totals[phase_counters->current][i] += values[i] - phase_counters->last_values[i];
+        }
+        phase_counters->nanoseconds[phase_counters->current] += now - phase_counters->last_time;
+    }
+    memcpy(phase_counters->last_values, values, sizeof(values));
+    phase_counters->last_time = now;
+}
+
+/**
+ * Marks the start of a new token in the training loop. Only one token in PHASE_SAMPLE_INTERVAL is measured, the
+ * phase boundaries of the other tokens cost a single branch, so the instrumented build runs at nearly the speed of
+ * the normal one and the breakdown is a sample of the whole training.
+ * @param phase_counters Current phase counters, NULL if the training is not instrumented.
+ */
+void start_phase_sample(Phase_counters_ptr phase_counters) {
+    if (phase_counters == NULL){
+        return;
+    }
+    if (phase_counters->active){
+        close_training_phase(phase_counters);
+        phase_counters->current = -1;
+    }
+    phase_counters->active = phase_counters->token_count % PHASE_SAMPLE_INTERVAL == 0;
+    phase_counters->token_count++;
+}
+
+/**
+ * Ends the current phase of a sampled token and starts the given one.
+ * @param phase_counters Current phase counters, NULL if the training is not instrumented.
+ * @param phase Phase the training enters.
+ */
+void switch_training_phase(Phase_counters_ptr phase_counters, Training_phase phase) {
+    if (phase_counters == NULL || !phase_counters->active){
+        return;
+    }
+    close_training_phase(phase_counters);
+    phase_counters->current = phase;
+    phase_counters->calls[phase]++;
+}
+
+/**
+ * Prints the time, cycles, instructions per cycle, last level cache misses and data TLB misses of each phase for
+ * the sampled tokens, after subtracting the calibrated cost of the boundaries. Counters that could not be opened
+ * are printed as n/a.
+ * @param phase_counters Current phase counters
+ * @param output File to print to.
+ */
+void print_phase_counters(Phase_counters_ptr phase_counters, FILE* output) {
+    double corrected[TRAINING_PHASE_COUNT][PHASE_COUNTER_COUNT];
+    double time[TRAINING_PHASE_COUNT];
+    double total_time = 0;
+    for (int phase = 0; phase < TRAINING_PHASE_COUNT; phase++){
+        time[phase] = phase_counters->nanoseconds[phase] - phase_counters->calls[phase] * phase_counters->time_overhead;
+        if (time[phase] < 0){
+            time[phase] = 0;
+        }
+        total_time += time[phase];
+        for (int i = 0; i < PHASE_COUNTER_COUNT; i++){
+            corrected[phase][i] = phase_counters->totals[phase][i] - phase_counters->calls[phase] * phase_counters->read_overhead[i];
+            if (corrected[phase][i] < 0){
+                corrected[phase][i] = 0;
+            }
+        }
+    }
+    fprintf(output, "Training phases, 1 in %d of %lld tokens sampled\n", PHASE_SAMPLE_INTERVAL, phase_counters->token_count);
+    fprintf(output, "%-18s %12s %8s %14s %6s %12s %12s\n", "phase", "ms", "time%", "cycles", "IPC", "LLC misses", "dTLB misses");
+    for (int phase = 0; phase < TRAINING_PHASE_COUNT; phase++){
+        fprintf(output, "%-18s %12.3f %7.2f%%", PHASE_NAMES[phase], time[phase] / 1e6, total_time > 0 ? 100.0 * time[phase] / total_time : 0.0);
+        if (phase_counters->positions[0] != -1){
+            fprintf(output, " %14.0f", corrected[phase][0]);
+        } else {
+            fprintf(output, " %14s", "n/a");
+        }
+        if (phase_counters->positions[0] != -1 && phase_counters->positions[1] != -1 && corrected[phase][0] > 0){
+            fprintf(output, " %6.2f", corrected[phase][1] / corrected[phase][0]);
+        } else {
+            fprintf(output, " %6s", "n/a");
+        }
+        for (int i = 2; i < PHASE_COUNTER_COUNT; i++){
+            if (phase_counters->positions[i] != -1){
+                fprintf(output, " %12.0f", corrected[phase][i]);
+            } else {
+                fprintf(output, " %12s", "n/a");
+            }
+        }
+        fprintf(output, "\n");
+    }
+}
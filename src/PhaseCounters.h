@@ -0,0 +1,67 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_PHASECOUNTERS_H
+#define WORDTOVEC_PHASECOUNTERS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#define TRAINING_PHASE_COUNT 6
+#define PHASE_COUNTER_COUNT 4
+
+static int PHASE_SAMPLE_INTERVAL = 64;
+static int PHASE_CALIBRATION_READS = 1000;
+
+enum training_phase{
+    TOKEN_RESOLUTION_PHASE,
+    CONTEXT_GATHER_PHASE,
+    FORWARD_PHASE,
+    SIGMOID_PHASE,
+    UPDATE_PHASE,
+    CORPUS_ADVANCE_PHASE
+};
+
+typedef enum training_phase Training_phase;
+
+struct phase_counters{
+    int group;
+    int descriptors[PHASE_COUNTER_COUNT];
+    int positions[PHASE_COUNTER_COUNT];
+    int opened;
+    unsigned long long totals[TRAINING_PHASE_COUNT][PHASE_COUNTER_COUNT];
+    unsigned long long nanoseconds[TRAINING_PHASE_COUNT];
+    unsigned long long calls[TRAINING_PHASE_COUNT];
+    double read_overhead[PHASE_COUNTER_COUNT];
+    double time_overhead;
+    unsigned long long last_values[PHASE_COUNTER_COUNT];
+    unsigned long long last_time;
+    long long token_count;
+    int current;
+    bool active;
+};
+
+typedef struct phase_counters Phase_counters;
+
+typedef Phase_counters *Phase_counters_ptr;
+
+#ifdef PHASE_COUNTERS
+#define TRAINING_SAMPLE(neural_network) start_phase_sample((neural_network)->phase_counters)
+#define TRAINING_PHASE(neural_network, phase) switch_training_phase((neural_network)->phase_counters, phase)
+#else
+#define TRAINING_SAMPLE(neural_network)
+#define TRAINING_PHASE(neural_network, phase)
+#endif
+
+Phase_counters_ptr create_phase_counters();
+
+void free_phase_counters(Phase_counters_ptr phase_counters);
+
+void start_phase_sample(Phase_counters_ptr phase_counters);
+
+void switch_training_phase(Phase_counters_ptr phase_counters, Training_phase phase);
+
+void print_phase_counters(Phase_counters_ptr phase_counters, FILE* output);
+
+#endif //WORDTOVEC_PHASECOUNTERS_H
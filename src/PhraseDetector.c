@@ -0,0 +1,302 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <string.h>
+#include <pthread.h>
+#include <StringUtils.h>
+#include <Memory/Memory.h>
+#include "PhraseDetector.h"
+
+struct phrase_batch{
+    char* text;
+    size_t text_size;
+    size_t text_capacity;
+    size_t* sentence_offsets;
+    int sentence_count;
+};
+
+typedef struct phrase_batch Phrase_batch;
+
+struct phrase_count_task{
+    Phrase_detector_ptr phrase_detector;
+    Phrase_batch* batch;
+    int start;
+    int end;
+    long long word_count;
+};
+
+typedef struct phrase_count_task Phrase_count_task;
+
+/**
+ * FNV-1a hash of a word.
+ * @param word Word to hash.
+ * @return 64 bit hash value of the word.
+ */
+static unsigned long long hash_word(const char* word) {
+    unsigned long long hash = 14695981039346656037ULL;
+    while (*word){
+        hash ^= (unsigned char) *word;
+        hash *= 1099511628211ULL;
+        word++;
+    }
+    return hash;
+}
+
+/**
+ * Combines the hashes of two consecutive words into the hash of the bigram.
+ * @param hash1 Hash of the first word.
+ * @param hash2 Hash of the second word.
+ * @return 64 bit hash value of the bigram.
+ */
+static unsigned long long hash_bigram(unsigned long long hash1, unsigned long long hash2) {
+    unsigned long long hash = hash1 * 0x9E3779B97F4A7C15ULL ^ hash2;
+    hash ^= hash >> 29;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+/**
+ * Appends the words of a sentence to the batch. Words are stored one after another as null terminated strings and
+ * an empty string marks the end of the sentence, so that the batch can be scanned without any per word allocation.
+ * @param batch Batch to append to.
+ * @param sentence Sentence to append.
+ */
+static void batch_add_sentence(Phrase_batch* batch, Sentence_ptr sentence) {
+    batch->sentence_offsets[batch->sentence_count] = batch->text_size;
+    batch->sentence_count++;
+    for (int i = 0; i <= sentence_word_count(sentence); i++){
+        const char* word = i < sentence_word_count(sentence) ? sentence_get_word(sentence, i) : "";
+        size_t length = strlen(word) + 1;
+        if (batch->text_size + length > batch->text_capacity){
+            batch->text_capacity = 2 * (batch->text_size + length);
+            batch->text = realloc_(batch->text, batch->text_capacity);
+        }
+        memcpy(batch->text + batch->text_size, word, length);
+        batch->text_size += length;
+    }
+}
+
+/**
+ * Reads the next PHRASE_BATCH_SIZE sentences of the corpus into the batch.
+ * @param batch Batch to fill.
+ * @param corpus Corpus to read from.
+ * @return Number of sentences read.
+ */
+static int read_batch(Phrase_batch* batch, Corpus_ptr corpus) {
+    batch->text_size = 0;
+    batch->sentence_count = 0;
+    while (batch->sentence_count < PHRASE_BATCH_SIZE){
+        Sentence_ptr sentence = corpus_get_sentence2(corpus);
+        if (sentence == NULL){
+            break;
+        }
+        batch_add_sentence(batch, sentence);
+    }
+    return batch->sentence_count;
+}
+
+/**
+ * Counts the unigrams and bigrams of the sentences in the task range. Counts are hashed into the fixed size
+ * tables of the detector, so the memory used does not depend on the corpus size.
+ * @param task Counting task.
+ * @return NULL
+ */
+static void* count_phrases(void* task) {
+    Phrase_count_task* count_task = task;
+    Phrase_detector_ptr phrase_detector = count_task->phrase_detector;
+    unsigned long long unigram_mask = phrase_detector->unigram_table_size - 1;
+    unsigned long long bigram_mask = phrase_detector->bigram_table_size - 1;
+    count_task->word_count = 0;
+    for (int i = count_task->start; i < count_task->end; i++){
+        const char* word = count_task->batch->text + count_task->batch->sentence_offsets[i];
+        unsigned long long previous = 0;
+        bool has_previous = false;
+        while (*word){
+            unsigned long long hash = hash_word(word);
+            atomic_fetch_add_explicit(&phrase_detector->unigram_counts[hash & unigram_mask], 1, memory_order_relaxed);
+            if (has_previous){
+                atomic_fetch_add_explicit(&phrase_detector->bigram_counts[hash_bigram(previous, hash) & bigram_mask], 1, memory_order_relaxed);
+            }
+            previous = hash;
+            has_previous = true;
+            count_task->word_count++;
+            word += strlen(word) + 1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Counts the sentences of a batch with the threads of the detector.
+ * @param phrase_detector Current phrase detector
+ * @param batch Batch to count.
+ * @param tasks Task array with one task per thread.
+ * @param threads Thread handles with one handle per thread.
+ * @param started Output, true for the threads that could be started.
+ */
+static void start_counting(Phrase_detector_ptr phrase_detector, Phrase_batch* batch, Phrase_count_task* tasks, pthread_t* threads, bool* started) {
+    for (int i = 0; i < phrase_detector->thread_count; i++){
+        tasks[i].phrase_detector = phrase_detector;
+        tasks[i].batch = batch;
+        tasks[i].start = (int) ((long long) batch->sentence_count * i / phrase_detector->thread_count);
+        tasks[i].end = (int) ((long long) batch->sentence_count * (i + 1) / phrase_detector->thread_count);
+        started[i] = pthread_create(&threads[i], NULL, count_phrases, &tasks[i]) == 0;
+    }
+}
+
+/**
+ * Waits for the counting threads of a batch and adds their word counts to the total. The tasks of the threads
+ * that could not be started are counted by the calling thread.
+ * @param phrase_detector Current phrase detector
+ * @param tasks Task array with one task per thread.
+ * @param threads Thread handles with one handle per thread.
+ * @param started True for the threads that could be started.
+ */
+static void finish_counting(Phrase_detector_ptr phrase_detector, Phrase_count_task* tasks, pthread_t* threads, const bool* started) {
+    for (int i = 0; i < phrase_detector->thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            count_phrases(&tasks[i]);
+        }
+        phrase_detector->total_number_of_words += tasks[i].word_count;
+    }
+}
+
+/**
+ * Constructor for the phrase detector with the word2phrase defaults, a minimum count of PHRASE_MIN_COUNT and a
+ * threshold of PHRASE_THRESHOLD.
+ * @param corpus Corpus to detect phrases in.
+ * @param thread_count Number of counting threads.
+ * @return Phrase detector storing the unigram and bigram counts.
+ */
+Phrase_detector_ptr create_phrase_detector(Corpus_ptr corpus, int thread_count) {
+    return create_phrase_detector2(corpus, thread_count, PHRASE_MIN_COUNT, PHRASE_THRESHOLD);
+}
+
+/**
+ * Constructor for the phrase detector. Makes one pass over the corpus and counts unigrams and bigrams into
+ * bounded hash tables. Sentences are read in batches; while the threads count one batch, the next batch is read
+ * from the corpus. A thread count below one is taken as one.
+ * @param corpus Corpus to detect phrases in.
+ * @param thread_count Number of counting threads.
+ * @param min_count Words and bigrams occurring less than min_count times are never joined.
+ * @param threshold Bigrams whose score is above the threshold are joined into phrases.
+ * @return Phrase detector storing the unigram and bigram counts.
+ */
+Phrase_detector_ptr create_phrase_detector2(Corpus_ptr corpus, int thread_count, int min_count, double threshold) {
+    if (thread_count < 1){
+        thread_count = 1;
+    }
+    Phrase_detector_ptr result = malloc_(sizeof(Phrase_detector));
+    Phrase_batch batches[2];
+    Phrase_count_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    bool started[thread_count];
+    int current = 0;
+    result->unigram_table_size = PHRASE_UNIGRAM_TABLE_SIZE;
+    result->bigram_table_size = PHRASE_BIGRAM_TABLE_SIZE;
+    result->unigram_counts = calloc_(result->unigram_table_size, sizeof(_Atomic long long));
+    result->bigram_counts = calloc_(result->bigram_table_size, sizeof(_Atomic long long));
+    result->total_number_of_words = 0;
+    result->min_count = min_count;
+    result->threshold = threshold;
+    result->thread_count = thread_count;
+    result->current_sentence = NULL;
+    for (int i = 0; i < 2; i++){
+        batches[i].text_capacity = 1 << 20;
+        batches[i].text = malloc_(batches[i].text_capacity);
+        batches[i].sentence_offsets = malloc_(PHRASE_BATCH_SIZE * sizeof(size_t));
+    }
+    corpus_open(corpus);
+    read_batch(&batches[current], corpus);
+    while (batches[current].sentence_count > 0){
+        start_counting(result, &batches[current], tasks, threads, started);
+        read_batch(&batches[1 - current], corpus);
+        finish_counting(result, tasks, threads, started);
+        current = 1 - current;
+    }
+    corpus_close(corpus);
+    for (int i = 0; i < 2; i++){
+        free_(batches[i].text);
+        free_(batches[i].sentence_offsets);
+    }
+    return result;
+}
+
+/**
+ * Frees memory allocated for the phrase detector. Frees count tables and the last rewritten sentence.
+ * @param phrase_detector Phrase detector to deallocate.
+ */
+void free_phrase_detector(Phrase_detector_ptr phrase_detector) {
+    if (phrase_detector->current_sentence != NULL){
+        free_sentence(phrase_detector->current_sentence);
+    }
+    free_(phrase_detector->unigram_counts);
+    free_(phrase_detector->bigram_counts);
+    free_(phrase_detector);
+}
+
+/**
+ * Calculates the word2phrase score of a bigram, (count(w1 w2) - min_count) / (count(w1) * count(w2)) * N.
+ * @param phrase_detector Current phrase detector
+ * @param word1 First word of the bigram.
+ * @param word2 Second word of the bigram.
+ * @return Score of the bigram, 0 if one of the words occurs less than min_count times.
+ */
+double phrase_score(const Phrase_detector* phrase_detector, const char *word1, const char *word2) {
+    unsigned long long hash1 = hash_word(word1);
+    unsigned long long hash2 = hash_word(word2);
+    long long count1 = atomic_load_explicit(&phrase_detector->unigram_counts[hash1 & (phrase_detector->unigram_table_size - 1)], memory_order_relaxed);
+    long long count2 = atomic_load_explicit(&phrase_detector->unigram_counts[hash2 & (phrase_detector->unigram_table_size - 1)], memory_order_relaxed);
+    long long count12 = atomic_load_explicit(&phrase_detector->bigram_counts[hash_bigram(hash1, hash2) & (phrase_detector->bigram_table_size - 1)], memory_order_relaxed);
+    if (count1 < phrase_detector->min_count || count2 < phrase_detector->min_count || count12 <= phrase_detector->min_count){
+        return 0;
+    }
+    return (count12 - phrase_detector->min_count) / (double) count1 / (double) count2 * (double) phrase_detector->total_number_of_words;
+}
+
+/**
+ * Reads the next sentence of the corpus and joins the bigrams whose score is above the threshold with an
+ * underscore, e.g. "new york" becomes "new_york". Every call allocates the rewritten sentence and frees the one
+ * returned by the previous call, so the sentence is owned by the detector and is valid until the next call. Like
+ * the corpus it reads from, the function is therefore not thread safe: a detector may be shared by several
+ * networks, but only one of them may read sentences through it at a time. If the detector is NULL, the sentence of
+ * the corpus is returned as it is, so that the vocabulary and the trainers can read sentences through this function
+ * in both cases.
+ * @param phrase_detector Current phrase detector, or NULL.
+ * @param corpus Corpus to read from.
+ * @return Next (rewritten) sentence, NULL if the corpus is finished.
+ */
+Sentence_ptr phrase_get_sentence(Phrase_detector_ptr phrase_detector, Corpus_ptr corpus) {
+    Sentence_ptr sentence = corpus_get_sentence2(corpus);
+    if (phrase_detector == NULL || sentence == NULL){
+        return sentence;
+    }
+    Sentence_ptr result = create_sentence();
+    int i = 0;
+    while (i < sentence_word_count(sentence)){
+        char* word = sentence_get_word(sentence, i);
+        char* phrase;
+        if (i + 1 < sentence_word_count(sentence) && phrase_score(phrase_detector, word, sentence_get_word(sentence, i + 1)) > phrase_detector->threshold){
+            char* next = sentence_get_word(sentence, i + 1);
+            phrase = malloc_(strlen(word) + strlen(next) + 2);
+            strcpy(phrase, word);
+            strcat(phrase, "_");
+            strcat(phrase, next);
+            i += 2;
+        } else {
+            phrase = NULL;
+            phrase = str_copy(phrase, word);
+            i++;
+        }
+        sentence_add_word(result, phrase);
+    }
+    if (phrase_detector->current_sentence != NULL){
+        free_sentence(phrase_detector->current_sentence);
+    }
+    phrase_detector->current_sentence = result;
+    return result;
+}
@@ -0,0 +1,43 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_PHRASEDETECTOR_H
+#define WORDTOVEC_PHRASEDETECTOR_H
+
+#include <stdatomic.h>
+#include <Corpus.h>
+
+static int PHRASE_UNIGRAM_TABLE_SIZE = 1 << 22;
+static int PHRASE_BIGRAM_TABLE_SIZE = 1 << 24;
+static int PHRASE_BATCH_SIZE = 65536;
+static int PHRASE_MIN_COUNT = 5;
+static double PHRASE_THRESHOLD = 100;
+
+struct phrase_detector{
+    _Atomic long long* unigram_counts;
+    _Atomic long long* bigram_counts;
+    int unigram_table_size;
+    int bigram_table_size;
+    long long total_number_of_words;
+    int min_count;
+    double threshold;
+    int thread_count;
+    Sentence_ptr current_sentence;
+};
+
+typedef struct phrase_detector Phrase_detector;
+
+typedef Phrase_detector *Phrase_detector_ptr;
+
+Phrase_detector_ptr create_phrase_detector(Corpus_ptr corpus, int thread_count);
+
+Phrase_detector_ptr create_phrase_detector2(Corpus_ptr corpus, int thread_count, int min_count, double threshold);
+
+void free_phrase_detector(Phrase_detector_ptr phrase_detector);
+
+double phrase_score(const Phrase_detector* phrase_detector, const char* word1, const char* word2);
+
+Sentence_ptr phrase_get_sentence(Phrase_detector_ptr phrase_detector, Corpus_ptr corpus);
+
+#endif //WORDTOVEC_PHRASEDETECTOR_H
@@ -0,0 +1,769 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <StringUtils.h>
+#include <Memory/Memory.h>
+#include "ProductQuantizer.h"
+
+struct product_quantizer_file_header{
+    int magic;
+    int word_count;
+    int vector_length;
+    int subspace_count;
+    int centroid_count;
+};
+
+typedef struct product_quantizer_file_header Product_quantizer_file_header;
+
+struct quantizer_task{
+    Product_quantizer_ptr product_quantizer;
+    const Embedding_model* embedding_model;
+    const float* sample;
+    int sample_count;
+    int first_subspace;
+    int subspace_step;
+    int start;
+    int end;
+    unsigned long long seed;
+    float* points;
+    int* assignments;
+    double* sums;
+    int* counts;
+    float* transposed;
+    float* norms;
+    float* distances;
+};
+
+typedef struct quantizer_task Quantizer_task;
+
+struct scan_task{
+    const Product_quantizer* product_quantizer;
+    const float* tables;
+    int query_count;
+    int candidate_count;
+    int start;
+    int end;
+    float* heap_scores;
+    int* heap_indices;
+};
+
+typedef struct scan_task Scan_task;
+
+/**
+ * Allocates an empty product quantizer for the given shape. Codes are stored in blocks of PQ_BLOCK_ROWS rows, and
+ * inside a block the codes of each subspace are contiguous, so that a table scan reads the codes of consecutive
+ * rows for the same lookup table.
+ * @param word_count Number of rows.
+ * @param vector_length Length of the vectors.
+ * @param subspace_count Number of subspaces, each encoded with one byte.
+ * @param centroid_count Number of centroids per subspace.
+ * @return Product quantizer with uninitialized centroids and codes.
+ */
+static Product_quantizer_ptr allocate_product_quantizer(int word_count, int vector_length, int subspace_count, int centroid_count) {
+    Product_quantizer_ptr result = malloc_(sizeof(Product_quantizer));
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    int block_count = (word_count + PQ_BLOCK_ROWS - 1) / PQ_BLOCK_ROWS;
+    result->word_count = word_count;
+    result->vector_length = vector_length;
+    result->subspace_count = subspace_count;
+    result->subspace_length = vector_length / subspace_count;
+    result->centroid_count = centroid_count;
+    result->centroids = malloc_((size_t) subspace_count * centroid_count * result->subspace_length * sizeof(float));
+    result->codes = calloc_((size_t) block_count * PQ_BLOCK_ROWS * subspace_count, sizeof(unsigned char));
+    result->words = calloc_(word_count, sizeof(char*));
+    result->word_map = create_string_hash_map();
+    result->thread_count = processors > 0 ? (int) processors : 1;
+    return result;
+}
+
+/**
+ * Sets the word at a given row of the quantizer and registers it in the word map.
+ * @param product_quantizer Current product quantizer
+ * @param index Row of the word.
+ * @param word Word to be stored.
+ */
+static void product_quantizer_set_word(Product_quantizer_ptr product_quantizer, int index, const char* word) {
+    int* position = malloc_(sizeof(int));
+    *position = index;
+    product_quantizer->words[index] = str_copy(product_quantizer->words[index], word);
+    hash_map_insert(product_quantizer->word_map, product_quantizer->words[index], position);
+}
+
+/**
+ * Returns the address of the code of a row for a subspace.
+ * @param product_quantizer Current product quantizer
+ * @param row Row of the word.
+ * @param subspace Subspace of the code.
+ * @return Address of the code.
+ */
+static unsigned char* code_of(const Product_quantizer* product_quantizer, int row, int subspace) {
+    return product_quantizer->codes + ((size_t) (row / PQ_BLOCK_ROWS) * product_quantizer->subspace_count + subspace) * PQ_BLOCK_ROWS + row % PQ_BLOCK_ROWS;
+}
+
+/**
+ * Copies a row of a model scaled to unit length, so that inner products of quantized vectors approximate cosine
+ * similarities.
+ * @param embedding_model Model holding the row.
+ * @param row Row to copy.
+ * @param output Output vector of vector_length floats.
+ */
+static void normalized_row(const Embedding_model* embedding_model, int row, float* output) {
+    const float* vector = embedding_model_vector(embedding_model, row);
+    double norm = 0;
+    for (int j = 0; j < embedding_model->vector_length; j++){
+        norm += vector[j] * vector[j];
+    }
+    float scale = norm > 0 ? (float) (1 / sqrt(norm)) : 0;
+    for (int j = 0; j < embedding_model->vector_length; j++){
+        output[j] = vector[j] * scale;
+    }
+}
+
+/**
+ * Stores the centroids of a subspace dimension major together with their squared norms, so that the distances of
+ * a point to all centroids are computed by loops over the centroids, which the compiler vectorizes.
+ * @param product_quantizer Current product quantizer
+ * @param subspace Subspace of the centroids.
+ * @param transposed Output, subspace_length x centroid_count.
+ * @param norms Output, squared norms of the centroids.
+ */
+static void transpose_centroids(const Product_quantizer* product_quantizer, int subspace, float* transposed, float* norms) {
+    int length = product_quantizer->subspace_length;
+    const float* centroids = product_quantizer->centroids + (size_t) subspace * product_quantizer->centroid_count * length;
+    for (int c = 0; c < product_quantizer->centroid_count; c++){
+        norms[c] = 0;
+        for (int d = 0; d < length; d++){
+            transposed[d * product_quantizer->centroid_count + c] = centroids[c * length + d];
+            norms[c] += centroids[c * length + d] * centroids[c * length + d];
+        }
+    }
+}
+
+/**
+ * Finds the centroid closest to a point of a subspace. The squared distance is computed as |c|^2 - 2 x . c,
+ * dropping |x|^2 which is the same for all centroids.
+ * @param point Point of the subspace.
+ * @param transposed Centroids of the subspace, dimension major.
+ * @param norms Squared norms of the centroids.
+ * @param length Length of the subspace.
+ * @param centroid_count Number of centroids.
+ * @param distances Buffer of centroid_count floats.
+ * @return Index of the closest centroid.
+ */
+static int nearest_centroid(const float* point, const float* transposed, const float* norms, int length, int centroid_count, float* distances) {
+    int best = 0;
+    for (int c = 0; c < centroid_count; c++){
+        distances[c] = norms[c];
+    }
+    for (int d = 0; d < length; d++){
+        float value = -2 * point[d];
+        const float* column = transposed + d * centroid_count;
+        for (int c = 0; c < centroid_count; c++){
+            distances[c] += value * column[c];
+        }
+    }
+    for (int c = 1; c < centroid_count; c++){
+        if (distances[c] < distances[best]){
+            best = c;
+        }
+    }
+    return best;
+}
+
+/**
+ * Trains the centroids of every subspace_step'th subspace starting from first_subspace with Lloyd's k-means on the
+ * sample. Centroids start from the first sample points, which are in random order; a centroid losing all of its
+ * points is moved onto a random sample point.
+ * @param argument Quantizer task.
+ * @return NULL
+ */
+static void* run_kmeans_task(void* argument) {
+    Quantizer_task* task = argument;
+    Product_quantizer_ptr product_quantizer = task->product_quantizer;
+    int length = product_quantizer->subspace_length;
+    int centroid_count = product_quantizer->centroid_count;
+    unsigned long long next_random = task->seed;
+    for (int m = task->first_subspace; m < product_quantizer->subspace_count; m += task->subspace_step){
+        float* centroids = product_quantizer->centroids + (size_t) m * centroid_count * length;
+        for (int i = 0; i < task->sample_count; i++){
+            memcpy(task->points + (size_t) i * length, task->sample + (size_t) i * product_quantizer->vector_length + m * length, length * sizeof(float));
+        }
+        memcpy(centroids, task->points, (size_t) centroid_count * length * sizeof(float));
+        for (int iteration = 0; iteration < PQ_KMEANS_ITERATIONS; iteration++){
+            transpose_centroids(product_quantizer, m, task->transposed, task->norms);
+            memset(task->sums, 0, (size_t) centroid_count * length * sizeof(double));
+            memset(task->counts, 0, centroid_count * sizeof(int));
+            for (int i = 0; i < task->sample_count; i++){
+                const float* point = task->points + (size_t) i * length;
+                int c = nearest_centroid(point, task->transposed, task->norms, length, centroid_count, task->distances);
+                task->assignments[i] = c;
+                task->counts[c]++;
+                for (int d = 0; d < length; d++){
+                    task->sums[c * length + d] += point[d];
+                }
+            }
+            for (int c = 0; c < centroid_count; c++){
+                if (task->counts[c] > 0){
+                    for (int d = 0; d < length; d++){
+                        centroids[c * length + d] = (float) (task->sums[c * length + d] / task->counts[c]);
+                    }
+                } else {
+                    next_random = next_random * 25214903917ULL + 11;
+                    memcpy(centroids + c * length, task->points + (size_t) ((next_random >> 16) % task->sample_count) * length, length * sizeof(float));
+                }
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Encodes the rows start to end of the model: every subspace of a normalized row is replaced by the index of its
+ * closest centroid.
+ * @param argument Quantizer task, whose transposed centroids and norms hold all subspaces.
+ * @return NULL
+ */
+static void* run_encode_task(void* argument) {
+    Quantizer_task* task = argument;
+    Product_quantizer_ptr product_quantizer = task->product_quantizer;
+    int length = product_quantizer->subspace_length;
+    int centroid_count = product_quantizer->centroid_count;
+    float row[product_quantizer->vector_length];
+    for (int i = task->start; i < task->end; i++){
+        normalized_row(task->embedding_model, i, row);
+        for (int m = 0; m < product_quantizer->subspace_count; m++){
+            *code_of(product_quantizer, i, m) = (unsigned char) nearest_centroid(row + m * length,
+                                                                                task->transposed + (size_t) m * length * centroid_count,
+                                                                                task->norms + (size_t) m * centroid_count,
+                                                                                length,
+                                                                                centroid_count,
+                                                                                task->distances);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Trains a product quantizer on the rows of a model and encodes all rows. The normalized vectors are split into
+ * subspace_count subspaces, and each subspace is quantized with its own k-means codebook of up to
+ * PQ_CENTROID_COUNT centroids, so every row is stored in subspace_count bytes. Codebooks are trained on a random
+ * sample of at most PQ_TRAINING_SAMPLE rows, the subspaces are distributed over the threads, and the rows are
+ * encoded in parallel. All buffers are allocated by the calling thread. The result only depends on the seed.
+ * @param embedding_model Model to compress, for example created from the word_vectors of a trained network.
+ * @param subspace_count Number of subspaces, must divide the vector length.
+ * @param seed Seed of the sampling.
+ * @return Product quantizer, NULL if the vector length is not a multiple of the number of subspaces.
+ */
+Product_quantizer_ptr create_product_quantizer(const Embedding_model* embedding_model, int subspace_count, unsigned long long seed) {
+    if (subspace_count < 1 || embedding_model->vector_length % subspace_count != 0 || embedding_model->word_count == 0){
+        return NULL;
+    }
+    int centroid_count = embedding_model->word_count < PQ_CENTROID_COUNT ? embedding_model->word_count : PQ_CENTROID_COUNT;
+    Product_quantizer_ptr result = allocate_product_quantizer(embedding_model->word_count, embedding_model->vector_length, subspace_count, centroid_count);
+    int length = result->subspace_length;
+    int sample_count = embedding_model->word_count < PQ_TRAINING_SAMPLE ? embedding_model->word_count : PQ_TRAINING_SAMPLE;
+    int* permutation = malloc_(embedding_model->word_count * sizeof(int));
+    float* sample = malloc_((size_t) sample_count * embedding_model->vector_length * sizeof(float));
+    unsigned long long next_random = seed;
+    for (int i = 0; i < embedding_model->word_count; i++){
+        permutation[i] = i;
+        product_quantizer_set_word(result, i, embedding_model->words[i]);
+    }
+    for (int i = 0; i < sample_count; i++){
+        next_random = next_random * 25214903917ULL + 11;
+        int j = i + (int) ((next_random >> 16) % (embedding_model->word_count - i));
+        int temporary = permutation[i];
+        permutation[i] = permutation[j];
+        permutation[j] = temporary;
+        normalized_row(embedding_model, permutation[i], sample + (size_t) i * embedding_model->vector_length);
+    }
+    int thread_count = result->thread_count < subspace_count ? result->thread_count : subspace_count;
+    Quantizer_task tasks[result->thread_count];
+    pthread_t threads[result->thread_count];
+    bool started[result->thread_count];
+    for (int i = 0; i < thread_count; i++){
+        tasks[i].product_quantizer = result;
+        tasks[i].sample = sample;
+        tasks[i].sample_count = sample_count;
+        tasks[i].first_subspace = i;
+        tasks[i].subspace_step = thread_count;
+        tasks[i].seed = seed + i;
+        tasks[i].points = malloc_((size_t) sample_count * length * sizeof(float));
+        tasks[i].assignments = malloc_(sample_count * sizeof(int));
+        tasks[i].sums = malloc_((size_t) centroid_count * length * sizeof(double));
+        tasks[i].counts = malloc_(centroid_count * sizeof(int));
+        tasks[i].transposed = malloc_((size_t) centroid_count * length * sizeof(float));
+        tasks[i].norms = malloc_(centroid_count * sizeof(float));
+        tasks[i].distances = malloc_(centroid_count * sizeof(float));
+    }
+    for (int i = 1; i < thread_count; i++){
+        started[i] = pthread_create(&threads[i], NULL, run_kmeans_task, &tasks[i]) == 0;
+    }
+    run_kmeans_task(&tasks[0]);
+    for (int i = 1; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            run_kmeans_task(&tasks[i]);
+        }
+    }
+    for (int i = 0; i < thread_count; i++){
+        free_(tasks[i].points);
+        free_(tasks[i].assignments);
+        free_(tasks[i].sums);
+        free_(tasks[i].counts);
+        free_(tasks[i].transposed);
+        free_(tasks[i].norms);
+        free_(tasks[i].distances);
+    }
+    free_(sample);
+    free_(permutation);
+    float* transposed = malloc_((size_t) subspace_count * centroid_count * length * sizeof(float));
+    float* norms = malloc_((size_t) subspace_count * centroid_count * sizeof(float));
+    for (int m = 0; m < subspace_count; m++){
+        transpose_centroids(result, m, transposed + (size_t) m * length * centroid_count, norms + (size_t) m * centroid_count);
+    }
+    thread_count = result->thread_count < embedding_model->word_count ? result->thread_count : embedding_model->word_count;
+    for (int i = 0; i < thread_count; i++){
+        tasks[i].product_quantizer = result;
+        tasks[i].embedding_model = embedding_model;
+        tasks[i].start = (int) ((long long) embedding_model->word_count * i / thread_count);
+        tasks[i].end = (int) ((long long) embedding_model->word_count * (i + 1) / thread_count);
+        tasks[i].transposed = transposed;
+        tasks[i].norms = norms;
+        tasks[i].distances = malloc_(centroid_count * sizeof(float));
+    }
+    for (int i = 1; i < thread_count; i++){
+        started[i] = pthread_create(&threads[i], NULL, run_encode_task, &tasks[i]) == 0;
+    }
+    run_encode_task(&tasks[0]);
+    for (int i = 1; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            run_encode_task(&tasks[i]);
+        }
+    }
+    for (int i = 0; i < thread_count; i++){
+        free_(tasks[i].distances);
+    }
+    free_(transposed);
+    free_(norms);
+    return result;
+}
+
+/**
+ * Reads a null terminated word of any length from a file.
+ * @param input Input file.
+ * @param buffer Buffer holding the word, grown as needed.
+ * @param capacity Capacity of the buffer, updated when it grows.
+ * @return True if a whole word is read, false if the file ends before its terminating null.
+ */
+static bool read_product_quantizer_word(FILE* input, char** buffer, int* capacity) {
+    int length = 0;
+    int c;
+    while ((c = fgetc(input)) != EOF){
+        if (length == *capacity){
+            *capacity *= 2;
+            *buffer = realloc_(*buffer, *capacity);
+        }
+        (*buffer)[length] = (char) c;
+        if (c == 0){
+            return true;
+        }
+        length++;
+    }
+    return false;
+}
+
+/**
+ * Loads a product quantizer saved by save_product_quantizer. Words are read up to their terminating null whatever
+ * their length, and the header is validated before anything is allocated; since codes are stored in one byte, the
+ * number of centroids per subspace must be between 1 and PQ_CENTROID_COUNT. Every code of a word must select one
+ * of these centroids, and the codes of the padding rows of the last block are set to 0, since the scan reads them.
+ * @param file_name Name of the quantizer file.
+ * @return Product quantizer, NULL if the file could not be read, is not a quantizer file or has a code outside the
+ * codebook.
+ */
+Product_quantizer_ptr create_product_quantizer2(const char* file_name) {
+    FILE* input = fopen(file_name, "rb");
+    if (input == NULL){
+        return NULL;
+    }
+    Product_quantizer_file_header header;
+    if (fread(&header, sizeof(Product_quantizer_file_header), 1, input) != 1 || header.magic != PRODUCT_QUANTIZER_FILE_MAGIC ||
+        header.word_count < 0 || header.vector_length < 1 || header.subspace_count < 1 ||
+        header.vector_length % header.subspace_count != 0 ||
+        header.centroid_count < 1 || header.centroid_count > PQ_CENTROID_COUNT){
+        fclose(input);
+        return NULL;
+    }
+    Product_quantizer_ptr result = allocate_product_quantizer(header.word_count, header.vector_length, header.subspace_count, header.centroid_count);
+    int capacity = 64;
+    char* word = malloc_(capacity);
+    bool valid = true;
+    for (int i = 0; i < header.word_count && valid; i++){
+        valid = read_product_quantizer_word(input, &word, &capacity);
+        if (valid){
+            product_quantizer_set_word(result, i, word);
+        }
+    }
+    free_(word);
+    size_t centroid_size = (size_t) header.subspace_count * header.centroid_count * result->subspace_length;
+    size_t code_size = (size_t) (header.word_count + PQ_BLOCK_ROWS - 1) / PQ_BLOCK_ROWS * PQ_BLOCK_ROWS * header.subspace_count;
+    if (!valid || fread(result->centroids, sizeof(float), centroid_size, input) != centroid_size ||
+        fread(result->codes, sizeof(unsigned char), code_size, input) != code_size){
+        fclose(input);
+        free_product_quantizer(result);
+        return NULL;
+    }
+    fclose(input);
+    int padded_count = (header.word_count + PQ_BLOCK_ROWS - 1) / PQ_BLOCK_ROWS * PQ_BLOCK_ROWS;
+    for (int i = 0; i < padded_count; i++){
+        for (int m = 0; m < header.subspace_count; m++){
+            if (i >= header.word_count){
+                *code_of(result, i, m) = 0;
+            } else if (*code_of(result, i, m) >= header.centroid_count){
+                free_product_quantizer(result);
+                return NULL;
+            }
+        }
+    }
+    return result;
+}
+
+/**
+ * Frees memory allocated for the product quantizer.
+ * @param product_quantizer Product quantizer to deallocate.
+ */
+void free_product_quantizer(Product_quantizer_ptr product_quantizer) {
+    free_hash_map2(product_quantizer->word_map, NULL, free_);
+    for (int i = 0; i < product_quantizer->word_count; i++){
+        free_(product_quantizer->words[i]);
+    }
+    free_(product_quantizer->words);
+    free_(product_quantizer->centroids);
+    free_(product_quantizer->codes);
+    free_(product_quantizer);
+}
+
+/**
+ * Saves the quantizer in binary form: a header, the words as null terminated strings, the codebooks and the codes.
+ * The full vectors are not needed to load and search the quantizer.
+ * @param product_quantizer Current product quantizer
+ * @param file_name Name of the quantizer file.
+ * @return True if the quantizer is saved, false if the file could not be written.
+ */
+bool save_product_quantizer(const Product_quantizer* product_quantizer, const char* file_name) {
+    FILE* output = fopen(file_name, "wb");
+    if (output == NULL){
+        return false;
+    }
+    Product_quantizer_file_header header;
+    header.magic = PRODUCT_QUANTIZER_FILE_MAGIC;
+    header.word_count = product_quantizer->word_count;
+    header.vector_length = product_quantizer->vector_length;
+    header.subspace_count = product_quantizer->subspace_count;
+    header.centroid_count = product_quantizer->centroid_count;
+    bool written = fwrite(&header, sizeof(Product_quantizer_file_header), 1, output) == 1;
+    for (int i = 0; i < product_quantizer->word_count && written; i++){
+        size_t length = strlen(product_quantizer->words[i]) + 1;
+        written = fwrite(product_quantizer->words[i], 1, length, output) == length;
+    }
+    size_t centroid_size = (size_t) product_quantizer->subspace_count * product_quantizer->centroid_count * product_quantizer->subspace_length;
+    size_t code_size = (size_t) (product_quantizer->word_count + PQ_BLOCK_ROWS - 1) / PQ_BLOCK_ROWS * PQ_BLOCK_ROWS * product_quantizer->subspace_count;
+    written = written && fwrite(product_quantizer->centroids, sizeof(float), centroid_size, output) == centroid_size &&
+              fwrite(product_quantizer->codes, sizeof(unsigned char), code_size, output) == code_size;
+    return fclose(output) == 0 && written;
+}
+
+/**
+ * Returns the row of a word in the quantizer.
+ * @param product_quantizer Current product quantizer
+ * @param word Word to be searched.
+ * @return Row of the word, -1 if the word does not exist in the quantizer.
+ */
+int product_quantizer_index(const Product_quantizer* product_quantizer, const char* word) {
+    int* position = hash_map_get(product_quantizer->word_map, word);
+    if (position == NULL){
+        return -1;
+    }
+    return *position;
+}
+
+/**
+ * Reconstructs the normalized vector of a row from its codes.
+ * @param product_quantizer Current product quantizer
+ * @param row Row to decode.
+ * @param output Output vector of vector_length floats.
+ */
+void decode_product_quantizer_row(const Product_quantizer* product_quantizer, int row, float* output) {
+    int length = product_quantizer->subspace_length;
+    for (int m = 0; m < product_quantizer->subspace_count; m++){
+        const float* centroid = product_quantizer->centroids + ((size_t) m * product_quantizer->centroid_count + *code_of(product_quantizer, row, m)) * length;
+        memcpy(output + m * length, centroid, length * sizeof(float));
+    }
+}
+
+/**
+ * Reconstructs all rows of the quantizer into an embedding model, for example to evaluate the quantization with
+ * the functions working on models.
+ * @param product_quantizer Current product quantizer
+ * @return Embedding model holding the reconstructed vectors.
+ */
+Embedding_model_ptr decode_product_quantizer(const Product_quantizer* product_quantizer) {
+    Embedding_model_ptr result = create_embedding_model3(product_quantizer->word_count, product_quantizer->vector_length);
+    for (int i = 0; i < product_quantizer->word_count; i++){
+        embedding_model_set_word(result, i, product_quantizer->words[i]);
+        decode_product_quantizer_row(product_quantizer, i, result->vectors + (size_t) i * product_quantizer->vector_length);
+    }
+    return result;
+}
+
+/**
+ * Scans the code blocks start to end for all queries of the task with asymmetric distances: the score of a row is
+ * the sum of the lookup table entries selected by its codes. Inside a block the codes of a subspace are
+ * contiguous, so the loop over the rows of a block reads consecutive bytes and a single table of
+ * centroid_count floats that stays in the first level cache; the compiler vectorizes it into table gathers where
+ * the target has them. Each query keeps its best candidate_count rows in its own heap.
+ * @param argument Scan task.
+ * @return NULL
+ */
+static void* run_scan_task(void* argument) {
+    Scan_task* task = argument;
+    const Product_quantizer* product_quantizer = task->product_quantizer;
+    int subspace_count = product_quantizer->subspace_count;
+    int centroid_count = product_quantizer->centroid_count;
+    int sizes[task->query_count];
+    float sums[PQ_BLOCK_ROWS];
+    for (int q = 0; q < task->query_count; q++){
+        sizes[q] = 0;
+    }
+    for (int block = task->start; block < task->end; block++){
+        int row_count = product_quantizer->word_count - block * PQ_BLOCK_ROWS < PQ_BLOCK_ROWS ? product_quantizer->word_count - block * PQ_BLOCK_ROWS : PQ_BLOCK_ROWS;
+        const unsigned char* block_codes = product_quantizer->codes + (size_t) block * subspace_count * PQ_BLOCK_ROWS;
+        for (int q = 0; q < task->query_count; q++){
+            const float* tables = task->tables + (size_t) q * subspace_count * centroid_count;
+            for (int r = 0; r < PQ_BLOCK_ROWS; r++){
+                sums[r] = 0;
+            }
+            for (int m = 0; m < subspace_count; m++){
+                const float* table = tables + (size_t) m * centroid_count;
+                const unsigned char* codes = block_codes + m * PQ_BLOCK_ROWS;
+                for (int r = 0; r < PQ_BLOCK_ROWS; r++){
+                    sums[r] += table[codes[r]];
+                }
+            }
+            float* heap_scores = task->heap_scores + (size_t) q * task->candidate_count;
+            int* heap_indices = task->heap_indices + (size_t) q * task->candidate_count;
+            for (int r = 0; r < row_count; r++){
+                push_neighbor(heap_scores, heap_indices, &sizes[q], task->candidate_count, sums[r], block * PQ_BLOCK_ROWS + r);
+            }
+        }
+    }
+    for (int q = 0; q < task->query_count; q++){
+        for (int i = sizes[q]; i < task->candidate_count; i++){
+            task->heap_scores[(size_t) q * task->candidate_count + i] = -INFINITY;
+            task->heap_indices[(size_t) q * task->candidate_count + i] = -1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Finds the k rows with the highest approximate cosine similarity to each query of a batch. For every query, a
+ * lookup table holds the inner products of each subspace of the normalized query with all centroids of that
+ * subspace, and the code blocks are split over the threads and scanned with these tables. If a rerank model is
+ * given, the best rerank_count candidates of each query are rescored with the exact cosine similarity against the
+ * full vectors of the model before the k best are selected. All buffers are allocated by the calling thread.
+ * @param product_quantizer Current product quantizer
+ * @param queries Query vectors, query_count x vector_length.
+ * @param query_count Number of queries.
+ * @param k Number of neighbors per query.
+ * @param rerank_model Model with the full vectors of the quantized rows, NULL to return the approximate scores.
+ * @param rerank_count Number of candidates rescored per query if a rerank model is given.
+ * @param indices Output rows, query_count x k, best first, -1 if there are fewer than k rows.
+ * @param scores Output similarities, query_count x k.
+ */
+void search_product_quantizer(const Product_quantizer* product_quantizer,
+                              const float* queries,
+                              int query_count,
+                              int k,
+                              const Embedding_model* rerank_model,
+                              int rerank_count,
+                              int* indices,
+                              float* scores) {
+    int vector_length = product_quantizer->vector_length;
+    int subspace_count = product_quantizer->subspace_count;
+    int centroid_count = product_quantizer->centroid_count;
+    int length = product_quantizer->subspace_length;
+    int candidate_count = rerank_model != NULL && rerank_count > k ? rerank_count : k;
+    int block_count = (product_quantizer->word_count + PQ_BLOCK_ROWS - 1) / PQ_BLOCK_ROWS;
+    int thread_count = product_quantizer->thread_count < block_count ? product_quantizer->thread_count : block_count;
+    if (thread_count < 1){
+        thread_count = 1;
+    }
+    float* normalized = malloc_((size_t) query_count * vector_length * sizeof(float));
+    float* tables = malloc_((size_t) query_count * subspace_count * centroid_count * sizeof(float));
+    for (int q = 0; q < query_count; q++){
+        const float* query = queries + (size_t) q * vector_length;
+        float* unit = normalized + (size_t) q * vector_length;
+        double norm = 0;
+        for (int j = 0; j < vector_length; j++){
+            norm += query[j] * query[j];
+        }
+        float scale = norm > 0 ? (float) (1 / sqrt(norm)) : 0;
+        for (int j = 0; j < vector_length; j++){
+            unit[j] = query[j] * scale;
+        }
+        for (int m = 0; m < subspace_count; m++){
+            float* table = tables + ((size_t) q * subspace_count + m) * centroid_count;
+            const float* centroids = product_quantizer->centroids + (size_t) m * centroid_count * length;
+            for (int c = 0; c < centroid_count; c++){
+                float dot = 0;
+                for (int d = 0; d < length; d++){
+                    dot += unit[m * length + d] * centroids[c * length + d];
+                }
+                table[c] = dot;
+            }
+        }
+    }
+    float* heap_scores = malloc_((size_t) thread_count * query_count * candidate_count * sizeof(float));
+    int* heap_indices = malloc_((size_t) thread_count * query_count * candidate_count * sizeof(int));
+    float* candidate_scores = malloc_((size_t) candidate_count * sizeof(float));
+    int* candidate_indices = malloc_((size_t) candidate_count * sizeof(int));
+    Scan_task tasks[thread_count];
+    pthread_t threads[thread_count];
+    for (int i = 0; i < thread_count; i++){
+        tasks[i].product_quantizer = product_quantizer;
+        tasks[i].tables = tables;
+        tasks[i].query_count = query_count;
+        tasks[i].candidate_count = candidate_count;
+        tasks[i].start = (int) ((long long) block_count * i / thread_count);
+        tasks[i].end = (int) ((long long) block_count * (i + 1) / thread_count);
+        tasks[i].heap_scores = heap_scores + (size_t) i * query_count * candidate_count;
+        tasks[i].heap_indices = heap_indices + (size_t) i * query_count * candidate_count;
+    }
+    bool started[thread_count];
+    for (int i = 1; i < thread_count; i++){
+        started[i] = pthread_create(&threads[i], NULL, run_scan_task, &tasks[i]) == 0;
+    }
+    run_scan_task(&tasks[0]);
+    for (int i = 1; i < thread_count; i++){
+        if (started[i]){
+            pthread_join(threads[i], NULL);
+        } else {
+            run_scan_task(&tasks[i]);
+        }
+    }
+    for (int q = 0; q < query_count; q++){
+        int size = 0;
+        for (int i = 0; i < thread_count; i++){
+            for (int j = 0; j < candidate_count; j++){
+                int index = tasks[i].heap_indices[(size_t) q * candidate_count + j];
+                if (index != -1){
+                    push_neighbor(candidate_scores, candidate_indices, &size, candidate_count, tasks[i].heap_scores[(size_t) q * candidate_count + j], index);
+                }
+            }
+        }
+        float* best_scores = scores + (size_t) q * k;
+        int* best_indices = indices + (size_t) q * k;
+        int best_size = 0;
+        for (int i = 0; i < size; i++){
+            float score = candidate_scores[i];
+            if (rerank_model != NULL){
+                const float* row = embedding_model_vector(rerank_model, candidate_indices[i]);
+                const float* unit = normalized + (size_t) q * vector_length;
+                double dot = 0, norm = 0;
+                for (int j = 0; j < vector_length; j++){
+                    dot += unit[j] * row[j];
+                    norm += row[j] * row[j];
+                }
+                score = norm > 0 ? (float) (dot / sqrt(norm)) : 0;
+            }
+            push_neighbor(best_scores, best_indices, &best_size, k, score, candidate_indices[i]);
+        }
+        sort_neighbors(best_scores, best_indices, best_size, k);
+    }
+    free_(normalized);
+    free_(tables);
+    free_(heap_scores);
+    free_(heap_indices);
+    free_(candidate_scores);
+    free_(candidate_indices);
+}
+
+/**
+ * Measures the recall of the quantizer: for query_count rows spread evenly over the model of the exact index, the
+ * k nearest neighbors found by the quantizer are compared with the exact k nearest neighbors.
+ * @param product_quantizer Current product quantizer
+ * @param nearest_neighbors Exact index of the model the quantizer is trained on.
+ * @param query_count Number of query rows.
+ * @param k Number of neighbors per query.
+ * @param rerank_count Number of candidates reranked with the full vectors, 0 for no reranking.
+ * @return Mean fraction of the exact neighbors found by the quantizer.
+ */
+double product_quantizer_recall(const Product_quantizer* product_quantizer,
+                                const Nearest_neighbors* nearest_neighbors,
+                                int query_count,
+                                int k,
+                                int rerank_count) {
+    const Embedding_model* embedding_model = nearest_neighbors->embedding_model;
+    int vector_length = embedding_model->vector_length;
+    float* queries = malloc_((size_t) query_count * vector_length * sizeof(float));
+    int* exact_indices = malloc_((size_t) query_count * k * sizeof(int));
+    float* exact_scores = malloc_((size_t) query_count * k * sizeof(float));
+    int* approximate_indices = malloc_((size_t) query_count * k * sizeof(int));
+    float* approximate_scores = malloc_((size_t) query_count * k * sizeof(float));
+    long long found = 0, total = 0;
+    for (int q = 0; q < query_count; q++){
+        int row = (int) ((long long) embedding_model->word_count * q / query_count);
+        memcpy(queries + (size_t) q * vector_length, embedding_model_vector(embedding_model, row), vector_length * sizeof(float));
+    }
+    search_nearest_neighbors(nearest_neighbors, queries, query_count, k, exact_indices, exact_scores);
+    search_product_quantizer(product_quantizer, queries, query_count, k, rerank_count > 0 ? embedding_model : NULL, rerank_count, approximate_indices, approximate_scores);
+    for (int q = 0; q < query_count; q++){
+        for (int i = 0; i < k; i++){
+            int exact = exact_indices[(size_t) q * k + i];
+            if (exact == -1){
+                continue;
+            }
+            total++;
+            for (int j = 0; j < k; j++){
+                if (approximate_indices[(size_t) q * k + j] == exact){
+                    found++;
+                    break;
+                }
+            }
+        }
+    }
+    free_(queries);
+    free_(exact_indices);
+    free_(exact_scores);
+    free_(approximate_indices);
+    free_(approximate_scores);
+    return total > 0 ? found / (double) total : 0;
+}
+
+/**
+ * Measures how much of the quality of a model on a semantic dataset is retained by the quantizer, comparing the
+ * similarities of the reconstructed vectors with those of the original vectors.
+ * @param product_quantizer Current product quantizer
+ * @param semantic_data_set Semantic dataset.
+ * @param original Model the quantizer is trained on.
+ * @return Spearman correlation of the quantized model divided by the Spearman correlation of the original model.
+ */
+double product_quantizer_retention(const Product_quantizer* product_quantizer,
+                                   Semantic_data_set_ptr semantic_data_set,
+                                   const Embedding_model* original) {
+    Embedding_model_ptr decoded = decode_product_quantizer(product_quantizer);
+    double result = spearman_retention(semantic_data_set, original, decoded);
+    free_embedding_model(decoded);
+    return result;
+}
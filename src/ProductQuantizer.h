@@ -0,0 +1,70 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_PRODUCTQUANTIZER_H
+#define WORDTOVEC_PRODUCTQUANTIZER_H
+
+#include <HashMap/HashMap.h>
+#include "EmbeddingModel.h"
+#include "NearestNeighbors.h"
+#include "SemanticDataSet.h"
+#include "DimensionReduction.h"
+
+static int PRODUCT_QUANTIZER_FILE_MAGIC = 0x50563257;
+static int PQ_CENTROID_COUNT = 256;
+static int PQ_KMEANS_ITERATIONS = 16;
+static int PQ_TRAINING_SAMPLE = 32768;
+static int PQ_BLOCK_ROWS = 32;
+
+struct product_quantizer{
+    int word_count;
+    int vector_length;
+    int subspace_count;
+    int subspace_length;
+    int centroid_count;
+    float* centroids;
+    unsigned char* codes;
+    char** words;
+    Hash_map_ptr word_map;
+    int thread_count;
+};
+
+typedef struct product_quantizer Product_quantizer;
+
+typedef Product_quantizer *Product_quantizer_ptr;
+
+Product_quantizer_ptr create_product_quantizer(const Embedding_model* embedding_model, int subspace_count, unsigned long long seed);
+
+Product_quantizer_ptr create_product_quantizer2(const char* file_name);
+
+void free_product_quantizer(Product_quantizer_ptr product_quantizer);
+
+bool save_product_quantizer(const Product_quantizer* product_quantizer, const char* file_name);
+
+int product_quantizer_index(const Product_quantizer* product_quantizer, const char* word);
+
+void decode_product_quantizer_row(const Product_quantizer* product_quantizer, int row, float* output);
+
+Embedding_model_ptr decode_product_quantizer(const Product_quantizer* product_quantizer);
+
+void search_product_quantizer(const Product_quantizer* product_quantizer,
+                              const float* queries,
+                              int query_count,
+                              int k,
+                              const Embedding_model* rerank_model,
+                              int rerank_count,
+                              int* indices,
+                              float* scores);
+
+double product_quantizer_recall(const Product_quantizer* product_quantizer,
+                                const Nearest_neighbors* nearest_neighbors,
+                                int query_count,
+                                int k,
+                                int rerank_count);
+
+double product_quantizer_retention(const Product_quantizer* product_quantizer,
+                                   Semantic_data_set_ptr semantic_data_set,
+                                   const Embedding_model* original);
+
+#endif //WORDTOVEC_PRODUCTQUANTIZER_H
@@ -0,0 +1,545 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <Memory/Memory.h>
+#include "QueryServer.h"
+
+static const char* QUERY_TYPE_NAMES[QUERY_TYPE_COUNT] = {"vector", "similarity", "topk"};
+
+/**
+ * Returns the current value of the monotonic clock in seconds.
+ * @return Current time in seconds.
+ */
+static double monotonic_seconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**
+ * Adds a latency to a histogram. Bucket b counts the latencies in [2^b - 1, 2^(b + 1) - 1) microseconds, so that
+ * the histogram covers microseconds to hours with a fixed number of counters updated without locking.
+ * @param histogram Histogram to update.
+ * @param microseconds Latency of the request.
+ */
+static void record_latency(Latency_histogram* histogram, long long microseconds) {
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKET_COUNT - 1 && (microseconds + 1) >> (bucket + 1) > 0){
+        bucket++;
+    }
+    atomic_fetch_add(&histogram->buckets[bucket], 1);
+    atomic_fetch_add(&histogram->count, 1);
+    atomic_fetch_add(&histogram->total_microseconds, microseconds);
+}
+
+/**
+ * Returns the upper bound of the bucket holding the given quantile of a histogram.
+ * @param histogram Histogram to read.
+ * @param quantile Quantile between 0 and 1.
+ * @return Upper bound of the latency quantile in microseconds, 0 if the histogram is empty.
+ */
+static long long latency_quantile(Latency_histogram* histogram, double quantile) {
+    long long count = atomic_load(&histogram->count);
+    long long sum = 0;
+    if (count == 0){
+        return 0;
+    }
+    for (int i = 0; i < LATENCY_BUCKET_COUNT; i++){
+        sum += atomic_load(&histogram->buckets[i]);
+        if (sum >= quantile * count){
+            return (1LL << (i + 1)) - 1;
+        }
+    }
+    return (1LL << LATENCY_BUCKET_COUNT) - 1;
+}
+
+/**
+ * Constructor for the query server. The server answers vector, similarity and top-k requests on the rows of an
+ * embedding model, over a Unix domain socket if a path is given, otherwise over TCP on the loopback address. All
+ * buffers of the batcher are allocated here, the connection threads work on their stacks only.
+ * @param embedding_model Model to serve, not owned by the server.
+ * @param socket_path Path of the Unix domain socket, NULL to listen on TCP.
+ * @param port TCP port on 127.0.0.1, used if socket_path is NULL.
+ * @return Query server, not yet listening.
+ */
+Query_server_ptr create_query_server(const Embedding_model* embedding_model, const char* socket_path, int port) {
+    Query_server_ptr result = malloc_(sizeof(Query_server));
+    result->embedding_model = embedding_model;
+    result->nearest_neighbors = create_nearest_neighbors(embedding_model);
+    result->socket_path = socket_path;
+    result->port = port;
+    result->descriptor = -1;
+    atomic_init(&result->stopping, false);
+    result->connections = calloc_(QUERY_MAX_CONNECTIONS, sizeof(Query_connection));
+    for (int i = 0; i < QUERY_MAX_CONNECTIONS; i++){
+        result->connections[i].query_server = result;
+        result->connections[i].descriptor = -1;
+        result->connections[i].started = false;
+        atomic_init(&result->connections[i].active, false);
+    }
+    pthread_mutex_init(&result->mutex, NULL);
+    pthread_cond_init(&result->request_condition, NULL);
+    pthread_cond_init(&result->done_condition, NULL);
+    result->pending = malloc_(QUERY_MAX_CONNECTIONS * sizeof(Top_k_request*));
+    result->pending_count = 0;
+    result->batch_queries = malloc_((size_t) QUERY_BATCH_SIZE * embedding_model->vector_length * sizeof(float));
+    result->batch_indices = malloc_((size_t) QUERY_BATCH_SIZE * (QUERY_MAX_K + 1) * sizeof(int));
+    result->batch_scores = malloc_((size_t) QUERY_BATCH_SIZE * (QUERY_MAX_K + 1) * sizeof(float));
+    for (int i = 0; i < QUERY_TYPE_COUNT; i++){
+        for (int j = 0; j < LATENCY_BUCKET_COUNT; j++){
+            atomic_init(&result->histograms[i].buckets[j], 0);
+        }
+        atomic_init(&result->histograms[i].count, 0);
+        atomic_init(&result->histograms[i].total_microseconds, 0);
+    }
+    atomic_init(&result->batch_count, 0);
+    atomic_init(&result->batched_request_count, 0);
+    result->start_time = monotonic_seconds();
+    return result;
+}
+
+/**
+ * Frees memory allocated for the query server. The server must be stopped before. The model is not freed.
+ * @param query_server Query server to deallocate.
+ */
+void free_query_server(Query_server_ptr query_server) {
+    free_nearest_neighbors(query_server->nearest_neighbors);
+    free_(query_server->connections);
+    pthread_mutex_destroy(&query_server->mutex);
+    pthread_cond_destroy(&query_server->request_condition);
+    pthread_cond_destroy(&query_server->done_condition);
+    free_(query_server->pending);
+    free_(query_server->batch_queries);
+    free_(query_server->batch_indices);
+    free_(query_server->batch_scores);
+    free_(query_server);
+}
+
+/**
+ * Queues a top-k request for the batcher and waits until it is answered.
+ * @param query_server Current query server
+ * @param request Request living on the stack of the connection thread.
+ * @return False if the server is stopping and the request is not accepted.
+ */
+static bool submit_top_k_request(Query_server_ptr query_server, Top_k_request* request) {
+    pthread_mutex_lock(&query_server->mutex);
+    if (atomic_load(&query_server->stopping)){
+        pthread_mutex_unlock(&query_server->mutex);
+        return false;
+    }
+    request->done = false;
+    query_server->pending[query_server->pending_count] = request;
+    query_server->pending_count++;
+    pthread_cond_signal(&query_server->request_condition);
+    while (!request->done){
+        pthread_cond_wait(&query_server->done_condition, &query_server->mutex);
+    }
+    pthread_mutex_unlock(&query_server->mutex);
+    return true;
+}
+
+/**
+ * Body of the batcher thread. Top-k requests arriving at about the same time from different connections are
+ * coalesced: once a request is waiting, the batcher waits at most QUERY_BATCH_DELAY microseconds for the batch to
+ * fill up to QUERY_BATCH_SIZE requests, then scores all of them in one pass over the model. The thread exits when
+ * the server is stopping and no request is waiting.
+ * @param argument Query server.
+ * @return NULL
+ */
+static void* run_batcher(void* argument) {
+    Query_server_ptr query_server = argument;
+    Top_k_request* batch[QUERY_BATCH_SIZE];
+    int vector_length = query_server->embedding_model->vector_length;
+    pthread_mutex_lock(&query_server->mutex);
+    while (true){
+        while (query_server->pending_count == 0 && !atomic_load(&query_server->stopping)){
+            pthread_cond_wait(&query_server->request_condition, &query_server->mutex);
+        }
+        if (query_server->pending_count == 0){
+            break;
+        }
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += QUERY_BATCH_DELAY * 1000L;
+        if (deadline.tv_nsec >= 1000000000L){
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (query_server->pending_count < QUERY_BATCH_SIZE && !atomic_load(&query_server->stopping)){
+            if (pthread_cond_timedwait(&query_server->request_condition, &query_server->mutex, &deadline) == ETIMEDOUT){
+                break;
+            }
+        }
+        int count = query_server->pending_count < QUERY_BATCH_SIZE ? query_server->pending_count : QUERY_BATCH_SIZE;
+        memcpy(batch, query_server->pending, count * sizeof(Top_k_request*));
+        memmove(query_server->pending, query_server->pending + count, (query_server->pending_count - count) * sizeof(Top_k_request*));
+        query_server->pending_count -= count;
+        pthread_mutex_unlock(&query_server->mutex);
+        int k = 0;
+        for (int i = 0; i < count; i++){
+            memcpy(query_server->batch_queries + (size_t) i * vector_length, batch[i]->query, vector_length * sizeof(float));
+            if (batch[i]->k > k){
+                k = batch[i]->k;
+            }
+        }
+        search_nearest_neighbors(query_server->nearest_neighbors, query_server->batch_queries, count, k, query_server->batch_indices, query_server->batch_scores);
+        for (int i = 0; i < count; i++){
+            memcpy(batch[i]->indices, query_server->batch_indices + (size_t) i * k, batch[i]->k * sizeof(int));
+            memcpy(batch[i]->scores, query_server->batch_scores + (size_t) i * k, batch[i]->k * sizeof(float));
+        }
+        atomic_fetch_add(&query_server->batch_count, 1);
+        atomic_fetch_add(&query_server->batched_request_count, count);
+        pthread_mutex_lock(&query_server->mutex);
+        for (int i = 0; i < count; i++){
+            batch[i]->done = true;
+        }
+        pthread_cond_broadcast(&query_server->done_condition);
+    }
+    pthread_mutex_unlock(&query_server->mutex);
+    return NULL;
+}
+
+/**
+ * Writes the statistics of the server as key=value pairs: uptime, number and mean size of the batches, and for
+ * every request type the count, QPS, mean, median and 99th percentile latency in microseconds and the bucket
+ * counts of the latency histogram.
+ * @param query_server Current query server
+ * @param output Output buffer.
+ * @param size Size of the output buffer.
+ * @return Number of characters written.
+ */
+int query_server_statistics(Query_server_ptr query_server, char* output, int size) {
+    double uptime = monotonic_seconds() - query_server->start_time;
+    long long batch_count = atomic_load(&query_server->batch_count);
+    long long batched_request_count = atomic_load(&query_server->batched_request_count);
+    int length = snprintf(output, size, "uptime=%.3f batches=%lld mean_batch=%.2f", uptime, batch_count,
+                          batch_count > 0 ? batched_request_count / (double) batch_count : 0.0);
+    for (int i = 0; i < QUERY_TYPE_COUNT && length < size; i++){
+        Latency_histogram* histogram = &query_server->histograms[i];
+        long long count = atomic_load(&histogram->count);
+        long long total = atomic_load(&histogram->total_microseconds);
+        length += snprintf(output + length, size - length, " %s_count=%lld %s_qps=%.1f %s_mean_us=%.1f %s_p50_us=%lld %s_p99_us=%lld %s_buckets=",
+                           QUERY_TYPE_NAMES[i], count,
+                           QUERY_TYPE_NAMES[i], uptime > 0 ? count / uptime : 0.0,
+                           QUERY_TYPE_NAMES[i], count > 0 ? total / (double) count : 0.0,
+                           QUERY_TYPE_NAMES[i], latency_quantile(histogram, 0.5),
+                           QUERY_TYPE_NAMES[i], latency_quantile(histogram, 0.99),
+                           QUERY_TYPE_NAMES[i]);
+        for (int j = 0; j < LATENCY_BUCKET_COUNT && length < size; j++){
+            length += snprintf(output + length, size - length, j == 0 ? "%lld" : ",%lld", atomic_load(&histogram->buckets[j]));
+        }
+    }
+    return length < size ? length : size - 1;
+}
+
+/**
+ * Answers one request line. The response is a single line starting with OK or ERR.
+ * @param query_server Current query server
+ * @param line Request line without the newline, modified by the tokenizer.
+ * @param response Response buffer of QUERY_BUFFER_SIZE characters.
+ * @return Length of the response, -1 if the connection should be closed.
+ */
+static int answer_request(Query_server_ptr query_server, char* line, char* response) {
+    const Embedding_model* embedding_model = query_server->embedding_model;
+    char* rest;
+    char* command = strtok_r(line, " \t\r", &rest);
+    char* argument1 = strtok_r(NULL, " \t\r", &rest);
+    char* argument2 = strtok_r(NULL, " \t\r", &rest);
+    double start = monotonic_seconds();
+    int length;
+    Query_type type;
+    if (command == NULL){
+        return snprintf(response, QUERY_BUFFER_SIZE, "ERR empty request\n");
+    }
+    if (strcmp(command, "QUIT") == 0){
+        return -1;
+    }
+    if (strcmp(command, "STATS") == 0){
+        length = snprintf(response, QUERY_BUFFER_SIZE, "OK ");
+        length += query_server_statistics(query_server, response + length, QUERY_BUFFER_SIZE - length - 1);
+        response[length++] = '\n';
+        return length;
+    }
+    if (strcmp(command, "VECTOR") == 0 && argument1 != NULL){
+        int index = embedding_model_index(embedding_model, argument1);
+        if (index == -1){
+            return snprintf(response, QUERY_BUFFER_SIZE, "ERR unknown word %s\n", argument1);
+        }
+        const float* vector = embedding_model_vector(embedding_model, index);
+        length = snprintf(response, QUERY_BUFFER_SIZE, "OK");
+        for (int i = 0; i < embedding_model->vector_length && length < QUERY_BUFFER_SIZE - 1; i++){
+            length += snprintf(response + length, QUERY_BUFFER_SIZE - 1 - length, " %.6g", vector[i]);
+        }
+        type = VECTOR_QUERY;
+    } else {
+        if (strcmp(command, "SIMILARITY") == 0 && argument2 != NULL){
+            int index1 = embedding_model_index(embedding_model, argument1);
+            int index2 = embedding_model_index(embedding_model, argument2);
+            if (index1 == -1 || index2 == -1){
+                return snprintf(response, QUERY_BUFFER_SIZE, "ERR unknown word %s\n", index1 == -1 ? argument1 : argument2);
+            }
+            length = snprintf(response, QUERY_BUFFER_SIZE, "OK %.6g", cosine_similarity_of_rows(query_server->nearest_neighbors, index1, index2));
+            type = SIMILARITY_QUERY;
+        } else {
+            if (strcmp(command, "TOPK") == 0 && argument2 != NULL){
+                int k = atoi(argument1);
+                int index = embedding_model_index(embedding_model, argument2);
+                if (k < 1 || k > QUERY_MAX_K){
+                    return snprintf(response, QUERY_BUFFER_SIZE, "ERR k must be between 1 and %d\n", QUERY_MAX_K);
+                }
+                if (index == -1){
+                    return snprintf(response, QUERY_BUFFER_SIZE, "ERR unknown word %s\n", argument2);
+                }
+                int indices[QUERY_MAX_K + 1];
+                float scores[QUERY_MAX_K + 1];
+                Top_k_request request = {embedding_model_vector(embedding_model, index), k + 1, indices, scores, false};
+                if (!submit_top_k_request(query_server, &request)){
+                    return snprintf(response, QUERY_BUFFER_SIZE, "ERR server is stopping\n");
+                }
+                length = snprintf(response, QUERY_BUFFER_SIZE, "OK");
+                for (int i = 0, found = 0; i <= k && found < k && length < QUERY_BUFFER_SIZE - 1; i++){
+                    if (indices[i] != -1 && indices[i] != index){
+                        length += snprintf(response + length, QUERY_BUFFER_SIZE - 1 - length, " %s %.6g", embedding_model->words[indices[i]], scores[i]);
+                        found++;
+                    }
+                }
+                type = TOP_K_QUERY;
+            } else {
+                return snprintf(response, QUERY_BUFFER_SIZE, "ERR unknown request %s\n", command);
+            }
+        }
+    }
+    if (length > QUERY_BUFFER_SIZE - 2){
+        length = QUERY_BUFFER_SIZE - 2;
+    }
+    response[length++] = '\n';
+    record_latency(&query_server->histograms[type], (long long) ((monotonic_seconds() - start) * 1e6));
+    return length;
+}
+
+/**
+ * Writes a whole buffer to a socket.
+ * @param descriptor Socket descriptor.
+ * @param buffer Buffer to write.
+ * @param length Number of bytes to write.
+ * @return False if the peer closed the connection.
+ */
+static bool write_fully(int descriptor, const char* buffer, int length) {
+    while (length > 0){
+        ssize_t written = send(descriptor, buffer, length, MSG_NOSIGNAL);
+        if (written <= 0){
+            if (written < 0 && errno == EINTR){
+                continue;
+            }
+            return false;
+        }
+        buffer += written;
+        length -= (int) written;
+    }
+    return true;
+}
+
+/**
+ * Body of a connection thread. Reads newline separated requests and answers them in order until the peer closes
+ * the connection, sends QUIT, or the server shuts the socket down. The descriptor is closed by the server when the
+ * slot is reused or the server stops.
+ * @param argument Connection slot.
+ * @return NULL
+ */
+static void* run_connection(void* argument) {
+    Query_connection* connection = argument;
+    char buffer[QUERY_BUFFER_SIZE];
+    char response[QUERY_BUFFER_SIZE];
+    int length = 0;
+    bool open = true;
+    while (open){
+        ssize_t received = recv(connection->descriptor, buffer + length, QUERY_BUFFER_SIZE - 1 - length, 0);
+        if (received <= 0){
+            if (received < 0 && errno == EINTR){
+                continue;
+            }
+            break;
+        }
+        length += (int) received;
+        int start = 0;
+        char* newline;
+        buffer[length] = '\0';
+        while (open && (newline = memchr(buffer + start, '\n', length - start)) != NULL){
+            *newline = '\0';
+            int response_length = answer_request(connection->query_server, buffer + start, response);
+            if (response_length < 0 || !write_fully(connection->descriptor, response, response_length)){
+                open = false;
+            }
+            start = (int) (newline - buffer) + 1;
+        }
+        memmove(buffer, buffer + start, length - start);
+        length -= start;
+        if (length == QUERY_BUFFER_SIZE - 1){
+            const char* error = "ERR request too long\n";
+            write_fully(connection->descriptor, error, (int) strlen(error));
+            open = false;
+        }
+    }
+    atomic_store(&connection->active, false);
+    return NULL;
+}
+
+/**
+ * Body of the acceptor thread. Every accepted connection is served by its own thread in a free slot; if all
+ * QUERY_MAX_CONNECTIONS slots are busy, the connection is refused with an error line.
+ * @param argument Query server.
+ * @return NULL
+ */
+static void* run_acceptor(void* argument) {
+    Query_server_ptr query_server = argument;
+    while (!atomic_load(&query_server->stopping)){
+        int descriptor = accept(query_server->descriptor, NULL, NULL);
+        if (descriptor < 0){
+            if (errno == EINTR || errno == ECONNABORTED){
+                continue;
+            }
+            break;
+        }
+        if (atomic_load(&query_server->stopping)){
+            close(descriptor);
+            break;
+        }
+        Query_connection* connection = NULL;
+        for (int i = 0; i < QUERY_MAX_CONNECTIONS && connection == NULL; i++){
+            if (!atomic_load(&query_server->connections[i].active)){
+                connection = &query_server->connections[i];
+            }
+        }
+        if (connection == NULL){
+            const char* error = "ERR too many connections\n";
+            write_fully(descriptor, error, (int) strlen(error));
+            close(descriptor);
+            continue;
+        }
+        if (connection->started){
+            pthread_join(connection->thread, NULL);
+            close(connection->descriptor);
+        }
+        connection->descriptor = descriptor;
+        atomic_store(&connection->active, true);
+        connection->started = pthread_create(&connection->thread, NULL, run_connection, connection) == 0;
+        if (!connection->started){
+            atomic_store(&connection->active, false);
+            close(descriptor);
+            connection->descriptor = -1;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Closes the listening socket of a server whose threads could not be started, and removes its socket file.
+ * @param query_server Current query server
+ */
+static void close_listening_socket(Query_server_ptr query_server) {
+    close(query_server->descriptor);
+    if (query_server->socket_path != NULL){
+        unlink(query_server->socket_path);
+    }
+}
+
+/**
+ * Opens the listening socket of the server and starts the batcher and acceptor threads.
+ * @param query_server Current query server
+ * @return False if the socket could not be bound or a thread could not be started; the server is then not
+ * started and must not be stopped.
+ */
+bool start_query_server(Query_server_ptr query_server) {
+    if (query_server->socket_path != NULL){
+        struct sockaddr_un address;
+        if (strlen(query_server->socket_path) >= sizeof(address.sun_path)){
+            return false;
+        }
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strcpy(address.sun_path, query_server->socket_path);
+        unlink(query_server->socket_path);
+        query_server->descriptor = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (query_server->descriptor < 0 || bind(query_server->descriptor, (struct sockaddr*) &address, sizeof(address)) < 0){
+            if (query_server->descriptor >= 0){
+                close(query_server->descriptor);
+            }
+            return false;
+        }
+    } else {
+        struct sockaddr_in address;
+        int reuse = 1;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(query_server->port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        query_server->descriptor = socket(AF_INET, SOCK_STREAM, 0);
+        if (query_server->descriptor >= 0){
+            setsockopt(query_server->descriptor, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        }
+        if (query_server->descriptor < 0 || bind(query_server->descriptor, (struct sockaddr*) &address, sizeof(address)) < 0){
+            if (query_server->descriptor >= 0){
+                close(query_server->descriptor);
+            }
+            return false;
+        }
+    }
+    if (listen(query_server->descriptor, QUERY_MAX_CONNECTIONS) < 0){
+        close(query_server->descriptor);
+        return false;
+    }
+    query_server->start_time = monotonic_seconds();
+    if (pthread_create(&query_server->batcher, NULL, run_batcher, query_server) != 0){
+        close_listening_socket(query_server);
+        return false;
+    }
+    if (pthread_create(&query_server->acceptor, NULL, run_acceptor, query_server) != 0){
+        pthread_mutex_lock(&query_server->mutex);
+        atomic_store(&query_server->stopping, true);
+        pthread_cond_broadcast(&query_server->request_condition);
+        pthread_mutex_unlock(&query_server->mutex);
+        pthread_join(query_server->batcher, NULL);
+        close_listening_socket(query_server);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Stops a started server. The listening socket and the open connections are shut down so that the blocked
+ * threads wake up; requests already queued are still answered before the batcher exits.
+ * @param query_server Current query server
+ */
+void stop_query_server(Query_server_ptr query_server) {
+    pthread_mutex_lock(&query_server->mutex);
+    atomic_store(&query_server->stopping, true);
+    pthread_cond_broadcast(&query_server->request_condition);
+    pthread_mutex_unlock(&query_server->mutex);
+    shutdown(query_server->descriptor, SHUT_RDWR);
+    pthread_join(query_server->acceptor, NULL);
+    close(query_server->descriptor);
+    for (int i = 0; i < QUERY_MAX_CONNECTIONS; i++){
+        Query_connection* connection = &query_server->connections[i];
+        if (connection->started){
+            shutdown(connection->descriptor, SHUT_RDWR);
+            pthread_join(connection->thread, NULL);
+            close(connection->descriptor);
+            connection->started = false;
+        }
+    }
+    pthread_join(query_server->batcher, NULL);
+    if (query_server->socket_path != NULL){
+        unlink(query_server->socket_path);
+    }
+}
@@ -0,0 +1,96 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_QUERYSERVER_H
+#define WORDTOVEC_QUERYSERVER_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include "EmbeddingModel.h"
+#include "NearestNeighbors.h"
+
+#define LATENCY_BUCKET_COUNT 32
+#define QUERY_TYPE_COUNT 3
+
+static int QUERY_BATCH_SIZE = 32;
+static int QUERY_BATCH_DELAY = 200;
+static int QUERY_MAX_CONNECTIONS = 64;
+static int QUERY_MAX_K = 100;
+static int QUERY_BUFFER_SIZE = 65536;
+
+enum query_type{
+    VECTOR_QUERY,
+    SIMILARITY_QUERY,
+    TOP_K_QUERY
+};
+
+typedef enum query_type Query_type;
+
+struct latency_histogram{
+    _Atomic long long buckets[LATENCY_BUCKET_COUNT];
+    _Atomic long long count;
+    _Atomic long long total_microseconds;
+};
+
+typedef struct latency_histogram Latency_histogram;
+
+struct top_k_request{
+    const float* query;
+    int k;
+    int* indices;
+    float* scores;
+    bool done;
+};
+
+typedef struct top_k_request Top_k_request;
+
+struct query_connection{
+    struct query_server* query_server;
+    int descriptor;
+    pthread_t thread;
+    bool started;
+    atomic_bool active;
+};
+
+typedef struct query_connection Query_connection;
+
+struct query_server{
+    const Embedding_model* embedding_model;
+    Nearest_neighbors_ptr nearest_neighbors;
+    const char* socket_path;
+    int port;
+    int descriptor;
+    pthread_t acceptor;
+    pthread_t batcher;
+    atomic_bool stopping;
+    Query_connection* connections;
+    pthread_mutex_t mutex;
+    pthread_cond_t request_condition;
+    pthread_cond_t done_condition;
+    Top_k_request** pending;
+    int pending_count;
+    float* batch_queries;
+    int* batch_indices;
+    float* batch_scores;
+    Latency_histogram histograms[QUERY_TYPE_COUNT];
+    _Atomic long long batch_count;
+    _Atomic long long batched_request_count;
+    double start_time;
+};
+
+typedef struct query_server Query_server;
+
+typedef Query_server *Query_server_ptr;
+
+Query_server_ptr create_query_server(const Embedding_model* embedding_model, const char* socket_path, int port);
+
+void free_query_server(Query_server_ptr query_server);
+
+bool start_query_server(Query_server_ptr query_server);
+
+void stop_query_server(Query_server_ptr query_server);
+
+int query_server_statistics(Query_server_ptr query_server, char* output, int size);
+
+#endif //WORDTOVEC_QUERYSERVER_H
@@ -0,0 +1,61 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <pthread.h>
+#include "QueryServer.h"
+
+/**
+ * Serves a model saved with save_embedding_model. The model file is memory mapped read only, so several server
+ * processes share the same pages. The server listens on a Unix domain socket if the second argument is a path,
+ * on a loopback TCP port if it is a number, and stops on SIGINT or SIGTERM.
+ */
+int main(int argc, char** argv) {
+    if (argc < 2){
+        fprintf(stderr, "Usage: %s model_file [socket_path|port]\n", argv[0]);
+        return 1;
+    }
+    const char* socket_path = "wordtovec.sock";
+    int port = 0;
+    if (argc > 2){
+        char* end;
+        long number = strtol(argv[2], &end, 10);
+        if (*end == '\0' && number > 0 && number < 65536){
+            socket_path = NULL;
+            port = (int) number;
+        } else {
+            socket_path = argv[2];
+        }
+    }
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    Embedding_model_ptr embedding_model = create_embedding_model4(argv[1], false);
+    if (embedding_model == NULL){
+        fprintf(stderr, "Cannot load model %s\n", argv[1]);
+        return 1;
+    }
+    Query_server_ptr query_server = create_query_server(embedding_model, socket_path, port);
+    if (!start_query_server(query_server)){
+        fprintf(stderr, "Cannot listen on %s\n", socket_path != NULL ? socket_path : argv[2]);
+        free_query_server(query_server);
+        free_embedding_model(embedding_model);
+        return 1;
+    }
+    printf("Serving %d words of dimension %d\n", embedding_model->word_count, embedding_model->vector_length);
+    fflush(stdout);
+    int signal_number;
+    sigwait(&signals, &signal_number);
+    stop_query_server(query_server);
+    char statistics[4096];
+    query_server_statistics(query_server, statistics, sizeof(statistics));
+    printf("%s\n", statistics);
+    free_query_server(query_server);
+    free_embedding_model(embedding_model);
+    return 0;
+}
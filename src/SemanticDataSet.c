@@ -3,6 +3,7 @@
 //
 
 #include <stdlib.h>
+#include <math.h>
 #include <FileUtils.h>
 #include <StringUtils.h>
 #include <Memory/Memory.h>
@@ -73,6 +74,41 @@ calculate_similarities(Semantic_data_set_ptr semantic_data_set, Vectorized_dicti
     return result;
 }
 
+/**
+ * Calculates the similarities between words in the dataset. The word vectors will be taken from the input
+ * embedding model. As in calculate_similarities, pairs with a word that does not exist in the model are removed
+ * from the dataset.
+ * @param semantic_data_set Semantic dataset
+ * @param embedding_model Embedding model that stores the word vectors.
+ * @return Word pairs and their calculated similarities stored as a semantic dataset.
+ */
+Semantic_data_set_ptr calculate_similarities2(Semantic_data_set_ptr semantic_data_set, const Embedding_model* embedding_model) {
+    Semantic_data_set_ptr result = create_semantic_data_set2();
+    for (int i = 0; i < semantic_data_set->pairs->size; i++){
+        Word_pair_ptr word_pair = array_list_get(semantic_data_set->pairs, i);
+        int index1 = embedding_model_index(embedding_model, word_pair->word1);
+        int index2 = embedding_model_index(embedding_model, word_pair->word2);
+        if (index1 != -1 && index2 != -1){
+            const float* vector1 = embedding_model_vector(embedding_model, index1);
+            const float* vector2 = embedding_model_vector(embedding_model, index2);
+            double dot = 0, norm1 = 0, norm2 = 0, similarity = 0;
+            for (int j = 0; j < embedding_model->vector_length; j++){
+                dot += vector1[j] * vector2[j];
+                norm1 += vector1[j] * vector1[j];
+                norm2 += vector2[j] * vector2[j];
+            }
+            if (norm1 > 0 && norm2 > 0){
+                similarity = dot / sqrt(norm1 * norm2);
+            }
+            array_list_add(result->pairs, create_word_pair(word_pair->word1, word_pair->word2, similarity));
+        } else {
+            array_list_remove(semantic_data_set->pairs, i, (void (*)(void *)) free_word_pair);
+            i--;
+        }
+    }
+    return result;
+}
+
 /**
  * Sorts the word pairs in the dataset according to the WordPairComparator.
  * @param semantic_data_set Semantic dataset
@@ -8,6 +8,7 @@
 #include <ArrayList.h>
 #include "Dictionary/VectorizedDictionary.h"
 #include "WordPair.h"
+#include "EmbeddingModel.h"
 
 struct semantic_data_set{
     Array_list_ptr pairs;
@@ -25,6 +26,8 @@ void free_semantic_data_set(Semantic_data_set_ptr semantic_data_set);
 
 Semantic_data_set_ptr calculate_similarities(Semantic_data_set_ptr semantic_data_set, Vectorized_dictionary_ptr dictionary);
 
+Semantic_data_set_ptr calculate_similarities2(Semantic_data_set_ptr semantic_data_set, const Embedding_model* embedding_model);
+
 void sort_semantic_data_set(Semantic_data_set_ptr semantic_data_set);
 
 int index_of_word_pair(Semantic_data_set_ptr semantic_data_set, Word_pair_ptr word_pair);
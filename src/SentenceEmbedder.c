@@ -0,0 +1,305 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <Memory/Memory.h>
+#include "SentenceEmbedder.h"
+
+enum batch_state{
+    BATCH_EMPTY,
+    BATCH_FILLED,
+    BATCH_COMPUTING,
+    BATCH_DONE
+};
+
+typedef enum batch_state Batch_state;
+
+struct sentence_batch{
+    int* words;
+    int* offsets;
+    int word_capacity;
+    int count;
+    float* vectors;
+    Batch_state state;
+};
+
+typedef struct sentence_batch Sentence_batch;
+
+struct embedding_pipeline{
+    const Sentence_embedder* sentence_embedder;
+    Sentence_batch* batches;
+    int batch_count;
+    long long filled;
+    long long next_compute;
+    bool reading_finished;
+    bool write_failed;
+    FILE* output;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+};
+
+typedef struct embedding_pipeline Embedding_pipeline;
+
+/**
+ * Constructor for the sentence embedder. Every row of the model gets the smooth inverse frequency weight
+ * smoothing / (smoothing + p(w)), where p(w) is the relative frequency of the word in the vocabulary, so that
+ * frequent words contribute less to the sentence vector. Words of the model missing from the vocabulary get
+ * weight 1.
+ * @param embedding_model Word vectors, not owned by the embedder.
+ * @param vocabulary Vocabulary holding the word counts.
+ * @param smoothing Smoothing parameter, typically 1e-3.
+ * @return Sentence embedder.
+ */
+Sentence_embedder_ptr create_sentence_embedder(const Embedding_model* embedding_model, Vocabulary_ptr vocabulary, double smoothing) {
+    Sentence_embedder_ptr result = malloc_(sizeof(Sentence_embedder));
+    result->embedding_model = embedding_model;
+    result->smoothing = smoothing;
+    result->weights = malloc_(embedding_model->word_count * sizeof(float));
+    for (int i = 0; i < embedding_model->word_count; i++){
+        int* position = hash_map_get(vocabulary->word_map, embedding_model->words[i]);
+        double frequency = 0;
+        if (position != NULL){
+            frequency = vocabulary_get_word(vocabulary, *position)->count / (double) vocabulary->total_number_of_words;
+        }
+        result->weights[i] = (float) (smoothing / (smoothing + frequency));
+    }
+    return result;
+}
+
+/**
+ * Frees memory allocated for the sentence embedder. The embedding model is not freed.
+ * @param sentence_embedder Sentence embedder to deallocate.
+ */
+void free_sentence_embedder(Sentence_embedder_ptr sentence_embedder) {
+    free_(sentence_embedder->weights);
+    free_(sentence_embedder);
+}
+
+/**
+ * Computes the weighted average of the vectors of the words of a sentence. The accumulation runs over contiguous
+ * float rows of the model and is vectorized by the compiler.
+ * @param sentence_embedder Current sentence embedder
+ * @param words Rows of the words of the sentence in the model.
+ * @param length Number of words.
+ * @param output Output vector with vector_length floats, zero if the sentence is empty.
+ * @return Number of words averaged.
+ */
+int embed_sentence(const Sentence_embedder* sentence_embedder, const int* words, int length, float* output) {
+    const Embedding_model* embedding_model = sentence_embedder->embedding_model;
+    int vector_length = embedding_model->vector_length;
+    memset(output, 0, vector_length * sizeof(float));
+    for (int i = 0; i < length; i++){
+        const float* row = embedding_model->vectors + (size_t) words[i] * vector_length;
+        float weight = sentence_embedder->weights[words[i]];
+        for (int j = 0; j < vector_length; j++){
+            output[j] += weight * row[j];
+        }
+    }
+    if (length > 0){
+        float scale = 1.0f / length;
+        for (int j = 0; j < vector_length; j++){
+            output[j] *= scale;
+        }
+    }
+    return length;
+}
+
+/**
+ * Reads the next SENTENCE_BATCH_SIZE sentences of the corpus into a batch, replacing every word with its row in
+ * the model. Words missing from the model are dropped.
+ * @param pipeline Current pipeline
+ * @param batch Batch to fill.
+ * @param corpus Corpus to read.
+ */
+static void fill_sentence_batch(Embedding_pipeline* pipeline, Sentence_batch* batch, Corpus_ptr corpus) {
+    int word_count = 0;
+    batch->count = 0;
+    batch->offsets[0] = 0;
+    while (batch->count < SENTENCE_BATCH_SIZE){
+        Sentence_ptr sentence = corpus_get_sentence2(corpus);
+        if (sentence == NULL){
+            break;
+        }
+        if (word_count + sentence_word_count(sentence) > batch->word_capacity){
+            while (word_count + sentence_word_count(sentence) > batch->word_capacity){
+                batch->word_capacity *= 2;
+            }
+            batch->words = realloc_(batch->words, batch->word_capacity * sizeof(int));
+        }
+        for (int i = 0; i < sentence_word_count(sentence); i++){
+            int index = embedding_model_index(pipeline->sentence_embedder->embedding_model, sentence_get_word(sentence, i));
+            if (index != -1){
+                batch->words[word_count] = index;
+                word_count++;
+            }
+        }
+        batch->count++;
+        batch->offsets[batch->count] = word_count;
+    }
+}
+
+/**
+ * Main function of a worker thread. Takes filled batches in sequence order and embeds their sentences, until the
+ * corpus is read and all batches are taken.
+ * @param argument Pipeline.
+ * @return NULL
+ */
+static void* run_embedding_worker(void* argument) {
+    Embedding_pipeline* pipeline = argument;
+    int vector_length = pipeline->sentence_embedder->embedding_model->vector_length;
+    pthread_mutex_lock(&pipeline->mutex);
+    while (true){
+        while (pipeline->next_compute == pipeline->filled && !pipeline->reading_finished){
+            pthread_cond_wait(&pipeline->condition, &pipeline->mutex);
+        }
+        if (pipeline->next_compute == pipeline->filled){
+            break;
+        }
+        Sentence_batch* batch = &pipeline->batches[pipeline->next_compute % pipeline->batch_count];
+        pipeline->next_compute++;
+        batch->state = BATCH_COMPUTING;
+        pthread_mutex_unlock(&pipeline->mutex);
+        for (int i = 0; i < batch->count; i++){
+            embed_sentence(pipeline->sentence_embedder, batch->words + batch->offsets[i], batch->offsets[i + 1] - batch->offsets[i], batch->vectors + (size_t) i * vector_length);
+        }
+        pthread_mutex_lock(&pipeline->mutex);
+        batch->state = BATCH_DONE;
+        pthread_cond_broadcast(&pipeline->condition);
+    }
+    pthread_mutex_unlock(&pipeline->mutex);
+    return NULL;
+}
+
+/**
+ * Main function of the writer thread. Writes the vectors of the batches in sequence order as they are computed,
+ * and hands the written batches back to the reader. After a failed write, the remaining batches are still taken so
+ * that the pipeline drains, but nothing more is written.
+ * @param argument Pipeline.
+ * @return NULL
+ */
+static void* run_embedding_writer(void* argument) {
+    Embedding_pipeline* pipeline = argument;
+    int vector_length = pipeline->sentence_embedder->embedding_model->vector_length;
+    for (long long sequence = 0; ; sequence++){
+        Sentence_batch* batch = &pipeline->batches[sequence % pipeline->batch_count];
+        pthread_mutex_lock(&pipeline->mutex);
+        while (!(sequence < pipeline->filled && batch->state == BATCH_DONE) && !(pipeline->reading_finished && sequence == pipeline->filled)){
+            pthread_cond_wait(&pipeline->condition, &pipeline->mutex);
+        }
+        if (sequence == pipeline->filled){
+            pthread_mutex_unlock(&pipeline->mutex);
+            break;
+        }
+        pthread_mutex_unlock(&pipeline->mutex);
+        size_t vector_count = (size_t) batch->count * vector_length;
+        if (!pipeline->write_failed && fwrite(batch->vectors, sizeof(float), vector_count, pipeline->output) != vector_count){
+            pipeline->write_failed = true;
+        }
+        pthread_mutex_lock(&pipeline->mutex);
+        batch->state = BATCH_EMPTY;
+        pthread_cond_broadcast(&pipeline->condition);
+        pthread_mutex_unlock(&pipeline->mutex);
+    }
+    return NULL;
+}
+
+/**
+ * Embeds every sentence of a corpus and writes the sentence vectors to a file, as consecutive rows of
+ * vector_length floats in corpus order. The calling thread reads the corpus and maps the words to rows of the
+ * model in batches of SENTENCE_BATCH_SIZE sentences; thread_count workers embed the batches, and a writer thread
+ * writes them in order. Batches are recycled through a ring of 2 * thread_count slots, so memory does not grow
+ * with the corpus and reading, embedding and writing overlap. A thread count below one is taken as one; if fewer
+ * workers can be started, the started ones embed all batches.
+ * @param sentence_embedder Current sentence embedder
+ * @param corpus Corpus to embed.
+ * @param file_name Output file.
+ * @param thread_count Number of worker threads.
+ * @return Number of sentences embedded, -1 if the output file could not be opened or written, or no thread could be
+ * started.
+ */
+long long embed_corpus(const Sentence_embedder* sentence_embedder, Corpus_ptr corpus, const char* file_name, int thread_count) {
+    Embedding_pipeline pipeline;
+    pipeline.output = fopen(file_name, "wb");
+    if (pipeline.output == NULL){
+        return -1;
+    }
+    int vector_length = sentence_embedder->embedding_model->vector_length;
+    if (thread_count < 1){
+        thread_count = 1;
+    }
+    pthread_t workers[thread_count];
+    pthread_t writer;
+    pipeline.sentence_embedder = sentence_embedder;
+    pipeline.batch_count = 2 * thread_count;
+    pipeline.batches = malloc_(pipeline.batch_count * sizeof(Sentence_batch));
+    for (int i = 0; i < pipeline.batch_count; i++){
+        pipeline.batches[i].word_capacity = 16 * SENTENCE_BATCH_SIZE;
+        pipeline.batches[i].words = malloc_(pipeline.batches[i].word_capacity * sizeof(int));
+        pipeline.batches[i].offsets = malloc_((SENTENCE_BATCH_SIZE + 1) * sizeof(int));
+        pipeline.batches[i].vectors = malloc_((size_t) SENTENCE_BATCH_SIZE * vector_length * sizeof(float));
+        pipeline.batches[i].state = BATCH_EMPTY;
+    }
+    pipeline.filled = 0;
+    pipeline.next_compute = 0;
+    pipeline.reading_finished = false;
+    pipeline.write_failed = false;
+    pthread_mutex_init(&pipeline.mutex, NULL);
+    pthread_cond_init(&pipeline.condition, NULL);
+    int worker_count = 0;
+    while (worker_count < thread_count && pthread_create(&workers[worker_count], NULL, run_embedding_worker, &pipeline) == 0){
+        worker_count++;
+    }
+    bool started = worker_count > 0 && pthread_create(&writer, NULL, run_embedding_writer, &pipeline) == 0;
+    long long sentence_count = 0;
+    if (started){
+        corpus_open(corpus);
+    }
+    while (started){
+        Sentence_batch* batch = &pipeline.batches[pipeline.filled % pipeline.batch_count];
+        pthread_mutex_lock(&pipeline.mutex);
+        while (batch->state != BATCH_EMPTY){
+            pthread_cond_wait(&pipeline.condition, &pipeline.mutex);
+        }
+        pthread_mutex_unlock(&pipeline.mutex);
+        fill_sentence_batch(&pipeline, batch, corpus);
+        pthread_mutex_lock(&pipeline.mutex);
+        if (batch->count == 0){
+            pipeline.reading_finished = true;
+            pthread_cond_broadcast(&pipeline.condition);
+            pthread_mutex_unlock(&pipeline.mutex);
+            break;
+        }
+        sentence_count += batch->count;
+        batch->state = BATCH_FILLED;
+        pipeline.filled++;
+        pthread_cond_broadcast(&pipeline.condition);
+        pthread_mutex_unlock(&pipeline.mutex);
+    }
+    if (started){
+        corpus_close(corpus);
+    } else {
+        pthread_mutex_lock(&pipeline.mutex);
+        pipeline.reading_finished = true;
+        pthread_cond_broadcast(&pipeline.condition);
+        pthread_mutex_unlock(&pipeline.mutex);
+    }
+    for (int i = 0; i < worker_count; i++){
+        pthread_join(workers[i], NULL);
+    }
+    if (started){
+        pthread_join(writer, NULL);
+    }
+    pthread_mutex_destroy(&pipeline.mutex);
+    pthread_cond_destroy(&pipeline.condition);
+    for (int i = 0; i < pipeline.batch_count; i++){
+        free_(pipeline.batches[i].words);
+        free_(pipeline.batches[i].offsets);
+        free_(pipeline.batches[i].vectors);
+    }
+    free_(pipeline.batches);
+    bool closed = fclose(pipeline.output) == 0;
+    return started && closed && !pipeline.write_failed ? sentence_count : -1;
+}
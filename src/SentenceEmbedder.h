@@ -0,0 +1,32 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_SENTENCEEMBEDDER_H
+#define WORDTOVEC_SENTENCEEMBEDDER_H
+
+#include <Corpus.h>
+#include "EmbeddingModel.h"
+#include "Vocabulary.h"
+
+static int SENTENCE_BATCH_SIZE = 4096;
+
+struct sentence_embedder{
+    const Embedding_model* embedding_model;
+    float* weights;
+    double smoothing;
+};
+
+typedef struct sentence_embedder Sentence_embedder;
+
+typedef Sentence_embedder *Sentence_embedder_ptr;
+
+Sentence_embedder_ptr create_sentence_embedder(const Embedding_model* embedding_model, Vocabulary_ptr vocabulary, double smoothing);
+
+void free_sentence_embedder(Sentence_embedder_ptr sentence_embedder);
+
+int embed_sentence(const Sentence_embedder* sentence_embedder, const int* words, int length, float* output);
+
+long long embed_corpus(const Sentence_embedder* sentence_embedder, Corpus_ptr corpus, const char* file_name, int thread_count);
+
+#endif //WORDTOVEC_SENTENCEEMBEDDER_H
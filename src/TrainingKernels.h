@@ -0,0 +1,74 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_TRAININGKERNELS_H
+#define WORDTOVEC_TRAININGKERNELS_H
+
+#ifdef __GNUC__
+#define TRAINING_INLINE static inline __attribute__((always_inline))
+#else
+#define TRAINING_INLINE static inline
+#endif
+
+/**
+ * Calls X once for each vector length that has width specialized trainers. A trainer body inlined with one of
+ * these lengths as a compile time constant has its kernels fully unrolled and vectorized.
+ */
+#define TRAINING_KERNEL_WIDTHS(X) X(50) X(100) X(128) X(200) X(256) X(300)
+
+/**
+ * Calculates the dot product of two vectors.
+ * @param vector1 First vector to multiply.
+ * @param vector2 Second vector to multiply.
+ * @param vector_length Length of the vectors.
+ * @return Dot product of two given vectors.
+ */
+TRAINING_INLINE double training_dot_product(const double* restrict vector1, const double* restrict vector2, int vector_length) {
+    double sum = 0;
+    for (int j = 0; j < vector_length; j++){
+        sum += vector1[j] * vector2[j];
+    }
+    return sum;
+}
+
+/**
+ * Adds g times the output row to the output update, and g times the outputs to the output row.
+ * @param output_update Output update to be added.
+ * @param row Output row to be updated.
+ * @param outputs Current outputs.
+ * @param g Multiplier for the update.
+ * @param vector_length Length of the vectors.
+ */
+TRAINING_INLINE void training_update_output(double* restrict output_update, double* restrict row, const double* restrict outputs, double g, int vector_length) {
+    for (int j = 0; j < vector_length; j++){
+        output_update[j] += row[j] * g;
+        row[j] += outputs[j] * g;
+    }
+}
+
+/**
+ * Adds the source vector to the destination vector.
+ * @param destination Vector to be updated.
+ * @param source Vector to be added.
+ * @param vector_length Length of the vectors.
+ */
+TRAINING_INLINE void training_add_vector(double* restrict destination, const double* restrict source, int vector_length) {
+    for (int j = 0; j < vector_length; j++){
+        destination[j] += source[j];
+    }
+}
+
+/**
+ * Divides a vector by a scalar.
+ * @param vector Vector to be divided.
+ * @param divisor Divisor.
+ * @param vector_length Length of the vector.
+ */
+TRAINING_INLINE void training_divide_vector(double* restrict vector, double divisor, int vector_length) {
+    for (int j = 0; j < vector_length; j++){
+        vector[j] /= divisor;
+    }
+}
+
+#endif //WORDTOVEC_TRAININGKERNELS_H
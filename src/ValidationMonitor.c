@@ -0,0 +1,225 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <math.h>
+#include <Memory/Memory.h>
+#include "ValidationMonitor.h"
+
+/**
+ * Constructor for the validation monitor. The monitor evaluates the word vectors on a semantic dataset every
+ * interval words while training, and asks the training to stop once the Spearman correlation has not improved by
+ * more than min_delta for patience consecutive evaluations.
+ * @param data_set Semantic dataset used for validation. The monitor keeps its own copy of the pairs.
+ * @param interval Number of processed words between two evaluations.
+ * @param patience Number of evaluations without improvement after which the training stops, 0 to never stop.
+ * @param min_delta Minimum increase of the correlation counted as an improvement.
+ * @return Validation monitor.
+ */
+Validation_monitor_ptr create_validation_monitor(Semantic_data_set_ptr data_set, long long interval, int patience, double min_delta) {
+    Validation_monitor_ptr result = malloc_(sizeof(Validation_monitor));
+    result->data_set = create_semantic_data_set2();
+    for (int i = 0; i < data_set->pairs->size; i++){
+        Word_pair_ptr word_pair = array_list_get(data_set->pairs, i);
+        array_list_add(result->data_set->pairs, create_word_pair(word_pair->word1, word_pair->word2, word_pair->related_by));
+    }
+    result->interval = interval;
+    result->patience = patience;
+    result->min_delta = min_delta;
+    result->history = create_array_list();
+    result->rows = NULL;
+    result->snapshot = NULL;
+    return result;
+}
+
+/**
+ * Frees memory allocated for the validation monitor. Frees the copy of the dataset and the correlation history.
+ * @param validation_monitor Validation monitor to deallocate.
+ */
+void free_validation_monitor(Validation_monitor_ptr validation_monitor) {
+    free_semantic_data_set(validation_monitor->data_set);
+    free_array_list(validation_monitor->history, free_);
+    free_(validation_monitor);
+}
+
+/**
+ * Evaluates the current snapshot on the dataset and updates the early stopping state.
+ * @param validation_monitor Current validation monitor
+ */
+static void evaluate_snapshot(Validation_monitor_ptr validation_monitor) {
+    Semantic_data_set_ptr similarities = calculate_similarities2(validation_monitor->data_set, validation_monitor->snapshot);
+    double correlation = spearman_correlation(validation_monitor->data_set, similarities);
+    free_semantic_data_set(similarities);
+    array_list_add_double(validation_monitor->history, correlation);
+    if (correlation > validation_monitor->best_correlation + validation_monitor->min_delta){
+        validation_monitor->best_correlation = correlation;
+        validation_monitor->evaluations_without_improvement = 0;
+    } else {
+        validation_monitor->evaluations_without_improvement++;
+        if (validation_monitor->patience > 0 && validation_monitor->evaluations_without_improvement >= validation_monitor->patience){
+            atomic_store(&validation_monitor->stop, true);
+        }
+    }
+}
+
+/**
+ * Main function of the background evaluation thread. Waits for snapshots taken by the training and evaluates them
+ * until the monitor is finished.
+ * @param argument Validation monitor.
+ * @return NULL
+ */
+static void* run_validation_monitor(void* argument) {
+    Validation_monitor_ptr validation_monitor = argument;
+    pthread_mutex_lock(&validation_monitor->mutex);
+    while (true){
+        while (!validation_monitor->pending && !validation_monitor->finished){
+            pthread_cond_wait(&validation_monitor->condition, &validation_monitor->mutex);
+        }
+        if (!validation_monitor->pending){
+            break;
+        }
+        pthread_mutex_unlock(&validation_monitor->mutex);
+        evaluate_snapshot(validation_monitor);
+        pthread_mutex_lock(&validation_monitor->mutex);
+        validation_monitor->pending = false;
+    }
+    pthread_mutex_unlock(&validation_monitor->mutex);
+    return NULL;
+}
+
+/**
+ * Prepares the monitor for a training run and starts the background evaluation thread. The snapshot only stores
+ * the vectors of the words that appear in the dataset, so taking a snapshot costs a few hundred row copies
+ * regardless of the size of the vocabulary. If the thread can not be started, checkpoints are evaluated by the
+ * training thread that claims them.
+ * @param validation_monitor Current validation monitor
+ * @param vocabulary Vocabulary of the trained network.
+ * @param vector_length Length of the word vectors.
+ */
+void start_validation_monitor(Validation_monitor_ptr validation_monitor, Vocabulary_ptr vocabulary, int vector_length) {
+    Hash_map_ptr words = create_string_hash_map();
+    Array_list_ptr rows = create_array_list();
+    for (int i = 0; i < validation_monitor->data_set->pairs->size; i++){
+        Word_pair_ptr word_pair = array_list_get(validation_monitor->data_set->pairs, i);
+        char* pair_words[2] = {word_pair->word1, word_pair->word2};
+        for (int j = 0; j < 2; j++){
+            int* position = hash_map_get(vocabulary->word_map, pair_words[j]);
+            if (position != NULL && hash_map_get(words, pair_words[j]) == NULL){
+                hash_map_insert(words, pair_words[j], pair_words[j]);
+                array_list_add_int(rows, *position);
+            }
+        }
+    }
+    validation_monitor->snapshot = create_embedding_model3(rows->size, vector_length);
+    validation_monitor->rows = malloc_(rows->size * sizeof(int));
+    for (int i = 0; i < rows->size; i++){
+        validation_monitor->rows[i] = array_list_get_int(rows, i);
+        embedding_model_set_word(validation_monitor->snapshot, i, vocabulary_get_word(vocabulary, validation_monitor->rows[i])->name);
+    }
+    free_array_list(rows, free_);
+    free_hash_map2(words, NULL, NULL);
+    free_array_list(validation_monitor->history, free_);
+    validation_monitor->history = create_array_list();
+    validation_monitor->best_correlation = -INFINITY;
+    validation_monitor->evaluations_without_improvement = 0;
+    atomic_init(&validation_monitor->next_checkpoint, validation_monitor->interval);
+    atomic_init(&validation_monitor->stop, false);
+    validation_monitor->pending = false;
+    validation_monitor->finished = false;
+    pthread_mutex_init(&validation_monitor->mutex, NULL);
+    pthread_cond_init(&validation_monitor->condition, NULL);
+    validation_monitor->thread_started = pthread_create(&validation_monitor->thread, NULL, run_validation_monitor, validation_monitor) == 0;
+}
+
+/**
+ * Copies the validated rows of the word vectors into the snapshot.
+ * @param validation_monitor Current validation monitor
+ * @param word_vectors Word vectors of the trained network.
+ */
+static void copy_snapshot(Validation_monitor_ptr validation_monitor, double** word_vectors) {
+    Embedding_model_ptr snapshot = validation_monitor->snapshot;
+    for (int i = 0; i < snapshot->word_count; i++){
+        float* row = snapshot->vectors + (size_t) i * snapshot->vector_length;
+        for (int j = 0; j < snapshot->vector_length; j++){
+            row[j] = (float) word_vectors[validation_monitor->rows[i]][j];
+        }
+    }
+}
+
+/**
+ * Called by the training as words are processed. When the processed word count passes the next checkpoint,
+ * exactly one caller claims the checkpoint, copies the validated rows into the snapshot and hands it to the
+ * background thread. If the previous snapshot is still being evaluated, the checkpoint is skipped, so the training
+ * never waits for the evaluation. Without a background thread, the caller evaluates the snapshot itself.
+ * @param validation_monitor Current validation monitor
+ * @param word_vectors Word vectors of the trained network.
+ * @param word_count_actual Number of words processed so far over all epochs.
+ * @return True if the training should stop.
+ */
+bool validation_checkpoint(Validation_monitor_ptr validation_monitor, double** word_vectors, long long word_count_actual) {
+    long long checkpoint = atomic_load_explicit(&validation_monitor->next_checkpoint, memory_order_relaxed);
+    if (word_count_actual >= checkpoint &&
+        atomic_compare_exchange_strong(&validation_monitor->next_checkpoint, &checkpoint, word_count_actual + validation_monitor->interval)){
+        if (pthread_mutex_trylock(&validation_monitor->mutex) == 0){
+            if (!validation_monitor->thread_started){
+                copy_snapshot(validation_monitor, word_vectors);
+                evaluate_snapshot(validation_monitor);
+            } else if (!validation_monitor->pending){
+                copy_snapshot(validation_monitor, word_vectors);
+                validation_monitor->pending = true;
+                pthread_cond_signal(&validation_monitor->condition);
+            }
+            pthread_mutex_unlock(&validation_monitor->mutex);
+        }
+    }
+    return validation_should_stop(validation_monitor);
+}
+
+/**
+ * Synchronous version of the checkpoint, used by the deterministic training. When the processed word count passes
+ * the next checkpoint, the snapshot is evaluated by the caller before returning, so that the evaluated vectors and
+ * the stopping decision depend only on the word count, not on the timing of the background thread. Must be called
+ * by a single thread while no other thread updates the word vectors.
+ * @param validation_monitor Current validation monitor
+ * @param word_vectors Word vectors of the trained network.
+ * @param word_count_actual Number of words processed so far over all epochs.
+ * @return True if the training should stop.
+ */
+bool validation_checkpoint2(Validation_monitor_ptr validation_monitor, double** word_vectors, long long word_count_actual) {
+    if (word_count_actual >= atomic_load_explicit(&validation_monitor->next_checkpoint, memory_order_relaxed)){
+        atomic_store_explicit(&validation_monitor->next_checkpoint, word_count_actual + validation_monitor->interval, memory_order_relaxed);
+        copy_snapshot(validation_monitor, word_vectors);
+        evaluate_snapshot(validation_monitor);
+    }
+    return validation_should_stop(validation_monitor);
+}
+
+/**
+ * Checks if the validation correlation has plateaued.
+ * @param validation_monitor Current validation monitor
+ * @return True if the training should stop.
+ */
+bool validation_should_stop(Validation_monitor_ptr validation_monitor) {
+    return atomic_load_explicit(&validation_monitor->stop, memory_order_relaxed);
+}
+
+/**
+ * Waits for the evaluation of the last snapshot, stops the background thread and frees the snapshot. The
+ * correlation history stays available in the monitor.
+ * @param validation_monitor Current validation monitor
+ */
+void finish_validation_monitor(Validation_monitor_ptr validation_monitor) {
+    pthread_mutex_lock(&validation_monitor->mutex);
+    validation_monitor->finished = true;
+    pthread_cond_signal(&validation_monitor->condition);
+    pthread_mutex_unlock(&validation_monitor->mutex);
+    if (validation_monitor->thread_started){
+        pthread_join(validation_monitor->thread, NULL);
+    }
+    pthread_mutex_destroy(&validation_monitor->mutex);
+    pthread_cond_destroy(&validation_monitor->condition);
+    free_embedding_model(validation_monitor->snapshot);
+    free_(validation_monitor->rows);
+    validation_monitor->snapshot = NULL;
+    validation_monitor->rows = NULL;
+}
@@ -0,0 +1,51 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_VALIDATIONMONITOR_H
+#define WORDTOVEC_VALIDATIONMONITOR_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include "SemanticDataSet.h"
+#include "Vocabulary.h"
+
+struct validation_monitor{
+    Semantic_data_set_ptr data_set;
+    long long interval;
+    int patience;
+    double min_delta;
+    Array_list_ptr history;
+    double best_correlation;
+    int evaluations_without_improvement;
+    int* rows;
+    Embedding_model_ptr snapshot;
+    _Atomic long long next_checkpoint;
+    atomic_bool stop;
+    bool pending;
+    bool finished;
+    bool thread_started;
+    pthread_t thread;
+    pthread_mutex_t mutex;
+    pthread_cond_t condition;
+};
+
+typedef struct validation_monitor Validation_monitor;
+
+typedef Validation_monitor *Validation_monitor_ptr;
+
+Validation_monitor_ptr create_validation_monitor(Semantic_data_set_ptr data_set, long long interval, int patience, double min_delta);
+
+void free_validation_monitor(Validation_monitor_ptr validation_monitor);
+
+void start_validation_monitor(Validation_monitor_ptr validation_monitor, Vocabulary_ptr vocabulary, int vector_length);
+
+bool validation_checkpoint(Validation_monitor_ptr validation_monitor, double** word_vectors, long long word_count_actual);
+
+bool validation_checkpoint2(Validation_monitor_ptr validation_monitor, double** word_vectors, long long word_count_actual);
+
+bool validation_should_stop(Validation_monitor_ptr validation_monitor);
+
+void finish_validation_monitor(Validation_monitor_ptr validation_monitor);
+
+#endif //WORDTOVEC_VALIDATIONMONITOR_H
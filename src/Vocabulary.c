@@ -2,10 +2,43 @@
 // Created by Olcay Taner YILDIZ on 2.10.2023.
 //
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <StringUtils.h>
 #include <Memory/Memory.h>
 #include "Vocabulary.h"
 #include "VocabularyWord.h"
+#include "MappedCorpus.h"
+
+struct vocabulary_file_header{
+    int magic;
+    int word_count;
+    int table_size;
+    int code_length_limit;
+    long long total_number_of_words;
+    long long point_count;
+    long long name_bytes;
+    Corpus_fingerprint fingerprint;
+};
+
+typedef struct vocabulary_file_header Vocabulary_file_header;
+
+struct vocabulary_record{
+    long long count;
+    unsigned long long code_bits;
+    long long name_offset;
+    long long point_offset;
+    int frequency_rank;
+    int code_length;
+};
+
+typedef struct vocabulary_record Vocabulary_record;
 
 /**
  * Constructor for the Vocabulary class. For each distinct word in the corpus, a VocabularyWord
@@ -14,37 +47,275 @@
  * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
  */
 Vocabulary_ptr create_vocabulary(Corpus_ptr corpus) {
+    return create_vocabulary3(corpus, NULL);
+}
+
+/**
+ * Constructor for the Vocabulary class, where the sentences of the corpus are read through a phrase detector.
+ * Bigrams joined by the phrase detector become single words of the vocabulary.
+ * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * @param phrase_detector Phrase detector rewriting the sentences of the corpus, NULL if no phrases are detected.
+ */
+Vocabulary_ptr create_vocabulary3(Corpus_ptr corpus, Phrase_detector_ptr phrase_detector) {
     Vocabulary_ptr result = create_vocabulary2();
-    Counter_hash_map_ptr counts = create_counter_hash_map((unsigned int (*)(const void *, int)) hash_function_string,
-                                                          (int (*)(const void *, const void *)) compare_string);
+    Hash_map_ptr counts = create_string_hash_map();
     corpus_open(corpus);
-    Sentence_ptr sentence = corpus_get_sentence2(corpus);
+    Sentence_ptr sentence = phrase_get_sentence(phrase_detector, corpus);
     while (sentence != NULL){
         for (int i = 0; i < sentence_word_count(sentence); i++){
-            put_counter_hash_map(counts, sentence_get_word(sentence, i));
+            char* word = sentence_get_word(sentence, i);
+            long long* count = hash_map_get(counts, word);
+            if (count == NULL){
+                char* key = NULL;
+                key = str_copy(key, word);
+                count = malloc_(sizeof(long long));
+                *count = 0;
+                hash_map_insert(counts, key, count);
+            }
+            (*count)++;
         }
         result->total_number_of_words += sentence_word_count(sentence);
-        sentence = corpus_get_sentence2(corpus);
+        sentence = phrase_get_sentence(phrase_detector, corpus);
     }
-    Array_list_ptr list = key_value_list(counts->map);
+    Array_list_ptr list = key_value_list(counts);
     for (int i = 0; i < list->size; i++){
         Hash_node_ptr node = array_list_get(list, i);
-        array_list_add(result->vocabulary, create_vocabulary_word(node->key, *(int*)node->value));
+        array_list_add(result->vocabulary, create_vocabulary_word(node->key, *(long long*)node->value));
     }
     free_array_list(list, NULL);
-    array_list_sort(result->vocabulary, (int (*)(const void *, const void *)) compare_vocabulary_word2);
-    create_uni_gram_table(result);
-    construct_huffman_tree(result);
-    array_list_sort(result->vocabulary, (int (*)(const void *, const void *)) compare_vocabulary_word);
-    for (int i = 0; i < result->vocabulary->size; i++){
+    free_hash_map2(counts, free_, free_);
+    prepare_vocabulary(result);
+    return result;
+}
+
+/**
+ * Constructor for the Vocabulary class from a mapped corpus. The words are counted in place by several threads,
+ * without reading the corpus sentence by sentence.
+ * @param mapped_corpus Mapped corpus used to train word vectors using Word2Vec algorithm.
+ */
+Vocabulary_ptr create_vocabulary4(const struct mapped_corpus* mapped_corpus) {
+    Vocabulary_ptr result = create_vocabulary2();
+    count_mapped_corpus_words(mapped_corpus, result);
+    prepare_vocabulary(result);
+    return result;
+}
+
+/**
+ * Loads a vocabulary saved with save_vocabulary. The file is memory mapped and the words, their counts, frequency
+ * ranks, Huffman codes and points, and the unigram table are copied out of it, so no corpus is read and no tree is
+ * constructed. If a fingerprint is given, the vocabulary is loaded only if the file was saved for a corpus with the
+ * same fingerprint. Since frequency ranks, Huffman points and table entries are later used as row and word
+ * indexes, each of them is checked against the number of words, so a corrupt file is rejected instead of causing
+ * writes out of bounds during training.
+ * @param file_name Name of the vocabulary file.
+ * @param fingerprint Fingerprint of the corpus the vocabulary should belong to, NULL to load it in any case.
+ * @return Loaded vocabulary, NULL if the file can not be read, is not a vocabulary file, or belongs to another
+ * corpus.
+ */
+Vocabulary_ptr create_vocabulary5(const char* file_name, const Corpus_fingerprint* fingerprint) {
+    int descriptor = open(file_name, O_RDONLY);
+    if (descriptor == -1){
+        return NULL;
+    }
+    struct stat status;
+    if (fstat(descriptor, &status) == -1 || status.st_size < (off_t) sizeof(Vocabulary_file_header)){
+        close(descriptor);
+        return NULL;
+    }
+    void* mapped = mmap(NULL, status.st_size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+    close(descriptor);
+    if (mapped == MAP_FAILED){
+        return NULL;
+    }
+    const Vocabulary_file_header* header = mapped;
+    long long file_size = status.st_size;
+    bool valid = header->magic == VOCABULARY_FILE_MAGIC && header->code_length_limit == MAX_CODE_LENGTH &&
+                 header->word_count >= 0 && header->word_count <= file_size / (long long) sizeof(Vocabulary_record) &&
+                 header->table_size >= 0 && header->table_size <= file_size / (long long) sizeof(int) &&
+                 header->point_count >= 0 && header->point_count <= file_size / (long long) sizeof(int) &&
+                 header->name_bytes > 0 && header->name_bytes <= file_size;
+    if (!valid || sizeof(Vocabulary_file_header) + header->word_count * (long long) sizeof(Vocabulary_record) +
+        (header->point_count + header->table_size) * (long long) sizeof(int) + header->name_bytes != file_size ||
+        (fingerprint != NULL && !same_fingerprint(&header->fingerprint, fingerprint))){
+        munmap(mapped, status.st_size);
+        return NULL;
+    }
+    const Vocabulary_record* records = (const Vocabulary_record*) (header + 1);
+    const int* points = (const int*) (records + header->word_count);
+    const int* table = points + header->point_count;
+    const char* names = (const char*) (table + header->table_size);
+    if (names[header->name_bytes - 1] != '\0'){
+        munmap(mapped, status.st_size);
+        return NULL;
+    }
+    for (int i = 0; i < header->word_count && valid; i++){
+        valid = records[i].code_length >= 0 && records[i].code_length <= MAX_CODE_LENGTH &&
+                records[i].frequency_rank >= 0 && records[i].frequency_rank < header->word_count &&
+                records[i].name_offset >= 0 && records[i].name_offset < header->name_bytes &&
+                records[i].point_offset >= 0 &&
+                records[i].point_offset + (records[i].code_length < MAX_CODE_LENGTH ? records[i].code_length + 1 : MAX_CODE_LENGTH) <= header->point_count;
+        for (int j = 0; j < records[i].code_length && valid; j++){
+            valid = points[records[i].point_offset + j] >= 0 && points[records[i].point_offset + j] < header->word_count - 1;
+        }
+    }
+    for (int i = 0; i < header->table_size && valid; i++){
+        valid = table[i] >= 0 && table[i] < header->word_count;
+    }
+    if (!valid){
+        munmap(mapped, status.st_size);
+        return NULL;
+    }
+    Vocabulary_ptr result = create_vocabulary2();
+    result->total_number_of_words = header->total_number_of_words;
+    for (int i = 0; i < header->word_count; i++){
+        Vocabulary_word_ptr word = create_vocabulary_word(names + records[i].name_offset, records[i].count);
+        word->frequency_rank = records[i].frequency_rank;
+        word->code_length = records[i].code_length;
+        for (int j = 0; j < records[i].code_length; j++){
+            word->code[j] = (int) ((records[i].code_bits >> j) & 1);
+        }
+        for (int j = 0; j <= records[i].code_length && j < MAX_CODE_LENGTH; j++){
+            word->point[j] = points[records[i].point_offset + j];
+        }
+        array_list_add(result->vocabulary, word);
+    }
+    for (int i = 0; i < header->table_size; i++){
+        array_list_add_int(result->table, table[i]);
+    }
+    for (int i = 0; i < header->word_count; i++){
         int* index = malloc_(sizeof(int));
         *index = i;
-        hash_map_insert(result->word_map, ((Vocabulary_word_ptr)array_list_get(result->vocabulary, i))->name, index);
+        hash_map_insert(result->word_map, vocabulary_get_word(result, i)->name, index);
     }
-    free_counter_hash_map(counts);
+    munmap(mapped, status.st_size);
     return result;
 }
 
+/**
+ * Constructor for the Vocabulary class with a persistent cache. If the cache file holds the vocabulary of a corpus
+ * with the same fingerprint, read through a phrase detector with the same thresholds, the vocabulary is loaded
+ * from it. Otherwise the vocabulary is constructed from the corpus and saved into the cache file for the next run.
+ * @param corpus Corpus used to train word vectors using Word2Vec algorithm.
+ * @param phrase_detector Phrase detector rewriting the sentences of the corpus, NULL if no phrases are detected.
+ * @param cache_file_name Name of the vocabulary cache file.
+ * @return Loaded or constructed vocabulary.
+ */
+Vocabulary_ptr create_vocabulary6(Corpus_ptr corpus, Phrase_detector_ptr phrase_detector, const char* cache_file_name) {
+    Corpus_fingerprint fingerprint = create_corpus_fingerprint(corpus->file_name, phrase_detector);
+    if (is_valid_fingerprint(&fingerprint)){
+        Vocabulary_ptr result = create_vocabulary5(cache_file_name, &fingerprint);
+        if (result != NULL){
+            return result;
+        }
+    }
+    Vocabulary_ptr result = create_vocabulary3(corpus, phrase_detector);
+    if (is_valid_fingerprint(&fingerprint)){
+        save_vocabulary(result, cache_file_name, &fingerprint);
+    }
+    return result;
+}
+
+/**
+ * Saves the vocabulary into a binary file: a header with the fingerprint of the corpus, one fixed size record per
+ * word in vocabulary order with its count, frequency rank and Huffman code packed into bits, followed by the
+ * Huffman points of all words, the unigram table and the words themselves. The file is written under a unique
+ * temporary name created with mkstemp and renamed, so a concurrent reader never sees a partial file and concurrent
+ * writers never share a temporary file.
+ * @param vocabulary Vocabulary to save.
+ * @param file_name Name of the vocabulary file.
+ * @param fingerprint Fingerprint of the corpus of the vocabulary.
+ * @return True if the file is written.
+ */
+bool save_vocabulary(Vocabulary_ptr vocabulary, const char* file_name, const Corpus_fingerprint* fingerprint) {
+    char* temporary_name = malloc_(strlen(file_name) + 8);
+    sprintf(temporary_name, "%s.XXXXXX", file_name);
+    int descriptor = mkstemp(temporary_name);
+    FILE* output = descriptor != -1 ? fdopen(descriptor, "wb") : NULL;
+    if (output == NULL){
+        if (descriptor != -1){
+            close(descriptor);
+            remove(temporary_name);
+        }
+        free_(temporary_name);
+        return false;
+    }
+    fchmod(descriptor, 0644);
+    int word_count = size_of_vocabulary(vocabulary);
+    Vocabulary_file_header header;
+    memset(&header, 0, sizeof(Vocabulary_file_header));
+    header.magic = VOCABULARY_FILE_MAGIC;
+    header.word_count = word_count;
+    header.table_size = vocabulary->table->size;
+    header.code_length_limit = MAX_CODE_LENGTH;
+    header.total_number_of_words = vocabulary->total_number_of_words;
+    header.fingerprint = *fingerprint;
+    for (int i = 0; i < word_count; i++){
+        Vocabulary_word_ptr word = vocabulary_get_word(vocabulary, i);
+        header.point_count += word->code_length < MAX_CODE_LENGTH ? word->code_length + 1 : MAX_CODE_LENGTH;
+        header.name_bytes += (long long) strlen(word->name) + 1;
+    }
+    fwrite(&header, sizeof(Vocabulary_file_header), 1, output);
+    long long point_offset = 0, name_offset = 0;
+    for (int i = 0; i < word_count; i++){
+        Vocabulary_word_ptr word = vocabulary_get_word(vocabulary, i);
+        Vocabulary_record record;
+        memset(&record, 0, sizeof(Vocabulary_record));
+        record.count = word->count;
+        record.frequency_rank = word->frequency_rank;
+        record.code_length = word->code_length;
+        record.name_offset = name_offset;
+        record.point_offset = point_offset;
+        for (int j = 0; j < word->code_length; j++){
+            record.code_bits |= (unsigned long long) (word->code[j] & 1) << j;
+        }
+        fwrite(&record, sizeof(Vocabulary_record), 1, output);
+        point_offset += word->code_length < MAX_CODE_LENGTH ? word->code_length + 1 : MAX_CODE_LENGTH;
+        name_offset += (long long) strlen(word->name) + 1;
+    }
+    for (int i = 0; i < word_count; i++){
+        Vocabulary_word_ptr word = vocabulary_get_word(vocabulary, i);
+        fwrite(word->point, sizeof(int), word->code_length < MAX_CODE_LENGTH ? word->code_length + 1 : MAX_CODE_LENGTH, output);
+    }
+    for (int i = 0; i < vocabulary->table->size; i++){
+        int value = get_table_value(vocabulary, i);
+        fwrite(&value, sizeof(int), 1, output);
+    }
+    for (int i = 0; i < word_count; i++){
+        Vocabulary_word_ptr word = vocabulary_get_word(vocabulary, i);
+        fwrite(word->name, 1, strlen(word->name) + 1, output);
+    }
+    bool result = ferror(output) == 0;
+    result = fclose(output) == 0 && result;
+    if (result){
+        result = rename(temporary_name, file_name) == 0;
+    } else {
+        remove(temporary_name);
+    }
+    free_(temporary_name);
+    return result;
+}
+
+/**
+ * Prepares a vocabulary whose words and counts are already added. Words are sorted according to their
+ * occurrences, and the position of each word in this order is kept as its frequency rank. Unigram table and
+ * Huffman tree are constructed, and then words are sorted alphabetically and inserted into the word map.
+ * @param vocabulary Current vocabulary object
+ */
+void prepare_vocabulary(Vocabulary_ptr vocabulary) {
+    array_list_sort(vocabulary->vocabulary, (int (*)(const void *, const void *)) compare_vocabulary_word2);
+    for (int i = 0; i < vocabulary->vocabulary->size; i++){
+        ((Vocabulary_word_ptr) array_list_get(vocabulary->vocabulary, i))->frequency_rank = i;
+    }
+    create_uni_gram_table(vocabulary);
+    construct_huffman_tree(vocabulary);
+    array_list_sort(vocabulary->vocabulary, (int (*)(const void *, const void *)) compare_vocabulary_word);
+    for (int i = 0; i < vocabulary->vocabulary->size; i++){
+        int* index = malloc_(sizeof(int));
+        *index = i;
+        hash_map_insert(vocabulary->word_map, ((Vocabulary_word_ptr)array_list_get(vocabulary->vocabulary, i))->name, index);
+    }
+}
+
 /**
  * Empty constructor for vocabulary. Allocates empty vocabulary, table and word map.
  * @return An empty allocated vocabulary.
@@ -133,18 +404,18 @@ void create_uni_gram_table(Vocabulary_ptr vocabulary) {
  */
 void construct_huffman_tree(Vocabulary_ptr vocabulary) {
     int min1i, min2i, b, i, size = vocabulary->vocabulary->size;
-    int count[size * 2 + 1];
+    long long* count = malloc_((size * 2 + 1) * sizeof(long long));
     int code[MAX_CODE_LENGTH];
     int point[MAX_CODE_LENGTH];
-    int binary[size * 2 + 1];
-    int parentNode[size * 2 + 1];
+    int* binary = calloc_(size * 2 + 1, sizeof(int));
+    int* parentNode = calloc_(size * 2 + 1, sizeof(int));
     Vocabulary_word_ptr word;
     for (int a = 0; a < size; a++){
         word = array_list_get(vocabulary->vocabulary, a);
         count[a] = word->count;
     }
     for (int a = size; a < size * 2; a++)
-        count[a] = 1000000000;
+        count[a] = 1000000000000000000LL;
     int pos1 = size - 1;
     int pos2 = size;
     for (int a = 0; a < size - 1; a++) {
@@ -196,6 +467,9 @@ void construct_huffman_tree(Vocabulary_ptr vocabulary) {
             word->point[i - b] = point[b] - size;
         }
     }
+    free_(count);
+    free_(binary);
+    free_(parentNode);
 }
 
 /**
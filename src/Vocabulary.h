@@ -9,14 +9,19 @@
 #include <HashMap/HashMap.h>
 #include <Corpus.h>
 #include "VocabularyWord.h"
+#include "PhraseDetector.h"
+#include "CorpusFingerprint.h"
 
 static int MAX_CODE_LENGTH = 40;
+static int VOCABULARY_FILE_MAGIC = 0x56563257;
+
+struct mapped_corpus;
 
 struct vocabulary{
     Array_list_ptr vocabulary;
     Array_list_ptr table;
     Hash_map_ptr word_map;
-    int total_number_of_words;
+    long long total_number_of_words;
 };
 
 typedef struct vocabulary Vocabulary;
@@ -27,8 +32,20 @@ Vocabulary_ptr create_vocabulary(Corpus_ptr corpus);
 
 Vocabulary_ptr create_vocabulary2();
 
+Vocabulary_ptr create_vocabulary3(Corpus_ptr corpus, Phrase_detector_ptr phrase_detector);
+
+Vocabulary_ptr create_vocabulary4(const struct mapped_corpus* mapped_corpus);
+
+Vocabulary_ptr create_vocabulary5(const char* file_name, const Corpus_fingerprint* fingerprint);
+
+Vocabulary_ptr create_vocabulary6(Corpus_ptr corpus, Phrase_detector_ptr phrase_detector, const char* cache_file_name);
+
+bool save_vocabulary(Vocabulary_ptr vocabulary, const char* file_name, const Corpus_fingerprint* fingerprint);
+
 void free_vocabulary(Vocabulary_ptr vocabulary);
 
+void prepare_vocabulary(Vocabulary_ptr vocabulary);
+
 void create_uni_gram_table(Vocabulary_ptr vocabulary);
 
 void construct_huffman_tree(Vocabulary_ptr vocabulary);
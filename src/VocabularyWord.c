@@ -13,11 +13,12 @@
  * @param name Lemma of the word
  * @param count Number of occurrences of this word in the corpus
  */
-Vocabulary_word_ptr create_vocabulary_word(const char *name, int count) {
+Vocabulary_word_ptr create_vocabulary_word(const char *name, long long count) {
     Vocabulary_word_ptr result = malloc_(sizeof(Vocabulary_word));
     result->name = str_copy(result->name, name);
     result->count = count;
     result->code_length = 0;
+    result->frequency_rank = 0;
     return result;
 }
 
@@ -26,7 +27,15 @@ int compare_vocabulary_word(const Vocabulary_word *word1, const Vocabulary_word
 }
 
 int compare_vocabulary_word2(const Vocabulary_word *word1, const Vocabulary_word *word2) {
-    return compare_int_r(&(word1->count), &(word2->count));
+    if (word1->count > word2->count){
+        return -1;
+    } else {
+        if (word1->count < word2->count){
+            return 1;
+        } else {
+            return 0;
+        }
+    }
 }
 
 /**
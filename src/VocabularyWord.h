@@ -9,8 +9,9 @@
 
 struct vocabulary_word{
     char* name;
-    int count;
+    long long count;
     int code_length;
+    int frequency_rank;
     int code[40];
     int point[40];
 };
@@ -19,7 +20,7 @@ typedef struct vocabulary_word Vocabulary_word;
 
 typedef Vocabulary_word *Vocabulary_word_ptr;
 
-Vocabulary_word_ptr create_vocabulary_word(const char* name, int count);
+Vocabulary_word_ptr create_vocabulary_word(const char* name, long long count);
 
 void free_vocabulary_word(Vocabulary_word_ptr word);
 
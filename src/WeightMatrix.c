@@ -0,0 +1,196 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <Memory/Memory.h>
+#include "WeightMatrix.h"
+
+/**
+ * Constructor for a weight matrix allocated on the heap row by row.
+ * @param row Number of rows.
+ * @param column Number of columns.
+ * @return Weight matrix with all weights set to zero.
+ */
+Weight_matrix_ptr create_weight_matrix(int row, int column) {
+    Weight_matrix_ptr result = malloc_(sizeof(Weight_matrix));
+    result->row = row;
+    result->column = column;
+    result->placement = HEAP_PLACEMENT;
+    result->rows = allocate_2d(row, column);
+    result->data = NULL;
+    result->size = 0;
+    result->descriptor = -1;
+    return result;
+}
+
+/**
+ * Constructor for a weight matrix stored as a single mapped slab, whose pages are distributed over the NUMA nodes.
+ * The slab is first touched by threads pinned to the cpus of the training threads, so each node gets an equal
+ * share of the rows and the memory bandwidth of all nodes is used while training. If the slab can not be mapped,
+ * the matrix falls back to the heap.
+ * @param row Number of rows.
+ * @param column Number of columns.
+ * @param numa_topology NUMA topology of the machine.
+ * @param thread_count Number of training threads.
+ * @return Weight matrix with all weights set to zero.
+ */
+Weight_matrix_ptr create_numa_weight_matrix(int row, int column, const Numa_topology* numa_topology, int thread_count) {
+    size_t size = (size_t) row * column * sizeof(double);
+    double* data = size > 0 ? mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0) : MAP_FAILED;
+    if (data == MAP_FAILED){
+        return create_weight_matrix(row, column);
+    }
+    Weight_matrix_ptr result = malloc_(sizeof(Weight_matrix));
+    result->row = row;
+    result->column = column;
+    result->placement = NUMA_PLACEMENT;
+    result->data = data;
+    result->size = size;
+    result->descriptor = -1;
+    first_touch_partitioned(numa_topology, data, size, thread_count);
+    result->rows = malloc_(row * sizeof(double*));
+    for (int i = 0; i < row; i++){
+        result->rows[i] = data + (size_t) i * column;
+    }
+    return result;
+}
+
+/**
+ * Constructor for a weight matrix backed by a memory mapped file, so that the matrix can be larger than the
+ * physical memory. Row i is stored at position row_order[i] of the file. If the order is the frequency rank of the
+ * words, the rows of frequent words are packed at the beginning of the file and stay resident in the page cache,
+ * while the rows of rare words are paged in on demand. The first resident_row_count rows of the file are advised
+ * as needed, the rest as randomly accessed so that the kernel does not read ahead cold rows. The file is kept after
+ * the matrix is freed.
+ * @param row Number of rows.
+ * @param column Number of columns.
+ * @param file_name Name of the backing file, it is truncated if it exists.
+ * @param row_order Position of each row in the file.
+ * @param resident_row_count Number of rows at the beginning of the file expected to stay in memory.
+ * @return Weight matrix with all weights set to zero, NULL if the file could not be created or mapped.
+ */
+Weight_matrix_ptr create_mapped_weight_matrix(int row, int column, const char* file_name, const int* row_order, int resident_row_count) {
+    size_t size = (size_t) row * column * sizeof(double);
+    int descriptor = open(file_name, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (descriptor == -1){
+        return NULL;
+    }
+    double* data = MAP_FAILED;
+    if (size > 0 && ftruncate(descriptor, (off_t) size) == 0){
+        data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+    }
+    if (data == MAP_FAILED){
+        close(descriptor);
+        return NULL;
+    }
+    Weight_matrix_ptr result = malloc_(sizeof(Weight_matrix));
+    result->row = row;
+    result->column = column;
+    result->placement = FILE_PLACEMENT;
+    result->data = data;
+    result->size = size;
+    result->descriptor = descriptor;
+    size_t resident_size = (size_t) (resident_row_count < row ? resident_row_count : row) * column * sizeof(double);
+    size_t page_size = (size_t) sysconf(_SC_PAGESIZE);
+    resident_size = (resident_size + page_size - 1) / page_size * page_size;
+    if (resident_size > 0){
+        madvise(data, resident_size < size ? resident_size : size, MADV_WILLNEED);
+    }
+    if (resident_size < size){
+        madvise((char*) data + resident_size, size - resident_size, MADV_RANDOM);
+    }
+    result->rows = malloc_(row * sizeof(double*));
+    for (int i = 0; i < row; i++){
+        result->rows[i] = data + (size_t) row_order[i] * column;
+    }
+    return result;
+}
+
+/**
+ * Maps an anonymous region of the given size on huge pages. Explicit huge pages reserved in the hugetlbfs pool are
+ * tried first; if the pool is empty, the region is aligned to a huge page boundary and advised for transparent
+ * huge pages, which the kernel backs with huge pages when it can and with normal pages otherwise.
+ * @param size Size of the region, a multiple of HUGE_PAGE_SIZE.
+ * @return Start of the region, MAP_FAILED if it can not be mapped.
+ */
+static void* map_huge_pages(size_t size) {
+    void* data = MAP_FAILED;
+#ifdef MAP_HUGETLB
+    data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (data != MAP_FAILED){
+        return data;
+    }
+#endif
+    char* raw = mmap(NULL, size + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED){
+        return MAP_FAILED;
+    }
+    char* aligned = (char*) (((uintptr_t) raw + HUGE_PAGE_SIZE - 1) & ~((uintptr_t) HUGE_PAGE_SIZE - 1));
+    if (aligned > raw){
+        munmap(raw, aligned - raw);
+    }
+    if (raw + HUGE_PAGE_SIZE > aligned){
+        munmap(aligned + size, raw + HUGE_PAGE_SIZE - aligned);
+    }
+#ifdef MADV_HUGEPAGE
+    madvise(aligned, size, MADV_HUGEPAGE);
+#endif
+    return aligned;
+}
+
+/**
+ * Constructor for several weight matrices of the same shape stored in one slab of huge pages, one huge page
+ * aligned part per matrix. Row i of matrix k is stored at position row_orders[k][i] of its part; if the order is
+ * the frequency rank of the words, the rows of the most frequent words share a few huge pages, so the random row
+ * accesses of training hit a small set of TLB entries and cache sets instead of rows scattered over the heap. Each
+ * matrix unmaps its own part when it is freed. If the slab can not be mapped, the matrices fall back to the heap.
+ * @param count Number of matrices.
+ * @param row Number of rows of each matrix.
+ * @param column Number of columns of each matrix.
+ * @param row_orders Position of each row in its part, for each matrix.
+ * @param matrices Output array of count weight matrices with all weights set to zero.
+ */
+void create_huge_page_weight_matrices(int count, int row, int column, int* const* row_orders, Weight_matrix_ptr* matrices) {
+    size_t size = (size_t) row * column * sizeof(double);
+    size = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    char* data = size > 0 ? map_huge_pages(size * count) : MAP_FAILED;
+    for (int k = 0; k < count; k++){
+        if (data == MAP_FAILED){
+            matrices[k] = create_weight_matrix(row, column);
+            continue;
+        }
+        Weight_matrix_ptr result = malloc_(sizeof(Weight_matrix));
+        result->row = row;
+        result->column = column;
+        result->placement = HUGE_PAGE_PLACEMENT;
+        result->data = (double*) (data + k * size);
+        result->size = size;
+        result->descriptor = -1;
+        result->rows = malloc_(row * sizeof(double*));
+        for (int i = 0; i < row; i++){
+            result->rows[i] = result->data + (size_t) row_orders[k][i] * column;
+        }
+        matrices[k] = result;
+    }
+}
+
+/**
+ * Frees memory allocated for the weight matrix.
+ * @param weight_matrix Weight matrix to deallocate.
+ */
+void free_weight_matrix(Weight_matrix_ptr weight_matrix) {
+    if (weight_matrix->placement == HEAP_PLACEMENT){
+        free_2d(weight_matrix->rows, weight_matrix->row);
+    } else {
+        munmap(weight_matrix->data, weight_matrix->size);
+        free_(weight_matrix->rows);
+        if (weight_matrix->descriptor != -1){
+            close(weight_matrix->descriptor);
+        }
+    }
+    free_(weight_matrix);
+}
@@ -0,0 +1,46 @@
+//
+// Created by Olcay Taner YILDIZ on 19.10.2026.
+//
+
+#ifndef WORDTOVEC_WEIGHTMATRIX_H
+#define WORDTOVEC_WEIGHTMATRIX_H
+
+#include <stddef.h>
+#include "NumaTopology.h"
+
+static int HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+enum weight_placement{
+    HEAP_PLACEMENT,
+    NUMA_PLACEMENT,
+    FILE_PLACEMENT,
+    HUGE_PAGE_PLACEMENT
+};
+
+typedef enum weight_placement Weight_placement;
+
+struct weight_matrix{
+    double** rows;
+    double* data;
+    size_t size;
+    int row;
+    int column;
+    int descriptor;
+    Weight_placement placement;
+};
+
+typedef struct weight_matrix Weight_matrix;
+
+typedef Weight_matrix *Weight_matrix_ptr;
+
+Weight_matrix_ptr create_weight_matrix(int row, int column);
+
+Weight_matrix_ptr create_numa_weight_matrix(int row, int column, const Numa_topology* numa_topology, int thread_count);
+
+Weight_matrix_ptr create_mapped_weight_matrix(int row, int column, const char* file_name, const int* row_order, int resident_row_count);
+
+void create_huge_page_weight_matrices(int count, int row, int column, int* const* row_orders, Weight_matrix_ptr* matrices);
+
+void free_weight_matrix(Weight_matrix_ptr weight_matrix);
+
+#endif //WORDTOVEC_WEIGHTMATRIX_H
@@ -17,6 +17,24 @@ Word_to_vec_parameter_ptr create_word_to_vec_parameter() {
     result->negative_sampling_size = 5;
     result->number_of_iterations = 2;
     result->seed = 1;
+    result->thread_count = 1;
+    result->numa_aware = false;
+    result->huge_pages = false;
+    result->hot_word_count = 0;
+    result->hot_merge_interval = 4096;
+    result->hs_cached_levels = 0;
+    result->prefetch_distance = 2;
+    result->schedule = LINEAR_SCHEDULE;
+    result->warmup_ratio = 0;
+    result->restart_per_epoch = false;
+    result->weight_file_prefix = NULL;
+    result->vocabulary_cache_file = NULL;
+    result->deterministic = false;
+    result->deterministic_interval = 1024;
+    result->cooccurrence_memory_limit = 256LL * 1024 * 1024;
+    result->glove_learning_rate = 0.05;
+    result->glove_x_max = 100;
+    result->glove_power = 0.75;
     return result;
 }
 
@@ -7,6 +7,13 @@
 
 #include <stdbool.h>
 
+enum schedule_type{
+    LINEAR_SCHEDULE,
+    COSINE_SCHEDULE
+};
+
+typedef enum schedule_type Schedule_type;
+
 struct word_to_vec_parameter{
     int layer_size;
     bool cbow;
@@ -16,6 +23,24 @@ struct word_to_vec_parameter{
     int negative_sampling_size;
     int number_of_iterations;
     int seed;
+    int thread_count;
+    bool numa_aware;
+    bool huge_pages;
+    int hot_word_count;
+    int hot_merge_interval;
+    int hs_cached_levels;
+    int prefetch_distance;
+    Schedule_type schedule;
+    double warmup_ratio;
+    bool restart_per_epoch;
+    const char* weight_file_prefix;
+    const char* vocabulary_cache_file;
+    bool deterministic;
+    int deterministic_interval;
+    long long cooccurrence_memory_limit;
+    double glove_learning_rate;
+    double glove_x_max;
+    double glove_power;
 };
 
 typedef struct word_to_vec_parameter Word_to_vec_parameter;